@@ -0,0 +1,367 @@
+// SerialBaudBench：在仿真的 UART 线路上评估自动波特率检测（CBaudDetector）的正确率与耗时。
+// 发送端按真实速率（带 ±0.5% 时钟误差）输出 8N1 帧，接收端按候选速率在下降沿起始、位中点采样，
+// 停止位为低时按驱动的处理方式记帧错误（IGNPAR，丢弃该字节）或 break（交付 0x00）；
+// 读取每 1 ms 完成一次，切换速率另计 0.5 ms。不需要硬件，检测阈值改动后用它回归。
+#include "cbauddetector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Clock = CBaudDetector::Clock;
+
+constexpr double kReadTick = 1e-3;      // 读取完成的粒度
+constexpr double kSwitchCost = 0.5e-3;  // setBaudRate + flushInput 的耗时
+constexpr double kMaxRunTime = 5.0;     // 仿真线路时间上限
+constexpr double kClockTolerance = 0.005;
+
+enum Traffic
+{
+    ContinuousText,   // 连续的日志文本（含少量 UTF-8 中文）
+    TextLines,        // 每行之后停顿 20 ms 的传感器输出
+    ModbusPolling,    // 8 字节请求 + 25 字节应答，每 50 ms 一轮
+    RandomBinary,     // 连续随机字节
+    TrafficCount
+};
+
+const char *trafficName(int traffic)
+{
+    static const char *const names[TrafficCount] = {"text", "lines", "modbus", "binary"};
+    return names[traffic];
+}
+
+struct Options
+{
+    std::vector<int> traffic;
+    bool hasLineErrors = true;
+    int trials = 20;
+    unsigned seed = 1;
+    bool verbose = false;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialBaudBench [--traffic text|lines|modbus|binary|all] [--no-line-errors]\n"
+                 "                       [--trials <n>] [--seed <n>] [--verbose]\n"
+                 "  --no-line-errors  simulate a driver without framing/break counters (pty, some USB adapters)\n"
+                 "  --verbose         print the per-candidate scores of every failed trial\n";
+}
+
+// 发送端：帧起始时刻与字节，帧间可有空闲
+struct Line
+{
+    double bitTime = 0.0;
+    std::vector<double> frameStarts;
+    std::vector<unsigned char> bytes;
+
+    int bit(size_t frame, int index) const
+    {
+        return index == 0 ? 0 : index == 9 ? 1 : (bytes[frame] >> (index - 1)) & 1;
+    }
+
+    int level(double time) const
+    {
+        auto it = std::upper_bound(frameStarts.begin(), frameStarts.end(), time);
+        if (it == frameStarts.begin()) {
+            return 1;
+        }
+        const size_t frame = static_cast<size_t>(it - frameStarts.begin()) - 1;
+        const int index = static_cast<int>((time - frameStarts[frame]) / bitTime);
+        return index < 10 ? bit(frame, index) : 1;
+    }
+
+    // time 之后的第一个下降沿，没有时返回负数
+    double nextFallingEdge(double time) const
+    {
+        auto it = std::upper_bound(frameStarts.begin(), frameStarts.end(), time);
+        size_t frame = it == frameStarts.begin() ? 0 : static_cast<size_t>(it - frameStarts.begin()) - 1;
+        for (; frame < frameStarts.size(); ++frame) {
+            for (int index = 0; index < 10; ++index) {
+                const double edge = frameStarts[frame] + index * bitTime;
+                if (edge <= time || bit(frame, index) != 0) {
+                    continue;
+                }
+                // 起始位之前是空闲或上一帧的停止位，总是下降沿
+                if (index == 0 || bit(frame, index - 1) == 1) {
+                    return edge;
+                }
+            }
+        }
+        return -1.0;
+    }
+};
+
+Line generateLine(int traffic, unsigned baudRate, std::mt19937 &random)
+{
+    Line line;
+    std::uniform_real_distribution<double> tolerance(-kClockTolerance, kClockTolerance);
+    line.bitTime = 1.0 / (baudRate * (1.0 + tolerance(random)));
+    const double frameTime = 10.0 * line.bitTime;
+    // 检测在发送开始后的随机时刻启动
+    double time = -std::uniform_real_distribution<double>(0.0, 0.1)(random);
+    auto put = [&](unsigned char byte) {
+        line.frameStarts.push_back(time);
+        line.bytes.push_back(byte);
+        time += frameTime;
+    };
+    auto putText = [&](const std::string &text) {
+        for (char c : text) {
+            put(static_cast<unsigned char>(c));
+        }
+    };
+    std::uniform_int_distribution<int> byteValue(0, 255);
+    std::uniform_int_distribution<int> digit(0, 9);
+    int sequence = 0;
+    while (time < kMaxRunTime) {
+        switch (traffic) {
+        case ContinuousText:
+        case TextLines: {
+            std::string text = "seq=" + std::to_string(sequence++) + " temp=2" + std::to_string(digit(random)) + "."
+                               + std::to_string(digit(random)) + " hum=" + std::to_string(40 + digit(random));
+            text += sequence % 4 == 0 ? " 状态=正常\r\n" : " status=OK\r\n";
+            putText(text);
+            if (traffic == TextLines) {
+                time += 0.020;
+            }
+            break;
+        }
+        case ModbusPolling: {
+            const double cycleStart = time;
+            const unsigned char request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD};
+            for (unsigned char byte : request) {
+                put(byte);
+            }
+            time += 0.005;
+            put(0x01);
+            put(0x03);
+            put(0x14);
+            for (int i = 0; i < 10; ++i) {
+                put(0x00);
+                put(static_cast<unsigned char>(byteValue(random) & 0x3F));
+            }
+            put(static_cast<unsigned char>(byteValue(random)));
+            put(static_cast<unsigned char>(byteValue(random)));
+            time = std::max(time, cycleStart + 0.050);
+            break;
+        }
+        default:
+            put(static_cast<unsigned char>(byteValue(random)));
+            break;
+        }
+    }
+    return line;
+}
+
+// 接收端在某个速率下从 start 开始采样，得到的字节与错误事件
+struct RxEvent
+{
+    double time;
+    int kind;   // 0 字节，1 帧错误，2 break
+    unsigned char byte;
+};
+
+class Receiver
+{
+public:
+    Receiver(const Line &line, unsigned baudRate, double start)
+        : m_Line(line)
+        , m_BitTime(1.0 / baudRate)
+        , m_Time(start)
+    {
+    }
+
+    // 产生下一个事件，线路上没有更多数据时返回 false
+    bool next(RxEvent &event)
+    {
+        while (true) {
+            const double edge = m_Line.nextFallingEdge(m_Time);
+            if (edge < 0.0) {
+                return false;
+            }
+            if (m_Line.level(edge + 0.5 * m_BitTime) != 0) {
+                // 毛刺，不是起始位
+                m_Time = edge + 0.5 * m_BitTime;
+                continue;
+            }
+            unsigned char byte = 0;
+            for (int i = 0; i < 8; ++i) {
+                byte |= static_cast<unsigned char>(m_Line.level(edge + (1.5 + i) * m_BitTime) << i);
+            }
+            const double stopTime = edge + 9.5 * m_BitTime;
+            m_Time = stopTime;
+            event.time = stopTime;
+            event.byte = byte;
+            if (m_Line.level(stopTime) == 1) {
+                event.kind = 0;
+            } else {
+                event.kind = byte == 0 ? 2 : 1;
+            }
+            return true;
+        }
+    }
+
+private:
+    const Line &m_Line;
+    double m_BitTime;
+    double m_Time;
+};
+
+Clock::time_point toTimePoint(double seconds)
+{
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)));
+}
+
+struct TrialResult
+{
+    bool detected = false;
+    unsigned baudRate = 0;
+    double seconds = 0.0;
+    int candidates = 0;
+    std::string summary;
+    std::vector<CBaudDetector::Score> scores;
+};
+
+TrialResult runTrial(const Line &line, bool hasLineErrors)
+{
+    CBaudDetector detector;
+    TrialResult result;
+    double now = 0.0;
+    SerialTuning::LineErrors errors;
+    CBaudDetector::Verdict verdict = CBaudDetector::NextCandidate;
+    while (verdict == CBaudDetector::NextCandidate) {
+        now += kSwitchCost;
+        const unsigned baudRate = detector.beginCandidate(toTimePoint(now));
+        ++result.candidates;
+        detector.setLineErrors(errors, hasLineErrors, toTimePoint(now));
+        Receiver receiver(line, baudRate, now);
+        RxEvent event;
+        bool hasEvent = receiver.next(event);
+        const double deadline = std::chrono::duration<double>(detector.deadline().time_since_epoch()).count();
+        verdict = CBaudDetector::Listening;
+        for (double tick = now + kReadTick; verdict == CBaudDetector::Listening; tick += kReadTick) {
+            std::string data;
+            bool hasErrors = false;
+            while (hasEvent && event.time < tick) {
+                if (event.kind == 0) {
+                    data.push_back(static_cast<char>(event.byte));
+                } else if (event.kind == 1) {
+                    ++errors.frame;
+                    hasErrors = true;
+                } else {
+                    ++errors.breaks;
+                    data.push_back('\0');
+                    hasErrors = true;
+                }
+                hasEvent = receiver.next(event);
+            }
+            if (data.empty() && !hasErrors && tick < deadline) {
+                continue;
+            }
+            const Clock::time_point at = toTimePoint(tick);
+            detector.setLineErrors(errors, hasLineErrors, at);
+            detector.addData(data.data(), data.size(), at);
+            verdict = detector.evaluate(at);
+            now = tick;
+        }
+    }
+    if (verdict == CBaudDetector::NextCandidate) {
+        verdict = detector.finish();
+    }
+    result.detected = verdict == CBaudDetector::Detected;
+    result.baudRate = detector.detectedBaudRate();
+    result.seconds = now;
+    result.summary = detector.summary();
+    result.scores = detector.scores();
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--traffic" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            for (int traffic = 0; traffic < TrafficCount; ++traffic) {
+                if (name == "all" || name == trafficName(traffic)) {
+                    options.traffic.push_back(traffic);
+                }
+            }
+            if (options.traffic.empty()) {
+                printUsage();
+                return 2;
+            }
+        } else if (arg == "--no-line-errors") {
+            options.hasLineErrors = false;
+        } else if (arg == "--trials" && i + 1 < argc) {
+            options.trials = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.traffic.empty()) {
+        for (int traffic = 0; traffic < TrafficCount; ++traffic) {
+            options.traffic.push_back(traffic);
+        }
+    }
+
+    std::mt19937 random(options.seed);
+    std::printf("line error counters: %s, %d trials per rate\n", options.hasLineErrors ? "yes" : "no", options.trials);
+    std::printf("%-7s %8s %8s %8s %8s %10s %10s %10s\n", "traffic", "baud", "correct", "wrong", "failed", "mean ms",
+                "max ms", "tried");
+    int status = 0;
+    for (int traffic : options.traffic) {
+        for (unsigned baudRate : CBaudDetector::defaultCandidates()) {
+            int correct = 0;
+            int wrong = 0;
+            int failed = 0;
+            double totalSeconds = 0.0;
+            double maxSeconds = 0.0;
+            int totalCandidates = 0;
+            for (int trial = 0; trial < options.trials; ++trial) {
+                const Line line = generateLine(traffic, baudRate, random);
+                const TrialResult result = runTrial(line, options.hasLineErrors);
+                if (!result.detected) {
+                    ++failed;
+                } else if (result.baudRate == baudRate) {
+                    ++correct;
+                } else {
+                    ++wrong;
+                }
+                totalSeconds += result.seconds;
+                maxSeconds = std::max(maxSeconds, result.seconds);
+                totalCandidates += result.candidates;
+                if (options.verbose && (!result.detected || result.baudRate != baudRate)) {
+                    std::printf("  %s @ %u: %s\n", trafficName(traffic), baudRate, result.summary.c_str());
+                    for (const CBaudDetector::Score &score : result.scores) {
+                        std::printf("    %7u bytes=%-4zu errors=%-4llu text=%.2f step=%.2f score=%.3f\n",
+                                    score.baudRate, score.bytes, static_cast<unsigned long long>(score.lineErrors),
+                                    score.textFraction, score.stepFraction, score.score);
+                    }
+                }
+            }
+            // 错判比检测失败更糟：调用方会按错误的速率继续工作
+            if (wrong > 0) {
+                status = 1;
+            }
+            std::printf("%-7s %8u %8d %8d %8d %10.1f %10.1f %10.1f\n", trafficName(traffic), baudRate, correct, wrong,
+                        failed, totalSeconds * 1000.0 / options.trials, maxSeconds * 1000.0,
+                        static_cast<double>(totalCandidates) / options.trials);
+        }
+    }
+    return status;
+}
@@ -0,0 +1,140 @@
+// SerialCaptureSlice：按时间范围从捕获文件中截取片段，借助稀疏索引直接定位，不读取整个文件
+#include "ccapturefile.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+void printUsage()
+{
+    std::cerr << "Usage: SerialCaptureSlice <capture> [--info] [--reindex]\n"
+                 "                          [--from <time>] [--to <time>] [-o <output>] [--raw]\n"
+                 "  <time>    seconds relative to the first record (e.g. 60 or 90.5),\n"
+                 "            or absolute Unix epoch seconds prefixed with '@' (e.g. @1729300000.25)\n"
+                 "  --info    print capture and index summary\n"
+                 "  --reindex rebuild the sparse index (<capture>.idx) before use\n"
+                 "  -o        write the slice as a new indexed capture (stdout when omitted)\n"
+                 "  --raw     write payload bytes only, without record headers\n";
+}
+
+bool parseTime(const char *text, uint64_t firstTimestampNs, uint64_t &timestampNs)
+{
+    const bool absolute = text[0] == '@';
+    char *end = nullptr;
+    const double seconds = std::strtod(absolute ? text + 1 : text, &end);
+    if (end == text || *end != '\0' || seconds < 0 || !std::isfinite(seconds)) {
+        return false;
+    }
+    const uint64_t ns = static_cast<uint64_t>(std::llround(seconds * 1e9));
+    timestampNs = absolute ? ns : firstTimestampNs + ns;
+    return true;
+}
+
+void printTimestamp(const char *label, uint64_t timestampNs)
+{
+    std::printf("%-14s %llu.%09llu\n", label,
+                static_cast<unsigned long long>(timestampNs / 1000000000ULL),
+                static_cast<unsigned long long>(timestampNs % 1000000000ULL));
+}
+}
+
+int main(int argc, char *argv[])
+{
+    std::string capturePath;
+    std::string outputPath;
+    const char *fromText = nullptr;
+    const char *toText = nullptr;
+    bool info = false;
+    bool reindex = false;
+    bool raw = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--info") {
+            info = true;
+        } else if (arg == "--reindex") {
+            reindex = true;
+        } else if (arg == "--raw") {
+            raw = true;
+        } else if (arg == "--from" && i + 1 < argc) {
+            fromText = argv[++i];
+        } else if (arg == "--to" && i + 1 < argc) {
+            toText = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (capturePath.empty() && arg[0] != '-') {
+            capturePath = arg;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (capturePath.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    CCaptureReader reader;
+    std::string error;
+    if (!reader.open(capturePath, reindex, &error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    if (info) {
+        std::printf("%-14s %llu bytes\n", "file size", static_cast<unsigned long long>(reader.fileSize()));
+        std::printf("%-14s %zu\n", "index entries", reader.index().entries().size());
+        printTimestamp("first record", reader.firstTimestampNs());
+        printTimestamp("last record", reader.lastTimestampNs());
+        if (!fromText && !toText) {
+            return 0;
+        }
+    }
+
+    uint64_t fromNs = 0;
+    uint64_t toNs = UINT64_MAX;
+    if ((fromText && !parseTime(fromText, reader.firstTimestampNs(), fromNs))
+        || (toText && !parseTime(toText, reader.firstTimestampNs(), toNs))) {
+        std::cerr << "Invalid time value\n";
+        return 2;
+    }
+    if (!reader.seek(fromNs)) {
+        return 0;  // 起点之后没有记录，输出为空
+    }
+
+    CCaptureWriter writer;
+    FILE *rawOutput = nullptr;
+    if (outputPath.empty()) {
+        rawOutput = stdout;
+        raw = true;
+    } else if (raw) {
+        rawOutput = std::fopen(outputPath.c_str(), "wb");
+        if (!rawOutput) {
+            std::cerr << "Cannot open output file: " << outputPath << "\n";
+            return 1;
+        }
+    } else if (!writer.open(outputPath, &error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    CCaptureRecord record;
+    while (reader.next(record) && record.timestampNs < toNs) {
+        if (raw) {
+            std::fwrite(record.data.data(), 1, record.data.size(), rawOutput);
+        } else {
+            writer.append(record.timestampNs, record.data.data(), record.data.size());
+        }
+    }
+
+    if (rawOutput && rawOutput != stdout) {
+        std::fclose(rawOutput);
+    }
+    writer.close();
+    return 0;
+}
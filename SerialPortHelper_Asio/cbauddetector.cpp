@@ -0,0 +1,364 @@
+#include "cbauddetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+// 速率不对时单个字节恰好无错误的概率上限，用于折算样本量带来的把握。接收端比突发数据慢得多时，
+// 停止位常落在突发之后的空闲里，乱码也几乎全部无错误（仿真中可达 0.8），连续 22 个以上才算有把握
+constexpr double kWrongRateCleanProbability = 0.85;
+// 速率不对时单个字节恰好是文本的概率上限；文本流因此只需约 7 个连续字节
+constexpr double kWrongRateTextProbability = 0.6;
+// 错误率超过 10% 的部分每 1% 扣 3% 的分
+constexpr double kErrorAllowance = 0.1;
+constexpr double kErrorPenalty = 3.0;
+// 文本流中允许的非文本比例，超过后线性扣分，达到 2 倍时记 0
+constexpr double kTextTolerance = 0.1;
+
+bool isTextByte(unsigned char byte)
+{
+    return (byte >= 0x20 && byte < 0x7F) || byte == '\t' || byte == '\r' || byte == '\n';
+}
+
+// 0 起始位、8 个数据位（低位先发）、1 停止位组成的 10 位帧中只有一次跳变，即数据为 0…01…1 形式：
+// 接收端比发送端快得多时，一个字节的时间内线路电平基本不变，采到的几乎都是这种字节
+bool isStepByte(unsigned char byte)
+{
+    const unsigned inverted = static_cast<unsigned char>(~byte);
+    return (inverted & (inverted + 1)) == 0;
+}
+}
+
+std::vector<unsigned> CBaudDetector::defaultCandidates()
+{
+    return {921600, 460800, 230400, 115200, 57600, 38400, 19200, 9600, 4800, 2400, 1200};
+}
+
+CBaudDetector::CBaudDetector(std::vector<unsigned> candidates)
+    : m_Candidates(std::move(candidates))
+{
+    m_Scores.reserve(m_Candidates.size());
+}
+
+bool CBaudDetector::hasNextCandidate() const
+{
+    return m_NextIndex < m_Candidates.size();
+}
+
+unsigned CBaudDetector::beginCandidate(Clock::time_point now)
+{
+    if (m_IsListening) {
+        closeCandidate();
+    }
+    Score score;
+    score.baudRate = m_Candidates[m_NextIndex++];
+    m_Scores.push_back(score);
+    m_IsListening = true;
+    // 连续数据流中接收端可能先把数据位的下降沿当成起始位，要过几个字符才能对齐
+    const auto twoCharacters = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(20.0 / std::max(score.baudRate, 1u)));
+    m_SettleEnd = now + std::max<Clock::duration>(kSettleTime, twoCharacters);
+    // 低速率下 kMaxDwell 内收不到足够的字节，至少留出 kMinTextSampleBytes 再多几个字符的时间
+    const auto sampleTime = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(10.0 * (kMinTextSampleBytes + 8) / std::max(score.baudRate, 1u)));
+    m_Deadline = m_SettleEnd + std::max<Clock::duration>(kMaxDwell, sampleTime);
+    m_BaseErrors = SerialTuning::LineErrors();
+    m_TextBytes = 0;
+    m_StepBytes = 0;
+    // 从“文本分刚好为 0”的比例起步，文本流十来个字节即可回升到满分
+    m_TextAverage = 1.0 - 2.0 * kTextTolerance;
+    m_Quality = 0.0;
+    m_HasNewErrors = false;
+    m_Utf8Pending = 0;
+    m_Utf8LeadBytes = 0;
+    return score.baudRate;
+}
+
+unsigned CBaudDetector::nextBaudRate() const
+{
+    return hasNextCandidate() ? m_Candidates[m_NextIndex] : 0;
+}
+
+CBaudDetector::Verdict CBaudDetector::skipCandidate()
+{
+    if (m_IsListening) {
+        closeCandidate();
+    }
+    if (hasNextCandidate()) {
+        Score score;
+        score.baudRate = m_Candidates[m_NextIndex++];
+        m_Scores.push_back(score);
+    }
+    return advance();
+}
+
+unsigned CBaudDetector::currentBaudRate() const
+{
+    return m_Scores.empty() ? 0 : m_Scores.back().baudRate;
+}
+
+CBaudDetector::Clock::time_point CBaudDetector::deadline() const
+{
+    return m_Deadline;
+}
+
+void CBaudDetector::setLineErrors(const SerialTuning::LineErrors &errors, bool available, Clock::time_point now)
+{
+    if (!m_IsListening) {
+        return;
+    }
+    Score &score = m_Scores.back();
+    if (!available) {
+        score.hasLineErrors = false;
+        return;
+    }
+    if (now < m_SettleEnd || !score.hasLineErrors) {
+        // 第一次读数与稳定期内的读数都作为基线，切换瞬间的错位不计入
+        m_BaseErrors = errors;
+        score.hasLineErrors = true;
+        if (now < m_SettleEnd) {
+            return;
+        }
+    }
+    // 溢出与速率无关，不计入
+    const uint64_t lineErrors = (errors.frame - m_BaseErrors.frame) + (errors.parity - m_BaseErrors.parity)
+                                + (errors.breaks - m_BaseErrors.breaks);
+    if (lineErrors > score.lineErrors) {
+        score.lineErrors = lineErrors;
+        score.cleanRun = 0;
+        score.textRun = 0;
+        m_HasNewErrors = true;
+    }
+}
+
+void CBaudDetector::addData(const char *data, size_t size, Clock::time_point now)
+{
+    if (!m_IsListening || now < m_SettleEnd) {
+        return;
+    }
+    Score &score = m_Scores.back();
+    size = std::min(size, kMaxSampleBytes - std::min(score.bytes, kMaxSampleBytes));
+    size_t textRun = score.textRun;
+    for (size_t i = 0; i < size; ++i) {
+        const unsigned char byte = static_cast<unsigned char>(data[i]);
+        if (isStepByte(byte)) {
+            ++m_StepBytes;
+        }
+        // UTF-8 按 RFC 3629 严格校验：拒绝超长编码、代理区与 0x10FFFF 以上，乱码中常见的 C0/E0/F0 + 80 因此不算文本
+        if (m_Utf8Pending > 0) {
+            if ((byte & 0xC0) == 0x80) {
+                ++m_Utf8LeadBytes;
+                if (--m_Utf8Pending == 0) {
+                    m_TextBytes += m_Utf8LeadBytes;
+                    textRun += m_Utf8LeadBytes;
+                    for (; m_Utf8LeadBytes > 0; --m_Utf8LeadBytes) {
+                        m_TextAverage += (1.0 - m_TextAverage) / kTextAverageWindow;
+                    }
+                }
+                continue;
+            }
+            for (; m_Utf8LeadBytes > 0; --m_Utf8LeadBytes) {
+                m_TextAverage -= m_TextAverage / kTextAverageWindow;
+            }
+            m_Utf8Pending = 0;
+        }
+        if (isTextByte(byte)) {
+            ++m_TextBytes;
+            ++textRun;
+            m_TextAverage += (1.0 - m_TextAverage) / kTextAverageWindow;
+            continue;
+        }
+        textRun = 0;
+        if (byte >= 0xC2 && byte <= 0xF4 && i + 1 < size) {
+            const unsigned char next = static_cast<unsigned char>(data[i + 1]);
+            const bool isValidSecond = (byte == 0xE0)   ? next >= 0xA0 && next <= 0xBF
+                                       : (byte == 0xED) ? next >= 0x80 && next <= 0x9F
+                                       : (byte == 0xF0) ? next >= 0x90 && next <= 0xBF
+                                       : (byte == 0xF4) ? next >= 0x80 && next <= 0x8F
+                                                        : (next & 0xC0) == 0x80;
+            if (isValidSecond) {
+                m_Utf8Pending = byte >= 0xF0 ? 3 : byte >= 0xE0 ? 2 : 1;
+                m_Utf8LeadBytes = 1;
+                continue;
+            }
+        }
+        m_TextAverage -= m_TextAverage / kTextAverageWindow;
+    }
+    score.bytes += size;
+    if (!score.hasLineErrors) {
+        score.textRun = textRun;
+    } else if (m_HasNewErrors) {
+        // 同一次读取中错误与字节的先后不明，这次的字节不算作无错误
+        m_HasNewErrors = false;
+    } else {
+        score.cleanRun += size;
+        score.textRun = textRun;
+    }
+}
+
+CBaudDetector::Verdict CBaudDetector::evaluate(Clock::time_point now)
+{
+    if (!m_IsListening) {
+        return advance();
+    }
+    scoreCurrent();
+    const Score &score = m_Scores.back();
+    const size_t minBytes = score.hasLineErrors ? kMinSampleBytes : kMinTextSampleBytes;
+    if (score.bytes >= minBytes && score.score >= kConfidentScore) {
+        closeCandidate();
+        // 接收端比发送端慢时停止位可能恰好落在空闲或后续帧的停止位上（连续数据流在一半速率下总是如此），
+        // 乱码也无错误；比发送端快时则不会一直无错误。所以有把握后还要把更高的候选听一遍，取有把握的最高速率
+        m_FallbackIndex = m_Scores.size() - 1;
+        scheduleHigherCandidates(score.baudRate);
+        return advance();
+    }
+    // 质量分（不计样本量）已经很低，不必等满时间
+    // 没有错误计数时只看文本比例，连续文本流开头可能有几个字节未对齐，多听一些再否决
+    const size_t observed = score.bytes + static_cast<size_t>(score.lineErrors);
+    const size_t rejectBytes = score.hasLineErrors ? kRejectBytes : kMinTextSampleBytes;
+    if ((observed >= rejectBytes && m_Quality < kRejectScore) || score.bytes >= kMaxSampleBytes
+        || now >= m_Deadline) {
+        closeCandidate();
+        return advance();
+    }
+    return Listening;
+}
+
+CBaudDetector::Verdict CBaudDetector::finish()
+{
+    if (m_IsListening) {
+        closeCandidate();
+    }
+    if (m_DetectedBaudRate != 0) {
+        return Detected;
+    }
+    if (m_FallbackIndex != kNoFallback) {
+        return declare(m_FallbackIndex);
+    }
+    // 原理同 evaluate()：过线的候选中取最高速率
+    const Score *best = nullptr;
+    bool anyData = false;
+    bool anyCounters = false;
+    for (const Score &score : m_Scores) {
+        anyData = anyData || score.bytes > 0 || score.lineErrors > 0;
+        anyCounters = anyCounters || score.hasLineErrors;
+        const size_t minBytes = score.hasLineErrors ? kMinSampleBytes : kMinTextSampleBytes;
+        if (score.bytes >= minBytes && score.score >= kAcceptScore && (!best || score.baudRate > best->baudRate)) {
+            best = &score;
+        }
+    }
+    if (best) {
+        return declare(static_cast<size_t>(best - m_Scores.data()));
+    }
+    if (!anyData) {
+        m_Summary = "No data received at any candidate rate";
+        return Failed;
+    }
+    const auto top = std::max_element(m_Scores.begin(), m_Scores.end(),
+                                      [](const Score &a, const Score &b) { return a.score < b.score; });
+    if (!anyCounters && top->textFraction < 1.0 - kTextTolerance) {
+        m_Summary = "Driver reports no line errors and the traffic is not text; rates cannot be told apart";
+    } else {
+        char text[160];
+        std::snprintf(text, sizeof(text), "No rate is convincing: best was %u baud with score %.3f", top->baudRate,
+                      top->score);
+        m_Summary = text;
+    }
+    return Failed;
+}
+
+unsigned CBaudDetector::detectedBaudRate() const
+{
+    return m_DetectedBaudRate;
+}
+
+double CBaudDetector::confidence() const
+{
+    return m_Confidence;
+}
+
+const std::vector<CBaudDetector::Score> &CBaudDetector::scores() const
+{
+    return m_Scores;
+}
+
+std::string CBaudDetector::summary() const
+{
+    return m_Summary;
+}
+
+void CBaudDetector::scoreCurrent()
+{
+    Score &score = m_Scores.back();
+    const double bytes = static_cast<double>(score.bytes);
+    const double errors = static_cast<double>(score.lineErrors);
+    score.errorRate = bytes + errors > 0.0 ? errors / (bytes + errors) : 0.0;
+    score.textFraction = bytes > 0.0 ? static_cast<double>(m_TextBytes) / bytes : 0.0;
+    score.stepFraction = bytes > 0.0 ? static_cast<double>(m_StepBytes) / bytes : 0.0;
+    if (score.bytes == 0) {
+        m_Quality = 0.0;
+        score.score = 0.0;
+        return;
+    }
+
+    if (score.hasLineErrors) {
+        // 对齐之前的几个错误是正常的，超出部分按比例扣分
+        m_Quality = std::clamp(1.0 - (score.errorRate - kErrorAllowance) * kErrorPenalty, 0.0, 1.0);
+    } else {
+        // 没有错误计数时接收端过快只能从字节分布上看出来：随机数据里台阶字节约占 9/256，
+        // 协议帧里的 0x00/0xFF 也很少过半；过半后线性扣分
+        const double stepFactor = std::clamp(2.0 - 2.0 * score.stepFraction, 0.0, 1.0);
+        const double textFactor =
+            std::clamp((m_TextAverage - (1.0 - 2.0 * kTextTolerance)) / kTextTolerance, 0.0, 1.0);
+        m_Quality = textFactor * stepFactor;
+    }
+    // 速率不对时连续采对的概率随长度指数下降，最近一段无错误、是文本的长度决定把握；
+    // 文本只在整体上就是文本流时才算证据，二进制流里偶尔连续几个可打印字节不说明问题
+    const bool isTextStream = score.textFraction >= 1.0 - kTextTolerance;
+    const double sample = 1.0
+                          - std::pow(kWrongRateCleanProbability, static_cast<double>(score.cleanRun))
+                                * (isTextStream ? std::pow(kWrongRateTextProbability, static_cast<double>(score.textRun))
+                                                : 1.0);
+    score.score = m_Quality * sample;
+}
+
+void CBaudDetector::closeCandidate()
+{
+    scoreCurrent();
+    m_IsListening = false;
+}
+
+CBaudDetector::Verdict CBaudDetector::advance()
+{
+    if (m_FallbackIndex != kNoFallback) {
+        // 核实中的更高速率有把握时已接替为 m_FallbackIndex；更高的候选都听完了就是结果
+        if (!hasNextCandidate() || m_Candidates[m_NextIndex] < m_Scores[m_FallbackIndex].baudRate) {
+            return declare(m_FallbackIndex);
+        }
+        return NextCandidate;
+    }
+    return hasNextCandidate() ? NextCandidate : finish();
+}
+
+void CBaudDetector::scheduleHigherCandidates(unsigned baudRate)
+{
+    // 尚未试过的更高速率按从低到高挪到前面，其余候选的顺序不变
+    auto first = m_Candidates.begin() + static_cast<std::ptrdiff_t>(m_NextIndex);
+    auto middle = std::stable_partition(first, m_Candidates.end(), [baudRate](unsigned rate) { return rate > baudRate; });
+    std::sort(first, middle);
+}
+
+CBaudDetector::Verdict CBaudDetector::declare(size_t index)
+{
+    const Score &score = m_Scores[index];
+    m_FallbackIndex = kNoFallback;
+    m_DetectedBaudRate = score.baudRate;
+    m_Confidence = score.score;
+    char text[160];
+    std::snprintf(text, sizeof(text), "Detected %u baud (confidence %.3f, %zu bytes, %llu line errors)", score.baudRate,
+                  score.score, score.bytes, static_cast<unsigned long long>(score.lineErrors));
+    m_Summary = text;
+    return Detected;
+}
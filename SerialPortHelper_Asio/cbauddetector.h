@@ -0,0 +1,119 @@
+#ifndef CBAUDDETECTOR_H
+#define CBAUDDETECTOR_H
+#include "cserialtuning.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 自动波特率检测：只听不发，逐个候选速率重新配置串口，对收到的数据打分，有把握时立即停止。
+// 速率不对时接收端采到的停止位常为低电平，驱动记帧错误或 break（asio 打开时设置了 IGNPAR，
+// 出错的字节直接丢弃），所以线路错误计数是主要依据；驱动不提供计数时只能看字节分布：
+// 文本流在错误速率下几乎不可能仍是可打印字符，接收端远快于发送端时采到的多是 0x00/0x80/0xC0/…/0xFF
+// 这类只有一次电平跳变的“台阶”字节。不提供计数又不是文本的二进制流无法判定，报告失败而不是猜。
+// 不依赖 Qt，由调用方驱动：切换速率后 beginCandidate()，每次读取完成后 setLineErrors() + addData() + evaluate()，
+// 到 deadline() 仍未出结论时再 evaluate() 一次
+class CBaudDetector
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Verdict
+    {
+        Listening,       // 当前候选还需要更多数据
+        NextCandidate,   // 当前候选已有结论，切换到下一个
+        Detected,        // 已确定速率
+        Failed           // 候选全部试过仍无法确定
+    };
+
+    struct Score
+    {
+        unsigned baudRate = 0;
+        size_t bytes = 0;            // 切换稳定后收到的字节数
+        uint64_t lineErrors = 0;     // 帧错误 + 校验错误 + break
+        bool hasLineErrors = false;  // 驱动是否提供线路错误计数
+        double errorRate = 0.0;      // lineErrors / (bytes + lineErrors)
+        double textFraction = 0.0;   // 可打印 ASCII、空白与合法 UTF-8 所占比例
+        double stepFraction = 0.0;   // 只有一次电平跳变的字节所占比例
+        size_t cleanRun = 0;         // 最后一次线路错误之后连续收到的字节数
+        size_t textRun = 0;          // 其中末尾连续的文本字节数
+        double score = 0.0;          // 0 ~ 1
+    };
+
+    // 切换速率后丢弃的时间（至少两个字符时间）：切换瞬间正在传输的字符必然错位
+    static constexpr std::chrono::milliseconds kSettleTime{2};
+    // 单个候选最长监听时间，线路空闲或数据稀疏时到期后换下一个
+    static constexpr std::chrono::milliseconds kMaxDwell{150};
+    static constexpr size_t kMinSampleBytes = 8;      // 少于这些字节不下“已确定”的结论
+    static constexpr size_t kRejectBytes = 12;        // 字节加错误达到这些后即可否决
+    // 没有错误计数时肯定与否决都至少要这么多字节：慢速接收端采到的乱码偶尔也会连续十来个都像文本
+    static constexpr size_t kMinTextSampleBytes = 32;
+    static constexpr size_t kMaxSampleBytes = 256;    // 收满后不再继续听，按已有数据打分
+    static constexpr double kConfidentScore = 0.97;   // 达到即停止扫描
+    static constexpr double kRejectScore = 0.3;
+    static constexpr double kAcceptScore = 0.6;       // 扫描结束时过线的候选中取最高速率
+
+    // 从高到低：比实际速率快的候选很快就会出错或采到台阶字节而被否决，比实际慢的则要听满 kMaxDwell，
+    // 所以先试高速率，第一个有把握的候选之上已没有待核实的速率，有把握即结束
+    static std::vector<unsigned> defaultCandidates();
+
+    explicit CBaudDetector(std::vector<unsigned> candidates = defaultCandidates());
+
+    bool hasNextCandidate() const;
+    // 下一个要试的速率，调用方先把串口切到该速率再 beginCandidate()；没有候选时为 0
+    unsigned nextBaudRate() const;
+    // 开始监听下一个候选，返回其速率
+    unsigned beginCandidate(Clock::time_point now);
+    // 下一个候选无法切换（驱动不支持该速率），记 0 分，返回值同 evaluate()
+    Verdict skipCandidate();
+    unsigned currentBaudRate() const;
+    // 当前候选的最晚结论时刻
+    Clock::time_point deadline() const;
+
+    // errors 为累计计数（SerialTuning::readLineErrors），稳定期内的读数作为基线
+    void setLineErrors(const SerialTuning::LineErrors &errors, bool available, Clock::time_point now);
+    void addData(const char *data, size_t size, Clock::time_point now);
+    Verdict evaluate(Clock::time_point now);
+    // 候选已全部结束，按最高分与领先幅度给出最终结论
+    Verdict finish();
+
+    unsigned detectedBaudRate() const;
+    double confidence() const;
+    const std::vector<Score> &scores() const;
+    // 结论的一行说明，供日志与界面显示
+    std::string summary() const;
+
+private:
+    static constexpr size_t kNoFallback = static_cast<size_t>(-1);
+    static constexpr double kTextAverageWindow = 16.0;
+
+    void scoreCurrent();
+    void closeCandidate();
+    Verdict advance();
+    void scheduleHigherCandidates(unsigned baudRate);
+    Verdict declare(size_t index);
+
+    std::vector<unsigned> m_Candidates;
+    size_t m_NextIndex = 0;
+    std::vector<Score> m_Scores;
+    bool m_IsListening = false;
+    Clock::time_point m_SettleEnd;
+    Clock::time_point m_Deadline;
+    SerialTuning::LineErrors m_BaseErrors;
+    // 当前候选的原始统计，打分时折算到 Score
+    size_t m_TextBytes = 0;
+    size_t m_StepBytes = 0;
+    double m_TextAverage = 0.0;     // 文本字节的滑动比例，连续文本流开头未对齐的几个字节会逐渐淡出
+    double m_Quality = 0.0;         // 不计样本量的得分
+    bool m_HasNewErrors = false;    // 上次 addData() 之后错误计数有增加
+    int m_Utf8Pending = 0;          // 还差几个 UTF-8 后续字节
+    size_t m_Utf8LeadBytes = 0;     // 未完成的多字节序列已计入的字节数
+    size_t m_FallbackIndex = kNoFallback;   // 已有把握的最高速率候选，正在核实更高的速率
+    unsigned m_DetectedBaudRate = 0;
+    double m_Confidence = 0.0;
+    std::string m_Summary;
+};
+
+#endif // CBAUDDETECTOR_H
@@ -0,0 +1,251 @@
+#include "ccapturefile.h"
+
+#include <algorithm>
+#include <cstring>
+
+const char CaptureFormat::kMagic[8] = {'S', 'P', 'H', 'C', 'A', 'P', '0', '1'};
+
+void CaptureFormat::encodeRecordHeader(char *out, uint64_t timestampNs, uint32_t length)
+{
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<char>((timestampNs >> (8 * i)) & 0xFF);
+    }
+    for (int i = 0; i < 4; ++i) {
+        out[8 + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+}
+
+void CaptureFormat::decodeRecordHeader(const char *in, uint64_t &timestampNs, uint32_t &length)
+{
+    timestampNs = 0;
+    length = 0;
+    for (int i = 0; i < 8; ++i) {
+        timestampNs |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    for (int i = 0; i < 4; ++i) {
+        length |= static_cast<uint32_t>(static_cast<unsigned char>(in[8 + i])) << (8 * i);
+    }
+}
+
+CCaptureWriter::~CCaptureWriter()
+{
+    close();
+}
+
+bool CCaptureWriter::open(const std::string &path, std::string *error)
+{
+    close();
+    m_File.open(path, std::ios::binary | std::ios::trunc);
+    m_IndexFile.open(CCaptureIndex::indexPathFor(path), std::ios::binary | std::ios::trunc);
+    if (!m_File || !m_IndexFile) {
+        if (error) {
+            *error = "Cannot create capture file: " + path;
+        }
+        m_File.close();
+        m_IndexFile.close();
+        return false;
+    }
+    m_File.write(CaptureFormat::kMagic, CaptureFormat::kHeaderSize);
+    m_IndexFile.write(CCaptureIndex::kMagic, sizeof(CCaptureIndex::kMagic));
+    m_Index.clear();
+    m_Offset = CaptureFormat::kHeaderSize;
+    m_LastTimestampNs = 0;
+    return true;
+}
+
+void CCaptureWriter::close()
+{
+    if (m_File.is_open()) {
+        m_File.close();
+    }
+    if (m_IndexFile.is_open()) {
+        m_IndexFile.close();
+    }
+}
+
+bool CCaptureWriter::isOpen() const
+{
+    return m_File.is_open();
+}
+
+bool CCaptureWriter::append(uint64_t timestampNs, const char *data, size_t size)
+{
+    if (!m_File.is_open() || size > UINT32_MAX) {
+        return false;
+    }
+    // 系统时钟可能回拨，记录时间戳钳制为非递减，保证索引可二分
+    timestampNs = std::max(timestampNs, m_LastTimestampNs);
+    m_LastTimestampNs = timestampNs;
+
+    if (m_Index.shouldAdd(timestampNs, m_Offset)) {
+        m_Index.add(timestampNs, m_Offset);
+        char raw[16];
+        for (int i = 0; i < 8; ++i) {
+            raw[i] = static_cast<char>((timestampNs >> (8 * i)) & 0xFF);
+            raw[8 + i] = static_cast<char>((m_Offset >> (8 * i)) & 0xFF);
+        }
+        m_IndexFile.write(raw, sizeof(raw));
+        m_IndexFile.flush();
+    }
+
+    char header[CaptureFormat::kRecordHeaderSize];
+    CaptureFormat::encodeRecordHeader(header, timestampNs, static_cast<uint32_t>(size));
+    m_File.write(header, sizeof(header));
+    m_File.write(data, static_cast<std::streamsize>(size));
+    m_Offset += CaptureFormat::kRecordHeaderSize + size;
+    return static_cast<bool>(m_File);
+}
+
+void CCaptureWriter::flush()
+{
+    m_File.flush();
+    m_IndexFile.flush();
+}
+
+uint64_t CCaptureWriter::bytesWritten() const
+{
+    return m_Offset;
+}
+
+bool CCaptureReader::open(const std::string &path, bool forceReindex, std::string *error)
+{
+    close();
+    m_File.open(path, std::ios::binary);
+    if (!m_File) {
+        if (error) {
+            *error = "Cannot open capture file: " + path;
+        }
+        return false;
+    }
+    char magic[CaptureFormat::kHeaderSize];
+    if (!m_File.read(magic, sizeof(magic)) || std::memcmp(magic, CaptureFormat::kMagic, sizeof(magic)) != 0) {
+        if (error) {
+            *error = "Invalid capture file: " + path;
+        }
+        m_File.close();
+        return false;
+    }
+    m_Path = path;
+    m_File.seekg(0, std::ios::end);
+    m_FileSize = static_cast<uint64_t>(m_File.tellg());
+
+    // 索引缺失或损坏时离线重建并写回，下次打开即可直接使用
+    const std::string indexPath = CCaptureIndex::indexPathFor(path);
+    if (forceReindex || !m_Index.load(indexPath)) {
+        if (!m_Index.rebuild(path, error)) {
+            m_File.close();
+            return false;
+        }
+        m_Index.save(indexPath);
+    }
+    m_Index.truncateTo(m_FileSize);
+
+    m_File.clear();
+    m_File.seekg(static_cast<std::streamoff>(CaptureFormat::kHeaderSize));
+    uint64_t timestampNs = 0;
+    uint32_t length = 0;
+    m_FirstTimestampNs = nextHeader(timestampNs, length) ? timestampNs : 0;
+    m_File.clear();
+    m_File.seekg(static_cast<std::streamoff>(CaptureFormat::kHeaderSize));
+    return true;
+}
+
+void CCaptureReader::close()
+{
+    if (m_File.is_open()) {
+        m_File.close();
+    }
+    m_File.clear();
+    m_Index.clear();
+    m_FileSize = 0;
+    m_FirstTimestampNs = 0;
+}
+
+bool CCaptureReader::seek(uint64_t timestampNs)
+{
+    if (!m_File.is_open()) {
+        return false;
+    }
+    m_File.clear();
+    m_File.seekg(static_cast<std::streamoff>(m_Index.offsetBefore(timestampNs, CaptureFormat::kHeaderSize)));
+
+    // 最多扫描一个索引间隔的记录头
+    while (true) {
+        const std::streamoff recordStart = m_File.tellg();
+        uint64_t recordTs = 0;
+        uint32_t length = 0;
+        if (!nextHeader(recordTs, length)) {
+            return false;
+        }
+        if (recordTs >= timestampNs) {
+            m_File.clear();
+            m_File.seekg(recordStart);
+            return true;
+        }
+    }
+}
+
+bool CCaptureReader::nextHeader(uint64_t &timestampNs, uint32_t &length)
+{
+    char header[CaptureFormat::kRecordHeaderSize];
+    if (!m_File.read(header, sizeof(header))) {
+        return false;
+    }
+    CaptureFormat::decodeRecordHeader(header, timestampNs, length);
+    m_File.seekg(length, std::ios::cur);
+    return static_cast<uint64_t>(m_File.tellg()) <= m_FileSize;
+}
+
+bool CCaptureReader::next(CCaptureRecord &record)
+{
+    char header[CaptureFormat::kRecordHeaderSize];
+    record.offset = static_cast<uint64_t>(m_File.tellg());
+    if (!m_File.read(header, sizeof(header))) {
+        return false;
+    }
+    uint32_t length = 0;
+    CaptureFormat::decodeRecordHeader(header, record.timestampNs, length);
+    // 录制中断导致的半条记录视为文件结束；长度来自文件，先核对剩余大小，损坏的记录头不会触发大块分配
+    const uint64_t dataStart = static_cast<uint64_t>(m_File.tellg());
+    if (dataStart > m_FileSize || length > m_FileSize - dataStart) {
+        return false;
+    }
+    record.data.resize(length);
+    return length == 0 || static_cast<bool>(m_File.read(record.data.data(), length));
+}
+
+uint64_t CCaptureReader::firstTimestampNs() const
+{
+    return m_FirstTimestampNs;
+}
+
+uint64_t CCaptureReader::lastTimestampNs()
+{
+    if (!m_File.is_open()) {
+        return 0;
+    }
+    const std::streamoff position = m_File.tellg();
+    m_File.clear();
+    const auto &entries = m_Index.entries();
+    m_File.seekg(static_cast<std::streamoff>(entries.empty() ? CaptureFormat::kHeaderSize : entries.back().offset));
+
+    uint64_t last = m_FirstTimestampNs;
+    uint64_t timestampNs = 0;
+    uint32_t length = 0;
+    while (nextHeader(timestampNs, length)) {
+        last = timestampNs;
+    }
+    m_File.clear();
+    m_File.seekg(position);
+    return last;
+}
+
+uint64_t CCaptureReader::fileSize() const
+{
+    return m_FileSize;
+}
+
+const CCaptureIndex &CCaptureReader::index() const
+{
+    return m_Index;
+}
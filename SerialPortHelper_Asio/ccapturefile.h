@@ -0,0 +1,83 @@
+#ifndef CCAPTUREFILE_H
+#define CCAPTUREFILE_H
+#include "ccaptureindex.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// 捕获文件格式（小端）：
+//   文件头  : 8 字节魔数 "SPHCAP01"
+//   每条记录: u64 时间戳(纳秒, Unix 纪元) + u32 负载长度 + 负载
+// 记录按时间戳非递减排列，稀疏索引保存在旁路文件 <capture>.idx 中
+namespace CaptureFormat
+{
+constexpr uint64_t kHeaderSize = 8;
+constexpr uint64_t kRecordHeaderSize = 12;
+extern const char kMagic[8];
+
+void encodeRecordHeader(char *out, uint64_t timestampNs, uint32_t length);
+void decodeRecordHeader(const char *in, uint64_t &timestampNs, uint32_t &length);
+}
+
+struct CCaptureRecord
+{
+    uint64_t timestampNs = 0;
+    uint64_t offset = 0;
+    std::vector<char> data;
+};
+
+// 录制端：追加记录，同时增量维护索引并追加写入 .idx
+class CCaptureWriter
+{
+public:
+    CCaptureWriter() = default;
+    ~CCaptureWriter();
+    CCaptureWriter(const CCaptureWriter &) = delete;
+    CCaptureWriter &operator=(const CCaptureWriter &) = delete;
+
+    bool open(const std::string &path, std::string *error = nullptr);
+    void close();
+    bool isOpen() const;
+
+    bool append(uint64_t timestampNs, const char *data, size_t size);
+    void flush();
+
+    uint64_t bytesWritten() const;
+
+private:
+    std::ofstream m_File;
+    std::ofstream m_IndexFile;
+    CCaptureIndex m_Index;
+    uint64_t m_Offset = 0;
+    uint64_t m_LastTimestampNs = 0;
+};
+
+// 读取端：打开时加载索引（缺失或损坏时重建），支持按时间戳定位后顺序读取
+class CCaptureReader
+{
+public:
+    bool open(const std::string &path, bool forceReindex = false, std::string *error = nullptr);
+    void close();
+
+    // 定位到第一条时间戳 >= timestampNs 的记录，之后 next() 从该记录开始
+    bool seek(uint64_t timestampNs);
+    bool next(CCaptureRecord &record);
+    // 只读记录头，跳过负载
+    bool nextHeader(uint64_t &timestampNs, uint32_t &length);
+
+    uint64_t firstTimestampNs() const;
+    uint64_t lastTimestampNs();
+    uint64_t fileSize() const;
+    const CCaptureIndex &index() const;
+
+private:
+    std::ifstream m_File;
+    std::string m_Path;
+    CCaptureIndex m_Index;
+    uint64_t m_FileSize = 0;
+    uint64_t m_FirstTimestampNs = 0;
+};
+
+#endif // CCAPTUREFILE_H
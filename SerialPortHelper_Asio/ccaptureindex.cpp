@@ -0,0 +1,159 @@
+#include "ccaptureindex.h"
+#include "ccapturefile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+const char CCaptureIndex::kMagic[8] = {'S', 'P', 'H', 'I', 'D', 'X', '0', '1'};
+
+namespace
+{
+void putU64(char *out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint64_t getU64(const char *in)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+void setError(std::string *error, const std::string &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+}
+
+std::string CCaptureIndex::indexPathFor(const std::string &capturePath)
+{
+    return capturePath + ".idx";
+}
+
+void CCaptureIndex::clear()
+{
+    m_Entries.clear();
+}
+
+bool CCaptureIndex::empty() const
+{
+    return m_Entries.empty();
+}
+
+const std::vector<CCaptureIndex::Entry> &CCaptureIndex::entries() const
+{
+    return m_Entries;
+}
+
+bool CCaptureIndex::shouldAdd(uint64_t timestampNs, uint64_t offset) const
+{
+    if (m_Entries.empty()) {
+        return true;
+    }
+    const Entry &last = m_Entries.back();
+    return offset - last.offset >= kByteInterval || timestampNs - last.timestampNs >= kTimeIntervalNs;
+}
+
+void CCaptureIndex::add(uint64_t timestampNs, uint64_t offset)
+{
+    m_Entries.push_back({timestampNs, offset});
+}
+
+void CCaptureIndex::truncateTo(uint64_t fileSize)
+{
+    while (!m_Entries.empty() && m_Entries.back().offset >= fileSize) {
+        m_Entries.pop_back();
+    }
+}
+
+uint64_t CCaptureIndex::offsetBefore(uint64_t timestampNs, uint64_t fallback) const
+{
+    // 严格小于：索引条目之前的记录时间戳都不大于该条目，可以安全跳过
+    auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), timestampNs,
+                               [](const Entry &entry, uint64_t ts) { return entry.timestampNs < ts; });
+    if (it == m_Entries.begin()) {
+        return fallback;
+    }
+    return std::prev(it)->offset;
+}
+
+bool CCaptureIndex::load(const std::string &indexPath, std::string *error)
+{
+    m_Entries.clear();
+    std::ifstream file(indexPath, std::ios::binary);
+    if (!file) {
+        setError(error, "Cannot open index file: " + indexPath);
+        return false;
+    }
+    char magic[sizeof(kMagic)];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        setError(error, "Invalid index file: " + indexPath);
+        return false;
+    }
+    char raw[16];
+    while (file.read(raw, sizeof(raw))) {
+        Entry entry{getU64(raw), getU64(raw + 8)};
+        if (!m_Entries.empty() && (entry.timestampNs < m_Entries.back().timestampNs
+                                   || entry.offset <= m_Entries.back().offset)) {
+            m_Entries.clear();
+            setError(error, "Index entries out of order: " + indexPath);
+            return false;
+        }
+        m_Entries.push_back(entry);
+    }
+    return true;
+}
+
+bool CCaptureIndex::save(const std::string &indexPath, std::string *error) const
+{
+    std::ofstream file(indexPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        setError(error, "Cannot write index file: " + indexPath);
+        return false;
+    }
+    file.write(kMagic, sizeof(kMagic));
+    char raw[16];
+    for (const Entry &entry : m_Entries) {
+        putU64(raw, entry.timestampNs);
+        putU64(raw + 8, entry.offset);
+        file.write(raw, sizeof(raw));
+    }
+    return static_cast<bool>(file);
+}
+
+bool CCaptureIndex::rebuild(const std::string &capturePath, std::string *error)
+{
+    m_Entries.clear();
+    std::ifstream file(capturePath, std::ios::binary);
+    if (!file) {
+        setError(error, "Cannot open capture file: " + capturePath);
+        return false;
+    }
+    char magic[CaptureFormat::kHeaderSize];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, CaptureFormat::kMagic, sizeof(magic)) != 0) {
+        setError(error, "Invalid capture file: " + capturePath);
+        return false;
+    }
+
+    uint64_t offset = CaptureFormat::kHeaderSize;
+    char header[CaptureFormat::kRecordHeaderSize];
+    while (file.read(header, sizeof(header))) {
+        uint64_t timestampNs = 0;
+        uint32_t length = 0;
+        CaptureFormat::decodeRecordHeader(header, timestampNs, length);
+        if (shouldAdd(timestampNs, offset)) {
+            add(timestampNs, offset);
+        }
+        offset += CaptureFormat::kRecordHeaderSize + length;
+        file.seekg(static_cast<std::streamoff>(offset));
+    }
+    return true;
+}
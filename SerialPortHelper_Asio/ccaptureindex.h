@@ -0,0 +1,47 @@
+#ifndef CCAPTUREINDEX_H
+#define CCAPTUREINDEX_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 捕获文件的稀疏索引：每隔一段字节数或一段时间记录一条 (时间戳, 文件偏移)，
+// 按时间戳定位时先二分索引，再在一个索引间隔内顺序扫描，整体 O(log n)
+class CCaptureIndex
+{
+public:
+    struct Entry
+    {
+        uint64_t timestampNs;
+        uint64_t offset;
+    };
+
+    static constexpr uint64_t kByteInterval = 256 * 1024;       // 至少每 256 KiB 一条
+    static constexpr uint64_t kTimeIntervalNs = 1000000000ULL;  // 至少每 1 s 一条
+
+    // 索引文件与捕获文件放在一起：<capture>.idx
+    static std::string indexPathFor(const std::string &capturePath);
+
+    void clear();
+    bool empty() const;
+    const std::vector<Entry> &entries() const;
+
+    bool shouldAdd(uint64_t timestampNs, uint64_t offset) const;
+    void add(uint64_t timestampNs, uint64_t offset);
+    // 丢弃偏移超出文件大小的条目（录制中途崩溃时索引可能比数据先落盘）
+    void truncateTo(uint64_t fileSize);
+
+    // 返回时间戳严格小于 timestampNs 的最后一条索引的偏移，没有则返回 fallback
+    uint64_t offsetBefore(uint64_t timestampNs, uint64_t fallback) const;
+
+    bool load(const std::string &indexPath, std::string *error = nullptr);
+    bool save(const std::string &indexPath, std::string *error = nullptr) const;
+    // 离线重建：只读记录头并跳过负载
+    bool rebuild(const std::string &capturePath, std::string *error = nullptr);
+
+    static const char kMagic[8];
+
+private:
+    std::vector<Entry> m_Entries;
+};
+
+#endif // CCAPTUREINDEX_H
@@ -0,0 +1,398 @@
+#include "cdeviceemulator.h"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr size_t kReadSize = 4096;
+// 读取出错（设备被拔出等）后重试的间隔
+constexpr std::chrono::milliseconds kReadRetryInterval{100};
+// stop() 等待 I/O 线程执行关闭的上限
+constexpr std::chrono::seconds kStopTimeout{2};
+}
+
+struct CDeviceEmulator::State : std::enable_shared_from_this<State>
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingReply
+    {
+        Clock::time_point due;
+        std::vector<uint8_t> bytes;
+    };
+
+    State(boost::asio::io_context &ioContext, CDeviceRules rules)
+        : port(ioContext)
+        , rules(std::move(rules))
+        , gapTimer(ioContext)
+        , replyTimer(ioContext)
+        , readRetryTimer(ioContext)
+    {
+        stats.isRunning = true;
+        stats.ruleMatches.resize(this->rules.ruleCount());
+    }
+
+    void startRead();
+    void handleRead(const boost::system::error_code &error, size_t size);
+    void processInput(bool isIdle);
+    void armGapTimer();
+    void enqueue(Clock::time_point due, std::vector<uint8_t> bytes);
+    void flush();
+    void startPeriodic(size_t index, Clock::time_point due);
+    void shutdown();
+
+    boost::asio::serial_port port;
+    int slaveFd = -1;   // 新建的 pty 一直持有从设备，被测程序关闭重开之间主设备不会读到挂断
+    CDeviceRules rules;
+    std::chrono::microseconds frameGap{0};
+    std::array<uint8_t, kReadSize> readBuffer{};
+    std::vector<uint8_t> input;
+    CDeviceRules::Match match;
+    boost::asio::steady_timer gapTimer;
+    std::deque<PendingReply> replies;
+    Clock::time_point lastDue;
+    boost::asio::steady_timer replyTimer;
+    bool isReplyTimerArmed = false;
+    std::vector<uint8_t> outgoing;
+    bool isWriting = false;
+    uint64_t outgoingReplies = 0;
+    boost::asio::steady_timer readRetryTimer;
+    std::vector<CDeviceRules::Periodic> periodic;
+    std::vector<std::unique_ptr<boost::asio::steady_timer>> periodicTimers;
+    std::atomic<bool> isRunning{true};
+
+    mutable std::mutex statsMutex;
+    Stats stats;
+};
+
+void CDeviceEmulator::State::startRead()
+{
+    auto self = shared_from_this();
+    port.async_read_some(boost::asio::buffer(readBuffer), [self](const boost::system::error_code &error, size_t size) {
+        self->handleRead(error, size);
+    });
+}
+
+void CDeviceEmulator::State::handleRead(const boost::system::error_code &error, size_t size)
+{
+    if (!isRunning.load() || error == boost::asio::error::operation_aborted) {
+        return;
+    }
+    if (error) {
+        // 现有串口被拔出时稍后再试，不让出错的读取空转
+        auto self = shared_from_this();
+        readRetryTimer.expires_after(kReadRetryInterval);
+        readRetryTimer.async_wait([self](const boost::system::error_code &waitError) {
+            if (!waitError && self->isRunning.load()) {
+                self->startRead();
+            }
+        });
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.bytesIn += size;
+    }
+    input.insert(input.end(), readBuffer.begin(), readBuffer.begin() + static_cast<std::ptrdiff_t>(size));
+    processInput(false);
+    startRead();
+}
+
+void CDeviceEmulator::State::processInput(bool isIdle)
+{
+    const auto now = Clock::now();
+    size_t offset = 0;
+    uint64_t frames = 0;
+    uint64_t unmatched = 0;
+    std::vector<int> matchedRules;
+    while (offset < input.size()) {
+        const auto result = rules.match(input.data() + offset, input.size() - offset, &match);
+        if (result == CDeviceRules::Matched) {
+            std::vector<uint8_t> reply;
+            rules.render(match, input.data() + offset, &reply);
+            if (!reply.empty()) {
+                enqueue(now + rules.delay(match.rule), std::move(reply));
+            }
+            matchedRules.push_back(match.rule);
+            ++frames;
+            offset += match.length;
+        } else if (result == CDeviceRules::NoMatch || isIdle) {
+            // 空闲超时时仍是半帧，说明起点的字节是残帧或噪声
+            ++unmatched;
+            ++offset;
+        } else {
+            break;
+        }
+    }
+    input.erase(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(offset));
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.frames += frames;
+        stats.unmatchedBytes += unmatched;
+        for (int rule : matchedRules) {
+            ++stats.ruleMatches[static_cast<size_t>(rule)];
+        }
+    }
+    if (!input.empty()) {
+        armGapTimer();
+    }
+    flush();
+}
+
+void CDeviceEmulator::State::armGapTimer()
+{
+    // 每次读到数据都重新计时，重新设置会取消上一次等待
+    auto self = shared_from_this();
+    gapTimer.expires_after(frameGap);
+    gapTimer.async_wait([self](const boost::system::error_code &error) {
+        if (!error && self->isRunning.load() && !self->input.empty()) {
+            self->processInput(true);
+        }
+    });
+}
+
+void CDeviceEmulator::State::enqueue(Clock::time_point due, std::vector<uint8_t> bytes)
+{
+    // 应答按顺序发出，延时短的不能越过前面尚未到期的
+    due = std::max(due, lastDue);
+    lastDue = due;
+    replies.push_back({due, std::move(bytes)});
+}
+
+void CDeviceEmulator::State::flush()
+{
+    if (!isRunning.load()) {
+        return;
+    }
+    const auto now = Clock::now();
+    if (!isWriting) {
+        // 到期的应答合并成一次写入
+        outgoingReplies = 0;
+        while (!replies.empty() && replies.front().due <= now) {
+            outgoing.insert(outgoing.end(), replies.front().bytes.begin(), replies.front().bytes.end());
+            replies.pop_front();
+            ++outgoingReplies;
+        }
+        if (!outgoing.empty()) {
+            isWriting = true;
+            auto self = shared_from_this();
+            boost::asio::async_write(port, boost::asio::buffer(outgoing),
+                                     [self](const boost::system::error_code &error, size_t size) {
+                                         self->isWriting = false;
+                                         self->outgoing.clear();
+                                         if (error) {
+                                             return;
+                                         }
+                                         {
+                                             std::lock_guard<std::mutex> lock(self->statsMutex);
+                                             self->stats.bytesOut += size;
+                                             self->stats.replies += self->outgoingReplies;
+                                         }
+                                         self->flush();
+                                     });
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.queuedReplies = replies.size();
+    }
+    if (!replies.empty() && !isReplyTimerArmed && replies.front().due > now) {
+        isReplyTimerArmed = true;
+        auto self = shared_from_this();
+        replyTimer.expires_at(replies.front().due);
+        replyTimer.async_wait([self](const boost::system::error_code &error) {
+            self->isReplyTimerArmed = false;
+            if (!error) {
+                self->flush();
+            }
+        });
+    }
+}
+
+void CDeviceEmulator::State::startPeriodic(size_t index, Clock::time_point due)
+{
+    auto self = shared_from_this();
+    boost::asio::steady_timer &timer = *periodicTimers[index];
+    timer.expires_at(due);
+    timer.async_wait([self, index, due](const boost::system::error_code &error) {
+        if (error || !self->isRunning.load()) {
+            return;
+        }
+        const CDeviceRules::Periodic &periodic = self->periodic[index];
+        CDeviceRules::Match match;
+        match.rule = periodic.rule;
+        std::vector<uint8_t> bytes;
+        self->rules.render(match, nullptr, &bytes);
+        const auto now = Clock::now();
+        self->enqueue(now, std::move(bytes));
+        {
+            std::lock_guard<std::mutex> lock(self->statsMutex);
+            ++self->stats.periodicFrames;
+            ++self->stats.ruleMatches[static_cast<size_t>(periodic.rule)];
+        }
+        self->flush();
+        // 按固定节拍发送，落后超过一个周期时不补发
+        auto next = due + periodic.period;
+        if (next < now) {
+            next = now + periodic.period;
+        }
+        self->startPeriodic(index, next);
+    });
+}
+
+void CDeviceEmulator::State::shutdown()
+{
+    isRunning.store(false);
+    boost::system::error_code ec;
+    gapTimer.cancel(ec);
+    replyTimer.cancel(ec);
+    readRetryTimer.cancel(ec);
+    for (auto &timer : periodicTimers) {
+        timer->cancel(ec);
+    }
+    port.close(ec);
+#if !defined(_WIN32)
+    if (slaveFd >= 0) {
+        ::close(slaveFd);
+        slaveFd = -1;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.isRunning = false;
+}
+
+CDeviceEmulator::CDeviceEmulator(boost::asio::io_context &ioContext)
+    : m_IoContext(ioContext)
+{
+}
+
+CDeviceEmulator::~CDeviceEmulator()
+{
+    stop();
+}
+
+bool CDeviceEmulator::start(CDeviceRules rules, const Options &options, std::string *error)
+{
+    if (isRunning()) {
+        if (error) {
+            *error = "Emulator is already running";
+        }
+        return false;
+    }
+    auto state = std::make_shared<State>(m_IoContext, std::move(rules));
+    state->frameGap = options.frameGap;
+    std::string devicePath = options.device;
+    try {
+        if (options.device.empty()) {
+#if defined(_WIN32)
+            if (error) {
+                *error = "Creating a pty is not supported on Windows; pass one end of a virtual serial port pair";
+            }
+            return false;
+#else
+            const int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+            if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0) {
+                if (master >= 0) {
+                    ::close(master);
+                }
+                if (error) {
+                    *error = "Failed to create a pty";
+                }
+                return false;
+            }
+            devicePath = ::ptsname(master);
+            // 原始模式：不回显、不做行处理，被测程序打开后仍会按自己的参数重新设置
+            termios settings{};
+            if (::tcgetattr(master, &settings) == 0) {
+                ::cfmakeraw(&settings);
+                ::tcsetattr(master, TCSANOW, &settings);
+            }
+            state->slaveFd = ::open(devicePath.c_str(), O_RDWR | O_NOCTTY);
+            state->port.assign(master);
+#endif
+        } else {
+            state->port.open(options.device);
+            state->port.set_option(boost::asio::serial_port::baud_rate(options.baudRate));
+            state->port.set_option(boost::asio::serial_port::character_size(8));
+            state->port.set_option(boost::asio::serial_port::parity(boost::asio::serial_port::parity::none));
+            state->port.set_option(boost::asio::serial_port::stop_bits(boost::asio::serial_port::stop_bits::one));
+            state->port.set_option(boost::asio::serial_port::flow_control(boost::asio::serial_port::flow_control::none));
+        }
+    } catch (const boost::system::system_error &e) {
+        if (error) {
+            *error = "Failed to open " + (options.device.empty() ? std::string("pty") : options.device) + ": " + e.what();
+        }
+        state->shutdown();
+        return false;
+    }
+    m_DevicePath = devicePath;
+    m_p_State = state;
+    boost::asio::post(m_IoContext, [state]() {
+        if (!state->isRunning.load()) {
+            return;
+        }
+        const auto now = State::Clock::now();
+        state->periodic = state->rules.periodicRules();
+        for (size_t i = 0; i < state->periodic.size(); ++i) {
+            state->periodicTimers.push_back(std::make_unique<boost::asio::steady_timer>(state->port.get_executor()));
+            state->startPeriodic(i, now + state->periodic[i].period);
+        }
+        state->startRead();
+    });
+    return true;
+}
+
+void CDeviceEmulator::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    // 保留 m_p_State 供 stats() 读取最后的统计
+    auto state = m_p_State;
+    if (m_IoContext.get_executor().running_in_this_thread() || m_IoContext.stopped()) {
+        // 在 I/O 线程上，或 io_context 已停止（I/O 线程已退出）不会再执行回调，直接关闭
+        state->shutdown();
+        return;
+    }
+    auto done = std::make_shared<std::promise<void>>();
+    auto finished = done->get_future();
+    boost::asio::post(m_IoContext, [state, done]() {
+        state->shutdown();
+        done->set_value();
+    });
+    if (finished.wait_for(kStopTimeout) == std::future_status::timeout) {
+        // 没有线程在运行 io_context：回调不再继续收发，串口在投递的关闭执行或 io_context 销毁时释放
+        state->isRunning.store(false);
+    }
+}
+
+bool CDeviceEmulator::isRunning() const
+{
+    return m_p_State && m_p_State->isRunning.load();
+}
+
+std::string CDeviceEmulator::devicePath() const
+{
+    return m_DevicePath;
+}
+
+CDeviceEmulator::Stats CDeviceEmulator::stats() const
+{
+    if (!m_p_State) {
+        return Stats();
+    }
+    std::lock_guard<std::mutex> lock(m_p_State->statsMutex);
+    return m_p_State->stats;
+}
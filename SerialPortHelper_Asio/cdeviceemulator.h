@@ -0,0 +1,62 @@
+#ifndef CDEVICEEMULATOR_H
+#define CDEVICEEMULATOR_H
+#include "cdevicerules.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+
+// 虚拟设备：接在 pty 对（或虚拟串口对、零调制解调器线）的另一端，按 CDeviceRules 的规则表应答，
+// 被测程序照常打开 devicePath()。既可在没有硬件时代替设备，也可作为 CSerialPortManager 的负载源。
+// 全部收发都在 io_context 的线程上完成：读到的数据追加到输入缓冲后逐帧匹配，匹配到的应答按 delay 排队，
+// 到期的应答合并成一次写入；应答按请求顺序发出，前一条的延时会推迟后一条（与真实设备逐条处理一致）。
+// 缓冲起点不属于任何规则时逐字节丢弃；可能是某条规则的前缀（或有正则规则）时等待，
+// 线路空闲超过 frameGap 仍未凑成一帧就丢弃第一个字节重新匹配
+// 公共接口可在任意线程调用；stop()（及析构）在 io_context 已停止时直接在调用线程上关闭，
+// io_context 未停止却没有线程运行它时最多等待 2 s，之后只停止收发，串口留到 io_context 再运行或销毁时关闭
+class CDeviceEmulator
+{
+public:
+    struct Options
+    {
+        std::string device;              // 为空时新建 pty 对（仅 POSIX）
+        unsigned baudRate = 115200;      // 打开现有串口时使用，pty 没有波特率
+        std::chrono::microseconds frameGap{5000};
+    };
+
+    struct Stats
+    {
+        bool isRunning = false;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+        uint64_t frames = 0;            // 匹配到规则的请求帧
+        uint64_t replies = 0;           // 写出的应答（含周期发送）
+        uint64_t periodicFrames = 0;
+        uint64_t unmatchedBytes = 0;    // 不属于任何规则而丢弃的字节
+        uint64_t queuedReplies = 0;     // 等待延时到期或写出的应答
+        std::vector<uint64_t> ruleMatches;   // 按规则表顺序，周期规则为发送次数
+    };
+
+    explicit CDeviceEmulator(boost::asio::io_context &ioContext);
+    ~CDeviceEmulator();
+
+    bool start(CDeviceRules rules, const Options &options, std::string *error);
+    // 返回后不再读写设备；pty 随之关闭，被测程序一端读到挂断
+    void stop();
+    bool isRunning() const;
+    // 被测程序要打开的设备：新建的 pty 为从设备路径，否则为 Options::device
+    std::string devicePath() const;
+    Stats stats() const;
+
+private:
+    struct State;
+
+    boost::asio::io_context &m_IoContext;
+    std::shared_ptr<State> m_p_State;
+    std::string m_DevicePath;
+};
+
+#endif // CDEVICEEMULATOR_H
@@ -0,0 +1,701 @@
+#include "cdevicerules.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <regex>
+#include <sstream>
+
+namespace
+{
+constexpr size_t kWholeInput = std::numeric_limits<size_t>::max();
+
+enum ChecksumKind
+{
+    CrcModbus,
+    CrcCcitt,
+    CrcXmodem,
+    Crc32,
+    Sum8,
+    Xor8
+};
+
+int checksumWidth(ChecksumKind kind)
+{
+    switch (kind) {
+    case Crc32:
+        return 4;
+    case Sum8:
+    case Xor8:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+// 低字节在前的校验
+bool isLittleEndian(ChecksumKind kind)
+{
+    return kind == CrcModbus || kind == Crc32;
+}
+
+// 查表计算，每字节一次查表；表在第一次使用时生成
+uint32_t computeChecksum(ChecksumKind kind, const uint8_t *data, size_t size)
+{
+    switch (kind) {
+    case CrcModbus: {
+        static const auto table = []() {
+            std::array<uint16_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint16_t crc = static_cast<uint16_t>(i);
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+                }
+                t[i] = crc;
+            }
+            return t;
+        }();
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < size; ++i) {
+            crc = static_cast<uint16_t>((crc >> 8) ^ table[(crc ^ data[i]) & 0xFF]);
+        }
+        return crc;
+    }
+    case CrcCcitt:
+    case CrcXmodem: {
+        static const auto table = []() {
+            std::array<uint16_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint16_t crc = static_cast<uint16_t>(i << 8);
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+                }
+                t[i] = crc;
+            }
+            return t;
+        }();
+        uint16_t crc = kind == CrcCcitt ? 0xFFFF : 0x0000;
+        for (size_t i = 0; i < size; ++i) {
+            crc = static_cast<uint16_t>((crc << 8) ^ table[((crc >> 8) ^ data[i]) & 0xFF]);
+        }
+        return crc;
+    }
+    case Crc32: {
+        static const auto table = []() {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                t[i] = crc;
+            }
+            return t;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i) {
+            crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xFF];
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+    case Sum8: {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < size; ++i) {
+            sum = static_cast<uint8_t>(sum + data[i]);
+        }
+        return sum;
+    }
+    case Xor8: {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < size; ++i) {
+            sum ^= data[i];
+        }
+        return sum;
+    }
+    }
+    return 0;
+}
+
+// 校验按线路上的字节序展开；:hex 时按数值从高到低输出大写十六进制文本
+void encodeChecksum(ChecksumKind kind, bool asHex, uint32_t value, std::vector<uint8_t> *out)
+{
+    const int width = checksumWidth(kind);
+    if (asHex) {
+        static const char digits[] = "0123456789ABCDEF";
+        for (int nibble = width * 2 - 1; nibble >= 0; --nibble) {
+            out->push_back(static_cast<uint8_t>(digits[(value >> (nibble * 4)) & 0xF]));
+        }
+        return;
+    }
+    for (int i = 0; i < width; ++i) {
+        const int shift = isLittleEndian(kind) ? i * 8 : (width - 1 - i) * 8;
+        out->push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+std::string trimmed(const std::string &text)
+{
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+bool startsWithWord(const std::string &text, const char *word)
+{
+    const size_t length = std::strlen(word);
+    return text.compare(0, length, word) == 0 && (text.size() == length || std::isspace(static_cast<unsigned char>(text[length])));
+}
+
+// 引号外的第一个 "=>"
+size_t findArrow(const std::string &line)
+{
+    bool isQuoted = false;
+    for (size_t i = 0; i + 1 < line.size(); ++i) {
+        if (isQuoted && line[i] == '\\') {
+            ++i;
+        } else if (line[i] == '"') {
+            isQuoted = !isQuoted;
+        } else if (!isQuoted && line[i] == '=' && line[i + 1] == '>') {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+bool parseSize(const std::string &text, size_t *value)
+{
+    if (text.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    const unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+    if (*end != '\0' || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    *value = static_cast<size_t>(parsed);
+    return true;
+}
+}
+
+struct CDeviceRules::Element
+{
+    enum Kind
+    {
+        Literal,
+        Wildcard,
+        Input,
+        Group,
+        Checksum,
+        Mark,
+        Sequence,
+        Random
+    };
+
+    Kind kind = Literal;
+    std::vector<uint8_t> bytes;   // Literal
+    size_t offset = 0;            // Input 的起点，Group 的组号
+    size_t length = 0;            // Input 的长度（kWholeInput 为到末尾），Random 的字节数
+    ChecksumKind checksum = CrcModbus;
+    bool asHex = false;
+
+    // 在匹配中占的字节数
+    size_t width() const
+    {
+        switch (kind) {
+        case Literal:
+            return bytes.size();
+        case Wildcard:
+            return 1;
+        case Checksum:
+            return static_cast<size_t>(checksumWidth(checksum)) * (asHex ? 2 : 1);
+        default:
+            return 0;
+        }
+    }
+};
+
+struct CDeviceRules::Rule
+{
+    int line = 0;
+    std::string text;
+    bool isPeriodic = false;
+    bool isRegex = false;
+    std::chrono::microseconds period{0};
+    std::chrono::microseconds delay{0};
+    std::regex regex;
+    size_t groupCount = 0;
+    std::vector<Element> match;
+    std::vector<Element> reply;
+    uint8_t sequence = 0;
+};
+
+CDeviceRules::CDeviceRules()
+    : m_Random(std::random_device{}())
+{
+}
+
+CDeviceRules::~CDeviceRules() = default;
+CDeviceRules::CDeviceRules(CDeviceRules &&) noexcept = default;
+CDeviceRules &CDeviceRules::operator=(CDeviceRules &&) noexcept = default;
+
+bool CDeviceRules::parseDuration(const std::string &text, std::chrono::microseconds *duration)
+{
+    char *end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0.0) {
+        return false;
+    }
+    const std::string unit = end;
+    double scale = 0.0;
+    if (unit == "us") {
+        scale = 1.0;
+    } else if (unit == "ms") {
+        scale = 1e3;
+    } else if (unit == "s") {
+        scale = 1e6;
+    } else {
+        return false;
+    }
+    *duration = std::chrono::microseconds(static_cast<long long>(value * scale + 0.5));
+    return true;
+}
+
+bool CDeviceRules::parseTemplate(const std::string &text, bool isMatch, std::vector<Element> *elements,
+                                 std::string *error)
+{
+    size_t i = 0;
+    while (i < text.size()) {
+        const char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+        Element element;
+        if (c == '"') {
+            // 字符串
+            element.kind = Element::Literal;
+            ++i;
+            bool isClosed = false;
+            while (i < text.size()) {
+                char ch = text[i++];
+                if (ch == '"') {
+                    isClosed = true;
+                    break;
+                }
+                if (ch == '\\' && i < text.size()) {
+                    const char escape = text[i++];
+                    switch (escape) {
+                    case 'r': ch = '\r'; break;
+                    case 'n': ch = '\n'; break;
+                    case 't': ch = '\t'; break;
+                    case '0': ch = '\0'; break;
+                    case 'x': {
+                        const int high = i < text.size() ? hexValue(text[i]) : -1;
+                        const int low = i + 1 < text.size() ? hexValue(text[i + 1]) : -1;
+                        if (high < 0 || low < 0) {
+                            *error = "invalid \\x escape";
+                            return false;
+                        }
+                        ch = static_cast<char>(high * 16 + low);
+                        i += 2;
+                        break;
+                    }
+                    default: ch = escape; break;
+                    }
+                }
+                element.bytes.push_back(static_cast<uint8_t>(ch));
+            }
+            if (!isClosed) {
+                *error = "unterminated string";
+                return false;
+            }
+        } else if (c == '{') {
+            const size_t close = text.find('}', i);
+            if (close == std::string::npos) {
+                *error = "unterminated {";
+                return false;
+            }
+            const std::string token = text.substr(i + 1, close - i - 1);
+            i = close + 1;
+            std::vector<std::string> parts;
+            std::stringstream stream(token);
+            for (std::string part; std::getline(stream, part, ':');) {
+                parts.push_back(part);
+            }
+            const std::string name = parts.empty() ? std::string() : parts[0];
+            const bool asHex = parts.size() > 1 && parts.back() == "hex";
+            if (asHex) {
+                parts.pop_back();
+            }
+            if (name == "mark" && parts.size() == 1) {
+                element.kind = Element::Mark;
+            } else if ((name == "sum8" || name == "xor8") && parts.size() == 1) {
+                element.kind = Element::Checksum;
+                element.checksum = name == "sum8" ? Sum8 : Xor8;
+                element.asHex = asHex;
+            } else if (name == "crc" && parts.size() == 2) {
+                element.kind = Element::Checksum;
+                element.asHex = asHex;
+                if (parts[1] == "modbus") {
+                    element.checksum = CrcModbus;
+                } else if (parts[1] == "ccitt") {
+                    element.checksum = CrcCcitt;
+                } else if (parts[1] == "xmodem") {
+                    element.checksum = CrcXmodem;
+                } else if (parts[1] == "crc32") {
+                    element.checksum = Crc32;
+                } else {
+                    *error = "unknown checksum {" + token + "}";
+                    return false;
+                }
+            } else if (isMatch) {
+                *error = "{" + token + "} is only allowed in replies";
+                return false;
+            } else if (name == "in" && parts.size() <= 3) {
+                element.kind = Element::Input;
+                element.length = parts.size() == 1 ? kWholeInput : 1;
+                if ((parts.size() > 1 && !parseSize(parts[1], &element.offset))
+                    || (parts.size() > 2 && !parseSize(parts[2], &element.length))) {
+                    *error = "invalid {" + token + "}";
+                    return false;
+                }
+            } else if (name == "seq" && parts.size() == 1) {
+                element.kind = Element::Sequence;
+            } else if (name == "rand" && parts.size() == 2 && parseSize(parts[1], &element.length)) {
+                element.kind = Element::Random;
+            } else if (parts.size() == 1 && parseSize(name, &element.offset) && element.offset <= 9) {
+                element.kind = Element::Group;
+            } else {
+                *error = "unknown {" + token + "}";
+                return false;
+            }
+        } else {
+            size_t end = i;
+            while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end]))) {
+                ++end;
+            }
+            const std::string word = text.substr(i, end - i);
+            i = end;
+            if (word == "??") {
+                if (!isMatch) {
+                    *error = "?? is only allowed in matches";
+                    return false;
+                }
+                element.kind = Element::Wildcard;
+            } else {
+                // 十六进制字节，可连写
+                element.kind = Element::Literal;
+                if (word.size() % 2 != 0) {
+                    *error = "odd number of hex digits in '" + word + "'";
+                    return false;
+                }
+                for (size_t k = 0; k < word.size(); k += 2) {
+                    const int high = hexValue(word[k]);
+                    const int low = hexValue(word[k + 1]);
+                    if (high < 0 || low < 0) {
+                        *error = "invalid hex byte in '" + word + "'";
+                        return false;
+                    }
+                    element.bytes.push_back(static_cast<uint8_t>(high * 16 + low));
+                }
+            }
+        }
+        // 相邻字面量合并，匹配时少一次分支
+        if (element.kind == Element::Literal && !elements->empty() && elements->back().kind == Element::Literal) {
+            elements->back().bytes.insert(elements->back().bytes.end(), element.bytes.begin(), element.bytes.end());
+        } else {
+            elements->push_back(std::move(element));
+        }
+    }
+    return true;
+}
+
+bool CDeviceRules::parse(const std::string &text, std::string *error)
+{
+    std::vector<std::unique_ptr<Rule>> rules;
+    std::stringstream stream(text);
+    int lineNumber = 0;
+    for (std::string raw; std::getline(stream, raw);) {
+        ++lineNumber;
+        const std::string line = trimmed(raw);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        auto fail = [&](const std::string &message) {
+            if (error) {
+                *error = "line " + std::to_string(lineNumber) + ": " + message;
+            }
+            return false;
+        };
+        const size_t arrow = findArrow(line);
+        if (arrow == std::string::npos) {
+            return fail("missing =>");
+        }
+        auto rule = std::make_unique<Rule>();
+        rule->line = lineNumber;
+        rule->text = line;
+        const std::string left = trimmed(line.substr(0, arrow));
+        std::string right = trimmed(line.substr(arrow + 2));
+        std::string message;
+
+        if (startsWithWord(left, "every")) {
+            rule->isPeriodic = true;
+            if (!parseDuration(trimmed(left.substr(5)), &rule->period) || rule->period.count() <= 0) {
+                return fail("invalid period '" + trimmed(left.substr(5)) + "'");
+            }
+        } else if (startsWithWord(left, "regex")) {
+            rule->isRegex = true;
+            try {
+                rule->regex = std::regex(trimmed(left.substr(5)), std::regex::ECMAScript | std::regex::optimize);
+            } catch (const std::regex_error &e) {
+                return fail(std::string("invalid regex: ") + e.what());
+            }
+            rule->groupCount = rule->regex.mark_count();
+        } else {
+            if (!parseTemplate(left, true, &rule->match, &message)) {
+                return fail(message);
+            }
+            size_t width = 0;
+            for (const Element &element : rule->match) {
+                width += element.width();
+            }
+            if (width == 0) {
+                return fail("empty match");
+            }
+        }
+
+        if (startsWithWord(right, "delay")) {
+            if (rule->isPeriodic) {
+                return fail("delay is not allowed on periodic rules");
+            }
+            const std::string rest = trimmed(right.substr(5));
+            const size_t space = rest.find_first_of(" \t");
+            if (!parseDuration(rest.substr(0, space), &rule->delay)) {
+                return fail("invalid delay '" + rest.substr(0, space) + "'");
+            }
+            right = space == std::string::npos ? std::string() : rest.substr(space);
+        }
+        if (!parseTemplate(right, false, &rule->reply, &message)) {
+            return fail(message);
+        }
+        for (const Element &element : rule->reply) {
+            if (rule->isPeriodic && (element.kind == Element::Input || element.kind == Element::Group)) {
+                return fail("periodic rules have no request to refer to");
+            }
+            if (element.kind == Element::Group && (!rule->isRegex || element.offset > rule->groupCount)) {
+                return fail("{" + std::to_string(element.offset) + "} refers to a missing regex group");
+            }
+        }
+        if (rule->isPeriodic && rule->reply.empty()) {
+            return fail("periodic rule has nothing to send");
+        }
+        rules.push_back(std::move(rule));
+    }
+    m_Rules = std::move(rules);
+    return true;
+}
+
+bool CDeviceRules::load(const std::string &path, std::string *error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        if (error) {
+            *error = "Failed to open " + path;
+        }
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), error);
+}
+
+size_t CDeviceRules::ruleCount() const
+{
+    return m_Rules.size();
+}
+
+const std::string &CDeviceRules::ruleText(int rule) const
+{
+    return m_Rules[static_cast<size_t>(rule)]->text;
+}
+
+int CDeviceRules::ruleLine(int rule) const
+{
+    return m_Rules[static_cast<size_t>(rule)]->line;
+}
+
+std::chrono::microseconds CDeviceRules::delay(int rule) const
+{
+    return m_Rules[static_cast<size_t>(rule)]->delay;
+}
+
+std::vector<CDeviceRules::Periodic> CDeviceRules::periodicRules() const
+{
+    std::vector<Periodic> periodic;
+    for (size_t i = 0; i < m_Rules.size(); ++i) {
+        if (m_Rules[i]->isPeriodic) {
+            periodic.push_back({static_cast<int>(i), m_Rules[i]->period});
+        }
+    }
+    return periodic;
+}
+
+CDeviceRules::MatchResult CDeviceRules::matchBytes(const Rule &rule, const uint8_t *data, size_t size) const
+{
+    size_t position = 0;
+    size_t mark = 0;
+    for (const Element &element : rule.match) {
+        switch (element.kind) {
+        case Element::Literal: {
+            const size_t available = std::min(element.bytes.size(), size - position);
+            if (std::memcmp(data + position, element.bytes.data(), available) != 0) {
+                return NoMatch;
+            }
+            if (available < element.bytes.size()) {
+                return NeedMore;
+            }
+            break;
+        }
+        case Element::Wildcard:
+            if (position == size) {
+                return NeedMore;
+            }
+            break;
+        case Element::Mark:
+            mark = position;
+            break;
+        case Element::Checksum: {
+            if (position + element.width() > size) {
+                return NeedMore;
+            }
+            std::vector<uint8_t> expected;
+            encodeChecksum(element.checksum, element.asHex,
+                           computeChecksum(element.checksum, data + mark, position - mark), &expected);
+            for (size_t k = 0; k < expected.size(); ++k) {
+                // 十六进制文本不区分大小写
+                const uint8_t actual = element.asHex ? static_cast<uint8_t>(std::toupper(data[position + k]))
+                                                     : data[position + k];
+                if (actual != expected[k]) {
+                    return NoMatch;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        position += element.width();
+    }
+    return Matched;
+}
+
+CDeviceRules::MatchResult CDeviceRules::match(const uint8_t *data, size_t size, Match *match) const
+{
+    bool needMore = false;
+    for (size_t i = 0; i < m_Rules.size(); ++i) {
+        const Rule &rule = *m_Rules[i];
+        if (rule.isPeriodic) {
+            continue;
+        }
+        if (rule.isRegex) {
+            const char *begin = reinterpret_cast<const char *>(data);
+            std::cmatch result;
+            if (std::regex_search(begin, begin + size, result, rule.regex, std::regex_constants::match_continuous)
+                && result.length(0) > 0) {
+                match->rule = static_cast<int>(i);
+                match->length = static_cast<size_t>(result.length(0));
+                match->groups.clear();
+                for (size_t group = 0; group < result.size(); ++group) {
+                    match->groups.emplace_back(static_cast<size_t>(result.position(group)),
+                                               result[group].matched ? static_cast<size_t>(result.length(group)) : 0);
+                }
+                return Matched;
+            }
+            // 正则无法判断缓冲是否为前缀，帧不太长时都等下去
+            needMore = needMore || size < kMaxRegexFrame;
+            continue;
+        }
+        const MatchResult result = matchBytes(rule, data, size);
+        if (result == Matched) {
+            size_t length = 0;
+            for (const Element &element : rule.match) {
+                length += element.width();
+            }
+            match->rule = static_cast<int>(i);
+            match->length = length;
+            match->groups.clear();
+            return Matched;
+        }
+        needMore = needMore || result == NeedMore;
+    }
+    return needMore ? NeedMore : NoMatch;
+}
+
+void CDeviceRules::render(const Match &match, const uint8_t *request, std::vector<uint8_t> *out)
+{
+    Rule &rule = *m_Rules[static_cast<size_t>(match.rule)];
+    size_t mark = out->size();
+    for (const Element &element : rule.reply) {
+        switch (element.kind) {
+        case Element::Literal:
+            out->insert(out->end(), element.bytes.begin(), element.bytes.end());
+            break;
+        case Element::Input:
+            if (request != nullptr && element.offset < match.length) {
+                const size_t length = std::min(element.length, match.length - element.offset);
+                out->insert(out->end(), request + element.offset, request + element.offset + length);
+            }
+            break;
+        case Element::Group:
+            if (request != nullptr && element.offset < match.groups.size()) {
+                const auto &group = match.groups[element.offset];
+                out->insert(out->end(), request + group.first, request + group.first + group.second);
+            }
+            break;
+        case Element::Checksum:
+            encodeChecksum(element.checksum, element.asHex,
+                           computeChecksum(element.checksum, out->data() + mark, out->size() - mark), out);
+            break;
+        case Element::Mark:
+            mark = out->size();
+            break;
+        case Element::Sequence:
+            out->push_back(rule.sequence++);
+            break;
+        case Element::Random:
+            for (size_t k = 0; k < element.length; ++k) {
+                out->push_back(static_cast<uint8_t>(m_Random()));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool CDeviceRules::renderTemplate(const std::string &text, std::vector<uint8_t> *out, std::string *error)
+{
+    CDeviceRules rules;
+    if (!rules.parse("every 1s => " + text, error)) {
+        return false;
+    }
+    Match match;
+    match.rule = 0;
+    rules.render(match, nullptr, out);
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef CDEVICERULES_H
+#define CDEVICERULES_H
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// 虚拟设备的规则表：每行一条规则，收到的帧按规则匹配后生成应答。
+//   <匹配> => [delay <时长>] <应答模板>
+//   every <时长> => <应答模板>              （不需要请求，按固定周期主动发送）
+//   regex <ECMAScript 正则> => ...          （从缓冲起点匹配，二进制字节用 \xNN）
+// 匹配与应答都是字节模板，由空白分隔的元素组成：
+//   01 03 / 0103        十六进制字节
+//   "OK\r\n"            字符串，支持 \r \n \t \0 \\ \" \xNN
+//   ??                  任意一个字节（仅匹配）
+//   {in} {in:O} {in:O:L} 请求的全部 / 第 O 字节 / 从 O 起 L 字节（仅应答）
+//   {0}..{9}            正则的整个匹配与捕获组（仅应答）
+//   {crc:modbus|ccitt|xmodem|crc32} {sum8} {xor8}  从开头（或上一个 {mark}）到此处的校验，加 :hex 输出大写十六进制文本；
+//                       modbus、crc32 低字节在前，ccitt（CRC-16/CCITT-FALSE）、xmodem 高字节在前；
+//                       用在匹配中时校验请求中对应位置的字节
+//   {mark}              校验的起点
+//   {seq}               每条规则独立的一字节递增计数（仅应答）
+//   {rand:N}            N 个随机字节（仅应答）
+// 时长写作 500us、2ms、1s。# 开头为注释。
+// 例：Modbus 从站 1 读保持寄存器，2 ms 后回 2 个寄存器
+//   01 03 ?? ?? 00 02 {crc:modbus} => delay 2ms 01 03 04 12 34 00 {seq} {crc:modbus}
+// 不依赖 Qt，模拟器与测试工具共用；render() 会推进 {seq} 与随机数，只能单线程调用
+class CDeviceRules
+{
+public:
+    enum MatchResult
+    {
+        Matched,
+        NeedMore,   // 缓冲是某条规则的前缀（或有正则规则），等更多数据或帧间隔
+        NoMatch     // 缓冲起点的字节不可能属于任何规则
+    };
+
+    struct Match
+    {
+        int rule = -1;
+        size_t length = 0;
+        // 正则匹配的各组在请求中的 (偏移, 长度)，没有参与匹配的组长度为 0
+        std::vector<std::pair<size_t, size_t>> groups;
+    };
+
+    struct Periodic
+    {
+        int rule = -1;
+        std::chrono::microseconds period{0};
+    };
+
+    // 正则规则最多等待的帧长度，超过仍不匹配就当作不匹配
+    static constexpr size_t kMaxRegexFrame = 4096;
+
+    CDeviceRules();
+    ~CDeviceRules();
+    CDeviceRules(CDeviceRules &&) noexcept;
+    CDeviceRules &operator=(CDeviceRules &&) noexcept;
+
+    // 解析失败时 error 为 "line N: ..."，原有规则不变
+    bool parse(const std::string &text, std::string *error);
+    bool load(const std::string &path, std::string *error);
+
+    size_t ruleCount() const;
+    // 规则的原文，供统计输出
+    const std::string &ruleText(int rule) const;
+    int ruleLine(int rule) const;
+    std::chrono::microseconds delay(int rule) const;
+    std::vector<Periodic> periodicRules() const;
+
+    // 按规则表顺序取第一条在缓冲起点完整匹配的规则
+    MatchResult match(const uint8_t *data, size_t size, Match *match) const;
+    // 按规则生成应答追加到 out；periodic 规则的 request 为空
+    void render(const Match &match, const uint8_t *request, std::vector<uint8_t> *out);
+
+    // 把不引用请求的模板（字节、字符串、校验等）直接生成字节，供命令行给出请求帧
+    static bool renderTemplate(const std::string &text, std::vector<uint8_t> *out, std::string *error);
+
+private:
+    struct Element;
+    struct Rule;
+
+    static bool parseTemplate(const std::string &text, bool isMatch, std::vector<Element> *elements,
+                              std::string *error);
+    static bool parseDuration(const std::string &text, std::chrono::microseconds *duration);
+    MatchResult matchBytes(const Rule &rule, const uint8_t *data, size_t size) const;
+
+    std::vector<std::unique_ptr<Rule>> m_Rules;
+    std::mt19937 m_Random;
+};
+
+#endif // CDEVICERULES_H
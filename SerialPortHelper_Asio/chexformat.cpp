@@ -0,0 +1,199 @@
+#include "chexformat.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HEXFORMAT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define HEXFORMAT_TARGET_SSSE3
+#else
+#define HEXFORMAT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define HEXFORMAT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+const char kDigits[17] = "0123456789abcdef";
+
+// 48 个输出字符分成 3 个 16 字节段，每段用 pshufb/tbl 从高、低半字节的字符向量中取字符，
+// 第 3 个位置填空格：位置 p 对应字节 p / 3，p % 3 == 0 取高位，== 1 取低位
+struct ShuffleTables
+{
+    alignas(16) uint8_t high[3][16];
+    alignas(16) uint8_t low[3][16];
+    alignas(16) uint8_t spaces[3][16];
+
+    ShuffleTables()
+    {
+        for (int segment = 0; segment < 3; ++segment) {
+            for (int i = 0; i < 16; ++i) {
+                const int position = segment * 16 + i;
+                const uint8_t byteIndex = static_cast<uint8_t>(position / 3);
+                high[segment][i] = position % 3 == 0 ? byteIndex : 0x80;
+                low[segment][i] = position % 3 == 1 ? byteIndex : 0x80;
+                spaces[segment][i] = position % 3 == 2 ? ' ' : 0;
+            }
+        }
+    }
+};
+
+const ShuffleTables &shuffleTables()
+{
+    static const ShuffleTables tables;
+    return tables;
+}
+
+void formatHexScalar(const unsigned char *data, char *out)
+{
+    for (size_t i = 0; i < HexFormat::kBytesPerRow; ++i) {
+        out[i * 3] = kDigits[data[i] >> 4];
+        out[i * 3 + 1] = kDigits[data[i] & 0x0F];
+        out[i * 3 + 2] = ' ';
+    }
+}
+
+[[maybe_unused]] void formatAsciiScalar(const unsigned char *data, char *out)
+{
+    for (size_t i = 0; i < HexFormat::kBytesPerRow; ++i) {
+        out[i] = data[i] >= 0x20 && data[i] <= 0x7E ? static_cast<char>(data[i]) : '.';
+    }
+}
+
+#if defined(HEXFORMAT_X86)
+bool cpuHasSsse3()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    __builtin_cpu_init();  // 可能在静态初始化阶段被调用
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+HEXFORMAT_TARGET_SSSE3 void formatHexSsse3(const unsigned char *data, char *out)
+{
+    const ShuffleTables &tables = shuffleTables();
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kDigits));
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(input, 4), nibbleMask));
+    const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(input, nibbleMask));
+    for (int segment = 0; segment < 3; ++segment) {
+        const __m128i highPart = _mm_shuffle_epi8(high, _mm_load_si128(reinterpret_cast<const __m128i *>(tables.high[segment])));
+        const __m128i lowPart = _mm_shuffle_epi8(low, _mm_load_si128(reinterpret_cast<const __m128i *>(tables.low[segment])));
+        const __m128i spaces = _mm_load_si128(reinterpret_cast<const __m128i *>(tables.spaces[segment]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + segment * 16),
+                         _mm_or_si128(_mm_or_si128(highPart, lowPart), spaces));
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEXFORMAT_SSE2 1
+void formatAsciiSse2(const unsigned char *data, char *out)
+{
+    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    // 无符号区间判断：max(v, 0x20) == v 且 min(v, 0x7E) == v
+    const __m128i aboveLow = _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(0x20)), input);
+    const __m128i belowHigh = _mm_cmpeq_epi8(_mm_min_epu8(input, _mm_set1_epi8(0x7E)), input);
+    const __m128i printable = _mm_and_si128(aboveLow, belowHigh);
+    const __m128i result = _mm_or_si128(_mm_and_si128(printable, input),
+                                        _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), result);
+}
+#endif
+#endif
+
+#if defined(HEXFORMAT_NEON)
+void formatHexNeon(const unsigned char *data, char *out)
+{
+    const ShuffleTables &tables = shuffleTables();
+    const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t *>(kDigits));
+    const uint8x16_t input = vld1q_u8(data);
+    const uint8x16_t high = vqtbl1q_u8(digits, vshrq_n_u8(input, 4));
+    const uint8x16_t low = vqtbl1q_u8(digits, vandq_u8(input, vdupq_n_u8(0x0F)));
+    for (int segment = 0; segment < 3; ++segment) {
+        // 索引 0x80 超出表范围，tbl 返回 0
+        const uint8x16_t highPart = vqtbl1q_u8(high, vld1q_u8(tables.high[segment]));
+        const uint8x16_t lowPart = vqtbl1q_u8(low, vld1q_u8(tables.low[segment]));
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + segment * 16),
+                 vorrq_u8(vorrq_u8(highPart, lowPart), vld1q_u8(tables.spaces[segment])));
+    }
+}
+
+void formatAsciiNeon(const unsigned char *data, char *out)
+{
+    const uint8x16_t input = vld1q_u8(data);
+    const uint8x16_t printable = vandq_u8(vcgeq_u8(input, vdupq_n_u8(0x20)), vcleq_u8(input, vdupq_n_u8(0x7E)));
+    vst1q_u8(reinterpret_cast<uint8_t *>(out), vbslq_u8(printable, input, vdupq_n_u8('.')));
+}
+#endif
+
+using RowFunction = void (*)(const unsigned char *, char *);
+
+RowFunction selectHexFunction()
+{
+#if defined(HEXFORMAT_X86)
+    if (cpuHasSsse3()) {
+        return formatHexSsse3;
+    }
+#elif defined(HEXFORMAT_NEON)
+    return formatHexNeon;
+#endif
+    return formatHexScalar;
+}
+
+RowFunction selectAsciiFunction()
+{
+#if defined(HEXFORMAT_SSE2)
+    return formatAsciiSse2;
+#elif defined(HEXFORMAT_NEON)
+    return formatAsciiNeon;
+#else
+    return formatAsciiScalar;
+#endif
+}
+
+const RowFunction g_FormatHexRow = selectHexFunction();
+const RowFunction g_FormatAsciiRow = selectAsciiFunction();
+}
+
+void HexFormat::formatHex(const unsigned char *data, size_t count, char *out)
+{
+    if (count >= kBytesPerRow) {
+        g_FormatHexRow(data, out);
+        return;
+    }
+    unsigned char row[kBytesPerRow] = {};
+    std::memcpy(row, data, count);
+    g_FormatHexRow(row, out);
+    std::memset(out + count * 3, ' ', kHexChars - count * 3);
+}
+
+void HexFormat::formatAscii(const unsigned char *data, size_t count, char *out)
+{
+    if (count >= kBytesPerRow) {
+        g_FormatAsciiRow(data, out);
+        return;
+    }
+    unsigned char row[kBytesPerRow] = {};
+    char text[kBytesPerRow];
+    std::memcpy(row, data, count);
+    g_FormatAsciiRow(row, text);
+    std::memcpy(out, text, count);
+}
+
+void HexFormat::formatOffset(uint64_t offset, size_t digits, char *out)
+{
+    for (size_t i = digits; i > 0; --i) {
+        out[i - 1] = kDigits[offset & 0x0F];
+        offset >>= 4;
+    }
+}
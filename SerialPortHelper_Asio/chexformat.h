@@ -0,0 +1,21 @@
+#ifndef CHEXFORMAT_H
+#define CHEXFORMAT_H
+#include <cstddef>
+#include <cstdint>
+
+// HEX 显示的行格式化：每行 16 字节，"xx xx ... xx " 共 48 字符 + 16 个 ASCII 字符。
+// x86 上运行时检测 SSSE3 用 pshufb 查表/展开，aarch64 上用 NEON tbl，其余平台走标量实现。
+namespace HexFormat
+{
+constexpr size_t kBytesPerRow = 16;
+constexpr size_t kHexChars = kBytesPerRow * 3;
+
+// count <= 16，不足 16 字节的部分用空格补齐，始终写出 kHexChars 个字符
+void formatHex(const unsigned char *data, size_t count, char *out);
+// 不可打印字节替换为 '.'，写出 count 个字符
+void formatAscii(const unsigned char *data, size_t count, char *out);
+// 偏移列：取 offset 的低 digits 个十六进制位，高位补 0，与字节列用同一张字符表
+void formatOffset(uint64_t offset, size_t digits, char *out);
+}
+
+#endif // CHEXFORMAT_H
@@ -0,0 +1,332 @@
+#include "cmultiportwindow.h"
+#include "cportpanel.h"
+#include "cportwatcher.h"
+#include "cserialportregistry.h"
+
+#include <QCheckBox>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+// 指标刷新间隔，速率按这个间隔内的增量换算
+constexpr int kMetricsIntervalMs = 500;
+// 错误日志最多保留的行数
+constexpr int kMaxErrorLines = 1000;
+// 所有面板接收区回滚的默认总预算（MiB），32 个口时每个 32 MiB
+constexpr int kDefaultScrollbackBudgetMiB = 1024;
+}
+
+CMultiPortWindow::CMultiPortWindow(CSerialPortRegistry *registry, CPortWatcher *watcher, QWidget *parent)
+    : QWidget(parent, Qt::Window)
+    , m_p_Registry(registry)
+    , m_p_Watcher(watcher)
+    , m_p_Tabs(new QTabWidget(this))
+    , m_p_Metrics(new QTableWidget(this))
+    , m_p_Errors(new QPlainTextEdit(this))
+    , m_p_TcpPort(new QSpinBox(this))
+    , m_p_TcpLocalOnly(new QCheckBox("仅本机", this))
+    , m_p_AutoReconnect(new QCheckBox("断线自动重连", this))
+    , m_p_ScrollbackBudget(new QSpinBox(this))
+{
+    setWindowTitle("多串口监控");
+    resize(960, 640);
+
+    const QStringList headers = {"名称", "串口", "状态", "波特率", "接收字节", "读取完成/s", "交付/s", "接收 KB/s",
+                                 "写队列", "错误", "TCP", "共享内存", "重连"};
+    m_p_Metrics->setColumnCount(headers.size());
+    m_p_Metrics->setHorizontalHeaderLabels(headers);
+    m_p_Metrics->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_p_Metrics->verticalHeader()->setVisible(false);
+    m_p_Metrics->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_p_Metrics->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_p_Errors->setReadOnly(true);
+    m_p_Errors->setMaximumBlockCount(kMaxErrorLines);
+
+    // 以 TCP 共享选中的串口，远程或本机测试程序连上即可收发；端口 0 表示由系统分配
+    m_p_TcpPort->setRange(0, 65535);
+    m_p_TcpPort->setValue(7000);
+    m_p_TcpPort->setSpecialValueText("自动");
+    m_p_TcpLocalOnly->setChecked(true);
+    m_p_TcpLocalOnly->setToolTip("只监听 127.0.0.1；取消勾选后监听所有网卡，局域网内的任何人都能读写该串口");
+    auto *tcpShare = new QPushButton("TCP 共享选中串口", this);
+    auto *tcpStop = new QPushButton("停止共享", this);
+    auto *tcpRow = new QHBoxLayout;
+    tcpRow->addWidget(new QLabel("TCP 端口:", this));
+    tcpRow->addWidget(m_p_TcpPort);
+    tcpRow->addWidget(m_p_TcpLocalOnly);
+    tcpRow->addWidget(tcpShare);
+    tcpRow->addWidget(tcpStop);
+    // 发布到共享内存环，本机多个分析进程各自读取同一份接收数据（SerialShmTail 或 cshmring.h 客户端）
+    auto *shmShare = new QPushButton("发布到共享内存", this);
+    auto *shmStop = new QPushButton("停止发布", this);
+    tcpRow->addSpacing(16);
+    tcpRow->addWidget(shmShare);
+    tcpRow->addWidget(shmStop);
+    tcpRow->addStretch();
+
+    auto *overview = new QWidget(this);
+    auto *overviewLayout = new QVBoxLayout(overview);
+    overviewLayout->addWidget(m_p_Metrics, 3);
+    overviewLayout->addLayout(tcpRow);
+    overviewLayout->addWidget(m_p_Errors, 1);
+    m_p_Tabs->addTab(overview, "总览");
+
+    auto *buttons = new QHBoxLayout;
+    auto *add = new QPushButton("添加串口", this);
+    auto *remove = new QPushButton("移除当前", this);
+    buttons->addWidget(add);
+    buttons->addWidget(remove);
+    buttons->addWidget(m_p_AutoReconnect);
+    buttons->addSpacing(16);
+    buttons->addWidget(new QLabel("接收回滚总量:", this));
+    buttons->addWidget(m_p_ScrollbackBudget);
+    buttons->addStretch();
+    // 读写出错或拔出后按退避重新打开，对本窗口中所有串口（含主窗口的收发口）生效
+    m_p_AutoReconnect->setChecked(true);
+    m_p_AutoReconnect->setToolTip("串口失效后立即关闭，按 0.1 s 起加倍、最长 5 s 的间隔重新打开，设备重新插入时立即重试");
+    // 几十个口同时监控时按总量控制内存，而不是每个口各保留一份默认回滚
+    m_p_ScrollbackBudget->setRange(64, 64 * 1024);
+    m_p_ScrollbackBudget->setSingleStep(256);
+    m_p_ScrollbackBudget->setValue(kDefaultScrollbackBudgetMiB);
+    m_p_ScrollbackBudget->setSuffix(" MiB");
+    m_p_ScrollbackBudget->setToolTip("本窗口所有串口面板的接收区共用的内存上限，平均分给每个面板，超出时丢弃最旧的数据");
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addWidget(m_p_Tabs, 1);
+
+    connect(add, &QPushButton::clicked, this, &CMultiPortWindow::handleAddPort);
+    connect(remove, &QPushButton::clicked, this, &CMultiPortWindow::handleRemovePort);
+    connect(tcpShare, &QPushButton::clicked, this, &CMultiPortWindow::handleTcpShare);
+    connect(tcpStop, &QPushButton::clicked, this, &CMultiPortWindow::handleTcpStop);
+    connect(shmShare, &QPushButton::clicked, this, &CMultiPortWindow::handleShmShare);
+    connect(shmStop, &QPushButton::clicked, this, &CMultiPortWindow::handleShmStop);
+    connect(m_p_Registry, &CSerialPortRegistry::signal_PortRemoved, this, &CMultiPortWindow::handlePortRemoved);
+    connect(m_p_Registry, &CSerialPortRegistry::signal_PortError, this, &CMultiPortWindow::handlePortError);
+    connect(m_p_Registry, &CSerialPortRegistry::signal_PortReconnected, this, &CMultiPortWindow::handlePortReconnected);
+    connect(m_p_Watcher, &CPortWatcher::signal_PortsChanged, this, &CMultiPortWindow::handlePortsChanged);
+    connect(m_p_AutoReconnect, &QCheckBox::toggled, this, [this](bool checked) {
+        for (int id : m_p_Registry->portIds()) {
+            m_p_Registry->setAutoReconnect(id, checked);
+        }
+    });
+    connect(m_p_ScrollbackBudget, qOverload<int>(&QSpinBox::valueChanged), this,
+            &CMultiPortWindow::applyScrollbackBudget);
+    connect(&m_MetricsTimer, &QTimer::timeout, this, &CMultiPortWindow::updateMetrics);
+    m_MetricsTimer.start(kMetricsIntervalMs);
+    updateMetrics();
+}
+
+void CMultiPortWindow::handleAddPort()
+{
+    const int id = m_p_Registry->addPort(QString("串口 %1").arg(m_p_Registry->portCount() + 1));
+    m_p_Registry->setAutoReconnect(id, m_p_AutoReconnect->isChecked());
+    auto *panel = new CPortPanel(m_p_Registry->port(id), m_p_Tabs);
+    panel->setAvailablePorts(m_p_Watcher->ports());
+    m_Panels.insert(id, panel);
+    applyScrollbackBudget();
+    m_p_Tabs->setCurrentIndex(m_p_Tabs->addTab(panel, m_p_Registry->label(id)));
+    // 打开后标签页显示实际的串口名
+    connect(panel, &CPortPanel::signal_PortNameChanged, this, [this, panel, id](const QString &portName) {
+        m_p_Tabs->setTabText(m_p_Tabs->indexOf(panel), QString("%1 (%2)").arg(m_p_Registry->label(id), portName));
+    });
+    updateMetrics();
+}
+
+void CMultiPortWindow::handleRemovePort()
+{
+    auto *panel = qobject_cast<CPortPanel *>(m_p_Tabs->currentWidget());
+    if (panel == nullptr) {
+        return;
+    }
+    // 主窗口的收发口不在这里创建，也不允许在这里移除
+    const int id = m_Panels.key(panel, 0);
+    if (id != 0) {
+        m_p_Registry->removePort(id);
+    }
+}
+
+void CMultiPortWindow::handlePortRemoved(int id)
+{
+    // 面板持有管理器指针，必须随注册表中的串口一起销毁
+    CPortPanel *panel = m_Panels.take(id);
+    if (panel != nullptr) {
+        m_p_Tabs->removeTab(m_p_Tabs->indexOf(panel));
+        delete panel;
+        applyScrollbackBudget();
+    }
+    m_LastCompletions.remove(id);
+    m_LastDeliveries.remove(id);
+    m_LastBytes.remove(id);
+    updateMetrics();
+}
+
+void CMultiPortWindow::handlePortError(int id, const QString &errorString)
+{
+    m_p_Errors->appendPlainText(QString("[%1] %2: %3")
+                                    .arg(QDateTime::currentDateTime().toString("hh:mm:ss.zzz"),
+                                         m_p_Registry->label(id), errorString));
+}
+
+void CMultiPortWindow::handlePortReconnected(int id)
+{
+    for (const auto &port : m_p_Registry->metrics()) {
+        if (port.id == id) {
+            m_p_Errors->appendPlainText(QString("[%1] %2: 已重新连接，断开 %3 ms，尝试 %4 次")
+                                            .arg(QDateTime::currentDateTime().toString("hh:mm:ss.zzz"), port.label)
+                                            .arg(port.reconnect.lastOutageMs, 0, 'f', 0)
+                                            .arg(port.reconnect.attempts));
+        }
+    }
+    if (CPortPanel *panel = m_Panels.value(id, nullptr)) {
+        panel->updateOpenState();
+    }
+    updateMetrics();
+}
+
+void CMultiPortWindow::handlePortsChanged()
+{
+    const auto ports = m_p_Watcher->ports();
+    for (CPortPanel *panel : m_Panels) {
+        panel->setAvailablePorts(ports);
+    }
+}
+
+void CMultiPortWindow::applyScrollbackBudget()
+{
+    if (m_Panels.isEmpty()) {
+        return;
+    }
+    const quint64 budget = static_cast<quint64>(m_p_ScrollbackBudget->value()) << 20;
+    for (CPortPanel *panel : m_Panels) {
+        panel->setScrollbackCapacity(budget / static_cast<quint64>(m_Panels.size()));
+    }
+}
+
+int CMultiPortWindow::selectedPortId() const
+{
+    const int row = m_p_Metrics->currentRow();
+    return row >= 0 && row < static_cast<int>(m_RowIds.size()) ? m_RowIds[row] : -1;
+}
+
+void CMultiPortWindow::handleTcpShare()
+{
+    const int id = selectedPortId();
+    if (id < 0) {
+        return;
+    }
+    const QString address = m_p_TcpLocalOnly->isChecked() ? "127.0.0.1" : "0.0.0.0";
+    const unsigned short port = m_p_Registry->startTcpServer(id, address, static_cast<unsigned short>(m_p_TcpPort->value()));
+    if (port != 0) {
+        m_p_Errors->appendPlainText(QString("%1 已在 %2:%3 上以 TCP 共享").arg(m_p_Registry->label(id), address).arg(port));
+    }
+    updateMetrics();
+}
+
+void CMultiPortWindow::handleTcpStop()
+{
+    const int id = selectedPortId();
+    if (id < 0) {
+        return;
+    }
+    m_p_Registry->stopTcpServer(id);
+    updateMetrics();
+}
+
+void CMultiPortWindow::handleShmShare()
+{
+    const int id = selectedPortId();
+    if (id < 0) {
+        return;
+    }
+    // 名称取设备名，客户端好记：COM3 -> sph-COM3，/dev/ttyUSB0 -> sph-ttyUSB0
+    const QString device = QFileInfo(m_p_Registry->port(id)->portName()).fileName();
+    const QString name = QString("sph-%1").arg(device.isEmpty() ? QString::number(id) : device);
+    if (m_p_Registry->startSharedMemory(id, name)) {
+        m_p_Errors->appendPlainText(QString("%1 已发布到共享内存 %2").arg(m_p_Registry->label(id), name));
+    }
+    updateMetrics();
+}
+
+void CMultiPortWindow::handleShmStop()
+{
+    const int id = selectedPortId();
+    if (id < 0) {
+        return;
+    }
+    m_p_Registry->stopSharedMemory(id);
+    updateMetrics();
+}
+
+void CMultiPortWindow::updateMetrics()
+{
+    const auto metrics = m_p_Registry->metrics();
+    const double seconds = kMetricsIntervalMs / 1000.0;
+    m_p_Metrics->setRowCount(static_cast<int>(metrics.size()));
+    m_RowIds.clear();
+    for (int row = 0; row < static_cast<int>(metrics.size()); ++row) {
+        const auto &port = metrics[row];
+        m_RowIds.push_back(port.id);
+        // 首次出现的串口没有上一次的计数，速率从下一次刷新开始显示；重新打开后计数清零
+        auto delta = [&port](const QMap<int, quint64> &last, quint64 current) {
+            const quint64 previous = last.value(port.id, current);
+            return current >= previous ? current - previous : current;
+        };
+        const quint64 completions = delta(m_LastCompletions, port.read.completions);
+        const quint64 deliveries = delta(m_LastDeliveries, port.read.deliveries);
+        const quint64 bytes = delta(m_LastBytes, port.read.bytes);
+        m_LastCompletions[port.id] = port.read.completions;
+        m_LastDeliveries[port.id] = port.read.deliveries;
+        m_LastBytes[port.id] = port.read.bytes;
+
+        const QStringList cells = {
+            port.label,
+            port.portName,
+            port.isOpen ? "打开" : "关闭",
+            port.isOpen ? QString::number(port.baudRate) : QString("-"),
+            QString::number(port.read.bytes),
+            QString::number(completions / seconds, 'f', 0),
+            QString::number(deliveries / seconds, 'f', 0),
+            QString::number(bytes / 1024.0 / seconds, 'f', 1),
+            QString("%1 KB%2").arg(port.writeQueueBytes / 1024).arg(port.isWriteThrottled ? "（限流）" : ""),
+            QString::number(port.errorCount),
+            port.tcpPort != 0 ? QString("%1 (%2 连接)").arg(port.tcpPort).arg(port.tcpClients) : QString("-"),
+            port.shmName.isEmpty() ? QString("-")
+                                   : QString("%1 (%2 读取端, 跳过 %3 次)")
+                                         .arg(port.shmName)
+                                         .arg(port.shm.readers)
+                                         .arg(port.shm.readerOverruns),
+            port.reconnect.isReconnecting
+                ? QString("重连中, 已断开 %1 ms, 已尝试 %2 次")
+                      .arg(port.reconnect.currentOutageMs, 0, 'f', 0)
+                      .arg(port.reconnect.attempts)
+                : port.reconnect.outages > 0 ? QString("断开 %1 次, 上次 %2 ms, 最长 %3 ms")
+                                                   .arg(port.reconnect.outages)
+                                                   .arg(port.reconnect.lastOutageMs, 0, 'f', 0)
+                                                   .arg(port.reconnect.maxOutageMs, 0, 'f', 0)
+                                             : QString("-"),
+        };
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = m_p_Metrics->item(row, column);
+            if (item == nullptr) {
+                item = new QTableWidgetItem;
+                m_p_Metrics->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+
+    // 只刷新当前可见的面板
+    if (auto *panel = qobject_cast<CPortPanel *>(m_p_Tabs->currentWidget())) {
+        panel->updateStats();
+    }
+}
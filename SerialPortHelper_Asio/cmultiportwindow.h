@@ -0,0 +1,62 @@
+#ifndef CMULTIPORTWINDOW_H
+#define CMULTIPORTWINDOW_H
+
+#include <QMap>
+#include <QTimer>
+#include <QWidget>
+#include <vector>
+
+class QCheckBox;
+class QPlainTextEdit;
+class QSpinBox;
+class QTabWidget;
+class QTableWidget;
+class CPortPanel;
+class CPortWatcher;
+class CSerialPortRegistry;
+
+// 多串口监控窗口：“总览”页汇总注册表中所有串口的指标和错误，其余每页是一个串口的面板
+class CMultiPortWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    // watcher 提供串口列表，新建的面板用它的缓存填充，插拔时刷新所有面板
+    CMultiPortWindow(CSerialPortRegistry *registry, CPortWatcher *watcher, QWidget *parent = nullptr);
+
+private slots:
+    void handleAddPort();
+    void handleRemovePort();
+    void handlePortRemoved(int id);
+    void handlePortError(int id, const QString &errorString);
+    void handlePortReconnected(int id);
+    void handlePortsChanged();
+    void handleTcpShare();
+    void handleTcpStop();
+    void handleShmShare();
+    void handleShmStop();
+    void updateMetrics();
+
+private:
+    // 把回滚总预算平均分给本窗口的面板，添加、移除面板或修改预算时调用
+    void applyScrollbackBudget();
+    // 总览表格中选中行的注册表编号，未选中时为 -1
+    int selectedPortId() const;
+
+    CSerialPortRegistry *m_p_Registry;
+    CPortWatcher *m_p_Watcher;
+    QTabWidget *m_p_Tabs;
+    QTableWidget *m_p_Metrics;
+    QPlainTextEdit *m_p_Errors;
+    QSpinBox *m_p_TcpPort;
+    QCheckBox *m_p_TcpLocalOnly;
+    QCheckBox *m_p_AutoReconnect;
+    QSpinBox *m_p_ScrollbackBudget;     // 所有面板接收区回滚的总上限（MiB）
+    std::vector<int> m_RowIds;          // 总览表格每行对应的注册表编号
+    QMap<int, CPortPanel *> m_Panels;   // 注册表编号 -> 本窗口创建的面板
+    QTimer m_MetricsTimer;
+    QMap<int, quint64> m_LastCompletions;
+    QMap<int, quint64> m_LastDeliveries;
+    QMap<int, quint64> m_LastBytes;
+};
+
+#endif // CMULTIPORTWINDOW_H
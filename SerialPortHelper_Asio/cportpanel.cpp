@@ -0,0 +1,224 @@
+#include "cportpanel.h"
+#include "creceiveview.h"
+#include "cserialportmanager.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QIntValidator>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSerialPort>
+#include <QSerialPortInfo>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <iterator>
+
+CPortPanel::CPortPanel(CSerialPortManager *manager, QWidget *parent)
+    : QWidget(parent)
+    , m_p_Manager(manager)
+    , m_p_Port(new QComboBox(this))
+    , m_p_BaudRate(new QComboBox(this))
+    , m_p_DataBits(new QComboBox(this))
+    , m_p_Parity(new QComboBox(this))
+    , m_p_StopBits(new QComboBox(this))
+    , m_p_FlowControl(new QComboBox(this))
+    , m_p_Latency(new QComboBox(this))
+    , m_p_Open(new QPushButton("打开串口", this))
+    , m_p_Hex(new QCheckBox("HEX", this))
+    , m_p_Timestamp(new QCheckBox("时间戳", this))
+    , m_p_View(new CReceiveView(this))
+    , m_p_SendText(new QLineEdit(this))
+    , m_p_Send(new QPushButton("发送", this))
+    , m_p_Stats(new QLabel(this))
+{
+    populateSettings(m_p_BaudRate, m_p_DataBits, m_p_Parity, m_p_StopBits, m_p_FlowControl, m_p_Latency);
+    m_p_View->setScrollbackCapacity(kScrollbackCapacity);
+
+    auto *settings = new QGridLayout;
+    const std::pair<const char *, QComboBox *> fields[] = {
+        {"串口:", m_p_Port},         {"波特率:", m_p_BaudRate},   {"数据位:", m_p_DataBits}, {"校验位:", m_p_Parity},
+        {"停止位:", m_p_StopBits},   {"流控:", m_p_FlowControl}, {"时延:", m_p_Latency},
+    };
+    // 每行两组“标签 + 下拉框”
+    for (int i = 0; i < static_cast<int>(std::size(fields)); ++i) {
+        settings->addWidget(new QLabel(fields[i].first, this), i / 2, (i % 2) * 2);
+        settings->addWidget(fields[i].second, i / 2, (i % 2) * 2 + 1);
+    }
+    settings->setColumnStretch(1, 1);
+    settings->setColumnStretch(3, 1);
+
+    auto *controls = new QHBoxLayout;
+    auto *clear = new QPushButton("清空", this);
+    controls->addWidget(m_p_Open);
+    controls->addWidget(m_p_Hex);
+    controls->addWidget(m_p_Timestamp);
+    controls->addStretch();
+    controls->addWidget(clear);
+
+    auto *sendRow = new QHBoxLayout;
+    sendRow->addWidget(m_p_SendText, 1);
+    sendRow->addWidget(m_p_Send);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(settings);
+    layout->addLayout(controls);
+    layout->addWidget(m_p_View, 1);
+    layout->addLayout(sendRow);
+    layout->addWidget(m_p_Stats);
+
+    connect(m_p_Open, &QPushButton::clicked, this, &CPortPanel::handleOpenClicked);
+    connect(m_p_Send, &QPushButton::clicked, this, &CPortPanel::handleSendClicked);
+    connect(m_p_SendText, &QLineEdit::returnPressed, this, &CPortPanel::handleSendClicked);
+    connect(clear, &QPushButton::clicked, m_p_View, &CReceiveView::clear);
+    connect(m_p_Hex, &QCheckBox::toggled, this, [this](bool checked) {
+        m_p_View->setDisplayMode(checked ? CReceiveView::HexMode : CReceiveView::TextMode);
+    });
+    connect(m_p_Timestamp, &QCheckBox::toggled, m_p_View, &CReceiveView::setTimestampVisible);
+    connect(m_p_Manager, &CSerialPortManager::signal_DataReceived, this, &CPortPanel::handleDataReceived);
+    // 设备拔出时由注册表关闭串口，按钮和下拉框随之恢复
+    connect(m_p_Manager, &CSerialPortManager::signal_PortClosed, this, &CPortPanel::updateOpenState);
+    updateOpenState();
+}
+
+void CPortPanel::populateSettings(QComboBox *baudRate, QComboBox *dataBits, QComboBox *parity, QComboBox *stopBits,
+                                  QComboBox *flowControl, QComboBox *latency)
+{
+    //获取标准的波特率，并补充 USB 转串口芯片常用的高速率；下拉框可编辑，任意整数速率均可输入
+    auto baudRates = QSerialPortInfo::standardBaudRates();
+    for (qint32 rate : {230400, 460800, 921600, 1000000, 1500000, 2000000, 3000000, 4000000, 6000000, 12000000}) {
+        if (!baudRates.contains(rate)) {
+            baudRates.append(rate);
+        }
+    }
+    std::sort(baudRates.begin(), baudRates.end());
+    for (auto rate : baudRates) {
+        baudRate->addItem(QString::number(rate), rate);
+    }
+    baudRate->setEditable(true);
+    baudRate->setInsertPolicy(QComboBox::NoInsert);
+    baudRate->setValidator(new QIntValidator(1, 100000000, baudRate));
+    baudRate->setCurrentText("9600");
+
+    //设置数据位
+    dataBits->addItem("5", QSerialPort::Data5);
+    dataBits->addItem("6", QSerialPort::Data6);
+    dataBits->addItem("7", QSerialPort::Data7);
+    dataBits->addItem("8", QSerialPort::Data8);
+    dataBits->setCurrentText("8");
+
+    //设置校验位
+    parity->addItem("None", QSerialPort::NoParity);
+    parity->addItem("Even", QSerialPort::EvenParity);
+    parity->addItem("Odd", QSerialPort::OddParity);
+    parity->setCurrentText("None");
+
+    //设置停止位
+    stopBits->addItem("1", QSerialPort::OneStop);
+    stopBits->addItem("1.5", QSerialPort::OneAndHalfStop);
+    stopBits->addItem("2", QSerialPort::TwoStop);
+    stopBits->setCurrentText("1");
+
+    //设置流控
+    flowControl->addItem("None", QSerialPort::NoFlowControl);
+    flowControl->addItem("RTS/CTS", QSerialPort::HardwareControl);
+    flowControl->addItem("XON/XOFF", QSerialPort::SoftwareControl);
+
+    //设置时延模式
+    latency->addItem("默认", SerialTuning::DefaultLatency);
+    latency->addItem("低时延", SerialTuning::LowLatency);
+    latency->addItem("高吞吐", SerialTuning::HighThroughput);
+}
+
+void CPortPanel::updatePortList(QComboBox *port, const std::vector<CPortWatcher::PortInfo> &ports)
+{
+    const QString current = port->currentData().toString();
+    port->clear();
+    for (const auto &portInfo : ports) {
+        port->addItem(portInfo.portName + ":" + portInfo.description, portInfo.portName);
+    }
+    // 列表变化后保持原来的选中项，只有选中的串口被拔出时才换到第一项
+    const int index = port->findData(current);
+    if (index >= 0) {
+        port->setCurrentIndex(index);
+    }
+}
+
+void CPortPanel::setAvailablePorts(const std::vector<CPortWatcher::PortInfo> &ports)
+{
+    updatePortList(m_p_Port, ports);
+}
+
+CSerialPortManager *CPortPanel::manager() const
+{
+    return m_p_Manager;
+}
+
+void CPortPanel::setScrollbackCapacity(quint64 bytes)
+{
+    m_p_View->setScrollbackCapacity(bytes);
+}
+
+void CPortPanel::updateStats()
+{
+    if (!m_p_Manager->isOpen()) {
+        return;
+    }
+    const auto read = m_p_Manager->readStats();
+    m_p_Stats->setText(QString("实际波特率 %1, 已接收 %2 KB, 写队列 %3 KB%4")
+                           .arg(m_p_Manager->appliedBaudRate())
+                           .arg(read.bytes / 1024)
+                           .arg(m_p_Manager->writeQueueBytes() / 1024)
+                           .arg(m_p_Manager->isWriteThrottled() ? "（限流）" : ""));
+}
+
+void CPortPanel::handleOpenClicked()
+{
+    if (m_p_Manager->isOpen()) {
+        m_p_Manager->closePort();
+        updateOpenState();
+        return;
+    }
+    const QString portName = m_p_Port->currentData().toString();
+    const int baudRate = m_p_BaudRate->currentText().toInt();
+    const int dataBits = m_p_DataBits->currentData().toInt();
+    const int parity = m_p_Parity->currentData().toInt();
+    const int stopBits = m_p_StopBits->currentData().toInt();
+    const int flowControl = m_p_FlowControl->currentData().toInt();
+    const auto latencyMode = static_cast<SerialTuning::LatencyMode>(m_p_Latency->currentData().toInt());
+    if (!m_p_Manager->openPort(portName, baudRate, dataBits, parity, stopBits, flowControl, latencyMode)) {
+        QMessageBox::warning(this, "警告", "打开串口失败");
+        return;
+    }
+    m_p_BaudRate->setToolTip(QString("实际波特率: %1").arg(m_p_Manager->appliedBaudRate()));
+    updateOpenState();
+    emit signal_PortNameChanged(portName);
+}
+
+void CPortPanel::handleSendClicked()
+{
+    if (!m_p_Manager->isOpen()) {
+        QMessageBox::warning(this, "警告", "请先打开串口");
+        return;
+    }
+    m_p_Manager->sendData(m_p_SendText->text().toUtf8());
+}
+
+void CPortPanel::handleDataReceived(const QByteArray &data, qint64 timestampNs)
+{
+    m_p_View->appendData(data, timestampNs);
+}
+
+void CPortPanel::updateOpenState()
+{
+    const bool isOpen = m_p_Manager->isOpen();
+    m_p_Open->setText(isOpen ? "关闭串口" : "打开串口");
+    for (QComboBox *comboBox : {m_p_Port, m_p_BaudRate, m_p_DataBits, m_p_Parity, m_p_StopBits, m_p_FlowControl,
+                                m_p_Latency}) {
+        comboBox->setEnabled(!isOpen);
+    }
+    m_p_Send->setEnabled(isOpen);
+}
@@ -0,0 +1,67 @@
+#ifndef CPORTPANEL_H
+#define CPORTPANEL_H
+
+#include "cportwatcher.h"
+
+#include <QWidget>
+#include <vector>
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class CReceiveView;
+class CSerialPortManager;
+
+// 单个串口的设置、收发与状态面板，由多串口窗口为注册表中的每个串口生成一个
+class CPortPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    // 每个面板接收区回滚上限的默认值；多串口窗口按总预算重新分配
+    static constexpr quint64 kScrollbackCapacity = 64ULL << 20;
+
+    CPortPanel(CSerialPortManager *manager, QWidget *parent = nullptr);
+
+    // 填充波特率、数据位、校验位、停止位、流控、时延模式下拉框，主窗口的收发设置也用它
+    static void populateSettings(QComboBox *baudRate, QComboBox *dataBits, QComboBox *parity, QComboBox *stopBits,
+                                 QComboBox *flowControl, QComboBox *latency);
+    // 用热插拔监视的缓存刷新串口下拉框，保留当前选中的串口；不在界面线程上枚举
+    static void updatePortList(QComboBox *port, const std::vector<CPortWatcher::PortInfo> &ports);
+
+    CSerialPortManager *manager() const;
+    void updateStats();
+    // 接收区回滚上限（含行与时间索引），缩小时立即丢弃最旧的数据
+    void setScrollbackCapacity(quint64 bytes);
+    void setAvailablePorts(const std::vector<CPortWatcher::PortInfo> &ports);
+    // 按端口当前是否打开刷新按钮与下拉框，注册表断线重连成功后由窗口调用
+    void updateOpenState();
+
+signals:
+    void signal_PortNameChanged(const QString &portName);
+
+private slots:
+    void handleOpenClicked();
+    void handleSendClicked();
+    void handleDataReceived(const QByteArray &data, qint64 timestampNs);
+
+private:
+    CSerialPortManager *m_p_Manager;
+    QComboBox *m_p_Port;
+    QComboBox *m_p_BaudRate;
+    QComboBox *m_p_DataBits;
+    QComboBox *m_p_Parity;
+    QComboBox *m_p_StopBits;
+    QComboBox *m_p_FlowControl;
+    QComboBox *m_p_Latency;
+    QPushButton *m_p_Open;
+    QCheckBox *m_p_Hex;
+    QCheckBox *m_p_Timestamp;
+    CReceiveView *m_p_View;
+    QLineEdit *m_p_SendText;
+    QPushButton *m_p_Send;
+    QLabel *m_p_Stats;
+};
+
+#endif // CPORTPANEL_H
@@ -0,0 +1,261 @@
+#include "cportwatcher.h"
+
+#include <QSerialPortInfo>
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// 去掉 /dev/、\\.\ 之类的前缀，只比较设备名
+QString deviceName(const QString &name)
+{
+    const int slash = std::max(name.lastIndexOf('/'), name.lastIndexOf('\\'));
+    return slash >= 0 ? name.mid(slash + 1) : name;
+}
+
+#if defined(__linux__)
+// 只有串口类设备节点的变化才值得重新枚举
+bool isSerialNode(const char *name)
+{
+    const QByteArray node(name);
+    return node.startsWith("tty") || node.startsWith("rfcomm");
+}
+#endif
+}
+
+bool CPortWatcher::PortInfo::operator==(const PortInfo &other) const
+{
+    // 同名端口换了一个设备（序列号或 VID/PID 不同）视为先拔后插
+    return portName == other.portName && systemLocation == other.systemLocation && serialNumber == other.serialNumber
+           && vendorId == other.vendorId && productId == other.productId;
+}
+
+CPortWatcher::CPortWatcher(QObject *parent)
+    : QObject{parent}
+{
+}
+
+CPortWatcher::~CPortWatcher()
+{
+    stop();
+}
+
+void CPortWatcher::start()
+{
+    if (m_Thread.joinable()) {
+        return;
+    }
+    m_IsStopping.store(false);
+#if defined(__linux__)
+    m_WakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+    m_Thread = std::thread([this]() { run(); });
+}
+
+void CPortWatcher::stop()
+{
+    if (!m_Thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_IsStopping.store(true);
+    }
+    m_WakeCondition.notify_all();
+#if defined(__linux__)
+    wake();
+#endif
+    m_Thread.join();
+#if defined(__linux__)
+    if (m_WakeFd >= 0) {
+        ::close(m_WakeFd);
+        m_WakeFd = -1;
+    }
+#endif
+}
+
+void CPortWatcher::refresh()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_IsRefreshRequested.store(true);
+    }
+    m_WakeCondition.notify_all();
+#if defined(__linux__)
+    wake();
+#endif
+}
+
+std::vector<CPortWatcher::PortInfo> CPortWatcher::ports() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Ports;
+}
+
+bool CPortWatcher::isReady() const
+{
+    return m_IsReady.load();
+}
+
+bool CPortWatcher::isSameDevice(const QString &left, const QString &right)
+{
+#if defined(_WIN32)
+    return deviceName(left).compare(deviceName(right), Qt::CaseInsensitive) == 0;
+#else
+    return deviceName(left) == deviceName(right);
+#endif
+}
+
+void CPortWatcher::run()
+{
+    enumerate();
+#if defined(__linux__)
+    if (runInotify()) {
+        return;
+    }
+#endif
+    runPolling();
+}
+
+void CPortWatcher::enumerate()
+{
+    std::vector<PortInfo> current;
+    for (const QSerialPortInfo &info : QSerialPortInfo::availablePorts()) {
+        PortInfo port;
+        port.portName = info.portName();
+        port.systemLocation = info.systemLocation();
+        port.description = info.description();
+        port.manufacturer = info.manufacturer();
+        port.serialNumber = info.serialNumber();
+        port.vendorId = info.hasVendorIdentifier() ? info.vendorIdentifier() : 0;
+        port.productId = info.hasProductIdentifier() ? info.productIdentifier() : 0;
+        current.push_back(port);
+    }
+    std::sort(current.begin(), current.end(),
+              [](const PortInfo &left, const PortInfo &right) { return left.portName < right.portName; });
+
+    QStringList added;
+    QStringList removed;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const PortInfo &port : m_Ports) {
+            if (std::find(current.begin(), current.end(), port) == current.end()) {
+                removed.append(port.portName);
+            }
+        }
+        for (const PortInfo &port : current) {
+            if (std::find(m_Ports.begin(), m_Ports.end(), port) == m_Ports.end()) {
+                added.append(port.portName);
+            }
+        }
+        m_Ports = std::move(current);
+    }
+    // 第一次枚举即使没有串口也通知一次，接收者据此知道缓存已就绪
+    const bool isFirst = !m_IsReady.exchange(true);
+    if (isFirst || !added.isEmpty() || !removed.isEmpty()) {
+        emit signal_PortsChanged(added, removed);
+    }
+}
+
+void CPortWatcher::runPolling()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeCondition.wait_for(lock, std::chrono::milliseconds(kPollIntervalMs),
+                                     [this]() { return m_IsStopping.load() || m_IsRefreshRequested.load(); });
+            if (m_IsStopping.load()) {
+                return;
+            }
+            m_IsRefreshRequested.store(false);
+        }
+        enumerate();
+    }
+}
+
+#if defined(__linux__)
+void CPortWatcher::wake()
+{
+    if (m_WakeFd >= 0) {
+        const uint64_t value = 1;
+        const ssize_t written = ::write(m_WakeFd, &value, sizeof(value));
+        (void)written;
+    }
+}
+
+bool CPortWatcher::runInotify()
+{
+    // 容器或权限受限的环境里可能没有 inotify，退回轮询
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || m_WakeFd < 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    // 节点出现后 udev 还要改权限、建符号链接，IN_ATTRIB 让枚举等到节点可用之后
+    if (inotify_add_watch(fd, "/dev", IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    bool isPending = false;
+    std::chrono::steady_clock::time_point deadline;
+    while (!m_IsStopping.load()) {
+        int timeoutMs = -1;
+        if (isPending) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            timeoutMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, remaining.count()));
+        }
+        pollfd fds[2] = {{fd, POLLIN, 0}, {m_WakeFd, POLLIN, 0}};
+        if (::poll(fds, 2, timeoutMs) < 0 && errno != EINTR) {
+            ::close(fd);
+            return false;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t value = 0;
+            const ssize_t drained = ::read(m_WakeFd, &value, sizeof(value));
+            (void)drained;
+        }
+        if (m_IsStopping.load()) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            bool isRelevant = false;
+            ssize_t length = 0;
+            while ((length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char *cursor = buffer; cursor < buffer + length;) {
+                    const auto *event = reinterpret_cast<const inotify_event *>(cursor);
+                    // 事件队列溢出时无从得知丢了什么，按有变化处理
+                    if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && isSerialNode(event->name))) {
+                        isRelevant = true;
+                    }
+                    cursor += sizeof(inotify_event) + event->len;
+                }
+            }
+            // 一次插拔会连续产生多个事件，等安静 kDebounceMs 后只枚举一次
+            if (isRelevant) {
+                isPending = true;
+                deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kDebounceMs);
+            }
+        }
+        if (m_IsRefreshRequested.exchange(false)
+            || (isPending && std::chrono::steady_clock::now() >= deadline)) {
+            isPending = false;
+            enumerate();
+        }
+    }
+    ::close(fd);
+    return true;
+}
+#endif
@@ -0,0 +1,76 @@
+#ifndef CPORTWATCHER_H
+#define CPORTWATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 串口热插拔监视：在后台线程上枚举串口并缓存结果，与上一次比较后只推送增减，界面与引擎都不在自己的线程上枚举。
+// Linux 上用 inotify 监视 /dev 中 tty 设备节点的创建、删除（udev 随后修改权限也算），事件平息后再枚举一次；
+// 其他平台或 inotify 不可用时每隔 kPollIntervalMs 枚举一次。
+// 枚举（QSerialPortInfo::availablePorts）在 USB 转串口较多的机器上可能要几百毫秒，启动不再等它
+class CPortWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int kDebounceMs = 250;
+    static constexpr int kPollIntervalMs = 2000;
+
+    struct PortInfo
+    {
+        QString portName;         // 如 COM3、ttyUSB0
+        QString systemLocation;   // 如 \\.\COM3、/dev/ttyUSB0
+        QString description;
+        QString manufacturer;
+        QString serialNumber;
+        quint16 vendorId = 0;
+        quint16 productId = 0;
+
+        bool operator==(const PortInfo &other) const;
+    };
+
+    explicit CPortWatcher(QObject *parent = nullptr);
+    ~CPortWatcher();
+
+    // 启动后台线程后立即返回，第一次枚举完成时所有串口作为新增推送一次
+    void start();
+    void stop();
+    // 立即重新枚举一次（如用户点击刷新），结果仍通过信号推送
+    void refresh();
+
+    // 最近一次枚举的缓存，按端口名排序；第一次枚举完成前为空
+    std::vector<PortInfo> ports() const;
+    bool isReady() const;
+
+    // 端口名是否指同一个设备：COM3 与 \\.\COM3、ttyUSB0 与 /dev/ttyUSB0 视为相同
+    static bool isSameDevice(const QString &left, const QString &right);
+
+signals:
+    // 在后台线程上发出，排队到接收者所在线程；参数为端口名
+    void signal_PortsChanged(const QStringList &added, const QStringList &removed);
+
+private:
+    void run();
+    void enumerate();
+    void runPolling();
+#if defined(__linux__)
+    bool runInotify();
+    void wake();
+    int m_WakeFd = -1;   // eventfd，停止或刷新时唤醒 poll()
+#endif
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_WakeCondition;
+    std::vector<PortInfo> m_Ports;   // 受 m_Mutex 保护
+    std::atomic<bool> m_IsReady{false};
+    std::atomic<bool> m_IsStopping{false};
+    std::atomic<bool> m_IsRefreshRequested{false};
+    std::thread m_Thread;
+};
+
+#endif // CPORTWATCHER_H
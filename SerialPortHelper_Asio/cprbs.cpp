@@ -0,0 +1,325 @@
+#include "cprbs.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// 各多项式 x^n + x^m + 1 的 m
+int shortTap(CPrbsGenerator::Pattern pattern)
+{
+    switch (pattern) {
+    case CPrbsGenerator::Prbs7:
+        return 6;
+    case CPrbsGenerator::Prbs15:
+        return 14;
+    case CPrbsGenerator::Prbs23:
+        return 18;
+    case CPrbsGenerator::Prbs31:
+        return 28;
+    }
+    return 14;
+}
+
+uint64_t loadWord(const uint8_t *bytes)
+{
+    uint64_t word = 0;
+    for (int i = 7; i >= 0; --i) {
+        word = (word << 8) | bytes[i];
+    }
+    return word;
+}
+
+// 不用编译器内建函数，MSVC 与 GCC 都能把整个循环向量化
+uint64_t popCount(uint64_t x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (x * 0x0101010101010101ull) >> 56;
+}
+}
+
+bool CPrbsGenerator::isValidPattern(int order)
+{
+    return order == Prbs7 || order == Prbs15 || order == Prbs23 || order == Prbs31;
+}
+
+CPrbsGenerator::CPrbsGenerator(Pattern pattern)
+    : m_Pattern(pattern)
+{
+    const int longTap = static_cast<int>(pattern);
+    const int tap = shortTap(pattern);
+    // 平方到短抽头不小于 64：新的 64 位全部由已有的 128 位算出
+    int longLag = longTap;
+    int shortLag = tap;
+    while (shortLag < 64) {
+        longLag <<= 1;
+        shortLag <<= 1;
+    }
+    m_LongOffset = 128 - longLag;
+    m_ShortOffset = 128 - shortLag;
+
+    // 前 128 位逐位生成，寄存器初值全 1
+    bool bits[128];
+    for (int k = 0; k < 128; ++k) {
+        bits[k] = k < longTap ? true : bits[k - longTap] != bits[k - tap];
+    }
+    for (int k = 0; k < 64; ++k) {
+        m_Older |= static_cast<uint64_t>(bits[k]) << k;
+        m_Newer |= static_cast<uint64_t>(bits[k + 64]) << k;
+    }
+}
+
+CPrbsGenerator::Pattern CPrbsGenerator::pattern() const
+{
+    return m_Pattern;
+}
+
+bool CPrbsGenerator::seed(const uint8_t *history)
+{
+    m_Older = loadWord(history);
+    m_Newer = loadWord(history + 8);
+    m_Pending = 0;
+    m_PendingBytes = 0;
+    return (m_Older | m_Newer) != 0;
+}
+
+void CPrbsGenerator::generate(uint8_t *out, size_t size)
+{
+    for (; size > 0 && m_PendingBytes > 0; --size, --m_PendingBytes) {
+        *out++ = static_cast<uint8_t>(m_Pending);
+        m_Pending >>= 8;
+    }
+    for (; size >= 8; size -= 8, out += 8) {
+        const uint64_t word = nextWord();
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<uint8_t>(word >> (8 * i));
+        }
+    }
+    if (size > 0) {
+        uint64_t word = nextWord();
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = static_cast<uint8_t>(word);
+            word >>= 8;
+        }
+        m_Pending = word;
+        m_PendingBytes = static_cast<int>(8 - size);
+    }
+}
+
+void CPrbsGenerator::skip(size_t size)
+{
+    for (; size > 0 && m_PendingBytes > 0; --size, --m_PendingBytes) {
+        m_Pending >>= 8;
+    }
+    for (; size >= 8; size -= 8) {
+        nextWord();
+    }
+    if (size > 0) {
+        m_Pending = nextWord() >> (8 * size);
+        m_PendingBytes = static_cast<int>(8 - size);
+    }
+}
+
+uint64_t CPrbsGenerator::nextWord()
+{
+    // 最近 128 位中从 offset 起的 64 位；两个偏移都在 (0, 64) 之间
+    const auto window = [this](int offset) { return (m_Older >> offset) | (m_Newer << (64 - offset)); };
+    const uint64_t word = window(m_LongOffset) ^ window(m_ShortOffset);
+    m_Older = m_Newer;
+    m_Newer = word;
+    return word;
+}
+
+CPrbsChecker::CPrbsChecker(CPrbsGenerator::Pattern pattern)
+    : m_Reference(pattern)
+    , m_LostReference(pattern)
+{
+    m_Current.bytes.reserve(kWindowBytes);
+    m_Previous.bytes.reserve(kWindowBytes);
+}
+
+void CPrbsChecker::check(const uint8_t *data, size_t size)
+{
+    m_Stats.bytes += size;
+    if (m_Stats.isLocked) {
+        checkLocked(data, size);
+    } else {
+        m_Acquire.insert(m_Acquire.end(), data, data + size);
+    }
+    // 锁定后捕获缓冲中剩下的字节按锁定状态继续比较，其中再次失步时又回到捕获
+    while (!m_Stats.isLocked && acquire()) {
+        std::vector<uint8_t> rest;
+        rest.swap(m_Acquire);
+        checkLocked(rest.data(), rest.size());
+    }
+}
+
+const CPrbsChecker::Stats &CPrbsChecker::stats() const
+{
+    return m_Stats;
+}
+
+double CPrbsChecker::bitErrorRate() const
+{
+    return m_Stats.checkedBits > 0 ? static_cast<double>(m_Stats.bitErrors) / static_cast<double>(m_Stats.checkedBits)
+                                   : 0.0;
+}
+
+uint64_t CPrbsChecker::streamPosition() const
+{
+    return m_Stats.bytes + m_Stats.lostBytes - std::min(m_Stats.insertedBytes, m_Stats.bytes + m_Stats.lostBytes);
+}
+
+uint64_t CPrbsChecker::countBitErrors(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    uint64_t errors = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        errors += popCount(x ^ y);
+    }
+    for (; i < size; ++i) {
+        errors += popCount(static_cast<uint64_t>(a[i] ^ b[i]));
+    }
+    return errors;
+}
+
+void CPrbsChecker::checkLocked(const uint8_t *data, size_t size)
+{
+    while (size > 0) {
+        if (m_Current.bytes.empty()) {
+            m_Current.start = m_Reference;
+        }
+        const size_t count = std::min(size, kWindowBytes - m_Current.bytes.size());
+        m_Expected.resize(count);
+        m_Reference.generate(m_Expected.data(), count);
+        m_Current.errors += countBitErrors(data, m_Expected.data(), count);
+        m_Current.bytes.insert(m_Current.bytes.end(), data, data + count);
+        data += count;
+        size -= count;
+        if (m_Current.bytes.size() == kWindowBytes && !closeWindow()) {
+            // 失步：失步窗口之后的数据也交给捕获
+            m_Acquire.insert(m_Acquire.end(), data, data + size);
+            return;
+        }
+    }
+}
+
+bool CPrbsChecker::closeWindow()
+{
+    if (m_Current.errors <= kSyncLossBits) {
+        // 窗口延后一个再计入：错位常发生在窗口中间，前半段误码不多，要等下一个窗口确认
+        if (!m_Previous.bytes.empty()) {
+            m_Stats.checkedBits += m_Previous.bytes.size() * 8;
+            m_Stats.bitErrors += m_Previous.errors;
+            m_HasCommittedSinceLock = true;
+        }
+        std::swap(m_Previous, m_Current);
+        m_Current.bytes.clear();
+        m_Current.errors = 0;
+        return true;
+    }
+    // 从尚未计入的最早窗口起重新捕获
+    if (m_HasCommittedSinceLock) {
+        ++m_Stats.syncLosses;
+    }
+    m_Stats.isLocked = false;
+    Window &first = m_Previous.bytes.empty() ? m_Current : m_Previous;
+    m_LostReference = first.start;
+    m_HasLostReference = true;
+    m_Acquire.clear();
+    if (!m_Previous.bytes.empty()) {
+        m_Acquire.insert(m_Acquire.end(), m_Previous.bytes.begin(), m_Previous.bytes.end());
+    }
+    m_Acquire.insert(m_Acquire.end(), m_Current.bytes.begin(), m_Current.bytes.end());
+    m_AcquireScanned = 0;
+    for (Window *window : {&m_Previous, &m_Current}) {
+        window->bytes.clear();
+        window->errors = 0;
+    }
+    return false;
+}
+
+bool CPrbsChecker::acquire()
+{
+    size_t &offset = m_AcquireScanned;
+    uint8_t expected[kVerifyBytes];
+    for (; m_Acquire.size() - offset >= kSeedBytes + kVerifyBytes; ++offset) {
+        CPrbsGenerator candidate(m_Reference.pattern());
+        if (!candidate.seed(&m_Acquire[offset])) {
+            continue;
+        }
+        candidate.generate(expected, kVerifyBytes);
+        if (std::memcmp(expected, &m_Acquire[offset + kSeedBytes], kVerifyBytes) != 0) {
+            continue;
+        }
+        resolveSlip(candidate, offset);
+        // 种子与验证段按构造必然吻合，不计入误码率
+        m_Stats.uncheckedBytes += kSeedBytes + kVerifyBytes;
+        m_Acquire.erase(m_Acquire.begin(), m_Acquire.begin() + static_cast<std::ptrdiff_t>(offset + kSeedBytes + kVerifyBytes));
+        m_AcquireScanned = 0;
+        m_Reference = candidate;
+        m_Stats.isLocked = true;
+        m_HasCommittedSinceLock = false;
+        return true;
+    }
+    // 长时间无法锁定（线路断开、速率不对）时只保留最近的数据，失步前的序列随之前移
+    if (m_Acquire.size() > kMaxAcquireBytes) {
+        const size_t drop = std::min(offset, m_Acquire.size() - kMaxAcquireBytes / 2);
+        m_Acquire.erase(m_Acquire.begin(), m_Acquire.begin() + static_cast<std::ptrdiff_t>(drop));
+        offset -= drop;
+        m_Stats.uncheckedBytes += drop;
+        if (m_HasLostReference) {
+            m_LostReference.skip(drop);
+        }
+    }
+    return false;
+}
+
+void CPrbsChecker::resolveSlip(const CPrbsGenerator &locked, size_t seedOffset)
+{
+    if (!m_HasLostReference) {
+        // 首次锁定，之前的字节可能是测试开始前线路上的残留
+        m_Stats.uncheckedBytes += seedOffset;
+        return;
+    }
+    m_HasLostReference = false;
+    // locked 已生成过验证段，对应验证段之后的接收位置；失步前的序列推进到同一位置后，
+    // 中间丢了 d 个字节时 locked 等于它再向前 d 个字节，多出 e 个字节时 locked 落后 e 个字节
+    CPrbsGenerator probe = m_LostReference;
+    probe.skip(seedOffset + kSeedBytes + kVerifyBytes);
+    const auto findOffset = [](CPrbsGenerator from, const CPrbsGenerator &to, size_t range) {
+        uint8_t target[kSeedBytes];
+        CPrbsGenerator(to).generate(target, sizeof(target));
+        std::vector<uint8_t> stream(range + sizeof(target));
+        from.generate(stream.data(), stream.size());
+        const auto found = std::search(stream.begin(), stream.end(), std::begin(target), std::end(target));
+        return found == stream.end() ? range + 1 : static_cast<size_t>(found - stream.begin());
+    };
+    const size_t lost = findOffset(probe, locked, kMaxSlipSearch);
+    if (lost == 0) {
+        // 没有错位，只是一段突发误码：按失步前的序列补算这段数据
+        if (seedOffset > 0) {
+            m_Expected.resize(seedOffset);
+            CPrbsGenerator(m_LostReference).generate(m_Expected.data(), seedOffset);
+            m_Stats.bitErrors += countBitErrors(m_Acquire.data(), m_Expected.data(), seedOffset);
+            m_Stats.checkedBits += static_cast<uint64_t>(seedOffset) * 8;
+        }
+        return;
+    }
+    // 多出一个字节在长序列中表现为丢失将近一个周期，近处的多出优先于远处的丢失
+    const size_t inserted = lost < kMaxInsertSearch ? kMaxInsertSearch + 1 : findOffset(locked, probe, kMaxInsertSearch);
+    if (inserted <= kMaxInsertSearch) {
+        m_Stats.insertedBytes += inserted;
+    } else if (lost <= kMaxSlipSearch) {
+        m_Stats.lostBytes += lost;
+    } else {
+        ++m_Stats.unresolvedSlips;
+    }
+    m_Stats.uncheckedBytes += seedOffset;
+}
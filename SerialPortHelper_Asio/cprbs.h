@@ -0,0 +1,119 @@
+#ifndef CPRBS_H
+#define CPRBS_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// PRBS（伪随机二进制序列）生成与校验，用于发送口接接收口的误码测试。
+// 多项式取 ITU-T O.150 的 x^7+x^6+1、x^15+x^14+1、x^23+x^18+1、x^31+x^28+1，序列满足 s[k] = s[k-n] ^ s[k-m]。
+// 字节按线路上的顺序打包（低位先发），线路上看到的比特流就是 PRBS 本身。
+// 逐位移位寄存器每字节要 8 轮，这里一次算 64 位：多项式平方 2^j 次后递推变为 s[k] = s[k-n·2^j] ^ s[k-m·2^j]，
+// 取 m·2^j >= 64，新的 64 位只依赖前 128 位，每个字只需两次拼接移位和一次异或。
+// 校验同样按 64 位字异或后数 1 的个数，12 Mbaud（约 1.2 MB/s）只占单核很小一部分。
+// 不依赖 Qt，引擎与命令行工具共用
+class CPrbsGenerator
+{
+public:
+    enum Pattern
+    {
+        Prbs7 = 7,
+        Prbs15 = 15,
+        Prbs23 = 23,
+        Prbs31 = 31
+    };
+
+    static bool isValidPattern(int order);
+
+    // 从全 1 状态起步，不同对象输出同一序列
+    explicit CPrbsGenerator(Pattern pattern = Prbs15);
+
+    Pattern pattern() const;
+    // 以序列中连续的 kSeedBytes 字节为历史，从紧接其后的字节继续生成；全 0（不可能出现在序列中）时返回 false
+    static constexpr size_t kSeedBytes = 16;
+    bool seed(const uint8_t *history);
+    void generate(uint8_t *out, size_t size);
+    void skip(size_t size);
+
+private:
+    uint64_t nextWord();
+
+    Pattern m_Pattern;
+    int m_LongOffset = 0;    // 128 位窗口中 s[k-n·2^j] 的起点
+    int m_ShortOffset = 0;   // 128 位窗口中 s[k-m·2^j] 的起点
+    uint64_t m_Older = 0;    // 最近 128 位的前半
+    uint64_t m_Newer = 0;    // 最近 128 位的后半
+    uint64_t m_Pending = 0;  // 上一次生成时没用完的字，从低字节起输出
+    int m_PendingBytes = 0;
+};
+
+// 自同步校验：未锁定时从收到的数据里取 16 字节作种子，后续 32 字节完全吻合即锁定，之后逐字节与本地序列比较。
+// 以 64 字节为窗口判断是否失步：误码超过窗口的 1/5 说明字节丢失或多出（序列错位后约一半比特不同），
+// 该窗口不计入误码率，重新捕获；重新锁定后从失步前的序列向前搜索，找出丢失（或多出）的字节数。
+// 找到的偏移为 0 时说明只是一段突发误码，这段数据按失步前的序列补算误码。
+// PRBS-7 的周期只有 127 字节，错位量只能确定到 127 的整数倍以内（多出 k 字节记为丢失 127-k 字节）
+class CPrbsChecker
+{
+public:
+    struct Stats
+    {
+        uint64_t bytes = 0;           // 收到的全部字节
+        uint64_t checkedBits = 0;     // 锁定期间比较过的比特数
+        uint64_t bitErrors = 0;
+        uint64_t syncLosses = 0;      // 失步次数
+        uint64_t lostBytes = 0;       // 重新锁定时找回的丢失字节数
+        uint64_t insertedBytes = 0;   // 重新锁定时找回的多出字节数
+        uint64_t unresolvedSlips = 0; // 超出搜索范围、无法确定错位量的重新锁定次数
+        uint64_t uncheckedBytes = 0;  // 捕获过程中未能比较的字节数
+        bool isLocked = false;
+    };
+
+    // 重新锁定时向前搜索的最大丢失字节数
+    static constexpr size_t kMaxSlipSearch = 64 * 1024;
+    static constexpr size_t kMaxInsertSearch = 256;
+
+    explicit CPrbsChecker(CPrbsGenerator::Pattern pattern = CPrbsGenerator::Prbs15);
+
+    void check(const uint8_t *data, size_t size);
+    const Stats &stats() const;
+    // 误码率：误码 / 比较过的比特数，尚未比较时为 0
+    double bitErrorRate() const;
+    // 已收到的最后一个字节在发送序列中的位置（从 1 计）：收到的字节数加上找回的丢失字节、减去多出的字节
+    uint64_t streamPosition() const;
+
+    // a、b 前 size 字节中不同的比特数
+    static uint64_t countBitErrors(const uint8_t *a, const uint8_t *b, size_t size);
+
+private:
+    struct Window
+    {
+        std::vector<uint8_t> bytes;
+        uint64_t errors = 0;
+        CPrbsGenerator start;   // 窗口起点的序列状态，失步时据此搜索错位
+    };
+
+    static constexpr size_t kSeedBytes = CPrbsGenerator::kSeedBytes;
+    static constexpr size_t kVerifyBytes = 32;
+    static constexpr size_t kWindowBytes = 64;
+    static constexpr uint64_t kSyncLossBits = kWindowBytes * 8 / 5;
+    static constexpr size_t kMaxAcquireBytes = 8 * 1024;
+
+    void checkLocked(const uint8_t *data, size_t size);
+    bool closeWindow();
+    bool acquire();
+    void resolveSlip(const CPrbsGenerator &locked, size_t seedOffset);
+
+    CPrbsGenerator m_Reference;
+    // 当前窗口与上一个尚未计入统计的窗口
+    Window m_Current;
+    Window m_Previous;
+    bool m_HasCommittedSinceLock = false;
+    std::vector<uint8_t> m_Expected;
+    // 失步后的捕获缓冲，m_LostReference 对应其第一个字节
+    std::vector<uint8_t> m_Acquire;
+    size_t m_AcquireScanned = 0;         // 已试过作种子的起点
+    CPrbsGenerator m_LostReference;
+    bool m_HasLostReference = false;
+    Stats m_Stats;
+};
+
+#endif // CPRBS_H
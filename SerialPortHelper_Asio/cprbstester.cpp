@@ -0,0 +1,276 @@
+#include "cprbstester.h"
+#include "cserialportmanager.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr std::chrono::milliseconds kChunkWireTime{5};
+constexpr size_t kMinChunkSize = 64;
+constexpr size_t kMaxChunkSize = 16 * 1024;
+constexpr size_t kDefaultChunkSize = 1024;
+// 发送口未打开（或正在重连）时重试写入的间隔
+constexpr std::chrono::milliseconds kRetryInterval{100};
+// stop() 等待 I/O 线程移除旁路、停止发送的上限
+constexpr std::chrono::seconds kStopTimeout{2};
+}
+
+struct CPrbsTester::State : std::enable_shared_from_this<State>
+{
+    State(boost::asio::io_context &ioContext, CPrbsGenerator::Pattern pattern)
+        : retryTimer(ioContext)
+        , generator(pattern)
+        , checker(pattern)
+    {
+        snapshot.isRunning = true;
+        snapshot.pattern = pattern;
+    }
+
+    void pump();
+    void handleRead(const char *data, size_t size, std::chrono::steady_clock::time_point arrival);
+    void publish(std::chrono::steady_clock::time_point arrival);
+    void shutdown();
+
+    boost::asio::steady_timer retryTimer;
+    CSerialPortManager *sender = nullptr;     // 停止后置空，之后的回调不再访问串口
+    CSerialPortManager *receiver = nullptr;
+    int readTapId = 0;
+    size_t chunkSize = 0;
+    CPrbsGenerator generator;
+    CPrbsChecker checker;
+    std::vector<std::shared_ptr<std::vector<char>>> buffers;
+    std::vector<size_t> freeBuffers;
+    // 已生成但发送口拒绝写入的块，等重试时原样送出，保持序列连续
+    bool hasHeldChunk = false;
+    size_t heldBuffer = 0;
+    bool isRetryArmed = false;
+    quint64 sentBytes = 0;
+    // 每块最后一个字节在序列中的位置（从 1 计）与交给发送口的时刻
+    std::deque<std::pair<quint64, std::chrono::steady_clock::time_point>> handoffs;
+    bool hasArrival = false;
+    std::chrono::steady_clock::time_point firstArrival;
+    quint64 firstReadBytes = 0;
+    double latencySumUs = 0.0;
+    std::atomic<bool> isRunning{true};
+
+    mutable std::mutex snapshotMutex;
+    Stats snapshot;
+};
+
+void CPrbsTester::State::pump()
+{
+    while (sender != nullptr && isRunning.load() && (hasHeldChunk || !freeBuffers.empty())) {
+        size_t index = heldBuffer;
+        if (!hasHeldChunk) {
+            index = freeBuffers.back();
+            freeBuffers.pop_back();
+            generator.generate(reinterpret_cast<uint8_t *>(buffers[index]->data()), chunkSize);
+            hasHeldChunk = true;
+            heldBuffer = index;
+        }
+        auto self = shared_from_this();
+        const auto handoff = std::chrono::steady_clock::now();
+        if (!sender->writeShared(buffers[index], chunkSize, [self, index]() {
+                self->freeBuffers.push_back(index);
+                self->pump();
+            })) {
+            if (!isRetryArmed) {
+                isRetryArmed = true;
+                retryTimer.expires_after(kRetryInterval);
+                retryTimer.async_wait([self](const boost::system::error_code &error) {
+                    self->isRetryArmed = false;
+                    if (error) {
+                        return;
+                    }
+                    self->pump();
+                });
+            }
+            return;
+        }
+        hasHeldChunk = false;
+        sentBytes += chunkSize;
+        handoffs.emplace_back(sentBytes, handoff);
+    }
+}
+
+void CPrbsTester::State::handleRead(const char *data, size_t size, std::chrono::steady_clock::time_point arrival)
+{
+    const CPrbsChecker::Stats before = checker.stats();
+    checker.check(reinterpret_cast<const uint8_t *>(data), size);
+    const CPrbsChecker::Stats &after = checker.stats();
+    if (!hasArrival) {
+        hasArrival = true;
+        firstArrival = arrival;
+        firstReadBytes = size;
+    }
+    // 本次读取前后一直锁定且没有错位时，读到的就是紧接上次的序列，其中结束的块可以算时延；
+    // 发生错位的那次读取无法确定块边界落在哪里（端口关闭时被丢弃的块也会表现为错位），只出队不计时延
+    const bool isAligned = before.isLocked && after.isLocked && after.syncLosses == before.syncLosses
+                           && after.lostBytes == before.lostBytes && after.insertedBytes == before.insertedBytes
+                           && after.unresolvedSlips == before.unresolvedSlips;
+    const quint64 position = checker.streamPosition();
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    while (!handoffs.empty() && handoffs.front().first <= position) {
+        if (isAligned && handoffs.front().first + size > position) {
+            const double latencyUs =
+                std::chrono::duration<double, std::micro>(arrival - handoffs.front().second).count();
+            Stats &stats = snapshot;
+            stats.minLatencyUs = stats.latencySamples == 0 ? latencyUs : std::min(stats.minLatencyUs, latencyUs);
+            stats.maxLatencyUs = std::max(stats.maxLatencyUs, latencyUs);
+            stats.lastLatencyUs = latencyUs;
+            ++stats.latencySamples;
+            latencySumUs += latencyUs;
+            stats.meanLatencyUs = latencySumUs / static_cast<double>(stats.latencySamples);
+        }
+        handoffs.pop_front();
+    }
+    publish(arrival);
+}
+
+// 调用方持有 snapshotMutex
+void CPrbsTester::State::publish(std::chrono::steady_clock::time_point arrival)
+{
+    Stats &stats = snapshot;
+    stats.sentBytes = sentBytes;
+    stats.checker = checker.stats();
+    stats.bitErrorRate = checker.bitErrorRate();
+    const quint64 position = checker.streamPosition();
+    stats.pendingBytes = sentBytes > position ? sentBytes - position : 0;
+    if (hasArrival) {
+        // 第一次读取的字节在计时起点之前就已到达
+        stats.seconds = std::chrono::duration<double>(arrival - firstArrival).count();
+        stats.bytesPerSecond =
+            stats.seconds > 0.0 ? static_cast<double>(stats.checker.bytes - firstReadBytes) / stats.seconds : 0.0;
+        const auto characterTime = receiver != nullptr ? receiver->characterTime() : std::chrono::nanoseconds(0);
+        if (characterTime.count() > 0) {
+            stats.lineUtilization = stats.bytesPerSecond * std::chrono::duration<double>(characterTime).count();
+        }
+    }
+}
+
+void CPrbsTester::State::shutdown()
+{
+    boost::system::error_code ec;
+    retryTimer.cancel(ec);
+    if (receiver != nullptr) {
+        receiver->removeReadTap(readTapId);
+    }
+    sender = nullptr;
+    receiver = nullptr;
+    isRunning.store(false);
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshot.isRunning = false;
+    snapshot.sentBytes = sentBytes;
+}
+
+CPrbsTester::CPrbsTester(boost::asio::io_context &ioContext)
+    : m_IoContext(ioContext)
+{
+}
+
+CPrbsTester::~CPrbsTester()
+{
+    stop();
+}
+
+bool CPrbsTester::start(CSerialPortManager *sender, CSerialPortManager *receiver, const Options &options,
+                        std::string *error)
+{
+    if (isRunning()) {
+        if (error) {
+            *error = "PRBS test is already running";
+        }
+        return false;
+    }
+    // 读取旁路和 writeShared 只能在串口的 I/O 线程上使用
+    if (sender == nullptr || receiver == nullptr || &sender->ioContext() != &m_IoContext
+        || &receiver->ioContext() != &m_IoContext) {
+        if (error) {
+            *error = "Both serial ports must run on the tester's I/O context";
+        }
+        return false;
+    }
+    if (!CPrbsGenerator::isValidPattern(options.pattern)) {
+        if (error) {
+            *error = "Unsupported PRBS pattern";
+        }
+        return false;
+    }
+    size_t chunkSize = options.chunkSize;
+    if (chunkSize == 0) {
+        const auto characterTime = sender->characterTime();
+        chunkSize = characterTime.count() > 0
+                        ? static_cast<size_t>(std::chrono::nanoseconds(kChunkWireTime).count() / characterTime.count())
+                        : kDefaultChunkSize;
+    }
+    chunkSize = std::clamp(chunkSize, kMinChunkSize, kMaxChunkSize);
+
+    auto state = std::make_shared<State>(m_IoContext, options.pattern);
+    state->chunkSize = chunkSize;
+    for (int i = 0; i < kChunksInFlight; ++i) {
+        state->buffers.push_back(std::make_shared<std::vector<char>>(chunkSize));
+        state->freeBuffers.push_back(static_cast<size_t>(i));
+    }
+    m_p_State = state;
+    boost::asio::post(m_IoContext, [state, sender, receiver]() {
+        if (!state->isRunning.load()) {
+            return;
+        }
+        state->sender = sender;
+        state->receiver = receiver;
+        std::weak_ptr<State> weak = state;
+        state->readTapId = receiver->addReadTap(
+            [weak](const std::shared_ptr<std::vector<char>> &buffer, size_t size,
+                   std::chrono::steady_clock::time_point arrival) {
+                if (auto locked = weak.lock()) {
+                    locked->handleRead(buffer->data(), size, arrival);
+                }
+            });
+        state->pump();
+    });
+    return true;
+}
+
+void CPrbsTester::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    // 保留 m_p_State 供 stats() 读取最后的统计
+    auto state = m_p_State;
+    if (m_IoContext.get_executor().running_in_this_thread() || m_IoContext.stopped()) {
+        // 在 I/O 线程上，或 io_context 已停止（如主窗口析构时注册表的 I/O 线程已退出）不会再执行回调，直接收尾
+        state->shutdown();
+        return;
+    }
+    // 在 I/O 线程上移除读取旁路并停止发送，等它完成后调用方才能关闭或销毁串口
+    auto done = std::make_shared<std::promise<void>>();
+    auto finished = done->get_future();
+    boost::asio::post(m_IoContext, [state, done]() {
+        state->shutdown();
+        done->set_value();
+    });
+    if (finished.wait_for(kStopTimeout) == std::future_status::timeout) {
+        // 没有线程在运行 io_context：先停止发送，旁路在投递的收尾执行时移除
+        state->isRunning.store(false);
+    }
+}
+
+bool CPrbsTester::isRunning() const
+{
+    return m_p_State && m_p_State->isRunning.load();
+}
+
+CPrbsTester::Stats CPrbsTester::stats() const
+{
+    if (!m_p_State) {
+        return Stats();
+    }
+    std::lock_guard<std::mutex> lock(m_p_State->snapshotMutex);
+    return m_p_State->snapshot;
+}
@@ -0,0 +1,69 @@
+#ifndef CPRBSTESTER_H
+#define CPRBSTESTER_H
+#include "cprbs.h"
+
+#include <QtGlobal>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+
+class CSerialPortManager;
+
+// 误码测试：发送口连续写出 PRBS，接收口（两口之间接线，或同一口插环回头）自同步校验，
+// 统计误码率、丢失/多出字节、持续吞吐与单向时延。
+// 与 CSerialTcpServer 一样运行在串口的 io_context 上：以读取旁路拿接收口的读取缓冲，
+// 以 writeShared 把生成缓冲直接送入发送口写队列，两个方向都不经过界面线程。
+// 写队列中最多保留 kChunksInFlight 块，写完一块再生成一块，发送速率由线路决定。
+// 单向时延取每块最后一个字节：接收口读取完成时刻减去该块交给发送口的时刻，满载时包含驱动发送缓冲中的排队。
+// 公共接口可在任意线程调用
+// stop()（及析构）在 io_context 已停止时直接在调用线程上收尾；io_context 未停止却没有线程运行它时最多等待 2 s，
+// 之后只停止发送，读取旁路留到 io_context 再运行时移除，此前两个串口必须保持有效
+class CPrbsTester
+{
+public:
+    static constexpr int kChunksInFlight = 4;
+
+    struct Options
+    {
+        CPrbsGenerator::Pattern pattern = CPrbsGenerator::Prbs15;
+        size_t chunkSize = 0;   // 每块字节数，0 时按发送口波特率取约 5 ms 线路时间
+    };
+
+    struct Stats
+    {
+        bool isRunning = false;
+        CPrbsGenerator::Pattern pattern = CPrbsGenerator::Prbs15;
+        quint64 sentBytes = 0;            // 已交给发送口的字节数
+        CPrbsChecker::Stats checker;
+        double bitErrorRate = 0.0;
+        quint64 pendingBytes = 0;         // 已发出、尚未收到也未判为丢失的字节数（含线路上在途的）
+        double seconds = 0.0;             // 从第一个字节到达到最后一个字节到达
+        double bytesPerSecond = 0.0;      // 持续吞吐
+        double lineUtilization = 0.0;     // 吞吐 / 接收口按帧格式折算的线路容量
+        quint64 latencySamples = 0;
+        double lastLatencyUs = 0.0;
+        double minLatencyUs = 0.0;
+        double meanLatencyUs = 0.0;
+        double maxLatencyUs = 0.0;
+    };
+
+    explicit CPrbsTester(boost::asio::io_context &ioContext);
+    ~CPrbsTester();
+
+    // sender、receiver 必须运行在同一个共享的 io_context 上（同一个 CSerialPortRegistry），可以是同一个口；
+    // 独占 io_context 的端口关闭时要跑空 io_context，与发送口关闭期间的重试定时器冲突，不支持；
+    // 测试期间两口关闭重开不影响测试，关闭期间的数据计为丢失
+    bool start(CSerialPortManager *sender, CSerialPortManager *receiver, const Options &options, std::string *error);
+    // 停止发送并移除读取旁路，返回后不再访问两个串口；最后一次的统计仍可读取
+    void stop();
+    bool isRunning() const;
+    Stats stats() const;
+
+private:
+    struct State;
+
+    boost::asio::io_context &m_IoContext;
+    std::shared_ptr<State> m_p_State;   // 写完回调与读取旁路共同持有，停止后随最后一个回调释放
+};
+
+#endif // CPRBSTESTER_H
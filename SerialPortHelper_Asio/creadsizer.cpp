@@ -0,0 +1,102 @@
+#include "creadsizer.h"
+
+#include <algorithm>
+
+CReadSizer::CReadSizer(size_t maxSize)
+    : m_MaxSize(std::max(maxSize, kMinimumSize))
+    , m_Size(kMinimumSize)
+{
+}
+
+void CReadSizer::setBaudRate(unsigned baudRate)
+{
+    // 10 位/字节，2 ms 的数据量，向上取 2 的幂
+    const size_t bytes = static_cast<size_t>(baudRate) / 10 / 500;
+    size_t minSize = kMinimumSize;
+    while (minSize < bytes) {
+        minSize <<= 1;
+    }
+    m_MinSize = std::min(minSize, m_MaxSize);
+    m_Size = clamp(m_Size);
+}
+
+void CReadSizer::setMaxSize(size_t maxSize)
+{
+    m_MaxSize = std::max(maxSize, kMinimumSize);
+    m_MinSize = std::min(m_MinSize, m_MaxSize);
+    m_Size = clamp(m_Size);
+}
+
+size_t CReadSizer::minSize() const
+{
+    return m_MinSize;
+}
+
+size_t CReadSizer::maxSize() const
+{
+    return m_MaxSize;
+}
+
+void CReadSizer::startAtMax()
+{
+    reset();
+    m_Size = m_MaxSize;
+}
+
+void CReadSizer::reset()
+{
+    m_Histogram.fill(0);
+    m_Samples = 0;
+    m_Size = m_MinSize;
+}
+
+size_t CReadSizer::size() const
+{
+    return m_Size;
+}
+
+void CReadSizer::record(size_t bytesTransferred)
+{
+    if (bytesTransferred >= m_Size) {
+        // 读满：内核缓冲里还有积压，下一次直接翻倍，重新开始统计
+        m_Size = clamp(m_Size * 2);
+        m_Histogram.fill(0);
+        m_Samples = 0;
+        return;
+    }
+    ++m_Histogram[static_cast<size_t>(bucketOf(bytesTransferred))];
+    if (++m_Samples < kWindow) {
+        return;
+    }
+
+    // 取窗口内第 90 百分位所在桶的上界（2 << bucket），再留一倍余量作为目标大小
+    int seen = 0;
+    int bucket = 0;
+    for (; bucket < kBucketCount - 1; ++bucket) {
+        seen += static_cast<int>(m_Histogram[static_cast<size_t>(bucket)]);
+        if (seen * 10 >= kWindow * 9) {
+            break;
+        }
+    }
+    const size_t target = clamp(static_cast<size_t>(4) << bucket);
+    if (target * 4 <= m_Size) {
+        m_Size = std::max(target, m_Size / 2);
+    }
+    m_Histogram.fill(0);
+    m_Samples = 0;
+}
+
+int CReadSizer::bucketOf(size_t bytes)
+{
+    int bucket = 0;
+    while (bytes > 1 && bucket < kBucketCount - 1) {
+        bytes >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+size_t CReadSizer::clamp(size_t size) const
+{
+    return std::min(std::max(size, m_MinSize), m_MaxSize);
+}
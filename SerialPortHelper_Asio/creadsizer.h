@@ -0,0 +1,45 @@
+#ifndef CREADSIZER_H
+#define CREADSIZER_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// async_read_some 的请求大小自适应：下限由波特率折算，上限由配置决定，
+// 中间按最近若干次完成的 bytesTransferred 直方图放大或缩小。
+// 读满缓冲说明内核里还有数据在等，立即翻倍；长期用不到四分之一时才减半，避免来回抖动。
+class CReadSizer
+{
+public:
+    static constexpr size_t kDefaultMaxSize = 64 * 1024;
+    static constexpr size_t kMinimumSize = 64;
+
+    explicit CReadSizer(size_t maxSize = kDefaultMaxSize);
+
+    // 下限取约 2 ms 线路时间的数据量，高速率下第一读就不至于过小
+    void setBaudRate(unsigned baudRate);
+    void setMaxSize(size_t maxSize);
+    size_t minSize() const;
+    size_t maxSize() const;
+
+    // 从上限开始（高吞吐模式），之后仍按直方图调整
+    void startAtMax();
+    void reset();
+
+    size_t size() const;
+    void record(size_t bytesTransferred);
+
+private:
+    static constexpr int kBucketCount = 32;   // 按 2 的幂分桶
+    static constexpr int kWindow = 64;        // 每隔多少次完成评估一次是否缩小
+
+    static int bucketOf(size_t bytes);
+    size_t clamp(size_t size) const;
+
+    size_t m_MinSize = kMinimumSize;
+    size_t m_MaxSize;
+    size_t m_Size;
+    std::array<uint32_t, kBucketCount> m_Histogram{};
+    int m_Samples = 0;
+};
+
+#endif // CREADSIZER_H
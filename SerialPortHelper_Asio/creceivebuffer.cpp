@@ -0,0 +1,246 @@
+#include "creceivebuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+CReceiveBuffer::CReceiveBuffer(uint64_t capacity)
+    : m_Capacity(std::max<uint64_t>(capacity, kBlockSize))
+{
+    m_LineStarts.push_back(0);
+}
+
+void CReceiveBuffer::setCapacity(uint64_t capacity)
+{
+    m_Capacity = std::max<uint64_t>(capacity, kBlockSize);
+    dropFront();
+}
+
+uint64_t CReceiveBuffer::capacity() const
+{
+    return m_Capacity;
+}
+
+void CReceiveBuffer::append(const char *data, size_t size, int64_t timestampNs, int stream)
+{
+    if (size == 0) {
+        return;
+    }
+    const bool isStreamChanged = stream != (m_StreamMarks.empty() ? 0 : m_StreamMarks.back().stream);
+    if (isStreamChanged) {
+        // 切换处强制断行，每行只属于一路数据；先把之前的数据编入行索引，断点才能按顺序追加
+        indexPending();
+        if (m_LineStarts.back() != m_End) {
+            m_LineStarts.push_back(m_End);
+        }
+        m_StreamMarks.push_back({m_End, stream});
+    }
+    // 低波特率下每次读取可能只有一两个字节，逐次记录的时间标记会比数据本身还大；
+    // 切换 stream 时照常记录，新行的时间戳不沿用另一路的
+    if (timestampNs != 0
+        && (isStreamChanged || m_TimeMarks.empty()
+            || timestampNs - m_TimeMarks.back().timestampNs >= kTimeMarkResolutionNs)) {
+        m_TimeMarks.push_back({m_End, timestampNs});
+    }
+    while (size > 0) {
+        const uint64_t used = m_End - m_BlockBase;
+        const size_t blockIndex = static_cast<size_t>(used / kBlockSize);
+        const size_t inBlock = static_cast<size_t>(used % kBlockSize);
+        if (blockIndex == m_Blocks.size()) {
+            // 不用 make_unique，避免每块 1 MiB 的清零
+            m_Blocks.emplace_back(new char[kBlockSize]);
+        }
+        const size_t span = std::min(size, kBlockSize - inBlock);
+        std::memcpy(m_Blocks[blockIndex].get() + inBlock, data, span);
+        data += span;
+        size -= span;
+        m_End += span;
+    }
+    // 行索引的大小要计入容量，不能等到查询时才一次性建立
+    if (m_End - std::max(m_IndexedOffset, m_Begin) >= kBlockSize) {
+        indexPending();
+    }
+    dropFront();
+}
+
+void CReceiveBuffer::clear()
+{
+    m_Blocks.clear();
+    m_BlockBase = 0;
+    m_Begin = 0;
+    m_End = 0;
+    m_TimeMarks.clear();
+    m_StreamMarks.clear();
+    m_LineStarts.clear();
+    m_LineStarts.push_back(0);
+    m_FirstLine = 0;
+    m_IndexedOffset = 0;
+}
+
+uint64_t CReceiveBuffer::beginOffset() const
+{
+    return m_Begin;
+}
+
+uint64_t CReceiveBuffer::endOffset() const
+{
+    return m_End;
+}
+
+uint64_t CReceiveBuffer::size() const
+{
+    return m_End - m_Begin;
+}
+
+uint64_t CReceiveBuffer::firstLine()
+{
+    return m_FirstLine;
+}
+
+uint64_t CReceiveBuffer::endLine()
+{
+    indexPending();
+    return m_FirstLine + m_LineStarts.size();
+}
+
+uint64_t CReceiveBuffer::lineStart(uint64_t line)
+{
+    indexPending();
+    if (line < m_FirstLine) {
+        return m_Begin;
+    }
+    const uint64_t index = line - m_FirstLine;
+    return index < m_LineStarts.size() ? m_LineStarts[static_cast<size_t>(index)] : m_End;
+}
+
+void CReceiveBuffer::lineRange(uint64_t line, uint64_t &start, uint64_t &end)
+{
+    start = lineStart(line);
+    end = lineStart(line + 1);
+    if (end > start && end <= m_End && line + 1 < endLine()) {
+        // 折行产生的行不以 '\n' 结尾，只有真正的换行才需要去掉
+        char last = 0;
+        copy(end - 1, &last, 1);
+        if (last == '\n') {
+            --end;
+        }
+    }
+}
+
+uint64_t CReceiveBuffer::lineAtOffset(uint64_t offset)
+{
+    indexPending();
+    auto it = std::upper_bound(m_LineStarts.begin(), m_LineStarts.end(), offset);
+    if (it == m_LineStarts.begin()) {
+        return m_FirstLine;
+    }
+    return m_FirstLine + static_cast<uint64_t>(std::distance(m_LineStarts.begin(), it) - 1);
+}
+
+int64_t CReceiveBuffer::timestampAt(uint64_t offset) const
+{
+    auto it = std::upper_bound(m_TimeMarks.begin(), m_TimeMarks.end(), offset,
+                               [](uint64_t value, const TimeMark &mark) { return value < mark.offset; });
+    if (it == m_TimeMarks.begin()) {
+        return 0;
+    }
+    return std::prev(it)->timestampNs;
+}
+
+int CReceiveBuffer::streamAt(uint64_t offset) const
+{
+    auto it = std::upper_bound(m_StreamMarks.begin(), m_StreamMarks.end(), offset,
+                               [](uint64_t value, const StreamMark &mark) { return value < mark.offset; });
+    if (it == m_StreamMarks.begin()) {
+        return 0;
+    }
+    return std::prev(it)->stream;
+}
+
+uint64_t CReceiveBuffer::nextStreamChange(uint64_t offset) const
+{
+    auto it = std::upper_bound(m_StreamMarks.begin(), m_StreamMarks.end(), offset,
+                               [](uint64_t value, const StreamMark &mark) { return value < mark.offset; });
+    return it != m_StreamMarks.end() ? it->offset : UINT64_MAX;
+}
+
+bool CReceiveBuffer::hasStreams() const
+{
+    return !m_StreamMarks.empty();
+}
+
+size_t CReceiveBuffer::copy(uint64_t offset, char *out, size_t size) const
+{
+    offset = std::max(offset, m_Begin);
+    size_t copied = 0;
+    while (copied < size && offset < m_End) {
+        const uint64_t relative = offset - m_BlockBase;
+        const size_t blockIndex = static_cast<size_t>(relative / kBlockSize);
+        const size_t inBlock = static_cast<size_t>(relative % kBlockSize);
+        const size_t span = static_cast<size_t>(std::min<uint64_t>({size - copied, kBlockSize - inBlock, m_End - offset}));
+        std::memcpy(out + copied, m_Blocks[blockIndex].get() + inBlock, span);
+        copied += span;
+        offset += span;
+    }
+    return copied;
+}
+
+void CReceiveBuffer::indexPending()
+{
+    uint64_t pos = std::max(m_IndexedOffset, m_Begin);
+    while (pos < m_End) {
+        const uint64_t limit = std::min(m_End, m_LineStarts.back() + kMaxLineLength);
+        if (pos >= limit) {
+            m_LineStarts.push_back(limit);
+            continue;
+        }
+        const uint64_t relative = pos - m_BlockBase;
+        const size_t inBlock = static_cast<size_t>(relative % kBlockSize);
+        const size_t span = static_cast<size_t>(std::min<uint64_t>(limit - pos, kBlockSize - inBlock));
+        const char *p = m_Blocks[static_cast<size_t>(relative / kBlockSize)].get() + inBlock;
+        const char *hit = static_cast<const char *>(std::memchr(p, '\n', span));
+        if (hit) {
+            pos += static_cast<uint64_t>(hit - p) + 1;
+            m_LineStarts.push_back(pos);
+        } else {
+            pos += span;
+        }
+    }
+    m_IndexedOffset = pos;
+}
+
+uint64_t CReceiveBuffer::indexBytes() const
+{
+    return m_TimeMarks.size() * sizeof(TimeMark) + m_StreamMarks.size() * sizeof(StreamMark)
+           + m_LineStarts.size() * sizeof(uint64_t);
+}
+
+void CReceiveBuffer::dropFront()
+{
+    if (m_End - m_BlockBase + indexBytes() > m_Capacity) {
+        // 丢弃前先把将要丢弃的数据编入行索引，保证绝对行号准确
+        indexPending();
+    }
+    // 每丢一块随即丢掉它的索引，再按剩余的数据与索引判断是否还要继续丢
+    while (m_Blocks.size() > 1 && m_End - m_BlockBase + indexBytes() > m_Capacity) {
+        m_Blocks.pop_front();
+        m_BlockBase += kBlockSize;
+        m_Begin = std::max(m_Begin, m_BlockBase);
+        while (m_LineStarts.size() > 1 && m_LineStarts[1] <= m_Begin) {
+            m_LineStarts.pop_front();
+            ++m_FirstLine;
+        }
+        while (m_TimeMarks.size() > 1 && m_TimeMarks[1].offset <= m_Begin) {
+            m_TimeMarks.pop_front();
+        }
+        // 最早的切换记录决定丢弃点之后数据的 stream，切回 0 之后的记录可以整条丢掉
+        while (!m_StreamMarks.empty()
+               && (m_StreamMarks.size() > 1 ? m_StreamMarks[1].offset <= m_Begin
+                                            : m_StreamMarks.front().stream == 0 && m_StreamMarks.front().offset <= m_Begin)) {
+            m_StreamMarks.pop_front();
+        }
+        // 被截断的首行从 m_Begin 开始
+        if (m_LineStarts.front() < m_Begin) {
+            m_LineStarts.front() = m_Begin;
+        }
+    }
+}
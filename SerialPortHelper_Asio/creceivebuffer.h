@@ -0,0 +1,84 @@
+#ifndef CRECEIVEBUFFER_H
+#define CRECEIVEBUFFER_H
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+// 接收区的有界字节环：按块分配，超出容量时整块丢弃最旧的数据。
+// 偏移均为自清空以来的绝对字节偏移，行索引在查询时或每积累一块未索引数据时增量建立。
+// 容量同时计入行索引与时间索引：换行密集或每次只读到一两个字节时，索引不会超出容量膨胀。
+class CReceiveBuffer
+{
+public:
+    static constexpr size_t kBlockSize = 1 << 20;                 // 1 MiB 一块
+    static constexpr uint64_t kDefaultCapacity = 1ULL << 30;      // 默认保留 1 GiB 回滚
+    static constexpr size_t kMaxLineLength = 4096;                // 无换行的二进制数据按此长度折行
+    static constexpr int64_t kTimeMarkResolutionNs = 1000000;     // 距上一个时间标记不到 1 ms 的数据沿用它
+
+    explicit CReceiveBuffer(uint64_t capacity = kDefaultCapacity);
+
+    void setCapacity(uint64_t capacity);
+    uint64_t capacity() const;
+
+    // timestampNs 为该块数据的到达时间（Unix 纪元纳秒），0 表示不记录；
+    // stream 区分交错写入的多路数据（如桥接监听的两个方向），与上一块不同时从新的一行开始
+    void append(const char *data, size_t size, int64_t timestampNs = 0, int stream = 0);
+    void clear();
+
+    uint64_t beginOffset() const;
+    uint64_t endOffset() const;
+    uint64_t size() const;
+
+    // 行号为绝对行号：被丢弃的行不会让后续行号变化
+    uint64_t firstLine();
+    uint64_t endLine();
+    uint64_t lineStart(uint64_t line);
+    // 返回 [start, end)，不含行尾的 '\n'
+    void lineRange(uint64_t line, uint64_t &start, uint64_t &end);
+    // 包含 offset 的行号
+    uint64_t lineAtOffset(uint64_t offset);
+
+    // 包含 offset 的那块数据的到达时间，未记录时返回 0
+    int64_t timestampAt(uint64_t offset) const;
+    // 包含 offset 的那块数据的 stream，以及 offset 之后下一次切换的偏移（没有时为 UINT64_MAX）
+    int streamAt(uint64_t offset) const;
+    uint64_t nextStreamChange(uint64_t offset) const;
+    // 缓冲区内是否有 stream 不为 0 的数据
+    bool hasStreams() const;
+
+    // 拷贝 [offset, offset + size) 中仍在缓冲区内的部分，返回实际拷贝的字节数
+    size_t copy(uint64_t offset, char *out, size_t size) const;
+
+private:
+    void indexPending();
+    void dropFront();
+    // 行索引与时间索引占用的内存，计入容量
+    uint64_t indexBytes() const;
+
+    std::deque<std::unique_ptr<char[]>> m_Blocks;
+    uint64_t m_Capacity;
+    uint64_t m_BlockBase = 0;      // m_Blocks.front() 首字节的绝对偏移
+    uint64_t m_Begin = 0;          // 第一个有效字节
+    uint64_t m_End = 0;            // 最后一个有效字节之后
+
+    struct TimeMark
+    {
+        uint64_t offset;
+        int64_t timestampNs;
+    };
+    std::deque<TimeMark> m_TimeMarks;    // 数据块的起始偏移与到达时间，1 ms 内到达的合并为一个
+
+    struct StreamMark
+    {
+        uint64_t offset;
+        int stream;
+    };
+    std::deque<StreamMark> m_StreamMarks;  // 只在 stream 切换时记录，没有记录时为 0
+
+    std::deque<uint64_t> m_LineStarts;   // 已索引行的起始偏移
+    uint64_t m_FirstLine = 0;            // m_LineStarts.front() 的绝对行号
+    uint64_t m_IndexedOffset = 0;        // 已扫描到的偏移
+};
+
+#endif // CRECEIVEBUFFER_H
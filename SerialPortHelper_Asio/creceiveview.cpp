@@ -0,0 +1,403 @@
+#include "creceiveview.h"
+#include "chexformat.h"
+
+#include <QDateTime>
+#include <QFontDatabase>
+#include <QPainter>
+#include <QScrollBar>
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+constexpr int kRefreshIntervalMs = 16;  // 约 60 fps
+constexpr int kTextMargin = 4;
+
+// HEX 行布局："0000000000  xx xx ... xx  ................  HH:mm:ss.zzzuuu"
+constexpr int kOffsetChars = 10;
+constexpr int kTimeChars = 15;
+constexpr int kHexRowChars = kOffsetChars + 2 + static_cast<int>(HexFormat::kHexChars) + 1
+                             + static_cast<int>(HexFormat::kBytesPerRow) + 2 + kTimeChars;
+
+// HH:mm:ss.zzz 之后再补三位微秒
+QString formatTimestamp(qint64 timestampNs)
+{
+    const qint64 microseconds = timestampNs / 1000;
+    return QDateTime::fromMSecsSinceEpoch(microseconds / 1000).toString("HH:mm:ss.zzz")
+           + QString("%1").arg(microseconds % 1000, 3, 10, QLatin1Char('0'));
+}
+}
+
+CReceiveView::CReceiveView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+
+    m_RefreshTimer.setInterval(kRefreshIntervalMs);
+    connect(&m_RefreshTimer, &QTimer::timeout, this, &CReceiveView::refresh);
+    m_RefreshTimer.start();
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        m_TopRow = firstRow() + static_cast<quint64>(value);
+        viewport()->update();
+    });
+    connect(horizontalScrollBar(), &QScrollBar::valueChanged, viewport(), qOverload<>(&QWidget::update));
+}
+
+void CReceiveView::appendData(const QByteArray &data, qint64 timestampNs, int stream)
+{
+    // 只拷贝进字节环，排版和绘制推迟到下一帧
+    const bool hadStreams = m_Buffer.hasStreams();
+    m_Buffer.append(data.constData(), static_cast<size_t>(data.size()),
+                    timestampNs != 0 ? timestampNs : QDateTime::currentMSecsSinceEpoch() * 1000000, stream);
+    if (hadStreams != m_Buffer.hasStreams()) {
+        // 出现第一块其他来源的数据时标签列占用宽度
+        updateHorizontalRange();
+    }
+    m_Dirty = true;
+}
+
+void CReceiveView::clear()
+{
+    m_Buffer.clear();
+    m_TopRow = 0;
+    m_Dirty = true;
+    refresh();
+}
+
+void CReceiveView::setScrollbackCapacity(quint64 bytes)
+{
+    m_Buffer.setCapacity(bytes);
+    m_Dirty = true;
+}
+
+void CReceiveView::setDisplayMode(DisplayMode mode)
+{
+    if (mode == m_DisplayMode) {
+        return;
+    }
+    // 两种模式都只按需格式化可见行，切换时只需把视口顶部换算到新模式的行号，
+    // 原本停在末尾的视口由 refresh() 继续跟随末尾
+    const quint64 topOffset = m_DisplayMode == TextMode ? m_Buffer.lineStart(m_TopRow)
+                                                        : m_TopRow * HexFormat::kBytesPerRow;
+    m_DisplayMode = mode;
+    m_TopRow = mode == TextMode ? m_Buffer.lineAtOffset(topOffset) : topOffset / HexFormat::kBytesPerRow;
+    updateHorizontalRange();
+    m_Dirty = true;
+    refresh();
+}
+
+CReceiveView::DisplayMode CReceiveView::displayMode() const
+{
+    return m_DisplayMode;
+}
+
+void CReceiveView::setTextEncoding(CStreamDecoder::Encoding encoding)
+{
+    m_Decoder.setEncoding(encoding);
+    viewport()->update();
+}
+
+void CReceiveView::setTimestampVisible(bool visible)
+{
+    if (visible == m_ShowTimestamp) {
+        return;
+    }
+    m_ShowTimestamp = visible;
+    updateHorizontalRange();
+    viewport()->update();
+}
+
+bool CReceiveView::isTimestampVisible() const
+{
+    return m_ShowTimestamp;
+}
+
+void CReceiveView::setStreamLabels(const QStringList &labels)
+{
+    m_StreamLabels = labels;
+    updateHorizontalRange();
+    viewport()->update();
+}
+
+quint64 CReceiveView::firstRow()
+{
+    if (m_DisplayMode == TextMode) {
+        return m_Buffer.firstLine();
+    }
+    return m_Buffer.beginOffset() / HexFormat::kBytesPerRow;
+}
+
+quint64 CReceiveView::endRow()
+{
+    if (m_DisplayMode == TextMode) {
+        return m_Buffer.endLine();
+    }
+    return (m_Buffer.endOffset() + HexFormat::kBytesPerRow - 1) / HexFormat::kBytesPerRow;
+}
+
+void CReceiveView::refresh()
+{
+    if (!m_Dirty) {
+        return;
+    }
+    m_Dirty = false;
+
+    QScrollBar *vbar = verticalScrollBar();
+    const bool followTail = vbar->value() >= vbar->maximum();
+    const quint64 first = firstRow();
+    const quint64 end = endRow();
+    const int pageRows = visibleLineCount();
+    const quint64 totalRows = end - first;
+    const int maximum = static_cast<int>(std::min<quint64>(
+        totalRows > static_cast<quint64>(pageRows) ? totalRows - pageRows : 0, INT_MAX));
+
+    // 旧数据被丢弃时保持视口停留在同一绝对行上
+    const quint64 topRow = followTail ? first + maximum : std::max(m_TopRow, first);
+    const QSignalBlocker blocker(vbar);
+    vbar->setRange(0, maximum);
+    vbar->setPageStep(pageRows);
+    vbar->setValue(static_cast<int>(std::min<quint64>(topRow - first, static_cast<quint64>(maximum))));
+    m_TopRow = first + static_cast<quint64>(vbar->value());
+
+    viewport()->update();
+}
+
+void CReceiveView::decodeRange(uint64_t start, uint64_t end)
+{
+    const size_t length = static_cast<size_t>(end - start);
+    m_LineBytes.resize(static_cast<int>(length));
+    m_Buffer.copy(start, m_LineBytes.data(), length);
+    const std::u16string &decoded = m_Decoder.decode(m_LineBytes.constData(), length);
+    m_RowText.append(reinterpret_cast<const QChar *>(decoded.data()), static_cast<int>(decoded.size()));
+}
+
+bool CReceiveView::isFoldBoundary(uint64_t offset)
+{
+    if (offset <= m_Buffer.beginOffset() || offset >= m_Buffer.endOffset()) {
+        return false;
+    }
+    // 换行与来源切换处的断行不会切开字符
+    char previous = 0;
+    m_Buffer.copy(offset - 1, &previous, 1);
+    return previous != '\n' && m_Buffer.streamAt(offset - 1) == m_Buffer.streamAt(offset);
+}
+
+const QString &CReceiveView::textRow(quint64 row, int firstColumn, int columns)
+{
+    // 多字节序列最长 4 字节，折行处最多借用或跳过 3 字节
+    constexpr uint64_t kMaxSequenceTail = 3;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    m_Buffer.lineRange(row, start, end);
+    m_RowText.clear();
+
+    // 折行处被切开的字符归上一行：从折行点之前的同步点解码到折行点，跳过补全残留序列所用的字节。
+    // 小于 0x30 的字节在 UTF-8 与 GB18030 中都只能是单字节字符，之后必是字符边界；
+    // 一行之内找不到时从一行之前开始（UTF-8 几个字节内即可同步，GBK 尽力而为）
+    m_Decoder.reset();
+    if (row > m_Buffer.firstLine() && isFoldBoundary(start)) {
+        const uint64_t from = start - std::min<uint64_t>(start - m_Buffer.beginOffset(), CReceiveBuffer::kMaxLineLength);
+        const size_t length = static_cast<size_t>(start - from);
+        m_LineBytes.resize(static_cast<int>(length));
+        m_Buffer.copy(from, m_LineBytes.data(), length);
+        size_t sync = length;
+        while (sync > 0 && static_cast<unsigned char>(m_LineBytes[static_cast<int>(sync - 1)]) >= 0x30) {
+            --sync;
+        }
+        m_Decoder.decode(m_LineBytes.constData() + sync, length - sync);
+        const uint64_t limit = std::min(end, start + kMaxSequenceTail);
+        while (m_Decoder.pendingSize() > 0 && start < limit) {
+            decodeRange(start, start + 1);
+            ++start;
+        }
+        m_RowText.clear();
+        m_Decoder.reset();
+    }
+
+    // 整行解码后再按字符（UTF-16 单元）跳过水平滚动的列，字节偏移不一定落在字符边界上
+    decodeRange(start, end);
+    const bool isFolded = end == m_Buffer.lineStart(row + 1) && isFoldBoundary(end);
+    for (uint64_t next = end; isFolded && m_Decoder.pendingSize() > 0 && next < end + kMaxSequenceTail
+                              && next < m_Buffer.endOffset();
+         ++next) {
+        decodeRange(next, next + 1);
+    }
+    // 行尾残留的不完整序列：末行上的可能还在接收中，不显示；其余替换为 U+FFFD
+    if (!m_Decoder.flush().empty() && end < m_Buffer.endOffset()) {
+        m_RowText.append(QChar::ReplacementCharacter);
+    }
+
+    int first = std::min(firstColumn, static_cast<int>(m_RowText.size()));
+    if (first > 0 && first < m_RowText.size() && m_RowText.at(first).isLowSurrogate()) {
+        --first;  // 不把代理对拆开
+    }
+    m_RowText.remove(0, first);
+    m_RowText.truncate(columns);
+    return m_RowText;
+}
+
+QString CReceiveView::hexRow(quint64 row)
+{
+    const uint64_t rowStart = std::max<uint64_t>(row * HexFormat::kBytesPerRow, m_Buffer.beginOffset());
+    const uint64_t rowEnd = std::min<uint64_t>((row + 1) * HexFormat::kBytesPerRow, m_Buffer.endOffset());
+    unsigned char bytes[HexFormat::kBytesPerRow];
+    const size_t count = m_Buffer.copy(rowStart, reinterpret_cast<char *>(bytes),
+                                       static_cast<size_t>(rowEnd > rowStart ? rowEnd - rowStart : 0));
+
+    char line[kHexRowChars];
+    std::fill(line, line + kHexRowChars, ' ');
+    HexFormat::formatOffset(row * HexFormat::kBytesPerRow, kOffsetChars, line);
+    char *cursor = line + kOffsetChars + 2;
+    HexFormat::formatHex(bytes, count, cursor);
+    cursor += HexFormat::kHexChars + 1;
+    HexFormat::formatAscii(bytes, count, cursor);
+    cursor += HexFormat::kBytesPerRow + 2;
+
+    QString text = QString::fromLatin1(line, static_cast<int>(cursor - line));
+    const qint64 timestampNs = m_ShowTimestamp ? m_Buffer.timestampAt(rowStart) : 0;
+    if (timestampNs != 0) {
+        text += formatTimestamp(timestampNs);
+    }
+    return text;
+}
+
+void CReceiveView::drawHexRow(QPainter &painter, quint64 row, int x, int y, int charWidth)
+{
+    const QString text = hexRow(row);
+    const uint64_t rowStart = std::max<uint64_t>(row * HexFormat::kBytesPerRow, m_Buffer.beginOffset());
+    const uint64_t rowEnd = std::min<uint64_t>((row + 1) * HexFormat::kBytesPerRow, m_Buffer.endOffset());
+    if (streamLabelWidth() == 0 || rowStart >= rowEnd) {
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(x, y, text);
+        return;
+    }
+    // 等宽字体下按列位置分段绘制：偏移与时间戳用默认颜色，HEX 与 ASCII 按各字节的来源着色
+    constexpr int hexColumn = kOffsetChars + 2;
+    constexpr int asciiColumn = hexColumn + static_cast<int>(HexFormat::kHexChars) + 1;
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(x, y, text.left(hexColumn));
+    const int asciiEnd = asciiColumn + static_cast<int>(HexFormat::kBytesPerRow);
+    if (text.size() > asciiEnd) {
+        painter.drawText(x + asciiEnd * charWidth, y, text.mid(asciiEnd));
+    }
+    const uint64_t base = row * HexFormat::kBytesPerRow;
+    for (uint64_t start = rowStart; start < rowEnd;) {
+        const uint64_t end = std::min(rowEnd, m_Buffer.nextStreamChange(start));
+        const int first = static_cast<int>(start - base);
+        const int count = static_cast<int>(end - start);
+        painter.setPen(streamColor(m_Buffer.streamAt(start)));
+        painter.drawText(x + (hexColumn + first * 3) * charWidth, y, text.mid(hexColumn + first * 3, count * 3));
+        painter.drawText(x + (asciiColumn + first) * charWidth, y, text.mid(asciiColumn + first, count));
+        start = end;
+    }
+}
+
+void CReceiveView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(viewport());
+    painter.setPen(palette().color(QPalette::Text));
+
+    const QFontMetrics metrics(font());
+    const int lineHeight = metrics.lineSpacing();
+    const int charWidth = std::max(1, metrics.horizontalAdvance(QLatin1Char('0')));
+    const int firstColumn = horizontalScrollBar()->value();
+    const int columns = visibleColumnCount() + 1;
+    const quint64 end = endRow();
+    // 文本模式的时间戳列与来源标签列固定在左侧，不随水平滚动
+    const int labelX = kTextMargin + timestampColumns() * charWidth;
+    const int labelWidth = streamLabelWidth();
+    const int textX = labelX + labelWidth;
+
+    int y = kTextMargin + metrics.ascent();
+    for (quint64 row = m_TopRow; row < end && y - metrics.ascent() < viewport()->height(); ++row) {
+        const uint64_t rowStart = m_DisplayMode == TextMode
+                                      ? m_Buffer.lineStart(row)
+                                      : std::max<uint64_t>(row * HexFormat::kBytesPerRow, m_Buffer.beginOffset());
+        const int stream = labelWidth > 0 ? m_Buffer.streamAt(rowStart) : 0;
+        if (m_DisplayMode == TextMode && m_ShowTimestamp) {
+            const qint64 timestampNs = m_Buffer.timestampAt(rowStart);
+            if (timestampNs != 0) {
+                painter.setPen(palette().color(QPalette::Text));
+                painter.drawText(kTextMargin, y, formatTimestamp(timestampNs));
+            }
+        }
+        if (labelWidth > 0) {
+            painter.setClipping(false);
+            painter.setPen(streamColor(stream));
+            painter.drawText(labelX, y, m_StreamLabels.value(stream, QString::number(stream)));
+            // 水平滚动的内容不能盖住标签列
+            painter.setClipRect(QRect(textX, 0, viewport()->width() - textX, viewport()->height()));
+        }
+        if (m_DisplayMode == TextMode) {
+            // 不同来源的数据在切换处已断行，整行同一颜色
+            painter.setPen(streamColor(stream));
+            painter.drawText(textX, y, textRow(row, firstColumn, columns));
+        } else {
+            // HEX 行按偏移对齐，一行内可能有两个来源，逐段着色
+            drawHexRow(painter, row, textX - firstColumn * charWidth, y, charWidth);
+        }
+        y += lineHeight;
+    }
+}
+
+void CReceiveView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateHorizontalRange();
+    m_Dirty = true;
+    refresh();
+}
+
+void CReceiveView::updateHorizontalRange()
+{
+    const int rowChars = m_DisplayMode == TextMode ? static_cast<int>(CReceiveBuffer::kMaxLineLength) : kHexRowChars;
+    QScrollBar *hbar = horizontalScrollBar();
+    hbar->setRange(0, std::max(0, rowChars - visibleColumnCount()));
+    hbar->setPageStep(visibleColumnCount());
+}
+
+int CReceiveView::visibleLineCount() const
+{
+    const int lineHeight = std::max(1, QFontMetrics(font()).lineSpacing());
+    return std::max(1, (viewport()->height() - 2 * kTextMargin) / lineHeight);
+}
+
+int CReceiveView::visibleColumnCount() const
+{
+    const int charWidth = std::max(1, QFontMetrics(font()).horizontalAdvance(QLatin1Char('0')));
+    return std::max(1, (viewport()->width() - 2 * kTextMargin - streamLabelWidth()) / charWidth - timestampColumns());
+}
+
+int CReceiveView::timestampColumns() const
+{
+    return m_ShowTimestamp && m_DisplayMode == TextMode ? kTimeChars + 1 : 0;
+}
+
+int CReceiveView::streamLabelWidth() const
+{
+    if (m_StreamLabels.isEmpty() || !m_Buffer.hasStreams()) {
+        return 0;
+    }
+    const QFontMetrics metrics(font());
+    int width = 0;
+    for (const QString &label : m_StreamLabels) {
+        width = std::max(width, metrics.horizontalAdvance(label));
+    }
+    return width + metrics.horizontalAdvance(QLatin1Char(' '));
+}
+
+QColor CReceiveView::streamColor(int stream) const
+{
+    // 0 为普通文本色，其余取调色板中的链接色与高亮色，深浅色主题下都可读
+    switch (stream) {
+    case 0:
+        return palette().color(QPalette::Text);
+    case 1:
+        return palette().color(QPalette::Link);
+    default:
+        return palette().color(QPalette::Highlight);
+    }
+}
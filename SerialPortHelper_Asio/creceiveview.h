@@ -0,0 +1,83 @@
+#ifndef CRECEIVEVIEW_H
+#define CRECEIVEVIEW_H
+
+#include "creceivebuffer.h"
+#include "cstreamdecoder.h"
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QColor>
+#include <QStringList>
+#include <QTimer>
+
+// 虚拟化的接收显示区：数据只写入有界字节环，行索引按需建立，
+// 绘制时只格式化可见行，刷新被合并到每帧（约 60 fps）一次
+class CReceiveView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    enum DisplayMode
+    {
+        TextMode,   // 按 UTF-8 文本逐行显示
+        HexMode     // 每行 16 字节：偏移 + HEX + ASCII（+ 到达时间）
+    };
+
+    explicit CReceiveView(QWidget *parent = nullptr);
+
+    // timestampNs 为数据的到达时间（Unix 纪元纳秒），由接收线程在读取完成时测得；为 0 时取当前时间。
+    // stream 标记数据的来源（如桥接监听的两个方向），不同来源交错显示时各自成行并用不同颜色区分
+    void appendData(const QByteArray &data, qint64 timestampNs = 0, int stream = 0);
+    void clear();
+    void setScrollbackCapacity(quint64 bytes);
+
+    void setDisplayMode(DisplayMode mode);
+    DisplayMode displayMode() const;
+
+    void setTextEncoding(CStreamDecoder::Encoding encoding);
+
+    // 时间戳列（精确到微秒）：文本模式显示在每行行首，HEX 模式显示在行尾
+    void setTimestampVisible(bool visible);
+    bool isTimestampVisible() const;
+
+    // 各 stream 的标签，缓冲区内出现非 0 stream 的数据时在行首显示标签列
+    void setStreamLabels(const QStringList &labels);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    // 行（文本模式）或 16 字节行（HEX 模式）的绝对编号范围
+    quint64 firstRow();
+    quint64 endRow();
+    const QString &textRow(quint64 row, int firstColumn, int columns);
+    // 把 [start, end) 解码后追加到 m_RowText
+    void decodeRange(uint64_t start, uint64_t end);
+    // offset 处是否为无换行数据按 kMaxLineLength 折出的行边界（多字节字符可能被切开）
+    bool isFoldBoundary(uint64_t offset);
+    QString hexRow(quint64 row);
+    void updateHorizontalRange();
+    int visibleLineCount() const;
+    int visibleColumnCount() const;
+    int timestampColumns() const;
+    // 来源标签列的像素宽度，不显示时为 0
+    int streamLabelWidth() const;
+    QColor streamColor(int stream) const;
+    void drawHexRow(QPainter &painter, quint64 row, int x, int y, int charWidth);
+
+    CReceiveBuffer m_Buffer;
+    QTimer m_RefreshTimer;
+    QByteArray m_LineBytes;     // 绘制时复用的行缓冲
+    CStreamDecoder m_Decoder;
+    QString m_RowText;          // 复用的解码结果，避免每行分配
+    DisplayMode m_DisplayMode = TextMode;
+    bool m_ShowTimestamp = false;
+    QStringList m_StreamLabels;
+    quint64 m_TopRow = 0;       // 视口第一行的绝对编号
+    bool m_Dirty = false;
+};
+
+#endif // CRECEIVEVIEW_H
@@ -1,31 +1,157 @@
 #include "cserialportmanager.h"
+#include "ccapturefile.h"
 
 #include <qdebug.h>
+#include <algorithm>
 #include <thread>
 #include <memory>
 #include <atomic>
+#include <future>
 #include <boost/asio/io_context.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+namespace
+{
+constexpr qint64 kFileSendChunkSize = 64 * 1024;          // 每次送入写队列的块大小
+constexpr size_t kWriteQueueHighWatermark = 256 * 1024;   // 写队列积压上限，超过后暂停从文件取块并通知生产者限流
+constexpr size_t kWriteQueueLowWatermark = 64 * 1024;     // 积压回落到此以下时解除限流
+constexpr size_t kWriteQueueHardLimit = 4 * 1024 * 1024;  // 超过后直接拒绝 sendData
+constexpr auto kFileSendProgressInterval = std::chrono::milliseconds(100);
+// 普通通道每次写出约 10 ms 线路时间的数据，高优先级帧最多等这么久就能插队
+constexpr auto kBulkChunkWireTime = std::chrono::milliseconds(10);
+constexpr size_t kMinBulkChunkSize = 64;
+constexpr size_t kMaxBulkChunkSize = 16 * 1024;
+// 交付条件迟迟不满足（如分隔符始终未出现且未设超时）时累积数据的上限，超过后直接交付
+constexpr size_t kMaxPendingReadSize = 1024 * 1024;
+constexpr auto kCloseTimeout = std::chrono::milliseconds(2000);
+// 连续这么多次可重试的读取错误后按设备失效处理，避免在坏掉的句柄上空转
+constexpr int kMaxConsecutiveReadRetries = 3;
+
+// 读写错误分类：关闭时取消的操作不是错误；被信号打断等可重试的错误原地重新发起；
+// 其余（EOF、EIO、ENXIO，Windows 上设备拔出时被系统中止的重叠操作等）都说明设备已失效
+enum class IoErrorKind
+{
+    Cancelled,
+    Retryable,
+    DeviceLost
+};
+
+IoErrorKind classifyIoError(const boost::system::error_code &error, bool isClosing)
+{
+    if (isClosing) {
+        return IoErrorKind::Cancelled;
+    }
+    if (error == boost::asio::error::interrupted || error == boost::asio::error::would_block
+        || error == boost::asio::error::try_again) {
+        return IoErrorKind::Retryable;
+    }
+    return IoErrorKind::DeviceLost;
+}
+
+double toMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void setHighTimerResolution(bool enable)
+{
+#ifdef _WIN32
+    // Windows 默认定时器粒度约 15.6 ms，有周期发送任务时提高到 1 ms
+    if (enable) {
+        timeBeginPeriod(1);
+    } else {
+        timeEndPeriod(1);
+    }
+#else
+    (void)enable;
+#endif
+}
+}
+
+struct CSerialPortManager::FileSendState
+{
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    const char *data = nullptr;
+    qint64 size = 0;
+    qint64 queued = 0;          // 已送入写队列的字节数
+    qint64 written = 0;         // 已写出的字节数
+    int chunksInFlight = 0;     // 写队列中仍引用映射内存的块数
+    bool cancelled = false;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastProgressTime;
+};
+struct CSerialPortManager::PeriodicTask
+{
+    PeriodicTask(boost::asio::io_context &ioContext)
+        : timer(ioContext)
+    {
+    }
+
+    int id = 0;
+    QByteArray frame;
+    std::chrono::steady_clock::duration period{};
+    WritePriority priority = HighPriority;
+    std::chrono::steady_clock::time_point deadline;   // 本次应触发的绝对时刻
+    boost::asio::steady_timer timer;
+    PeriodicStats stats;
+};
+
 CSerialPortManager::CSerialPortManager(QObject *parent)
-    : QObject{parent},m_IsPortOpen(false),m_IoContext(),m_p_SerialPort(nullptr)
+    : QObject{parent},m_p_OwnedIoContext(std::make_unique<boost::asio::io_context>()),m_IoContext(*m_p_OwnedIoContext),
+      m_p_SerialPort(nullptr),m_ReadPolicyTimer(m_IoContext),m_IsPortOpen(false),
+      m_BaudDetectTimer(m_IoContext)
 {
-    m_ReadBuffer.clear();
 
 
 }
 
+CSerialPortManager::CSerialPortManager(boost::asio::io_context &ioContext, QObject *parent)
+    : QObject{parent},m_IoContext(ioContext),m_p_SerialPort(nullptr),m_ReadPolicyTimer(m_IoContext),m_IsPortOpen(false),
+      m_BaudDetectTimer(m_IoContext)
+{
+}
+
 CSerialPortManager::~CSerialPortManager()
 {
     closePort();
-
+    // 共享 io_context 上本端口的回调还没执行完时不能释放本对象，等它们执行完再收尾
+    if (m_IsPortOpen.load() && !m_p_OwnedIoContext) {
+        while (!m_IoContext.stopped() && !waitForPendingOperations()) {
+            qDebug() << "Still waiting for pending operations before destroying the port.";
+        }
+        closePort();
+    }
 }
 
-bool CSerialPortManager::openPort(const QString &portName, int baudRate, int dataBits, int parity, int stopBits)
+bool CSerialPortManager::openPort(const QString &portName, int baudRate, int dataBits, int parity, int stopBits, int flowControl,
+                                  SerialTuning::LatencyMode latencyMode)
 {
     if(m_IsPortOpen)
     {
         emit signal_ErrorOccurred("Port is already open");
         return false;
     }
+    // QSerialPort::Parity 与 boost 的枚举取值不同（Odd 为 3，boost 为 1），需要逐项映射
+    boost::asio::serial_port::parity::type parityType = boost::asio::serial_port::parity::none;
+    switch (parity) {
+    case 0:
+        break;
+    case 2:
+        parityType = boost::asio::serial_port::parity::even;
+        break;
+    case 3:
+        parityType = boost::asio::serial_port::parity::odd;
+        break;
+    default:
+        emit signal_ErrorOccurred(QString("Unsupported parity: %1 (only none, even and odd)").arg(parity));
+        return false;
+    }
     try
     {
         std::string port = portName.toStdString();
@@ -38,9 +164,14 @@ bool CSerialPortManager::openPort(const QString &portName, int baudRate, int dat
         qDebug() << "Data Bits: " << dataBits;
         qDebug() << "Parity: " << parity;
         qDebug() << "Stop Bits: " << stopBits;
+        qDebug() << "Flow Control: " << flowControl;
+        qDebug() << "Latency Mode: " << SerialTuning::latencyModeName(latencyMode);
+        {
+            std::lock_guard<std::mutex> lock(m_OpenSettingsMutex);
+            m_OpenSettings = {portName, baudRate, dataBits, parity, stopBits, flowControl, latencyMode};
+        }
 
         m_p_SerialPort = std::make_unique<boost::asio::serial_port>(m_IoContext, portName.toStdString());
-        m_p_SerialPort->set_option(boost::asio::serial_port::baud_rate(baudRate));
         m_p_SerialPort->set_option(boost::asio::serial_port::character_size(dataBits));
         // Set stop bits correctly, depending on the selected value
         if (stopBits == 1) {
@@ -50,7 +181,77 @@ bool CSerialPortManager::openPort(const QString &portName, int baudRate, int dat
         } else if (stopBits == 2) {
             m_p_SerialPort->set_option(boost::asio::serial_port::stop_bits(boost::asio::serial_port::stop_bits::two));
         }
-        m_p_SerialPort->set_option(boost::asio::serial_port::parity(static_cast<boost::asio::serial_port::parity::type>(parity)));
+        m_p_SerialPort->set_option(boost::asio::serial_port::parity(parityType));
+        // QSerialPort::FlowControl 与 boost 的枚举取值不同，需要逐项映射
+        boost::asio::serial_port::flow_control::type flow = boost::asio::serial_port::flow_control::none;
+        switch (flowControl) {
+        case 1:
+            flow = boost::asio::serial_port::flow_control::hardware;
+            break;
+        case 2:
+            flow = boost::asio::serial_port::flow_control::software;
+            break;
+        default:
+            break;
+        }
+        m_p_SerialPort->set_option(boost::asio::serial_port::flow_control(flow));
+
+        // boost 的 baud_rate 选项只接受经典速率表中的值，任意速率（2/3/6/12 Mbaud 等）走平台接口，
+        // 并读回驱动实际采用的速率
+        std::string tuningError;
+        unsigned appliedBaudRate = 0;
+        if (baudRate <= 0 || !SerialTuning::setBaudRate(m_p_SerialPort->native_handle(), static_cast<unsigned>(baudRate), &tuningError)
+            || !SerialTuning::readBaudRate(m_p_SerialPort->native_handle(), appliedBaudRate, &tuningError)) {
+            emit signal_ErrorOccurred(QString("Failed to set baud rate %1: %2").arg(baudRate).arg(tuningError.c_str()));
+            m_p_SerialPort.reset();
+            return false;
+        }
+        qDebug() << "Applied Baud Rate: " << appliedBaudRate;
+
+        // 调优失败不影响使用，只提示
+        if (!SerialTuning::applyLatencyMode(m_p_SerialPort->native_handle(), latencyMode, &tuningError)) {
+            emit signal_ErrorOccurred(QString("Failed to apply latency mode: %1").arg(tuningError.c_str()));
+        }
+        if (latencyMode == SerialTuning::LowLatency
+            && !SerialTuning::flushInput(m_p_SerialPort->native_handle(), &tuningError)) {
+            emit signal_ErrorOccurred(QString("Failed to flush input: %1").arg(tuningError.c_str()));
+        }
+        // 读取请求从波特率折算的下限起步，高吞吐模式直接从上限起步
+        m_ReadSizer.setMaxSize(m_MaxReadBufferSize.load());
+        applyBaudRate(appliedBaudRate);
+        if (latencyMode == SerialTuning::HighThroughput) {
+            m_ReadSizer.startAtMax();
+        } else {
+            m_ReadSizer.reset();
+        }
+        // 上次桥接时借给对端的缓冲可能仍在对端写队列中，每次打开都换新的
+        for (auto &buffer : m_ReadBuffers) {
+            buffer = std::make_shared<std::vector<char>>(m_ReadSizer.maxSize());
+        }
+        m_ReadBufferIndex = 0;
+        m_IsReadStalled = false;
+        m_ReadBufferSize.store(m_ReadSizer.size());
+        {
+            std::lock_guard<std::mutex> lock(m_ReadPolicyMutex);
+            m_ReadPolicy = m_RequestedReadPolicy;
+        }
+        resolveReadPolicy();
+        m_PendingRead.clear();
+        m_DelimiterSearchFrom = 0;
+        m_IsReadPolicyTimerArmed = false;
+        m_ReadCompletions.store(0);
+        m_ReadDeliveries.store(0);
+        m_ClockBaseSteady = std::chrono::steady_clock::now();
+        m_ClockBaseSystemNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()).count();
+        m_ReadBytes.store(0);
+        m_ReadRetries.store(0);
+        m_ConsecutiveReadRetries = 0;
+        m_IsPortLost.store(false);
+        {
+            std::lock_guard<std::mutex> lock(m_BridgeStatsMutex);
+            m_BridgeStats = BridgeStats();
+        }
 
         //qDebug端口的参数
 
@@ -58,17 +259,29 @@ bool CSerialPortManager::openPort(const QString &portName, int baudRate, int dat
         qDebug() << "IoContext status: " << &m_IoContext;
         qDebug() << "Serial port object created: " << m_p_SerialPort.get();
         qDebug() << "Serial port opened successfully!";
+        m_WriteQueuedBytes.store(0);
+        m_IsWriteThrottled.store(false);
+        resetWriteLaneStats();
+        m_PendingOperations = 0;
         m_IsPortOpen.store(true);  // 标记串口为已打开状态
 
-        // 启动异步任务来poll io_context
-        m_AsyncPollThread = std::async(std::launch::async, [this]() {
-            while (m_IsPortOpen.load()) {
-                m_IoContext.poll(); // 持续poll，直到端口关闭
-                std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 加一个微小的延迟，避免100% CPU占用
+        // 启动异步任务运行 io_context。原先的 poll() + 10 ms 休眠会让每个完成和定时器多等最多 10 ms，
+        // 且线程先于首个异步操作运行时 poll() 会因无事可做而让 io_context 进入停止状态
+        if (m_p_OwnedIoContext) {
+            m_IoContext.restart();
+            m_p_WorkGuard = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
+                m_IoContext.get_executor());
+            m_AsyncPollThread = std::async(std::launch::async, [this]() {
+                m_IoContext.run();
+            });
+        }
+
+        // 首次读取也在 I/O 线程上发起，共享的 io_context 上同一端口的操作都由该线程串行执行
+        boost::asio::post(m_IoContext, [this]() {
+            if (!m_IsClosing.load()) {
+                readData();
             }
         });
-
-        readData();
         return true;
     }catch(const boost::system::system_error &e)
     {
@@ -83,33 +296,86 @@ void CSerialPortManager::closePort()
         qDebug() << "Port is already closed!";
         return;
     }
+    if (!m_p_OwnedIoContext && m_IoContext.get_executor().running_in_this_thread()) {
+        emit signal_ErrorOccurred("Cannot close the port from its I/O thread.");
+        return;
+    }
 
+    m_IsClosing.store(true);
     try {
-        // 停止异步操作
-        m_IoContext.stop();
-
-        // 强制等待所有异步任务完成
-        if (m_AsyncPollThread.valid()) {
-            std::future_status status = m_AsyncPollThread.wait_for(std::chrono::milliseconds(2000));
-            if (status == std::future_status::timeout) {
-                qDebug() << "Async poll thread did not finish in time!";
-            } else {
-                qDebug() << "Async poll thread finished.";
+        // 取消本端口的所有异步操作，并销毁周期任务（定时器析构时取消等待）；
+        // 在 I/O 线程停止后或在 I/O 线程上执行
+        auto cancelOperations = [this]() {
+            // 先解除桥接，对端之后不会再向本端转发或回调
+            detachBridge();
+            // 写队列在关闭后清空，缓冲的提供方（TCP 会话等）现在就得知不会再写出
+            for (auto &lane : m_WriteBuffers) {
+                for (PendingWrite &write : lane) {
+                    if (write.onReleased) {
+                        auto onReleased = std::move(write.onReleased);
+                        write.onReleased = nullptr;
+                        onReleased();
+                    }
+                }
             }
-        }
+            if (m_p_SerialPort) {
+                boost::system::error_code ec;
+                m_p_SerialPort->cancel(ec);  // 取消所有异步任务
+                if (ec) {
+                    qDebug() << "Failed to cancel operations: " << ec.message().c_str();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+                if (!m_PeriodicTasks.empty()) {
+                    setHighTimerResolution(false);
+                }
+                m_PeriodicTasks.clear();
+            }
+            m_ReadPolicyTimer.cancel();
+            // 检测中关闭时不再恢复速率，关闭后统一通知
+            m_BaudDetectTimer.cancel();
+            m_p_BaudDetector.reset();
+            if (m_IsReadTimerResolutionRaised) {
+                setHighTimerResolution(false);
+                m_IsReadTimerResolutionRaised = false;
+            }
+        };
 
-        // 取消所有异步操作
-        if (m_p_SerialPort) {
-            boost::system::error_code ec;
-            m_p_SerialPort->cancel(ec);  // 取消所有异步任务
-            if (ec) {
-                qDebug() << "Failed to cancel operations: " << ec.message().c_str();
+        if (m_p_OwnedIoContext) {
+            // 停止异步操作
+            m_p_WorkGuard.reset();
+            m_IoContext.stop();
+
+            // 强制等待所有异步任务完成
+            if (m_AsyncPollThread.valid()) {
+                std::future_status status = m_AsyncPollThread.wait_for(kCloseTimeout);
+                if (status == std::future_status::timeout) {
+                    qDebug() << "Async poll thread did not finish in time!";
+                } else {
+                    qDebug() << "Async poll thread finished.";
+                }
             }
-        }
 
-        // 等待所有异步操作完成
-        m_IoContext.restart();  // 重新启动 io_context
-        m_IoContext.run();  // 强制执行所有挂起的异步操作，确保它们完成
+            cancelOperations();
+
+            // 等待所有异步操作完成
+            m_IoContext.restart();  // 重新启动 io_context
+            m_IoContext.run();  // 强制执行所有挂起的异步操作，确保它们完成
+        } else if (m_IoContext.stopped()) {
+            // I/O 线程已退出（注册表析构等），不会再有回调执行，直接在调用线程上取消
+            cancelOperations();
+        } else {
+            // 共享的 io_context 上还有其他端口，不能停止：在 I/O 线程上取消，再等本端口的回调全部执行完
+            boost::asio::post(m_IoContext, cancelOperations);
+            if (!waitForPendingOperations()) {
+                // 回调仍可能在 I/O 线程上访问串口对象和写队列，不能在这里释放：保持打开状态（m_IsClosing 仍为 true，
+                // 不再发起新的读写），由调用方稍后重试
+                qDebug() << "Pending operations did not finish in time!";
+                emit signal_ErrorOccurred("Failed to close port: pending I/O operations did not finish in time.");
+                return;
+            }
+        }
 
         // 关闭串口
         boost::system::error_code ec;
@@ -120,6 +386,7 @@ void CSerialPortManager::closePort()
         if (ec) {
             qDebug() << "Failed to close port:" << ec.message().c_str();
             emit signal_ErrorOccurred(ec.message().c_str());
+            m_IsClosing.store(false);
             return;
         }
 
@@ -127,14 +394,39 @@ void CSerialPortManager::closePort()
 
         // 重置串口对象，彻底清理资源
         m_p_SerialPort.reset();  // 重置串口对象
+        for (auto &lane : m_WriteBuffers) {
+            lane.clear();
+        }
+        m_IsWriting = false;
+        {
+            std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+            for (auto &stats : m_LaneStats) {
+                stats.queuedFrames = 0;
+                stats.queuedBytes = 0;
+            }
+        }
+        releaseQueuedBytes(m_WriteQueuedBytes.load());
+        // 尚未满足交付条件的数据在关闭时一并交付，不丢弃
+        deliverPendingRead();
+        if (m_p_FileSend) {
+            finishFileSend(false, "Port closed.");
+        }
+        if (m_IsDetectingBaud.exchange(false)) {
+            emit signal_BaudDetectionFinished(false, 0, "Port closed.");
+        }
         m_IsPortOpen.store(false);  // 更新状态
+        m_IsClosing.store(false);
         emit signal_PortClosed();  // 发出信号
 
-        // 额外的延时，确保资源释放
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000)); // 等待更多时间确保串口完全关闭
+        // 额外的延时，确保资源释放；共享模式下已确认本端口没有未完成的操作，不再等待，
+        // 否则注册表逐个关闭几十个串口要等几十秒
+        if (m_p_OwnedIoContext) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000)); // 等待更多时间确保串口完全关闭
+        }
 
     } catch (const boost::system::system_error &e) {
         qDebug() << "System error while closing port:" << e.what();
+        m_IsClosing.store(false);
         emit signal_ErrorOccurred(QString("Failed to close port: %1").arg(e.what()));
     }
 }
@@ -146,35 +438,398 @@ bool CSerialPortManager::isOpen() const
     return m_IsPortOpen.load();
 }
 
-void CSerialPortManager::sendData(const QByteArray &data)
+boost::asio::io_context &CSerialPortManager::ioContext() const
+{
+    return m_IoContext;
+}
+
+QString CSerialPortManager::portName() const
+{
+    std::lock_guard<std::mutex> lock(m_OpenSettingsMutex);
+    return m_OpenSettings.portName;
+}
+
+CSerialPortManager::OpenSettings CSerialPortManager::openSettings() const
+{
+    std::lock_guard<std::mutex> lock(m_OpenSettingsMutex);
+    return m_OpenSettings;
+}
+
+bool CSerialPortManager::waitForPendingOperations()
+{
+    // 取消后的回调不一定已经排进队列（Windows 上由完成端口异步送达），
+    // 逐轮在 I/O 线程上投递屏障读取计数，直到归零或超时
+    const auto deadline = std::chrono::steady_clock::now() + kCloseTimeout;
+    for (;;) {
+        auto fence = std::make_shared<std::promise<int>>();
+        std::future<int> pending = fence->get_future();
+        boost::asio::post(m_IoContext, [this, fence]() { fence->set_value(m_PendingOperations); });
+        if (pending.wait_until(deadline) == std::future_status::timeout) {
+            return false;
+        }
+        if (pending.get() == 0) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+unsigned CSerialPortManager::appliedBaudRate() const
+{
+    return m_AppliedBaudRate.load();
+}
+
+std::chrono::nanoseconds CSerialPortManager::characterTime() const
+{
+    return std::chrono::nanoseconds(m_CharacterTimeNs.load());
+}
+
+void CSerialPortManager::setMaxReadBufferSize(size_t bytes)
+{
+    m_MaxReadBufferSize.store(std::max(bytes, CReadSizer::kMinimumSize));
+}
+
+size_t CSerialPortManager::readBufferSize() const
+{
+    return m_ReadBufferSize.load();
+}
+
+void CSerialPortManager::setReadPolicy(const ReadPolicy &policy)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ReadPolicyMutex);
+        m_RequestedReadPolicy = policy;
+    }
+    if (m_IsPortOpen.load()) {
+        boost::asio::post(m_IoContext, [this]() { applyReadPolicy(); });
+    }
+}
+
+CSerialPortManager::ReadPolicy CSerialPortManager::readPolicy() const
+{
+    std::lock_guard<std::mutex> lock(m_ReadPolicyMutex);
+    return m_RequestedReadPolicy;
+}
+
+CSerialPortManager::ReadStats CSerialPortManager::readStats() const
+{
+    ReadStats stats;
+    stats.completions = m_ReadCompletions.load();
+    stats.deliveries = m_ReadDeliveries.load();
+    stats.bytes = m_ReadBytes.load();
+    stats.retries = m_ReadRetries.load();
+    return stats;
+}
+
+bool CSerialPortManager::sendData(const QByteArray &data, WritePriority priority)
 {
     if (!m_IsPortOpen.load()) {
         emit signal_ErrorOccurred("Port is not open.");
+        return false;
+    }
+    if (data.isEmpty()) {
+        return true;
+    }
+    // 对端流控（CTS 无效或收到 XOFF）时写操作迟迟不完成，积压在这里截住，而不是无限增长
+    if (m_WriteQueuedBytes.load() + static_cast<size_t>(data.size()) > kWriteQueueHardLimit) {
+        emit signal_ErrorOccurred("Write queue is full, data dropped.");
+        return false;
+    }
+    // 在生产者一侧计数，投递到 I/O 线程之前的积压也能触发高水位
+    addQueuedBytes(static_cast<size_t>(data.size()));
+    // 写队列只在 I/O 线程上操作，QByteArray 隐式共享，投递时不拷贝数据
+    boost::asio::post(m_IoContext, [this, data, priority]() { enqueueWrite(data, priority); });
+    return true;
+}
+
+size_t CSerialPortManager::writeQueueBytes() const
+{
+    return m_WriteQueuedBytes.load();
+}
+
+bool CSerialPortManager::isWriteThrottled() const
+{
+    return m_IsWriteThrottled.load();
+}
+
+CSerialPortManager::WriteLaneStats CSerialPortManager::writeLaneStats(WritePriority priority) const
+{
+    std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+    return m_LaneStats[priority];
+}
+
+void CSerialPortManager::resetWriteLaneStats()
+{
+    std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+    for (auto &stats : m_LaneStats) {
+        // 队列深度反映当前状态，只清零累计量
+        stats.framesWritten = 0;
+        stats.lastWaitMs = 0.0;
+        stats.averageWaitMs = 0.0;
+        stats.maxWaitMs = 0.0;
+    }
+}
+
+void CSerialPortManager::addQueuedBytes(size_t bytes)
+{
+    const size_t queued = m_WriteQueuedBytes.fetch_add(bytes) + bytes;
+    if (queued >= kWriteQueueHighWatermark && !m_IsWriteThrottled.exchange(true)) {
+        emit signal_WriteQueueHighWatermark(static_cast<qint64>(queued));
+    }
+}
+
+void CSerialPortManager::releaseQueuedBytes(size_t bytes)
+{
+    const size_t queued = m_WriteQueuedBytes.fetch_sub(bytes) - bytes;
+    if (queued <= kWriteQueueLowWatermark && m_IsWriteThrottled.exchange(false)) {
+        emit signal_WriteQueueLowWatermark(static_cast<qint64>(queued));
+    }
+}
+
+int CSerialPortManager::startPeriodicSend(const QByteArray &frame, std::chrono::microseconds period,
+                                          WritePriority priority)
+{
+    if (!m_IsPortOpen.load()) {
+        emit signal_ErrorOccurred("Port is not open.");
+        return -1;
+    }
+    if (frame.isEmpty() || period.count() <= 0) {
+        emit signal_ErrorOccurred("Invalid periodic frame or period.");
+        return -1;
+    }
+    auto task = std::make_unique<PeriodicTask>(m_IoContext);
+    task->frame = frame;
+    task->period = period;
+    task->priority = priority;
+    task->deadline = std::chrono::steady_clock::now() + period;
+
+    std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+    const int id = m_NextPeriodicId++;
+    task->id = id;
+    PeriodicTask *raw = task.get();
+    if (m_PeriodicTasks.empty()) {
+        setHighTimerResolution(true);
+    }
+    m_PeriodicTasks.emplace(id, std::move(task));
+    // 定时器只在 I/O 线程上启动
+    boost::asio::post(m_IoContext, [this, id, raw]() {
+        std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+        if (m_PeriodicTasks.count(id) != 0) {
+            schedulePeriodic(*raw);
+        }
+    });
+    return id;
+}
+
+void CSerialPortManager::stopPeriodicSend(int id)
+{
+    boost::asio::post(m_IoContext, [this, id]() {
+        std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+        if (m_PeriodicTasks.erase(id) != 0 && m_PeriodicTasks.empty()) {
+            setHighTimerResolution(false);
+        }
+    });
+}
+
+void CSerialPortManager::stopAllPeriodicSends()
+{
+    boost::asio::post(m_IoContext, [this]() {
+        std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+        if (!m_PeriodicTasks.empty()) {
+            setHighTimerResolution(false);
+        }
+        m_PeriodicTasks.clear();
+    });
+}
+
+CSerialPortManager::PeriodicStats CSerialPortManager::periodicStats(int id) const
+{
+    std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+    auto it = m_PeriodicTasks.find(id);
+    return it != m_PeriodicTasks.end() ? it->second->stats : PeriodicStats();
+}
+
+void CSerialPortManager::schedulePeriodic(PeriodicTask &task)
+{
+    // 截止时刻是绝对时间，回调执行多久都不会推迟后续周期
+    task.timer.expires_at(task.deadline);
+    const int id = task.id;
+    ++m_PendingOperations;
+    task.timer.async_wait([this, id](const boost::system::error_code &error) {
+        --m_PendingOperations;
+        handlePeriodicTimer(id, error);
+    });
+}
+
+void CSerialPortManager::handlePeriodicTimer(int id, const boost::system::error_code &error)
+{
+    if (error || m_IsClosing.load()) {
         return;
     }
-    try {
-        m_WriteBuffer.push_back(boost::asio::buffer(data.constData(),data.size()));
-        if(m_WriteBuffer.size()==1)
+    const auto now = std::chrono::steady_clock::now();
+    QByteArray frame;
+    WritePriority priority = NormalPriority;
+    bool isThrottled = false;
+    {
+        // 锁内只更新统计并取出要发送的帧，入队时不持锁
+        std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+        auto it = m_PeriodicTasks.find(id);
+        if (it == m_PeriodicTasks.end()) {
+            return;
+        }
+        PeriodicTask &task = *it->second;
+        PeriodicStats &stats = task.stats;
+
+        const double latenessUs = std::chrono::duration<double, std::micro>(now - task.deadline).count();
+        const auto bin = std::upper_bound(kJitterBinBoundsUs.begin(), kJitterBinBoundsUs.end(),
+                                          static_cast<qint64>(latenessUs));
+        ++stats.histogram[static_cast<size_t>(bin - kJitterBinBoundsUs.begin())];
+        const quint64 fired = stats.sent + stats.throttled;
+        stats.meanLatenessUs = (stats.meanLatenessUs * fired + latenessUs) / (fired + 1);
+        stats.maxLatenessUs = std::max(stats.maxLatenessUs, latenessUs);
+
+        // 只看本任务所在通道的积压：文件发送让普通通道常驻在高水位附近，不能连带丢弃高优先级的心跳；
+        // 对端流控导致本通道积压到高水位时放弃本帧，不让周期帧继续堆积
         {
-            boost::asio::async_write(*m_p_SerialPort,m_WriteBuffer.front(),
-                                     std::bind(&CSerialPortManager::handleWrite,this,
-                                               boost::asio::placeholders::error,
-                                               boost::asio::placeholders::bytes_transferred));
+            std::lock_guard<std::mutex> laneLock(m_LaneStatsMutex);
+            isThrottled = m_LaneStats[task.priority].queuedBytes >= kWriteQueueHighWatermark;
         }
+        if (isThrottled) {
+            ++stats.throttled;
+        } else {
+            ++stats.sent;
+            frame = task.frame;
+            priority = task.priority;
+        }
+
+        task.deadline += task.period;
+        if (task.deadline <= now) {
+            // 落后超过一个周期（例如系统休眠）时跳到下一个未来的截止时刻，不补发
+            const auto behind = (now - task.deadline) / task.period + 1;
+            stats.missed += static_cast<quint64>(behind);
+            task.deadline += task.period * behind;
+        }
+    }
+
+    // 入队可能同步发出高水位、错误等信号，直连的槽函数会再调用 periodicStats()、startPeriodicSend()，持锁会自锁死
+    if (!isThrottled) {
+        addQueuedBytes(static_cast<size_t>(frame.size()));
+        enqueueWrite(frame, priority);
+    }
+
+    // 任务只在 I/O 线程上删除，重新查找一次，不依赖入队前取得的引用
+    std::lock_guard<std::mutex> lock(m_PeriodicMutex);
+    auto it = m_PeriodicTasks.find(id);
+    if (it != m_PeriodicTasks.end()) {
+        schedulePeriodic(*it->second);
+    }
+}
+
+void CSerialPortManager::enqueueWrite(const QByteArray &data, WritePriority priority, bool isFileChunk)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+    // 字节数已由调用方计入 m_WriteQueuedBytes
+    PendingWrite write;
+    write.data = data;
+    write.isFileChunk = isFileChunk;
+    write.enqueueTime = std::chrono::steady_clock::now();
+    pushWrite(std::move(write), priority);
+}
+
+void CSerialPortManager::pushWrite(PendingWrite write, WritePriority priority)
+{
+    const size_t size = static_cast<size_t>(write.data.size());
+    m_WriteBuffers[priority].push_back(std::move(write));
+    {
+        std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+        ++m_LaneStats[priority].queuedFrames;
+        m_LaneStats[priority].queuedBytes += size;
+    }
+    if (!m_IsWriting) {
+        startWrite();
+    }
+}
+
+void CSerialPortManager::enqueueBridgeWrite(const std::shared_ptr<std::vector<char>> &buffer, size_t size,
+                                            CSerialPortManager *source, std::chrono::steady_clock::time_point arrival)
+{
+    // 不受限流约束：转发量受对端读取缓冲块数限制，积压不会超过几块读取缓冲
+    addQueuedBytes(size);
+    PendingWrite write;
+    write.data = QByteArray::fromRawData(buffer->data(), static_cast<int>(size));
+    write.storage = buffer;
+    write.bridgeSource = source;
+    write.enqueueTime = arrival;
+    // 走普通通道，手动发送的高优先级帧仍可插队，便于在转发的数据流中注入
+    pushWrite(std::move(write), NormalPriority);
+}
+
+void CSerialPortManager::startWrite()
+{
+    if (!m_p_SerialPort || m_IsClosing.load()) {
+        return;
+    }
+    // 每次写完一块都重新选通道：高优先级帧整帧写出，普通通道的大块数据按 m_BulkChunkSize 切开
+    const auto lane = std::find_if(m_WriteBuffers.begin(), m_WriteBuffers.end(),
+                                   [](const std::deque<PendingWrite> &queue) { return !queue.empty(); });
+    if (lane == m_WriteBuffers.end()) {
+        return;
+    }
+    m_WritingLane = static_cast<WritePriority>(lane - m_WriteBuffers.begin());
+    PendingWrite &write = lane->front();
+    if (!write.started) {
+        write.started = true;
+        const double waitMs = toMilliseconds(std::chrono::steady_clock::now() - write.enqueueTime);
+        std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+        WriteLaneStats &stats = m_LaneStats[m_WritingLane];
+        stats.lastWaitMs = waitMs;
+        stats.maxWaitMs = std::max(stats.maxWaitMs, waitMs);
+        // 指数滑动平均，反映最近一段时间的排队情况
+        stats.averageWaitMs = stats.framesWritten == 0 ? waitMs : stats.averageWaitMs * 0.9 + waitMs * 0.1;
+        if (write.bridgeSource != nullptr) {
+            write.bridgeSource->recordBridgeLatency(std::chrono::steady_clock::now() - write.enqueueTime);
+        }
+    }
+    size_t length = static_cast<size_t>(write.data.size() - write.offset);
+    if (m_WritingLane != HighPriority) {
+        length = std::min(length, m_BulkChunkSize);
+    }
+    m_IsWriting = true;
+    try {
+        ++m_PendingOperations;
+        boost::asio::async_write(*m_p_SerialPort, boost::asio::buffer(write.data.constData() + write.offset, length),
+                                 std::bind(&CSerialPortManager::handleWrite, this,
+                                           boost::asio::placeholders::error,
+                                           boost::asio::placeholders::bytes_transferred));
     } catch (const boost::system::system_error &e) {
+        --m_PendingOperations;
+        m_IsWriting = false;
         emit signal_ErrorOccurred(QString("Failed to send data: %1").arg(e.what()));
     }
+}
 
-
+void CSerialPortManager::reportPortLost(const QString &errorString)
+{
+    emit signal_ErrorOccurred(errorString);
+    // 设备失效时读写两个方向往往先后报错，只通知一次
+    if (!m_IsPortLost.exchange(true)) {
+        emit signal_PortLost(errorString);
+    }
 }
+
 void CSerialPortManager::readData()
 {
     if (!m_IsPortOpen.load()) {
         emit signal_ErrorOccurred("Port is not open.");
         return;
     }
-    m_ReadBuffer.resize(1024);
-    m_p_SerialPort->async_read_some(boost::asio::buffer(m_ReadBuffer)
+    ++m_PendingOperations;
+    m_p_SerialPort->async_read_some(boost::asio::buffer(m_ReadBuffers[m_ReadBufferIndex]->data(), m_ReadSizer.size())
                                     ,std::bind(&CSerialPortManager::handleRead,this,
                                      boost::asio::placeholders::error,
                                      boost::asio::placeholders::bytes_transferred));
@@ -183,46 +838,771 @@ void CSerialPortManager::readData()
 
 void CSerialPortManager::handleWrite(const boost::system::error_code &error, size_t bytesTransferred)
 {
+    --m_PendingOperations;
+    m_IsWriting = false;
     if(error)
     {
-        emit signal_ErrorOccurred(QString("Failed to write data: %1").arg(error.message().c_str()));
+        // 关闭时取消的写入由 closePort() 收尾；写方向没有可重试的错误，asio 已在内部处理 EAGAIN
+        if (classifyIoError(error, m_IsClosing.load()) == IoErrorKind::Cancelled) {
+            return;
+        }
+        const QString message = QString("Failed to write data: %1").arg(error.message().c_str());
+        if (m_p_FileSend) {
+            finishFileSend(false, message);
+        }
+        reportPortLost(message);
         return;
     }
-    if (!m_WriteBuffer.empty()) {
-        m_WriteBuffer.pop_front();
+    std::deque<PendingWrite> &lane = m_WriteBuffers[m_WritingLane];
+    if (!lane.empty()) {
+        PendingWrite &write = lane.front();
+        write.offset += static_cast<int>(bytesTransferred);
+        if (write.isFileChunk && m_p_FileSend) {
+            m_p_FileSend->written += static_cast<qint64>(bytesTransferred);
+        }
+        const bool frameDone = write.offset >= write.data.size();
+        CSerialPortManager *bridgeSource = nullptr;
+        std::function<void()> onReleased;
+        if (frameDone) {
+            if (write.isFileChunk && m_p_FileSend) {
+                --m_p_FileSend->chunksInFlight;
+            }
+            bridgeSource = write.bridgeSource;
+            onReleased = std::move(write.onReleased);
+            lane.pop_front();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+            WriteLaneStats &stats = m_LaneStats[m_WritingLane];
+            stats.queuedBytes -= bytesTransferred;
+            if (frameDone) {
+                --stats.queuedFrames;
+                ++stats.framesWritten;
+            }
+        }
+        releaseQueuedBytes(bytesTransferred);
+        // 出队时已释放对缓冲的引用，对端若因缓冲用尽暂停了读取，现在可以继续
+        if (bridgeSource != nullptr) {
+            bridgeSource->handleBridgeBufferReturned();
+        }
+        if (onReleased) {
+            onReleased();
+        }
     }
-    if (!m_WriteBuffer.empty()) {
-        boost::asio::async_write(*m_p_SerialPort,m_WriteBuffer.front(),
-                                 std::bind(&CSerialPortManager::handleWrite,this,
-                                           boost::asio::placeholders::error,
-                                           boost::asio::placeholders::bytes_transferred));
+    // 写完一块后从映射中补块，保持写队列积压在高水位以下
+    pumpFileSend();
+    if (!m_IsWriting) {
+        startWrite();
     }
 }
 
-
-
 void CSerialPortManager::handleRead(const boost::system::error_code &error, size_t bytesTransferred)
 {
+    // 完成后第一时间取时间戳，之后的重新挂起读取、录制和分发都不计入
+    const auto arrival = std::chrono::steady_clock::now();
+    --m_PendingOperations;
     if(error)
     {
-        emit signal_ErrorOccurred(QString("Failed to read data: %1").arg(error.message().c_str()));
+        switch (classifyIoError(error, m_IsClosing.load())) {
+        case IoErrorKind::Cancelled:
+            return;
+        case IoErrorKind::Retryable:
+            if (++m_ConsecutiveReadRetries <= kMaxConsecutiveReadRetries) {
+                m_ReadRetries.fetch_add(1);
+                readData();
+                return;
+            }
+            break;
+        case IoErrorKind::DeviceLost:
+            break;
+        }
+        // 不再重新发起读取，尽快让接收者关闭端口
+        reportPortLost(QString("Failed to read data: %1").arg(error.message().c_str()));
         return;
     }
+    m_ConsecutiveReadRetries = 0;
+
+    const std::shared_ptr<std::vector<char>> completedBuffer = m_ReadBuffers[m_ReadBufferIndex];
+    const char *completed = completedBuffer->data();
+    m_ReadCompletions.fetch_add(1);
+    m_ReadBytes.fetch_add(bytesTransferred);
+    m_ReadSizer.record(bytesTransferred);
+    m_ReadBufferSize.store(m_ReadSizer.size());
 
-    QByteArray receivedData(m_ReadBuffer.data(), bytesTransferred);
+    // 先在另一块缓冲上挂起下一次读取，下面的拷贝、录制和信号处理期间端口始终有未完成的读取：
+    // Windows 上重叠 ReadFile 立即交给驱动，POSIX 上 asio 会先做一次推测性读取把内核缓冲取走
+    if (!m_IsClosing.load()) {
+        armNextRead();
+    }
+
+    // 自动波特率检测期间的数据按哪个速率都不可信，只用于打分
+    if (m_p_BaudDetector) {
+        feedBaudDetector(completed, bytesTransferred, arrival);
+        return;
+    }
 
-    // 将接收到的数据放入队列中，进行后续处理
+    // 录制保留每次读取的原始分块和时间戳，不受交付条件影响
     {
-        m_ReceivedDataQueue.push(receivedData);
+        std::lock_guard<std::mutex> lock(m_RecordMutex);
+        if (m_p_CaptureWriter) {
+            m_p_CaptureWriter->append(static_cast<uint64_t>(toTimestampNs(arrival)), completed, bytesTransferred);
+        }
+    }
+
+    // 旁路接收者（TCP 会话等）直接拿到读取缓冲，需要时自行持有引用
+    for (const auto &tap : m_ReadTaps) {
+        tap.second(completedBuffer, bytesTransferred, arrival);
     }
 
+    CSerialPortManager *peer = m_p_BridgePeer;
+    if (peer != nullptr) {
+        if (!peer->m_IsClosing.load() && peer->m_IsPortOpen.load()) {
+            ++m_BridgeLentBuffers;
+            peer->enqueueBridgeWrite(completedBuffer, bytesTransferred, this, arrival);
+            std::lock_guard<std::mutex> lock(m_BridgeStatsMutex);
+            ++m_BridgeStats.forwardedChunks;
+            m_BridgeStats.forwardedBytes += bytesTransferred;
+        } else {
+            std::lock_guard<std::mutex> lock(m_BridgeStatsMutex);
+            m_BridgeStats.droppedBytes += bytesTransferred;
+        }
+        if (!m_IsBridgeTapEnabled.load()) {
+            return;
+        }
+    }
+
+    appendReceived(completed, bytesTransferred, arrival);
+}
+
+bool CSerialPortManager::selectNextReadBuffer()
+{
+    // 只选引用计数为 1（没有借给对端）的缓冲；不桥接时总是选中下一块，与原先的两块轮换相同
+    for (size_t step = 1; step <= kReadBufferCount; ++step) {
+        const size_t index = (m_ReadBufferIndex + step) % kReadBufferCount;
+        if (m_ReadBuffers[index].use_count() == 1) {
+            m_ReadBufferIndex = index;
+            return true;
+        }
+    }
+    return false;
+}
 
-    emit signal_DataReceived(receivedData);
+void CSerialPortManager::armNextRead()
+{
+    // 缓冲都还被引用时：有借给桥接对端的就暂停，等对端写完归还，由此向上游施压；
+    // 否则是被 TCP 观察者等旁路持有，换一块新的继续读，不让慢客户端拖住串口
+    if (!selectNextReadBuffer()) {
+        if (m_BridgeLentBuffers > 0) {
+            m_IsReadStalled = true;
+            std::lock_guard<std::mutex> lock(m_BridgeStatsMutex);
+            ++m_BridgeStats.stalls;
+            return;
+        }
+        m_ReadBufferIndex = (m_ReadBufferIndex + 1) % kReadBufferCount;
+        m_ReadBuffers[m_ReadBufferIndex] = std::make_shared<std::vector<char>>(m_ReadSizer.maxSize());
+    }
+    m_IsReadStalled = false;
     readData();
 }
 
+void CSerialPortManager::handleBridgeBufferReturned()
+{
+    if (m_BridgeLentBuffers > 0) {
+        --m_BridgeLentBuffers;
+    }
+    if (m_IsReadStalled && !m_IsClosing.load() && m_IsPortOpen.load()) {
+        armNextRead();
+    }
+}
+
+int CSerialPortManager::addReadTap(ReadTap tap)
+{
+    const int id = m_NextReadTapId++;
+    m_ReadTaps.emplace(id, std::move(tap));
+    return id;
+}
+
+void CSerialPortManager::removeReadTap(int id)
+{
+    m_ReadTaps.erase(id);
+}
+
+bool CSerialPortManager::writeShared(const std::shared_ptr<std::vector<char>> &buffer, size_t size,
+                                     std::function<void()> onReleased)
+{
+    if (!m_IsPortOpen.load() || m_IsClosing.load() || size == 0) {
+        return false;
+    }
+    addQueuedBytes(size);
+    PendingWrite write;
+    write.data = QByteArray::fromRawData(buffer->data(), static_cast<int>(size));
+    write.storage = buffer;
+    write.onReleased = std::move(onReleased);
+    write.enqueueTime = std::chrono::steady_clock::now();
+    pushWrite(std::move(write), NormalPriority);
+    return true;
+}
+
+void CSerialPortManager::recordBridgeLatency(std::chrono::steady_clock::duration latency)
+{
+    const double latencyUs = std::chrono::duration<double, std::micro>(latency).count();
+    const auto bin = std::upper_bound(kJitterBinBoundsUs.begin(), kJitterBinBoundsUs.end(),
+                                      static_cast<qint64>(latencyUs));
+    std::lock_guard<std::mutex> lock(m_BridgeStatsMutex);
+    BridgeStats &stats = m_BridgeStats;
+    ++stats.histogram[static_cast<size_t>(bin - kJitterBinBoundsUs.begin())];
+    quint64 measured = 0;
+    for (quint64 count : stats.histogram) {
+        measured += count;
+    }
+    stats.lastLatencyUs = latencyUs;
+    stats.meanLatencyUs += (latencyUs - stats.meanLatencyUs) / static_cast<double>(measured);
+    stats.maxLatencyUs = std::max(stats.maxLatencyUs, latencyUs);
+}
+
+void CSerialPortManager::applyReadPolicy()
+{
+    // 已累积的数据是按旧条件收集的，先交付再换条件
+    deliverPendingRead();
+    {
+        std::lock_guard<std::mutex> lock(m_ReadPolicyMutex);
+        m_ReadPolicy = m_RequestedReadPolicy;
+    }
+    resolveReadPolicy();
+}
+
+void CSerialPortManager::resolveReadPolicy()
+{
+    if (m_ReadPolicy.idleGapChars > 0.0) {
+        m_IdleGap = std::chrono::nanoseconds(
+            static_cast<long long>(m_ReadPolicy.idleGapChars * static_cast<double>(m_CharacterTimeNs.load())));
+    } else {
+        m_IdleGap = m_ReadPolicy.idleGap;
+    }
+    // 字符时间级的空闲间隔在 115200 波特下只有几百微秒，Windows 上需要把定时器粒度提高到 1 ms
+    const bool needsResolution = m_IdleGap.count() > 0 || m_ReadPolicy.timeout.count() > 0;
+    if (needsResolution != m_IsReadTimerResolutionRaised) {
+        setHighTimerResolution(needsResolution);
+        m_IsReadTimerResolutionRaised = needsResolution;
+    }
+    // 旧条件下挂起的截止时刻作废，下一次读取完成时按新条件重新设置
+    m_ReadPolicyTimer.cancel();
+    m_IsReadPolicyTimerArmed = false;
+}
+
+void CSerialPortManager::appendReceived(const char *data, size_t size, std::chrono::steady_clock::time_point now)
+{
+    if (m_ReadPolicy.isImmediate()) {
+        deliverReceived(QByteArray(data, static_cast<int>(size)), now);
+        return;
+    }
+
+    if (m_PendingRead.isEmpty()) {
+        m_PendingReadSince = now;
+    }
+    m_LastReadTime = now;
+    m_PendingRead.append(data, static_cast<int>(size));
+
+    const QByteArray &delimiter = m_ReadPolicy.delimiter;
+    if (!delimiter.isEmpty()) {
+        int consumed = 0;
+        int found = static_cast<int>(m_PendingRead.indexOf(delimiter, m_DelimiterSearchFrom));
+        while (found >= 0) {
+            const int end = found + static_cast<int>(delimiter.size());
+            deliverReceived(m_PendingRead.mid(consumed, end - consumed), now);
+            consumed = end;
+            found = static_cast<int>(m_PendingRead.indexOf(delimiter, end));
+        }
+        if (consumed > 0) {
+            m_PendingRead.remove(0, consumed);
+            // 剩余部分都在分隔符之后，即本次读取到达的数据
+            m_PendingReadSince = now;
+        }
+        // 分隔符可能跨两次读取，末尾不足一个分隔符长度的部分下次重新查找
+        m_DelimiterSearchFrom = std::max(0, static_cast<int>(m_PendingRead.size() - delimiter.size()) + 1);
+    }
+
+    if (m_PendingRead.isEmpty()) {
+        return;
+    }
+    const size_t pendingSize = static_cast<size_t>(m_PendingRead.size());
+    if ((m_ReadPolicy.minBytes > 0 && pendingSize >= m_ReadPolicy.minBytes) || pendingSize >= kMaxPendingReadSize) {
+        deliverPendingRead();
+        return;
+    }
+    armReadPolicyTimer();
+}
+
+void CSerialPortManager::deliverReceived(const QByteArray &data, std::chrono::steady_clock::time_point arrival)
+{
+    m_ReadDeliveries.fetch_add(1);
+    emit signal_DataReceived(data, toTimestampNs(arrival));
+}
+
+qint64 CSerialPortManager::toTimestampNs(std::chrono::steady_clock::time_point time) const
+{
+    return m_ClockBaseSystemNs
+           + std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_ClockBaseSteady).count();
+}
+
+void CSerialPortManager::deliverPendingRead()
+{
+    if (m_PendingRead.isEmpty()) {
+        return;
+    }
+    QByteArray data;
+    data.swap(m_PendingRead);
+    m_DelimiterSearchFrom = 0;
+    // 由定时器或关闭触发交付时，时间戳仍取最后一块数据的到达时刻而不是交付时刻
+    deliverReceived(data, m_LastReadTime);
+}
+
+void CSerialPortManager::armReadPolicyTimer()
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point deadline = Clock::time_point::max();
+    if (m_IdleGap.count() > 0) {
+        deadline = m_LastReadTime + m_IdleGap;
+    }
+    if (m_ReadPolicy.timeout.count() > 0) {
+        deadline = std::min(deadline, m_PendingReadSince + m_ReadPolicy.timeout);
+    }
+    if (deadline == Clock::time_point::max() || m_IsClosing.load()) {
+        return;
+    }
+    // 每个字节都会推后空闲截止时刻，已挂起的等待若不晚于新截止时刻就保留，到期时再按最新时刻判断，
+    // 避免每次读取完成都取消并重设定时器
+    if (m_IsReadPolicyTimerArmed && m_ReadPolicyDeadline <= deadline) {
+        return;
+    }
+    m_IsReadPolicyTimerArmed = true;
+    m_ReadPolicyDeadline = deadline;
+    m_ReadPolicyTimer.expires_at(deadline);
+    ++m_PendingOperations;
+    m_ReadPolicyTimer.async_wait(std::bind(&CSerialPortManager::handleReadPolicyTimer, this, std::placeholders::_1));
+}
+
+void CSerialPortManager::handleReadPolicyTimer(const boost::system::error_code &error)
+{
+    --m_PendingOperations;
+    if (error) {
+        // 被更早的截止时刻替换或端口关闭
+        return;
+    }
+    m_IsReadPolicyTimerArmed = false;
+    if (m_PendingRead.isEmpty()) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const bool idle = m_IdleGap.count() > 0 && now >= m_LastReadTime + m_IdleGap;
+    const bool timedOut = m_ReadPolicy.timeout.count() > 0 && now >= m_PendingReadSince + m_ReadPolicy.timeout;
+    if (idle || timedOut) {
+        deliverPendingRead();
+    } else {
+        armReadPolicyTimer();
+    }
+}
+
+bool CSerialPortManager::sendFile(const QString &filePath)
+{
+    if (!m_IsPortOpen.load()) {
+        emit signal_ErrorOccurred("Port is not open.");
+        return false;
+    }
+    if (m_IsSendingFile.exchange(true)) {
+        emit signal_ErrorOccurred("A file is already being sent.");
+        return false;
+    }
 
+    auto state = std::make_shared<FileSendState>();
+    try {
+        // 只映射不读取，页面在写出时才由内核按需调入
+        state->file = boost::interprocess::file_mapping(filePath.toLocal8Bit().constData(), boost::interprocess::read_only);
+        state->region = boost::interprocess::mapped_region(state->file, boost::interprocess::read_only);
+        state->data = static_cast<const char *>(state->region.get_address());
+        state->size = static_cast<qint64>(state->region.get_size());
+    } catch (const boost::interprocess::interprocess_exception &e) {
+        // 空文件无法映射，按零长度处理
+        if (e.get_error_code() != boost::interprocess::size_error) {
+            m_IsSendingFile.store(false);
+            emit signal_ErrorOccurred(QString("Failed to map file: %1").arg(e.what()));
+            return false;
+        }
+    }
+    state->startTime = std::chrono::steady_clock::now();
+    state->lastProgressTime = state->startTime;
 
+    boost::asio::post(m_IoContext, [this, state]() {
+        m_p_FileSend = std::make_unique<FileSendState>(std::move(*state));
+        pumpFileSend();
+    });
+    return true;
+}
 
+void CSerialPortManager::cancelFileSend()
+{
+    boost::asio::post(m_IoContext, [this]() {
+        if (!m_p_FileSend) {
+            return;
+        }
+        m_p_FileSend->cancelled = true;
+        // 丢弃尚未开始写的文件块，正在写的那一块完成后结束
+        std::deque<PendingWrite> &lane = m_WriteBuffers[NormalPriority];
+        for (auto it = lane.begin(); it != lane.end();) {
+            if (it->isFileChunk && !(m_IsWriting && m_WritingLane == NormalPriority && it == lane.begin())) {
+                const size_t remaining = static_cast<size_t>(it->data.size() - it->offset);
+                {
+                    std::lock_guard<std::mutex> lock(m_LaneStatsMutex);
+                    --m_LaneStats[NormalPriority].queuedFrames;
+                    m_LaneStats[NormalPriority].queuedBytes -= remaining;
+                }
+                releaseQueuedBytes(remaining);
+                --m_p_FileSend->chunksInFlight;
+                it = lane.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        pumpFileSend();
+    });
+}
 
+bool CSerialPortManager::isSendingFile() const
+{
+    return m_IsSendingFile.load();
+}
 
+void CSerialPortManager::pumpFileSend()
+{
+    if (!m_p_FileSend || m_IsClosing.load()) {
+        return;
+    }
+    FileSendState &state = *m_p_FileSend;
+    while (!state.cancelled && state.queued < state.size && m_WriteQueuedBytes < kWriteQueueHighWatermark) {
+        const qint64 chunkSize = std::min(kFileSendChunkSize, state.size - state.queued);
+        // fromRawData 不拷贝，块直接引用映射内存，映射在所有块写出后才释放
+        ++state.chunksInFlight;
+        addQueuedBytes(static_cast<size_t>(chunkSize));
+        enqueueWrite(QByteArray::fromRawData(state.data + state.queued, static_cast<int>(chunkSize)), NormalPriority, true);
+        state.queued += chunkSize;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const bool done = state.chunksInFlight == 0 && (state.cancelled || state.queued >= state.size);
+    if (done || now - state.lastProgressTime >= kFileSendProgressInterval) {
+        state.lastProgressTime = now;
+        const double seconds = std::chrono::duration<double>(now - state.startTime).count();
+        emit signal_FileSendProgress(state.written, state.size, seconds > 0 ? state.written / seconds : 0.0);
+    }
+    if (done) {
+        finishFileSend(!state.cancelled, state.cancelled ? "File send cancelled." : "File sent.");
+    }
+}
+
+void CSerialPortManager::finishFileSend(bool success, const QString &message)
+{
+    m_p_FileSend.reset();
+    m_IsSendingFile.store(false);
+    emit signal_FileSendFinished(success, message);
+}
+
+bool CSerialPortManager::startBridge(CSerialPortManager *peer)
+{
+    if (peer == nullptr || peer == this) {
+        emit signal_ErrorOccurred("Invalid bridge peer.");
+        return false;
+    }
+    // 转发时要直接操作对端的写队列，两端必须由同一个 I/O 线程串行执行
+    if (m_p_OwnedIoContext || &peer->m_IoContext != &m_IoContext) {
+        emit signal_ErrorOccurred("Bridged ports must share one I/O context.");
+        return false;
+    }
+    if (!m_IsPortOpen.load() || !peer->isOpen()) {
+        emit signal_ErrorOccurred("Both ports must be open to bridge.");
+        return false;
+    }
+    bool isStarted = false;
+    runOnIoThread([this, peer, &isStarted]() {
+        if (m_p_BridgePeer != nullptr || peer->m_p_BridgePeer != nullptr || m_IsClosing.load()
+            || peer->m_IsClosing.load()) {
+            return;
+        }
+        for (CSerialPortManager *side : {this, peer}) {
+            std::lock_guard<std::mutex> lock(side->m_BridgeStatsMutex);
+            side->m_BridgeStats = BridgeStats();
+        }
+        m_p_BridgePeer = peer;
+        peer->m_p_BridgePeer = this;
+        m_IsBridged.store(true);
+        peer->m_IsBridged.store(true);
+        isStarted = true;
+    });
+    if (!isStarted) {
+        emit signal_ErrorOccurred("Failed to start bridge: a port is already bridged or closing.");
+    }
+    return isStarted;
+}
+
+void CSerialPortManager::stopBridge()
+{
+    if (!m_IsBridged.load()) {
+        return;
+    }
+    runOnIoThread([this]() { detachBridge(); });
+}
+
+bool CSerialPortManager::isBridged() const
+{
+    return m_IsBridged.load();
+}
+
+void CSerialPortManager::setBridgeTap(bool enabled)
+{
+    m_IsBridgeTapEnabled.store(enabled);
+}
+
+bool CSerialPortManager::isBridgeTapEnabled() const
+{
+    return m_IsBridgeTapEnabled.load();
+}
+
+CSerialPortManager::BridgeStats CSerialPortManager::bridgeStats() const
+{
+    std::lock_guard<std::mutex> lock(m_BridgeStatsMutex);
+    return m_BridgeStats;
+}
+
+void CSerialPortManager::detachBridge()
+{
+    CSerialPortManager *peer = m_p_BridgePeer;
+    if (peer == nullptr) {
+        return;
+    }
+    m_p_BridgePeer = nullptr;
+    peer->m_p_BridgePeer = nullptr;
+    m_IsBridged.store(false);
+    peer->m_IsBridged.store(false);
+    // 已进入写队列的转发数据照常写完，但不再回调对方（关闭的一方随后可能被销毁）
+    for (CSerialPortManager *side : {this, peer}) {
+        for (auto &lane : side->m_WriteBuffers) {
+            for (PendingWrite &write : lane) {
+                write.bridgeSource = nullptr;
+            }
+        }
+    }
+    // 借出的缓冲由对方写完后自行释放，不再计数；因缓冲借出而暂停的一方换新缓冲继续读取
+    for (CSerialPortManager *side : {this, peer}) {
+        side->m_BridgeLentBuffers = 0;
+        side->handleBridgeBufferReturned();
+    }
+}
+
+void CSerialPortManager::runOnIoThread(const std::function<void()> &task)
+{
+    if (m_IoContext.get_executor().running_in_this_thread()) {
+        task();
+        return;
+    }
+    std::promise<void> done;
+    boost::asio::post(m_IoContext, [&task, &done]() {
+        task();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+bool CSerialPortManager::startRecording(const QString &filePath)
+{
+    auto writer = std::make_unique<CCaptureWriter>();
+    std::string error;
+    if (!writer->open(filePath.toStdString(), &error)) {
+        emit signal_ErrorOccurred(QString("Failed to start recording: %1").arg(error.c_str()));
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_RecordMutex);
+    m_p_CaptureWriter = std::move(writer);
+    return true;
+}
+
+void CSerialPortManager::stopRecording()
+{
+    std::lock_guard<std::mutex> lock(m_RecordMutex);
+    m_p_CaptureWriter.reset();
+}
+
+bool CSerialPortManager::isRecording() const
+{
+    std::lock_guard<std::mutex> lock(m_RecordMutex);
+    return m_p_CaptureWriter != nullptr;
+}
+
+void CSerialPortManager::applyBaudRate(unsigned appliedBaudRate)
+{
+    m_AppliedBaudRate.store(appliedBaudRate);
+    m_ReadSizer.setBaudRate(appliedBaudRate);
+    m_ReadBufferSize.store(m_ReadSizer.size());
+    // QSerialPort::OneAndHalfStop 的取值为 3
+    const auto characterTime = SerialTuning::characterTime(appliedBaudRate, m_OpenSettings.dataBits,
+                                                           m_OpenSettings.parity != 0,
+                                                           m_OpenSettings.stopBits == 3 ? 1.5 : m_OpenSettings.stopBits);
+    m_CharacterTimeNs.store(characterTime.count());
+    // 按 1 起始位 + 8 数据位 + 1 停止位折算字节速率
+    const size_t bytesPerWireTime = static_cast<size_t>(appliedBaudRate) / 10 * kBulkChunkWireTime.count() / 1000;
+    m_BulkChunkSize = std::clamp(bytesPerWireTime, kMinBulkChunkSize, kMaxBulkChunkSize);
+}
+
+bool CSerialPortManager::startBaudDetection(const std::vector<unsigned> &candidates)
+{
+    if (!m_IsPortOpen.load() || m_IsClosing.load() || m_IsPortLost.load()) {
+        emit signal_ErrorOccurred("Port must be open to detect the baud rate.");
+        return false;
+    }
+    if (m_IsDetectingBaud.exchange(true)) {
+        emit signal_ErrorOccurred("Baud rate detection is already running.");
+        return false;
+    }
+    bool isStarted = false;
+    runOnIoThread([this, &candidates, &isStarted]() {
+        if (m_IsClosing.load() || !m_p_SerialPort) {
+            return;
+        }
+        // 已累积的数据是按原速率收到的，先交付
+        deliverPendingRead();
+        m_p_BaudDetector = std::make_unique<CBaudDetector>(candidates.empty() ? CBaudDetector::defaultCandidates()
+                                                                              : candidates);
+        m_BaudDetectOriginalRate = m_AppliedBaudRate.load();
+        m_LineErrors = SerialTuning::LineErrors();
+        isStarted = true;
+        beginBaudCandidate();
+    });
+    if (!isStarted) {
+        m_IsDetectingBaud.store(false);
+        emit signal_ErrorOccurred("Failed to start baud rate detection: port is closing.");
+    }
+    return isStarted;
+}
+
+void CSerialPortManager::cancelBaudDetection()
+{
+    if (!m_IsDetectingBaud.load()) {
+        return;
+    }
+    runOnIoThread([this]() {
+        if (m_p_BaudDetector) {
+            finishBaudDetection(false, 0, "Baud rate detection cancelled.");
+        }
+    });
+}
+
+bool CSerialPortManager::isDetectingBaud() const
+{
+    return m_IsDetectingBaud.load();
+}
+
+void CSerialPortManager::beginBaudCandidate()
+{
+    const auto handle = m_p_SerialPort->native_handle();
+    while (m_p_BaudDetector->hasNextCandidate()) {
+        // 驱动不支持的速率直接跳过
+        if (!SerialTuning::setBaudRate(handle, m_p_BaudDetector->nextBaudRate())) {
+            const CBaudDetector::Verdict verdict = m_p_BaudDetector->skipCandidate();
+            if (verdict != CBaudDetector::NextCandidate) {
+                handleBaudVerdict(verdict);
+                return;
+            }
+            continue;
+        }
+        // 内核里按上一个速率收到的数据不计入；挂起中的读取稍后完成的那一批落在稳定期内，由检测器丢弃
+        SerialTuning::flushInput(handle);
+        m_HasLineErrors = SerialTuning::readLineErrors(handle, m_LineErrors);
+        const auto now = std::chrono::steady_clock::now();
+        m_p_BaudDetector->beginCandidate(now);
+        m_p_BaudDetector->setLineErrors(m_LineErrors, m_HasLineErrors, now);
+        armBaudDetectTimer();
+        return;
+    }
+    handleBaudVerdict(m_p_BaudDetector->finish());
+}
+
+void CSerialPortManager::armBaudDetectTimer()
+{
+    // 线路空闲时没有读取完成，由定时器在候选的截止时刻给出结论；expires_at 会取消上一个候选的等待
+    m_BaudDetectTimer.expires_at(m_p_BaudDetector->deadline());
+    ++m_PendingOperations;
+    m_BaudDetectTimer.async_wait(std::bind(&CSerialPortManager::handleBaudDetectTimer, this, std::placeholders::_1));
+}
+
+void CSerialPortManager::feedBaudDetector(const char *data, size_t size, std::chrono::steady_clock::time_point arrival)
+{
+    if (m_HasLineErrors) {
+        m_HasLineErrors = SerialTuning::readLineErrors(m_p_SerialPort->native_handle(), m_LineErrors);
+        m_p_BaudDetector->setLineErrors(m_LineErrors, m_HasLineErrors, arrival);
+    }
+    m_p_BaudDetector->addData(data, size, arrival);
+    const CBaudDetector::Verdict verdict = m_p_BaudDetector->evaluate(arrival);
+    if (verdict != CBaudDetector::Listening) {
+        handleBaudVerdict(verdict);
+    }
+}
+
+void CSerialPortManager::handleBaudVerdict(CBaudDetector::Verdict verdict)
+{
+    switch (verdict) {
+    case CBaudDetector::Listening:
+        armBaudDetectTimer();
+        break;
+    case CBaudDetector::NextCandidate:
+        beginBaudCandidate();
+        break;
+    case CBaudDetector::Detected:
+        finishBaudDetection(true, m_p_BaudDetector->detectedBaudRate(), m_p_BaudDetector->summary().c_str());
+        break;
+    case CBaudDetector::Failed:
+        finishBaudDetection(false, 0, m_p_BaudDetector->summary().c_str());
+        break;
+    }
+}
+
+void CSerialPortManager::handleBaudDetectTimer(const boost::system::error_code &error)
+{
+    --m_PendingOperations;
+    if (error || !m_p_BaudDetector) {
+        // 换了候选、检测结束或端口关闭
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (m_HasLineErrors) {
+        m_HasLineErrors = SerialTuning::readLineErrors(m_p_SerialPort->native_handle(), m_LineErrors);
+        m_p_BaudDetector->setLineErrors(m_LineErrors, m_HasLineErrors, now);
+    }
+    handleBaudVerdict(m_p_BaudDetector->evaluate(now));
+}
+
+void CSerialPortManager::finishBaudDetection(bool success, unsigned baudRate, const QString &message)
+{
+    m_BaudDetectTimer.cancel();
+    m_p_BaudDetector.reset();
+    QString result = message;
+    const unsigned targetRate = success ? baudRate : m_BaudDetectOriginalRate;
+    const auto handle = m_p_SerialPort->native_handle();
+    std::string tuningError;
+    unsigned appliedBaudRate = 0;
+    if (SerialTuning::setBaudRate(handle, targetRate, &tuningError)
+        && SerialTuning::readBaudRate(handle, appliedBaudRate, &tuningError)) {
+        applyBaudRate(appliedBaudRate);
+        resolveReadPolicy();
+        if (success) {
+            // 断线重连按检测出的速率重新打开
+            std::lock_guard<std::mutex> lock(m_OpenSettingsMutex);
+            m_OpenSettings.baudRate = static_cast<int>(baudRate);
+        }
+    } else {
+        result = QString("Failed to set baud rate %1: %2").arg(targetRate).arg(tuningError.c_str());
+        emit signal_ErrorOccurred(result);
+        success = false;
+    }
+    // 切换过程中收到的数据按哪个速率都不可信
+    SerialTuning::flushInput(handle);
+    m_IsDetectingBaud.store(false);
+    emit signal_BaudDetectionFinished(success, success ? baudRate : 0, result);
+}
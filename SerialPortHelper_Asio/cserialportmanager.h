@@ -1,8 +1,19 @@
 #ifndef CSERIALPORTMANAGER_H
 #define CSERIALPORTMANAGER_H
+#include "cbauddetector.h"
+#include "creadsizer.h"
+#include "cserialtuning.h"
+
 #include <QObject>
+#include <QByteArray>
+#include <array>
+#include <chrono>
 #include <deque>
-#include <queue>
+#include <functional>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <vector>
 #include <boost/bind/bind.hpp>
 #include <boost/asio.hpp>
 class QSerialPort;
@@ -13,39 +24,343 @@ class thread;
 class QByteArray;
 class QString;
 class io_context;
+class CCaptureWriter;
 class CSerialPortManager : public QObject
 {
     Q_OBJECT
 public:
+    // 发送优先级通道：高优先级帧（急停、中止等）插在普通通道的分块之间写出，
+    // 最多等待普通通道正在写的一个分块
+    enum WritePriority
+    {
+        HighPriority,
+        NormalPriority,
+        WritePriorityCount
+    };
+
+    struct WriteLaneStats
+    {
+        size_t queuedFrames = 0;     // 排队中的帧数（含正在写的帧）
+        size_t queuedBytes = 0;      // 排队中尚未写出的字节数
+        quint64 framesWritten = 0;   // 已写完的帧数
+        double lastWaitMs = 0.0;     // 入队到开始写出的等待时间
+        double averageWaitMs = 0.0;
+        double maxWaitMs = 0.0;
+    };
+
+    // 周期发送的迟到（实际触发时刻 - 截止时刻）直方图，各桶上界单位为微秒，最后一桶收纳 >= 20 ms
+    static constexpr int kJitterBinCount = 12;
+    static constexpr std::array<qint64, kJitterBinCount - 1> kJitterBinBoundsUs{
+        {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000}};
+
+    struct PeriodicStats
+    {
+        quint64 sent = 0;        // 已送入写队列的帧数
+        quint64 missed = 0;      // 因处理过慢而整周期跳过的次数
+        quint64 throttled = 0;   // 所在通道积压到高水位时放弃的帧数
+        double meanLatenessUs = 0.0;
+        double maxLatenessUs = 0.0;
+        std::array<quint64, kJitterBinCount> histogram{};
+    };
+
+    // 接收交付条件：读到的数据先在 I/O 线程上累积，满足任一已启用的条件即整体交付（signal_DataReceived）。
+    // 全部不启用时每次读取完成立即交付，与原先行为相同
+    struct ReadPolicy
+    {
+        size_t minBytes = 0;                    // 累积到至少 N 字节，0 表示不启用
+        QByteArray delimiter;                   // 收到分隔符，交付到分隔符为止（含分隔符），空表示不启用
+        std::chrono::microseconds idleGap{0};   // 最后一个字节之后空闲超过 T，0 表示不启用
+        // 以字符时间计的空闲间隔（按波特率、数据位、校验位、停止位折算，如 Modbus RTU 的 3.5），
+        // 大于 0 时代替 idleGap，用于只靠静默分帧、没有分隔符的协议
+        double idleGapChars = 0.0;
+        std::chrono::microseconds timeout{0};   // 自累积的第一个字节起最长等待，0 表示不启用
+
+        bool isImmediate() const
+        {
+            return minBytes == 0 && delimiter.isEmpty() && idleGap.count() <= 0 && idleGapChars <= 0.0
+                   && timeout.count() <= 0;
+        }
+    };
+
+    struct ReadStats
+    {
+        quint64 completions = 0;   // 读取完成（I/O 线程唤醒）次数
+        quint64 deliveries = 0;    // 交付次数
+        quint64 bytes = 0;
+        quint64 retries = 0;       // 可重试的读取错误（被信号打断等）后原地重新发起读取的次数
+    };
+
+    // 最近一次 openPort() 的参数，断线重连时按原样重新打开
+    struct OpenSettings
+    {
+        QString portName;
+        int baudRate = 0;
+        int dataBits = 8;
+        int parity = 0;
+        int stopBits = 1;
+        int flowControl = 0;
+        SerialTuning::LatencyMode latencyMode = SerialTuning::DefaultLatency;
+    };
+
+    // 桥接转发的统计，只统计本端读到、交给对端写出的方向；
+    // 转发时延为读取完成到对端开始写出的时间，即桥接额外引入的时延（不含线路传输时间）
+    struct BridgeStats
+    {
+        quint64 forwardedChunks = 0;
+        quint64 forwardedBytes = 0;
+        quint64 droppedBytes = 0;   // 对端正在关闭时无法转发的字节数
+        quint64 stalls = 0;         // 读取缓冲全部在对端等待写出、暂停读取的次数
+        double lastLatencyUs = 0.0;
+        double meanLatencyUs = 0.0;
+        double maxLatencyUs = 0.0;
+        std::array<quint64, kJitterBinCount> histogram{};   // 桶上界同 kJitterBinBoundsUs
+    };
+
+    // 独占一个 io_context 和 I/O 线程
     explicit CSerialPortManager(QObject *parent = nullptr);
+    // 运行在外部共享的 io_context 上（由 CSerialPortRegistry 统一运行），本对象不启动也不停止它；
+    // 此时 closePort() 不能在该 io_context 的线程上调用；本端口的回调在超时内没有执行完时关闭失败（报错），
+    // 串口保持打开状态，可稍后再次关闭；io_context 已停止且 I/O 线程已退出时在调用线程上直接收尾
+    explicit CSerialPortManager(boost::asio::io_context &ioContext, QObject *parent = nullptr);
     ~CSerialPortManager();
 
-    bool openPort(const QString &portName, int baudRate, int dataBits, int parity, int stopBits);
+    // parity 取 QSerialPort::Parity 的值：NoParity / EvenParity / OddParity，boost 不支持 Space / Mark，打开失败
+    // flowControl 取 QSerialPort::FlowControl 的值：NoFlowControl / HardwareControl（RTS/CTS）/ SoftwareControl（XON/XOFF）
+    // latencyMode 为 LowLatency 时打开后还会丢弃内核中残留的旧输入
+    bool openPort(const QString &portName, int baudRate, int dataBits, int parity, int stopBits, int flowControl = 0,
+                  SerialTuning::LatencyMode latencyMode = SerialTuning::DefaultLatency);
     void closePort();
     bool isOpen() const;
+    // 本端口的异步操作所在的 io_context，共享模式下即注册表的 io_context
+    boost::asio::io_context &ioContext() const;
+    // 最近一次 openPort() 使用的端口名
+    QString portName() const;
+    OpenSettings openSettings() const;
+    // 打开后从驱动读回的实际波特率，可能与请求值略有不同
+    unsigned appliedBaudRate() const;
+    // 按实际波特率与帧格式折算的单个字符线路时间，端口未打开时为 0
+    std::chrono::nanoseconds characterTime() const;
+
+    // 单次读取请求的上限，下次打开串口时生效；实际请求大小在波特率折算的下限与该上限之间自适应
+    void setMaxReadBufferSize(size_t bytes);
+    size_t readBufferSize() const;
 
-    void sendData(const QByteArray &data);
+    // 可在任意时刻修改，端口打开时立即在 I/O 线程上生效，已累积的数据按旧条件先行交付
+    void setReadPolicy(const ReadPolicy &policy);
+    ReadPolicy readPolicy() const;
+    ReadStats readStats() const;
+
+    // 写队列积压超过硬上限时拒绝写入并返回 false，调用方应在收到高水位信号后暂停生产
+    bool sendData(const QByteArray &data, WritePriority priority = NormalPriority);
     void readData();
 
     void handleRead(const boost::system::error_code &error, size_t bytesTransferred);
     void handleWrite(const boost::system::error_code &error, size_t bytesTransferred);
 
+    // 内存映射发送文件：按块送入写队列，写队列积压超过高水位时暂停取块，写完一块再补一块
+    bool sendFile(const QString &filePath);
+    void cancelFileSend();
+    bool isSendingFile() const;
+
+    // 写队列背压：已接受但尚未写出的字节数越过高水位时进入限流，回落到低水位以下解除
+    size_t writeQueueBytes() const;
+    bool isWriteThrottled() const;
+    WriteLaneStats writeLaneStats(WritePriority priority) const;
+    void resetWriteLaneStats();
+
+    // 周期发送预先构造的帧，返回任务编号（端口未打开时返回 -1）；端口关闭时所有任务随之结束
+    int startPeriodicSend(const QByteArray &frame, std::chrono::microseconds period,
+                          WritePriority priority = HighPriority);
+    void stopPeriodicSend(int id);
+    void stopAllPeriodicSends();
+    PeriodicStats periodicStats(int id) const;
+
+    // 桥接：两个已打开的端口互相转发读到的数据。在 I/O 线程上把刚完成的读取缓冲直接交给对端的写队列，
+    // 不经过界面线程也不拷贝；对端写得慢时读取缓冲用尽，本端暂停读取，由驱动缓冲和流控向上游施压。
+    // 两端必须运行在同一个共享 io_context 上（同一个 CSerialPortRegistry），任一端关闭时自动解除
+    bool startBridge(CSerialPortManager *peer);
+    void stopBridge();
+    bool isBridged() const;
+    // 桥接时是否仍按交付条件把读到的数据发给界面（signal_DataReceived），默认不发；录制不受影响
+    void setBridgeTap(bool enabled);
+    bool isBridgeTapEnabled() const;
+    BridgeStats bridgeStats() const;
+
+    // 以下三个接口供运行在同一 io_context 上的组件（如 CSerialTcpServer）直接接入读写路径，只能在 I/O 线程上调用。
+    // 读取旁路：每次读取完成后以读取缓冲本身调用，不拷贝；需要异步使用时持有 buffer 的引用即可，
+    // 本端发现缓冲仍被引用时换新缓冲读取，不会覆盖
+    using ReadTap = std::function<void(const std::shared_ptr<std::vector<char>> &buffer, size_t size,
+                                       std::chrono::steady_clock::time_point arrival)>;
+    int addReadTap(ReadTap tap);
+    void removeReadTap(int id);
+    // 把 buffer 的前 size 字节直接送入普通通道写出，不拷贝；写完或端口关闭丢弃时在 I/O 线程上调用 onReleased。
+    // 端口未打开或正在关闭时返回 false，不调用 onReleased
+    bool writeShared(const std::shared_ptr<std::vector<char>> &buffer, size_t size, std::function<void()> onReleased);
+    // 把读取旁路收到的 arrival 折算为与 signal_DataReceived、录制文件相同的 Unix 纪元纳秒
+    qint64 toTimestampNs(std::chrono::steady_clock::time_point time) const;
+
+    // 录制接收数据到捕获文件（同时生成稀疏索引），可在串口打开前后任意时刻开始
+    bool startRecording(const QString &filePath);
+    void stopRecording();
+    bool isRecording() const;
+
+    // 自动检测接收波特率：端口须已打开（数据位、校验、停止位按打开时的设置），只听不发，
+    // 逐个候选速率在 I/O 线程上重新配置串口并打分，有把握时立即停止并切到检测出的速率；
+    // 检测期间读到的数据只用于打分，不交付、不录制、不转发，发送方向同样处在候选速率上。
+    // 失败或取消时恢复原速率。candidates 为空时使用 CBaudDetector::defaultCandidates()
+    bool startBaudDetection(const std::vector<unsigned> &candidates = {});
+    void cancelBaudDetection();
+    bool isDetectingBaud() const;
+
 signals:
-    void signal_DataReceived(const QByteArray &data);
+    // timestampNs：所含最后一块数据读取完成的时刻，在完成处理的第一时间用单调时钟测得，
+    // 再按打开时的对照折算为 Unix 纪元纳秒；不受界面线程排队和系统时间调整影响
+    void signal_DataReceived(const QByteArray &data, qint64 timestampNs);
     void signal_ErrorOccurred(const QString &errorString);
+    // 读写出现不可重试的错误（设备拔出、USB 复位等），本端口已停止读取，每次打开最多发出一次；
+    // 端口仍处于打开状态，由接收者关闭（CSerialPortRegistry 随后按退避重新打开）
+    void signal_PortLost(const QString &errorString);
     void signal_PortClosed();
+    void signal_FileSendProgress(qint64 bytesSent, qint64 totalBytes, double bytesPerSecond);
+    void signal_FileSendFinished(bool success, const QString &message);
+    void signal_WriteQueueHighWatermark(qint64 queuedBytes);
+    void signal_WriteQueueLowWatermark(qint64 queuedBytes);
+    // 自动波特率检测结束（含失败、取消与端口关闭），成功时端口已切到 baudRate
+    void signal_BaudDetectionFinished(bool success, unsigned baudRate, const QString &message);
 
 
 
 private:
-    boost::asio::io_context m_IoContext;
+    struct PendingWrite
+    {
+        QByteArray data;
+        bool isFileChunk = false;
+        int offset = 0;             // 普通通道按块写出时已写出的字节数
+        bool started = false;
+        std::chrono::steady_clock::time_point enqueueTime;   // 桥接转发的数据取对端的读取完成时刻
+        // 桥接转发的数据：data 以 fromRawData 直接引用对端的读取缓冲，storage 保证缓冲在写完前有效；
+        // 写完后通知 bridgeSource 缓冲已归还，桥接解除后置空
+        std::shared_ptr<std::vector<char>> storage;
+        CSerialPortManager *bridgeSource = nullptr;
+        std::function<void()> onReleased;   // writeShared 的调用方
+    };
+    struct FileSendState;
+    struct PeriodicTask;
+
+    // 以下函数只在 I/O 线程上调用
+    void enqueueWrite(const QByteArray &data, WritePriority priority, bool isFileChunk = false);
+    void pushWrite(PendingWrite write, WritePriority priority);
+    void enqueueBridgeWrite(const std::shared_ptr<std::vector<char>> &buffer, size_t size, CSerialPortManager *source,
+                            std::chrono::steady_clock::time_point arrival);
+    bool selectNextReadBuffer();
+    void armNextRead();
+    void handleBridgeBufferReturned();
+    void recordBridgeLatency(std::chrono::steady_clock::duration latency);
+    void detachBridge();
+    void runOnIoThread(const std::function<void()> &task);
+    void startWrite();
+    void addQueuedBytes(size_t bytes);
+    void releaseQueuedBytes(size_t bytes);
+    void pumpFileSend();
+    void finishFileSend(bool success, const QString &message);
+    void schedulePeriodic(PeriodicTask &task);
+    void handlePeriodicTimer(int id, const boost::system::error_code &error);
+    void applyReadPolicy();
+    void resolveReadPolicy();
+    void appendReceived(const char *data, size_t size, std::chrono::steady_clock::time_point now);
+    void deliverReceived(const QByteArray &data, std::chrono::steady_clock::time_point arrival);
+    void deliverPendingRead();
+    void armReadPolicyTimer();
+    void handleReadPolicyTimer(const boost::system::error_code &error);
+    bool waitForPendingOperations();
+    void reportPortLost(const QString &errorString);
+    void applyBaudRate(unsigned appliedBaudRate);
+    void beginBaudCandidate();
+    void armBaudDetectTimer();
+    void feedBaudDetector(const char *data, size_t size, std::chrono::steady_clock::time_point arrival);
+    void handleBaudVerdict(CBaudDetector::Verdict verdict);
+    void handleBaudDetectTimer(const boost::system::error_code &error);
+    void finishBaudDetection(bool success, unsigned baudRate, const QString &message);
+
+    std::unique_ptr<boost::asio::io_context> m_p_OwnedIoContext;   // 共享模式下为空
+    boost::asio::io_context &m_IoContext;
+    // 独占模式下端口打开期间保持 run() 不返回，读写完成和定时器都能立即分派
+    std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> m_p_WorkGuard;
     std::unique_ptr<boost::asio::serial_port> m_p_SerialPort;
     // 增加一个std::future类型的成员变量来管理poll线程
     std::future<void> m_AsyncPollThread;
-    std::vector<char> m_ReadBuffer;
-    std::deque<boost::asio::const_buffer> m_WriteBuffer;
+    // 读取缓冲轮换使用：完成后先在下一块上重新发起读取，再处理刚完成的那块。
+    // 处理在 I/O 线程上同步完成，不桥接时两块即可保证正在处理的缓冲不会被新的读取覆盖；
+    // 桥接时完成的缓冲借给对端写出（引用计数大于 1），多留两块让读取不必等对端写完
+    static constexpr size_t kReadBufferCount = 4;
+    std::array<std::shared_ptr<std::vector<char>>, kReadBufferCount> m_ReadBuffers;   // 打开时按上限一次分配
+    size_t m_ReadBufferIndex = 0;                // 当前挂起的读取所用的缓冲
+    bool m_IsReadStalled = false;                // 缓冲全部借出，等对端写完归还后再读
+    int m_BridgeLentBuffers = 0;                 // 借给桥接对端、尚未写完的缓冲数
+    std::map<int, ReadTap> m_ReadTaps;           // 只在 I/O 线程上访问
+    int m_NextReadTapId = 1;
+    CReadSizer m_ReadSizer;                      // 只在 I/O 线程上访问
+    std::atomic<size_t> m_MaxReadBufferSize{CReadSizer::kDefaultMaxSize};
+    std::atomic<size_t> m_ReadBufferSize{0};     // m_ReadSizer.size() 的副本，供其他线程查询
+    // 接收交付条件：m_RequestedReadPolicy 由调用方设置，I/O 线程取一份副本使用
+    mutable std::mutex m_ReadPolicyMutex;
+    ReadPolicy m_RequestedReadPolicy;
+    ReadPolicy m_ReadPolicy;
+    std::chrono::nanoseconds m_IdleGap{0};       // 生效的空闲间隔，idleGapChars 已按字符时间折算
+    std::atomic<long long> m_CharacterTimeNs{0};
+    bool m_IsReadTimerResolutionRaised = false;
+    QByteArray m_PendingRead;                    // 尚未满足交付条件的数据
+    int m_DelimiterSearchFrom = 0;               // m_PendingRead 中尚未查找过分隔符的起点
+    std::chrono::steady_clock::time_point m_PendingReadSince;   // 累积的第一个字节到达时刻
+    std::chrono::steady_clock::time_point m_LastReadTime;       // 最后一个字节到达时刻
+    // 空闲间隔与超时共用一个定时器，只在需要更早的截止时刻时才重新设置，平时到期后再按最新时刻判断
+    boost::asio::steady_timer m_ReadPolicyTimer;
+    bool m_IsReadPolicyTimerArmed = false;
+    std::chrono::steady_clock::time_point m_ReadPolicyDeadline;
+    // 打开时记录的单调时钟与系统时间对照，接收时间戳由单调时钟折算，录制文件中的时间戳因此单调不减
+    std::chrono::steady_clock::time_point m_ClockBaseSteady;
+    qint64 m_ClockBaseSystemNs = 0;
+    std::atomic<quint64> m_ReadCompletions{0};
+    std::atomic<quint64> m_ReadDeliveries{0};
+    std::atomic<quint64> m_ReadBytes{0};
+    std::atomic<quint64> m_ReadRetries{0};
+    int m_ConsecutiveReadRetries = 0;            // 只在 I/O 线程上访问，读取成功后清零
+    std::atomic<bool> m_IsPortLost{false};
+    // 各优先级的写队列持有数据（隐式共享），只在 I/O 线程上访问
+    std::array<std::deque<PendingWrite>, WritePriorityCount> m_WriteBuffers;
+    std::atomic<size_t> m_WriteQueuedBytes{0};   // 生产者入队时累加，写完或丢弃时在 I/O 线程上扣减
+    std::atomic<bool> m_IsWriteThrottled{false};
+    bool m_IsWriting = false;
+    WritePriority m_WritingLane = NormalPriority;   // 正在写出的帧所在通道
+    size_t m_BulkChunkSize = 0;                     // 普通通道每次写出的上限，按波特率折算
+    mutable std::mutex m_LaneStatsMutex;
+    std::array<WriteLaneStats, WritePriorityCount> m_LaneStats;
+    mutable std::mutex m_PeriodicMutex;
+    std::map<int, std::unique_ptr<PeriodicTask>> m_PeriodicTasks;
+    int m_NextPeriodicId = 1;
+    // 桥接对端，只在 I/O 线程上访问；两端运行在同一个线程上，可以直接调用对端的成员
+    CSerialPortManager *m_p_BridgePeer = nullptr;
+    std::atomic<bool> m_IsBridged{false};
+    std::atomic<bool> m_IsBridgeTapEnabled{false};
+    mutable std::mutex m_BridgeStatsMutex;
+    BridgeStats m_BridgeStats;
+    std::unique_ptr<FileSendState> m_p_FileSend;
+    std::atomic<bool> m_IsSendingFile{false};
     std::atomic<bool> m_IsPortOpen;
-    std::queue<QByteArray> m_ReceivedDataQueue;  // 接收数据队列
+    std::atomic<unsigned> m_AppliedBaudRate{0};
+    std::atomic<bool> m_IsClosing{false};        // 关闭过程中不再发起新的读写
+    int m_PendingOperations = 0;                 // 已发起、回调尚未执行的异步操作数，只在 I/O 线程上访问
+    mutable std::mutex m_OpenSettingsMutex;      // 自动波特率检测在 I/O 线程上改写其中的速率
+    OpenSettings m_OpenSettings;
+    // 自动波特率检测，只在 I/O 线程上访问；检测中 handleRead 把数据交给检测器，不做其他处理
+    std::unique_ptr<CBaudDetector> m_p_BaudDetector;
+    boost::asio::steady_timer m_BaudDetectTimer;
+    std::atomic<bool> m_IsDetectingBaud{false};
+    unsigned m_BaudDetectOriginalRate = 0;       // 失败或取消时恢复
+    SerialTuning::LineErrors m_LineErrors;
+    bool m_HasLineErrors = false;                // 驱动是否提供线路错误计数
+    mutable std::mutex m_RecordMutex;
+    std::unique_ptr<CCaptureWriter> m_p_CaptureWriter;
 
 
 };
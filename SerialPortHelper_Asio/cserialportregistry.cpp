@@ -0,0 +1,346 @@
+#include "cserialportregistry.h"
+#include "cportwatcher.h"
+
+#include <qdebug.h>
+#include <algorithm>
+
+CSerialPortRegistry::CSerialPortRegistry(QObject *parent)
+    : QObject{parent}
+    , m_p_WorkGuard(std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
+          m_IoContext.get_executor()))
+{
+    // I/O 线程在注册表的整个生命周期内运行，串口打开、关闭都不再启停线程
+    m_IoThread = std::async(std::launch::async, [this]() {
+        m_IoContext.run();
+    });
+}
+
+CSerialPortRegistry::~CSerialPortRegistry()
+{
+    // 串口关闭时要在 I/O 线程上取消操作并等待回调，必须先于线程退出
+    closeAll();
+    m_Ports.clear();
+    m_p_WorkGuard.reset();
+    m_IoContext.stop();
+    if (m_IoThread.valid()) {
+        m_IoThread.wait();
+    }
+}
+
+int CSerialPortRegistry::addPort(const QString &label)
+{
+    const int id = m_NextId++;
+    Entry &entry = m_Ports[id];
+    entry.label = label;
+    entry.manager = std::make_unique<CSerialPortManager>(m_IoContext);
+    // 错误信号在 I/O 线程上发出，排队到界面线程后再计数和转发；
+    // 重连期间每次尝试打开失败都会报错，只记下原因，不逐条转发
+    connect(entry.manager.get(), &CSerialPortManager::signal_ErrorOccurred, this, [this, id](const QString &error) {
+        auto it = m_Ports.find(id);
+        if (it == m_Ports.end()) {
+            return;
+        }
+        if (it->second.reconnect.isReconnecting) {
+            it->second.reconnect.lastError = error;
+            return;
+        }
+        ++it->second.errorCount;
+        emit signal_PortError(id, error);
+    });
+    connect(entry.manager.get(), &CSerialPortManager::signal_PortLost, this,
+            [this, id](const QString &error) { handlePortLost(id, error); });
+    entry.reconnectTimer = std::make_unique<QTimer>();
+    entry.reconnectTimer->setSingleShot(true);
+    connect(entry.reconnectTimer.get(), &QTimer::timeout, this, [this, id]() { attemptReconnect(id); });
+    emit signal_PortAdded(id);
+    return id;
+}
+
+bool CSerialPortRegistry::removePort(int id)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end()) {
+        return false;
+    }
+    if (it->second.tcpServer) {
+        it->second.tcpServer->stop();
+    }
+    stopSharedMemory(id);
+    if (it->second.manager->isOpen()) {
+        it->second.manager->closePort();
+    }
+    m_Ports.erase(it);
+    emit signal_PortRemoved(id);
+    return true;
+}
+
+CSerialPortManager *CSerialPortRegistry::port(int id) const
+{
+    auto it = m_Ports.find(id);
+    return it != m_Ports.end() ? it->second.manager.get() : nullptr;
+}
+
+std::vector<int> CSerialPortRegistry::portIds() const
+{
+    std::vector<int> ids;
+    ids.reserve(m_Ports.size());
+    for (const auto &port : m_Ports) {
+        ids.push_back(port.first);
+    }
+    return ids;
+}
+
+QString CSerialPortRegistry::label(int id) const
+{
+    auto it = m_Ports.find(id);
+    return it != m_Ports.end() ? it->second.label : QString();
+}
+
+int CSerialPortRegistry::portCount() const
+{
+    return static_cast<int>(m_Ports.size());
+}
+
+void CSerialPortRegistry::closeAll()
+{
+    for (auto &port : m_Ports) {
+        port.second.reconnectTimer->stop();
+        port.second.reconnect.isReconnecting = false;
+        if (port.second.manager->isOpen()) {
+            port.second.manager->closePort();
+        }
+    }
+}
+
+void CSerialPortRegistry::handlePortsChanged(const QStringList &added, const QStringList &removed)
+{
+    // 处理过程中会发出信号，接收者可能增删串口，先取编号再逐个查找
+    for (int id : portIds()) {
+        auto it = m_Ports.find(id);
+        if (it == m_Ports.end()) {
+            continue;
+        }
+        Entry &entry = it->second;
+        CSerialPortManager *manager = entry.manager.get();
+        if (manager->isOpen()) {
+            for (const QString &device : removed) {
+                if (CPortWatcher::isSameDevice(manager->portName(), device)) {
+                    handlePortLost(id, QString("Device removed: %1").arg(device));
+                    break;
+                }
+            }
+        } else if (entry.reconnect.isReconnecting) {
+            for (const QString &device : added) {
+                if (CPortWatcher::isSameDevice(entry.reconnectSettings.portName, device)) {
+                    attemptReconnect(id);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void CSerialPortRegistry::setAutoReconnect(int id, bool enabled)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end()) {
+        return;
+    }
+    it->second.reconnect.isEnabled = enabled;
+    if (!enabled) {
+        it->second.reconnectTimer->stop();
+        it->second.reconnect.isReconnecting = false;
+    }
+}
+
+bool CSerialPortRegistry::isAutoReconnect(int id) const
+{
+    auto it = m_Ports.find(id);
+    return it != m_Ports.end() && it->second.reconnect.isEnabled;
+}
+
+void CSerialPortRegistry::handlePortLost(int id, const QString &reason)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end()) {
+        return;
+    }
+    Entry &entry = it->second;
+    CSerialPortManager *manager = entry.manager.get();
+    // 读写出错与拔出事件先后到达，或调用方已先关闭，只处理一次
+    if (!manager->isOpen()) {
+        return;
+    }
+    // 失效的句柄上读取已经停止，尽快关闭，释放设备让驱动重新枚举
+    entry.reconnectSettings = manager->openSettings();
+    manager->closePort();
+    ++entry.errorCount;
+    if (manager->isOpen()) {
+        // 关闭失败时句柄仍被占用，重新打开也不会成功
+        emit signal_PortError(id, QString("Port lost and could not be closed: %1").arg(reason));
+        return;
+    }
+    entry.outageStart = std::chrono::steady_clock::now();
+    ++entry.reconnect.outages;
+    entry.reconnect.attempts = 0;
+    entry.reconnect.lastError = reason;
+    if (!entry.reconnect.isEnabled) {
+        emit signal_PortError(id, QString("Port lost: %1").arg(reason));
+        return;
+    }
+    entry.reconnect.isReconnecting = true;
+    entry.reconnectDelayMs = kReconnectInitialDelayMs;
+    entry.reconnectTimer->start(entry.reconnectDelayMs);
+    emit signal_PortError(id, QString("Port lost, reconnecting: %1").arg(reason));
+}
+
+void CSerialPortRegistry::attemptReconnect(int id)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end() || !it->second.reconnect.isReconnecting) {
+        return;
+    }
+    Entry &entry = it->second;
+    entry.reconnectTimer->stop();
+    CSerialPortManager *manager = entry.manager.get();
+    // 重连期间调用方手动打开了串口也算恢复
+    if (!manager->isOpen()) {
+        ++entry.reconnect.attempts;
+        const CSerialPortManager::OpenSettings &settings = entry.reconnectSettings;
+        if (!manager->openPort(settings.portName, settings.baudRate, settings.dataBits, settings.parity,
+                               settings.stopBits, settings.flowControl, settings.latencyMode)) {
+            entry.reconnectDelayMs = std::min(entry.reconnectDelayMs * 2, kReconnectMaxDelayMs);
+            entry.reconnectTimer->start(entry.reconnectDelayMs);
+            return;
+        }
+    }
+    const double outageMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.outageStart).count();
+    ReconnectStats &stats = entry.reconnect;
+    stats.isReconnecting = false;
+    ++stats.reconnects;
+    stats.lastOutageMs = outageMs;
+    stats.maxOutageMs = std::max(stats.maxOutageMs, outageMs);
+    stats.totalOutageMs += outageMs;
+    emit signal_PortReconnected(id);
+}
+
+unsigned short CSerialPortRegistry::startTcpServer(int id, const QString &address, unsigned short port)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end()) {
+        return 0;
+    }
+    Entry &entry = it->second;
+    if (entry.tcpServer && entry.tcpServer->isRunning()) {
+        return entry.tcpServer->port();
+    }
+    entry.tcpServer = std::make_unique<CSerialTcpServer>(m_IoContext);
+    std::string error;
+    if (!entry.tcpServer->start(entry.manager.get(), address.toStdString(), port, &error)) {
+        entry.tcpServer.reset();
+        ++entry.errorCount;
+        emit signal_PortError(id, QString("Failed to start TCP server: %1").arg(error.c_str()));
+        return 0;
+    }
+    return entry.tcpServer->port();
+}
+
+void CSerialPortRegistry::stopTcpServer(int id)
+{
+    auto it = m_Ports.find(id);
+    if (it != m_Ports.end() && it->second.tcpServer) {
+        it->second.tcpServer->stop();
+        it->second.tcpServer.reset();
+    }
+}
+
+bool CSerialPortRegistry::startSharedMemory(int id, const QString &name, quint64 capacity)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end()) {
+        return false;
+    }
+    Entry &entry = it->second;
+    if (entry.shmRing) {
+        return true;
+    }
+    auto ring = std::make_shared<CShmRingPublisher>();
+    std::string error;
+    if (!ring->open(name.toStdString(), capacity, &error)) {
+        ++entry.errorCount;
+        emit signal_PortError(id, QString("Failed to start shared memory: %1").arg(error.c_str()));
+        return false;
+    }
+    CSerialPortManager *manager = entry.manager.get();
+    int tapId = 0;
+    // 读取旁路只能在 I/O 线程上增删；发布在读取完成时直接进行，不经过界面线程
+    runOnIoThread([manager, ring, &tapId]() {
+        tapId = manager->addReadTap([manager, ring](const std::shared_ptr<std::vector<char>> &buffer, size_t size,
+                                                    std::chrono::steady_clock::time_point arrival) {
+            ring->publish(buffer->data(), size, static_cast<uint64_t>(manager->toTimestampNs(arrival)));
+        });
+    });
+    entry.shmRing = std::move(ring);
+    entry.shmTapId = tapId;
+    return true;
+}
+
+void CSerialPortRegistry::stopSharedMemory(int id)
+{
+    auto it = m_Ports.find(id);
+    if (it == m_Ports.end() || !it->second.shmRing) {
+        return;
+    }
+    Entry &entry = it->second;
+    CSerialPortManager *manager = entry.manager.get();
+    const int tapId = entry.shmTapId;
+    runOnIoThread([manager, tapId]() { manager->removeReadTap(tapId); });
+    entry.shmRing->close();
+    entry.shmRing.reset();
+    entry.shmTapId = 0;
+}
+
+void CSerialPortRegistry::runOnIoThread(const std::function<void()> &task)
+{
+    std::promise<void> done;
+    boost::asio::post(m_IoContext, [&task, &done]() {
+        task();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+std::vector<CSerialPortRegistry::PortMetrics> CSerialPortRegistry::metrics() const
+{
+    std::vector<PortMetrics> result;
+    result.reserve(m_Ports.size());
+    for (const auto &port : m_Ports) {
+        const CSerialPortManager &manager = *port.second.manager;
+        PortMetrics metrics;
+        metrics.id = port.first;
+        metrics.label = port.second.label;
+        metrics.portName = manager.portName();
+        metrics.isOpen = manager.isOpen();
+        metrics.baudRate = metrics.isOpen ? manager.appliedBaudRate() : 0;
+        metrics.read = manager.readStats();
+        metrics.writeQueueBytes = manager.writeQueueBytes();
+        metrics.isWriteThrottled = manager.isWriteThrottled();
+        metrics.errorCount = port.second.errorCount;
+        if (port.second.tcpServer) {
+            metrics.tcpPort = port.second.tcpServer->port();
+            metrics.tcpClients = port.second.tcpServer->stats().clients;
+        }
+        if (port.second.shmRing) {
+            metrics.shmName = QString::fromStdString(port.second.shmRing->name());
+            metrics.shm = port.second.shmRing->stats();
+        }
+        metrics.reconnect = port.second.reconnect;
+        if (metrics.reconnect.isReconnecting) {
+            const auto outage = std::chrono::steady_clock::now() - port.second.outageStart;
+            metrics.reconnect.currentOutageMs = std::chrono::duration<double, std::milli>(outage).count();
+        }
+        result.push_back(metrics);
+    }
+    return result;
+}
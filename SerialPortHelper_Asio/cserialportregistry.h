@@ -0,0 +1,129 @@
+#ifndef CSERIALPORTREGISTRY_H
+#define CSERIALPORTREGISTRY_H
+#include "cserialportmanager.h"
+#include "cserialtcpserver.h"
+#include "cshmring.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+#include <boost/asio.hpp>
+
+// 串口注册表：所有串口共用一个 io_context 和一个 I/O 线程，按编号增删，统一汇总各口的运行指标。
+// 串口数据量相对 CPU 很小，一个线程即可承载几十个口，不再为每个口各起一个线程。
+// 只在界面线程上使用
+class CSerialPortRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    // 断线重连的退避：第一次在失效后 kReconnectInitialDelayMs 尝试，每失败一次间隔加倍，最长 kReconnectMaxDelayMs
+    static constexpr int kReconnectInitialDelayMs = 100;
+    static constexpr int kReconnectMaxDelayMs = 5000;
+
+    struct ReconnectStats
+    {
+        bool isEnabled = true;
+        bool isReconnecting = false;
+        quint64 outages = 0;            // 失效（读写出错、设备拔出）次数
+        quint64 reconnects = 0;         // 重新打开成功次数
+        quint64 attempts = 0;           // 本次断线已尝试重新打开的次数
+        double lastOutageMs = 0.0;      // 最近一次从失效到重新打开的时间
+        double maxOutageMs = 0.0;
+        double totalOutageMs = 0.0;
+        double currentOutageMs = 0.0;   // 正在重连时已断开的时间
+        QString lastError;              // 最近一次失效或重新打开失败的原因
+    };
+
+    struct PortMetrics
+    {
+        int id = 0;
+        QString label;
+        QString portName;
+        bool isOpen = false;
+        unsigned baudRate = 0;
+        CSerialPortManager::ReadStats read;
+        size_t writeQueueBytes = 0;
+        bool isWriteThrottled = false;
+        quint64 errorCount = 0;
+        unsigned short tcpPort = 0;   // 未以 TCP 共享时为 0
+        size_t tcpClients = 0;
+        QString shmName;              // 未发布到共享内存时为空
+        CShmRingPublisher::Stats shm;
+        ReconnectStats reconnect;
+    };
+
+    explicit CSerialPortRegistry(QObject *parent = nullptr);
+    ~CSerialPortRegistry();
+
+    // 新建一个未打开的串口，返回编号；label 用于界面显示
+    int addPort(const QString &label);
+    // 关闭并销毁，之后该编号的指针失效
+    bool removePort(int id);
+    CSerialPortManager *port(int id) const;
+    std::vector<int> portIds() const;
+    QString label(int id) const;
+    int portCount() const;
+
+    void closeAll();
+    // 以 TCP 共享该串口（类似 ser2net），串口开关不影响监听和已有连接；port 为 0 时由系统分配。
+    // 返回实际监听的端口，失败时返回 0 并发出 signal_PortError
+    unsigned short startTcpServer(int id, const QString &address, unsigned short port);
+    void stopTcpServer(int id);
+    // 把该串口收到的数据连同时间戳发布到共享内存环，供多个分析进程各自读取（客户端见 cshmring.h）。
+    // 读取端跟不上时被跳过，不影响串口和其他读取端；失败时发出 signal_PortError
+    bool startSharedMemory(int id, const QString &name, quint64 capacity = ShmRingFormat::kDefaultCapacity);
+    void stopSharedMemory(int id);
+    // 串口失效（读写出错或设备拔出）时立即关闭，再按原来的参数以指数退避重新打开，默认开启。
+    // 交付条件、读取上限、录制、TCP 与共享内存共享跨重连保持；桥接与周期发送随关闭结束，
+    // 需要时由调用方在 signal_PortReconnected 后重新建立。关闭时同时放弃正在进行的重连
+    void setAutoReconnect(int id, bool enabled);
+    bool isAutoReconnect(int id) const;
+    std::vector<PortMetrics> metrics() const;
+
+public slots:
+    // 接热插拔监视：拔出的设备若仍被打开则按失效处理；正在重连的设备重新插入时立即重试，不等退避
+    void handlePortsChanged(const QStringList &added, const QStringList &removed);
+
+signals:
+    void signal_PortAdded(int id);
+    void signal_PortRemoved(int id);
+    // 汇总所有串口的错误，便于在一处显示
+    void signal_PortError(int id, const QString &errorString);
+    // 失效后重新打开成功，或重连期间被调用方手动打开
+    void signal_PortReconnected(int id);
+
+private:
+    void runOnIoThread(const std::function<void()> &task);
+    void handlePortLost(int id, const QString &reason);
+    void attemptReconnect(int id);
+
+    struct Entry
+    {
+        QString label;
+        std::unique_ptr<CSerialPortManager> manager;
+        std::unique_ptr<CSerialTcpServer> tcpServer;   // 声明在 manager 之后，先于串口销毁
+        std::shared_ptr<CShmRingPublisher> shmRing;    // 读取旁路也持有一份，在 I/O 线程上移除旁路后才关闭
+        int shmTapId = 0;
+        quint64 errorCount = 0;
+        ReconnectStats reconnect;
+        CSerialPortManager::OpenSettings reconnectSettings;   // 失效时的打开参数
+        int reconnectDelayMs = kReconnectInitialDelayMs;
+        std::chrono::steady_clock::time_point outageStart;
+        std::unique_ptr<QTimer> reconnectTimer;
+    };
+
+    boost::asio::io_context m_IoContext;
+    std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> m_p_WorkGuard;
+    std::future<void> m_IoThread;
+    std::map<int, Entry> m_Ports;
+    int m_NextId = 1;
+};
+
+#endif // CSERIALPORTREGISTRY_H
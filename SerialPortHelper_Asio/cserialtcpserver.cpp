@@ -0,0 +1,357 @@
+#include "cserialtcpserver.h"
+#include "cserialportmanager.h"
+
+#include <array>
+#include <deque>
+#include <future>
+#include <set>
+#include <utility>
+#include <vector>
+
+using boost::asio::ip::tcp;
+
+struct CSerialTcpServer::State : std::enable_shared_from_this<State>
+{
+    explicit State(boost::asio::io_context &ioContext)
+        : acceptor(ioContext)
+    {
+    }
+
+    void accept();
+    void broadcast(const std::shared_ptr<std::vector<char>> &buffer, size_t size);
+    void shutdown();
+
+    tcp::acceptor acceptor;
+    CSerialPortManager *manager = nullptr;   // 停止后置空，之后的回调不再访问串口
+    int readTapId = 0;
+    std::set<std::shared_ptr<Session>> sessions;
+    std::weak_ptr<Session> writer;
+    std::atomic<bool> isRunning{false};
+    std::atomic<size_t> clientCount{0};
+    std::atomic<bool> hasWriter{false};
+    std::atomic<quint64> bytesToClients{0};
+    std::atomic<quint64> bytesFromWriter{0};
+    std::atomic<quint64> droppedBytes{0};
+    std::atomic<quint64> ignoredBytes{0};
+};
+
+struct CSerialTcpServer::Session : std::enable_shared_from_this<Session>
+{
+    Session(tcp::socket socket, std::shared_ptr<State> state)
+        : socket(std::move(socket))
+        , state(std::move(state))
+    {
+        for (auto &buffer : inBuffers) {
+            buffer = std::make_shared<std::vector<char>>(kSocketReadSize);
+        }
+    }
+
+    void start();
+    void send(const std::shared_ptr<std::vector<char>> &buffer, size_t size);
+    void close();
+    void startRead(bool allocateIfBusy);
+    void handleRead(const boost::system::error_code &error, size_t size, size_t index);
+    void handleWriteReleased();
+    void writeNext();
+
+    tcp::socket socket;
+    std::shared_ptr<State> state;   // 关闭时释放，打断与 State::sessions 的循环引用
+    bool isWriter = false;
+    // 发给客户端的数据直接引用串口的读取缓冲
+    std::deque<std::pair<std::shared_ptr<std::vector<char>>, size_t>> outgoing;
+    size_t backlog = 0;
+    bool isWriting = false;
+    // 写入者的接收缓冲轮换使用：一块交给串口写队列期间在另一块上继续接收，两块都在排队时暂停接收，
+    // 由 TCP 流控向客户端施压
+    std::array<std::shared_ptr<std::vector<char>>, 2> inBuffers;
+    size_t inIndex = 0;
+    bool isWaitingForRelease = false;
+    bool isClosed = false;
+};
+
+void CSerialTcpServer::State::accept()
+{
+    auto self = shared_from_this();
+    acceptor.async_accept([self](const boost::system::error_code &error, tcp::socket socket) {
+        if (error || self->manager == nullptr) {
+            return;
+        }
+        auto session = std::make_shared<Session>(std::move(socket), self);
+        if (self->writer.expired()) {
+            session->isWriter = true;
+            self->writer = session;
+            self->hasWriter.store(true);
+        }
+        self->sessions.insert(session);
+        self->clientCount.store(self->sessions.size());
+        session->start();
+        self->accept();
+    });
+}
+
+void CSerialTcpServer::State::broadcast(const std::shared_ptr<std::vector<char>> &buffer, size_t size)
+{
+    for (const auto &session : sessions) {
+        session->send(buffer, size);
+    }
+}
+
+void CSerialTcpServer::State::shutdown()
+{
+    boost::system::error_code ec;
+    acceptor.close(ec);
+    if (manager != nullptr) {
+        manager->removeReadTap(readTapId);
+        manager = nullptr;
+    }
+    // close() 会从 sessions 中移除自身
+    const auto closing = sessions;
+    for (const auto &session : closing) {
+        session->close();
+    }
+    isRunning.store(false);
+}
+
+void CSerialTcpServer::Session::start()
+{
+    boost::system::error_code ec;
+    // 交互式的短帧不等 Nagle 合并
+    socket.set_option(tcp::no_delay(true), ec);
+    startRead(false);
+}
+
+void CSerialTcpServer::Session::send(const std::shared_ptr<std::vector<char>> &buffer, size_t size)
+{
+    if (isClosed) {
+        return;
+    }
+    if (backlog + size > kMaxClientBacklog) {
+        state->droppedBytes.fetch_add(size);
+        return;
+    }
+    outgoing.emplace_back(buffer, size);
+    backlog += size;
+    if (!isWriting) {
+        writeNext();
+    }
+}
+
+void CSerialTcpServer::Session::writeNext()
+{
+    if (outgoing.empty() || isClosed) {
+        isWriting = false;
+        return;
+    }
+    isWriting = true;
+    auto self = shared_from_this();
+    const auto &front = outgoing.front();
+    boost::asio::async_write(socket, boost::asio::buffer(front.first->data(), front.second),
+                             [self](const boost::system::error_code &error, size_t size) {
+                                 if (self->isClosed) {
+                                     return;
+                                 }
+                                 if (error) {
+                                     self->close();
+                                     return;
+                                 }
+                                 self->backlog -= self->outgoing.front().second;
+                                 self->outgoing.pop_front();
+                                 if (self->state) {
+                                     self->state->bytesToClients.fetch_add(size);
+                                 }
+                                 self->writeNext();
+                             });
+}
+
+void CSerialTcpServer::Session::startRead(bool allocateIfBusy)
+{
+    if (isClosed) {
+        return;
+    }
+    // 只在没有被串口写队列引用的缓冲上接收
+    size_t index = inBuffers.size();
+    for (size_t step = 0; step < inBuffers.size(); ++step) {
+        const size_t candidate = (inIndex + step) % inBuffers.size();
+        if (inBuffers[candidate].use_count() == 1) {
+            index = candidate;
+            break;
+        }
+    }
+    if (index == inBuffers.size()) {
+        if (!allocateIfBusy) {
+            isWaitingForRelease = true;
+            return;
+        }
+        // 串口关闭时写队列稍后才清空，缓冲仍被引用，换一块新的
+        index = inIndex;
+        inBuffers[index] = std::make_shared<std::vector<char>>(kSocketReadSize);
+    }
+    isWaitingForRelease = false;
+    inIndex = (index + 1) % inBuffers.size();
+    auto self = shared_from_this();
+    // 回调只记下标，不额外持有缓冲，引用计数才能准确反映是否还在串口写队列中
+    socket.async_read_some(boost::asio::buffer(inBuffers[index]->data(), inBuffers[index]->size()),
+                           [self, index](const boost::system::error_code &error, size_t size) {
+                               self->handleRead(error, size, index);
+                           });
+}
+
+void CSerialTcpServer::Session::handleRead(const boost::system::error_code &error, size_t size, size_t index)
+{
+    if (error) {
+        close();
+        return;
+    }
+    if (!state) {
+        return;
+    }
+    if (!isWriter) {
+        state->ignoredBytes.fetch_add(size);
+    } else {
+        std::weak_ptr<Session> weak = shared_from_this();
+        CSerialPortManager *manager = state->manager;
+        if (manager != nullptr && manager->writeShared(inBuffers[index], size, [weak]() {
+                if (auto session = weak.lock()) {
+                    session->handleWriteReleased();
+                }
+            })) {
+            state->bytesFromWriter.fetch_add(size);
+        } else {
+            state->droppedBytes.fetch_add(size);
+        }
+    }
+    startRead(false);
+}
+
+void CSerialTcpServer::Session::handleWriteReleased()
+{
+    if (isWaitingForRelease) {
+        startRead(true);
+    }
+}
+
+void CSerialTcpServer::Session::close()
+{
+    if (isClosed) {
+        return;
+    }
+    isClosed = true;
+    boost::system::error_code ec;
+    socket.shutdown(tcp::socket::shutdown_both, ec);
+    socket.close(ec);
+    outgoing.clear();
+    backlog = 0;
+    if (state) {
+        auto self = shared_from_this();
+        if (isWriter) {
+            state->writer.reset();
+            state->hasWriter.store(false);
+        }
+        state->sessions.erase(self);
+        state->clientCount.store(state->sessions.size());
+        state.reset();
+    }
+}
+
+CSerialTcpServer::CSerialTcpServer(boost::asio::io_context &ioContext)
+    : m_IoContext(ioContext)
+{
+}
+
+CSerialTcpServer::~CSerialTcpServer()
+{
+    stop();
+}
+
+bool CSerialTcpServer::start(CSerialPortManager *manager, const std::string &address, unsigned short port,
+                             std::string *error)
+{
+    if (m_p_State) {
+        if (error) {
+            *error = "TCP server is already running";
+        }
+        return false;
+    }
+    // 读取旁路和 writeShared 只能在串口的 I/O 线程上使用
+    if (manager == nullptr || &manager->ioContext() != &m_IoContext) {
+        if (error) {
+            *error = "Serial port must run on the server's I/O context";
+        }
+        return false;
+    }
+    auto state = std::make_shared<State>(m_IoContext);
+    try {
+        const tcp::endpoint endpoint(boost::asio::ip::make_address(address), port);
+        state->acceptor.open(endpoint.protocol());
+        state->acceptor.set_option(tcp::acceptor::reuse_address(true));
+        state->acceptor.bind(endpoint);
+        state->acceptor.listen();
+        m_Port = state->acceptor.local_endpoint().port();
+    } catch (const boost::system::system_error &e) {
+        if (error) {
+            *error = std::string("Failed to listen on ") + address + ":" + std::to_string(port) + ": " + e.what();
+        }
+        return false;
+    }
+    state->isRunning.store(true);
+    m_p_State = state;
+    boost::asio::post(m_IoContext, [state, manager]() {
+        if (!state->isRunning.load()) {
+            return;
+        }
+        state->manager = manager;
+        std::weak_ptr<State> weak = state;
+        state->readTapId = manager->addReadTap(
+            [weak](const std::shared_ptr<std::vector<char>> &buffer, size_t size, std::chrono::steady_clock::time_point) {
+                if (auto locked = weak.lock()) {
+                    locked->broadcast(buffer, size);
+                }
+            });
+        state->accept();
+    });
+    return true;
+}
+
+void CSerialTcpServer::stop()
+{
+    if (!m_p_State) {
+        return;
+    }
+    auto state = std::move(m_p_State);
+    if (m_IoContext.get_executor().running_in_this_thread()) {
+        state->shutdown();
+        return;
+    }
+    // 在 I/O 线程上移除读取旁路并关闭连接，等它完成后调用方才能关闭或销毁串口
+    std::promise<void> done;
+    boost::asio::post(m_IoContext, [state, &done]() {
+        state->shutdown();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+bool CSerialTcpServer::isRunning() const
+{
+    return m_p_State && m_p_State->isRunning.load();
+}
+
+unsigned short CSerialTcpServer::port() const
+{
+    return m_p_State ? m_Port : 0;
+}
+
+CSerialTcpServer::Stats CSerialTcpServer::stats() const
+{
+    Stats stats;
+    if (!m_p_State) {
+        return stats;
+    }
+    stats.clients = m_p_State->clientCount.load();
+    stats.hasWriter = m_p_State->hasWriter.load();
+    stats.bytesToClients = m_p_State->bytesToClients.load();
+    stats.bytesFromWriter = m_p_State->bytesFromWriter.load();
+    stats.droppedBytes = m_p_State->droppedBytes.load();
+    stats.ignoredBytes = m_p_State->ignoredBytes.load();
+    return stats;
+}
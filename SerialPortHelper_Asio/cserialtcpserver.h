@@ -0,0 +1,54 @@
+#ifndef CSERIALTCPSERVER_H
+#define CSERIALTCPSERVER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+
+class CSerialPortManager;
+
+// 串口 TCP 服务（类似 ser2net）：在串口所在的 io_context 上监听，远程或本机回环即可直接收发该串口。
+// 串口读到的数据以读取缓冲本身写给所有连接，写入者发来的数据以接收缓冲本身送入串口写队列，两个方向都不拷贝。
+// 第一个连接成为写入者，其余连接只读（发来的数据丢弃并计数）；写入者断开后，下一个新连接成为写入者。
+// 客户端积压超过 kMaxClientBacklog 时丢弃发给它的数据，慢客户端不会拖住串口和其他客户端。
+// 公共接口可在任意线程调用，连接状态只在 I/O 线程上访问
+class CSerialTcpServer
+{
+public:
+    static constexpr size_t kMaxClientBacklog = 1024 * 1024;
+    static constexpr size_t kSocketReadSize = 16 * 1024;
+
+    struct Stats
+    {
+        size_t clients = 0;
+        bool hasWriter = false;
+        quint64 bytesToClients = 0;    // 写给各客户端的字节数之和
+        quint64 bytesFromWriter = 0;   // 写入者送入串口写队列的字节数
+        quint64 droppedBytes = 0;      // 客户端积压超限或串口未打开而丢弃的字节数
+        quint64 ignoredBytes = 0;      // 只读客户端发来而被丢弃的字节数
+    };
+
+    explicit CSerialTcpServer(boost::asio::io_context &ioContext);
+    ~CSerialTcpServer();
+
+    // manager 必须运行在同一个 io_context 上；端口为 0 时由系统分配，用 port() 取实际端口。
+    // 串口可以在服务运行期间关闭、重新打开，连接保持不断
+    bool start(CSerialPortManager *manager, const std::string &address, unsigned short port, std::string *error);
+    // 关闭监听和所有连接，返回后不再访问 manager
+    void stop();
+    bool isRunning() const;
+    unsigned short port() const;
+    Stats stats() const;
+
+private:
+    struct State;
+    struct Session;
+
+    boost::asio::io_context &m_IoContext;
+    std::shared_ptr<State> m_p_State;   // 会话与异步回调共同持有，停止后随最后一个回调释放
+    unsigned short m_Port = 0;
+};
+
+#endif // CSERIALTCPSERVER_H
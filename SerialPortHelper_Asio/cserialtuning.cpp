@@ -0,0 +1,269 @@
+#include "cserialtuning.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+// 用内核的 termios2 接口（<asm/termbits.h>），它与 glibc 的 <termios.h> 不能同时包含
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#else
+#include <sys/ioctl.h>
+#include <termios.h>
+#ifdef __APPLE__
+#include <IOKit/serial/ioss.h>
+#endif
+#endif
+
+namespace
+{
+#ifdef _WIN32
+constexpr DWORD kThroughputQueueSize = 64 * 1024;   // 驱动收发队列，默认通常只有 4 KiB
+#endif
+
+bool fail(std::string *error, const std::string &message)
+{
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+#ifndef _WIN32
+std::string errnoMessage(const char *what)
+{
+    return std::string(what) + ": " + std::strerror(errno);
+}
+#endif
+}
+
+namespace SerialTuning
+{
+const char *latencyModeName(LatencyMode mode)
+{
+    switch (mode) {
+    case LowLatency:
+        return "low";
+    case HighThroughput:
+        return "throughput";
+    default:
+        return "default";
+    }
+}
+
+bool parseLatencyMode(const std::string &name, LatencyMode &mode)
+{
+    for (LatencyMode candidate : {DefaultLatency, LowLatency, HighThroughput}) {
+        if (name == latencyModeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool applyLatencyMode(NativeHandle handle, LatencyMode mode, std::string *error)
+{
+    if (mode == DefaultLatency) {
+        return true;
+    }
+#if defined(__linux__)
+    // usb-serial 驱动（ftdi_sio 等）据此把延迟定时器设为 1 ms，8250 据此关闭接收 FIFO 触发阈值下的攒包
+    serial_struct serial;
+    if (ioctl(handle, TIOCGSERIAL, &serial) == 0) {
+        if (mode == LowLatency) {
+            serial.flags |= ASYNC_LOW_LATENCY;
+        } else {
+            serial.flags &= ~ASYNC_LOW_LATENCY;
+        }
+        if (ioctl(handle, TIOCSSERIAL, &serial) != 0 && errno != ENOTTY && errno != EINVAL) {
+            return fail(error, errnoMessage("TIOCSSERIAL"));
+        }
+    } else if (errno != ENOTTY && errno != EINVAL) {
+        return fail(error, errnoMessage("TIOCGSERIAL"));
+    }
+
+    // asio 的描述符是非阻塞的，read() 不受 VMIN/VTIME 影响，但 VTIME 为 0 时 n_tty 的 poll
+    // 要等到 VMIN 个字节才报告可读；两种模式都固定为 VMIN=1、VTIME=0，首字节到达即唤醒
+    termios2 options;
+    if (ioctl(handle, TCGETS2, &options) != 0) {
+        return fail(error, errnoMessage("TCGETS2"));
+    }
+    options.c_cc[VMIN] = 1;
+    options.c_cc[VTIME] = 0;
+    if (ioctl(handle, TCSETS2, &options) != 0) {
+        return fail(error, errnoMessage("TCSETS2"));
+    }
+    return true;
+#elif defined(_WIN32)
+    if (mode == HighThroughput) {
+        if (!SetupComm(static_cast<HANDLE>(handle), kThroughputQueueSize, kThroughputQueueSize)) {
+            return fail(error, "SetupComm failed: " + std::to_string(GetLastError()));
+        }
+        return true;
+    }
+    // FTDI 等驱动的延迟定时器只能在设备管理器的高级属性中修改
+    return fail(error, "Low-latency tuning is not supported on this platform");
+#else
+    (void)handle;
+    return fail(error, "Latency tuning is not supported on this platform");
+#endif
+}
+
+bool queryLowLatencyFlag(NativeHandle handle, bool &enabled)
+{
+#if defined(__linux__)
+    serial_struct serial;
+    if (ioctl(handle, TIOCGSERIAL, &serial) != 0) {
+        return false;
+    }
+    enabled = (serial.flags & ASYNC_LOW_LATENCY) != 0;
+    return true;
+#else
+    (void)handle;
+    (void)enabled;
+    return false;
+#endif
+}
+
+bool flushInput(NativeHandle handle, std::string *error)
+{
+#ifdef _WIN32
+    if (!PurgeComm(static_cast<HANDLE>(handle), PURGE_RXCLEAR)) {
+        return fail(error, "PurgeComm failed: " + std::to_string(GetLastError()));
+    }
+    return true;
+#elif defined(__linux__)
+    if (ioctl(handle, TCFLSH, TCIFLUSH) != 0) {
+        return fail(error, errnoMessage("TCFLSH"));
+    }
+    return true;
+#else
+    if (tcflush(handle, TCIFLUSH) != 0) {
+        return fail(error, errnoMessage("tcflush"));
+    }
+    return true;
+#endif
+}
+
+bool readLineErrors(NativeHandle handle, LineErrors &errors, std::string *error)
+{
+#if defined(_WIN32)
+    DWORD flags = 0;
+    if (!ClearCommError(static_cast<HANDLE>(handle), &flags, nullptr)) {
+        return fail(error, "ClearCommError failed: " + std::to_string(GetLastError()));
+    }
+    errors.frame += (flags & CE_FRAME) ? 1 : 0;
+    errors.parity += (flags & CE_RXPARITY) ? 1 : 0;
+    errors.overrun += (flags & (CE_OVERRUN | CE_RXOVER)) ? 1 : 0;
+    errors.breaks += (flags & CE_BREAK) ? 1 : 0;
+    return true;
+#elif defined(__linux__)
+    // 计数从驱动加载起累计，不会因读取而清零，直接覆盖即可
+    serial_icounter_struct counters;
+    if (ioctl(handle, TIOCGICOUNT, &counters) != 0) {
+        return fail(error, errnoMessage("TIOCGICOUNT"));
+    }
+    errors.frame = static_cast<uint32_t>(counters.frame);
+    errors.parity = static_cast<uint32_t>(counters.parity);
+    errors.overrun = static_cast<uint32_t>(counters.overrun) + static_cast<uint32_t>(counters.buf_overrun);
+    errors.breaks = static_cast<uint32_t>(counters.brk);
+    return true;
+#else
+    (void)handle;
+    (void)errors;
+    return fail(error, "Line error counters are not supported on this platform");
+#endif
+}
+
+bool setBaudRate(NativeHandle handle, unsigned baudRate, std::string *error)
+{
+    if (baudRate == 0) {
+        return fail(error, "Invalid baud rate");
+    }
+#if defined(_WIN32)
+    DCB dcb;
+    std::memset(&dcb, 0, sizeof(dcb));
+    dcb.DCBlength = sizeof(dcb);
+    if (!GetCommState(static_cast<HANDLE>(handle), &dcb)) {
+        return fail(error, "GetCommState failed: " + std::to_string(GetLastError()));
+    }
+    dcb.BaudRate = baudRate;
+    if (!SetCommState(static_cast<HANDLE>(handle), &dcb)) {
+        return fail(error, "SetCommState failed: " + std::to_string(GetLastError()));
+    }
+    return true;
+#elif defined(__linux__)
+    // 输出和输入速率都标记为 BOTHER，具体数值写在 c_ospeed/c_ispeed 中
+    termios2 options;
+    if (ioctl(handle, TCGETS2, &options) != 0) {
+        return fail(error, errnoMessage("TCGETS2"));
+    }
+    options.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    options.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    options.c_ospeed = baudRate;
+    options.c_ispeed = baudRate;
+    if (ioctl(handle, TCSETS2, &options) != 0) {
+        return fail(error, errnoMessage("TCSETS2"));
+    }
+    return true;
+#elif defined(__APPLE__)
+    speed_t speed = static_cast<speed_t>(baudRate);
+    if (ioctl(handle, IOSSIOSPEED, &speed) != 0) {
+        return fail(error, errnoMessage("IOSSIOSPEED"));
+    }
+    return true;
+#else
+    // BSD 的 speed_t 就是数值速率
+    termios options;
+    if (tcgetattr(handle, &options) != 0) {
+        return fail(error, errnoMessage("tcgetattr"));
+    }
+    if (cfsetspeed(&options, static_cast<speed_t>(baudRate)) != 0 || tcsetattr(handle, TCSANOW, &options) != 0) {
+        return fail(error, errnoMessage("tcsetattr"));
+    }
+    return true;
+#endif
+}
+
+bool readBaudRate(NativeHandle handle, unsigned &baudRate, std::string *error)
+{
+#if defined(_WIN32)
+    DCB dcb;
+    std::memset(&dcb, 0, sizeof(dcb));
+    dcb.DCBlength = sizeof(dcb);
+    if (!GetCommState(static_cast<HANDLE>(handle), &dcb)) {
+        return fail(error, "GetCommState failed: " + std::to_string(GetLastError()));
+    }
+    baudRate = dcb.BaudRate;
+    return true;
+#elif defined(__linux__)
+    // 驱动在 set_termios 中把实际可达的速率写回 termios，这里读到的是取整后的值
+    termios2 options;
+    if (ioctl(handle, TCGETS2, &options) != 0) {
+        return fail(error, errnoMessage("TCGETS2"));
+    }
+    baudRate = options.c_ospeed;
+    return true;
+#else
+    termios options;
+    if (tcgetattr(handle, &options) != 0) {
+        return fail(error, errnoMessage("tcgetattr"));
+    }
+    baudRate = static_cast<unsigned>(cfgetospeed(&options));
+    return true;
+#endif
+}
+
+std::chrono::nanoseconds characterTime(unsigned baudRate, int dataBits, bool hasParity, double stopBits)
+{
+    if (baudRate == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    const double bits = 1.0 + dataBits + (hasParity ? 1.0 : 0.0) + stopBits;
+    return std::chrono::nanoseconds(static_cast<long long>(bits * 1e9 / baudRate + 0.5));
+}
+}
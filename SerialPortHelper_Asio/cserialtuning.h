@@ -0,0 +1,60 @@
+#ifndef CSERIALTUNING_H
+#define CSERIALTUNING_H
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// 串口驱动层调优，参数为 boost::asio::serial_port::native_handle()。
+// 不依赖 Qt，GUI 与命令行工具共用。
+namespace SerialTuning
+{
+#ifdef _WIN32
+using NativeHandle = void *;
+#else
+using NativeHandle = int;
+#endif
+
+enum LatencyMode
+{
+    DefaultLatency,   // 不改动驱动设置
+    LowLatency,       // 请求/应答：关闭驱动侧攒包（FTDI 延迟定时器 16 ms -> 1 ms），首字节到达即唤醒
+    HighThroughput    // 大流量：保留驱动侧攒包，配合大块读取减少唤醒与完成次数
+};
+
+const char *latencyModeName(LatencyMode mode);
+bool parseLatencyMode(const std::string &name, LatencyMode &mode);
+
+// 设置 ASYNC_LOW_LATENCY 与 VMIN/VTIME。不支持 TIOCSSERIAL 的驱动（pty、多数 CDC-ACM）
+// 跳过驱动标志，不视为失败；其他平台上 LowLatency 无法在用户态设置，返回 false
+bool applyLatencyMode(NativeHandle handle, LatencyMode mode, std::string *error = nullptr);
+
+// 查询驱动的 ASYNC_LOW_LATENCY 标志，驱动不支持时返回 false
+bool queryLowLatencyFlag(NativeHandle handle, bool &enabled);
+
+// 丢弃内核输入缓冲中残留的旧数据
+bool flushInput(NativeHandle handle, std::string *error = nullptr);
+
+// 接收线路错误计数。Linux 读驱动的累计计数（TIOCGICOUNT），Windows 每次读取并清除错误标志
+// （ClearCommError），有错误的类别记 1；调用方保留上一次的结果，按差值判断这段时间内是否出错
+struct LineErrors
+{
+    uint64_t frame = 0;
+    uint64_t parity = 0;
+    uint64_t overrun = 0;
+    uint64_t breaks = 0;
+};
+
+// 在传入的 errors 上更新（Windows 累加，Linux 直接取累计值）。驱动不提供计数（pty、部分 CDC-ACM）或平台不支持时返回 false
+bool readLineErrors(NativeHandle handle, LineErrors &errors, std::string *error = nullptr);
+
+// 设置任意整数波特率（如 2/3/6/12 Mbaud），不经过经典 termios 的 Bxxx 速率表：
+// Linux 用 termios2 + BOTHER，macOS 用 IOSSIOSPEED，Windows 直接写 DCB
+bool setBaudRate(NativeHandle handle, unsigned baudRate, std::string *error = nullptr);
+// 读回驱动实际采用的波特率，驱动按分频系数取整后可能与请求值不同
+bool readBaudRate(NativeHandle handle, unsigned &baudRate, std::string *error = nullptr);
+
+// 一个字符在线路上占用的时间：1 起始位 + 数据位 + 校验位（有校验时 1 位）+ 停止位（1 / 1.5 / 2）
+std::chrono::nanoseconds characterTime(unsigned baudRate, int dataBits, bool hasParity, double stopBits);
+}
+
+#endif // CSERIALTUNING_H
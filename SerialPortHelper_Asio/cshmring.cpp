@@ -0,0 +1,486 @@
+#include "cshmring.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr uint32_t kPaddingRecord = 1;
+constexpr uint64_t kMinCapacity = 64 * 1024;
+
+enum SlotState : uint32_t
+{
+    SlotFree = 0,
+    SlotActive = 1
+};
+
+// 每个读取槽独占一个缓存行，读取端更新游标不会与其他读取端或发布端互相失效
+struct alignas(64) ReaderSlot
+{
+    std::atomic<uint32_t> state;
+    std::atomic<int64_t> pid;
+    std::atomic<uint64_t> cursor;
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> lostBytes;
+};
+
+struct alignas(64) RingHeader
+{
+    std::atomic<uint32_t> magic;   // 最后写入，读取端看到魔数才说明初始化完成
+    uint32_t version;
+    uint64_t capacity;
+    uint32_t maxReaders;
+    uint32_t dataOffset;
+    std::atomic<uint32_t> isClosed;
+    // 只有发布端写，读取端频繁读，与不常变的字段分开
+    alignas(64) std::atomic<uint64_t> reservePosition;   // 正在写入的记录末尾，先于数据更新
+    std::atomic<uint64_t> writePosition;                 // 已完整写入的末尾，后于数据更新
+    ReaderSlot readers[ShmRingFormat::kMaxReaders];
+};
+
+// 跨进程共享的原子变量必须无锁，否则锁在各自进程里
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "64-bit atomics must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "32-bit atomics must be lock-free");
+
+uint64_t alignRecord(uint64_t size)
+{
+    return (size + ShmRingFormat::kRecordAlignment - 1) & ~static_cast<uint64_t>(ShmRingFormat::kRecordAlignment - 1);
+}
+
+int64_t currentProcessId()
+{
+#if defined(_WIN32)
+    return static_cast<int64_t>(GetCurrentProcessId());
+#else
+    return static_cast<int64_t>(getpid());
+#endif
+}
+
+std::string lastErrorMessage()
+{
+#if defined(_WIN32)
+    return "error " + std::to_string(GetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+}
+
+struct CShmRingMapping
+{
+    RingHeader *header = nullptr;
+    char *data = nullptr;
+    uint64_t mask = 0;
+    size_t size = 0;
+#if defined(_WIN32)
+    HANDLE handle = nullptr;
+#endif
+
+    ~CShmRingMapping()
+    {
+#if defined(_WIN32)
+        if (header != nullptr) {
+            UnmapViewOfFile(header);
+        }
+        if (handle != nullptr) {
+            CloseHandle(handle);
+        }
+#else
+        if (header != nullptr) {
+            munmap(header, size);
+        }
+#endif
+    }
+};
+
+std::string ShmRingFormat::objectName(const std::string &name)
+{
+#if defined(_WIN32)
+    return !name.empty() && name[0] == '/' ? name.substr(1) : name;
+#else
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+#endif
+}
+
+CShmRingPublisher::~CShmRingPublisher()
+{
+    close();
+}
+
+bool CShmRingPublisher::open(const std::string &name, uint64_t capacity, std::string *error)
+{
+    close();
+    uint64_t roundedCapacity = kMinCapacity;
+    while (roundedCapacity < capacity) {
+        roundedCapacity <<= 1;
+    }
+    const uint32_t dataOffset = static_cast<uint32_t>(alignRecord(sizeof(RingHeader)));
+    const uint64_t totalSize = dataOffset + roundedCapacity;
+    const std::string objectName = ShmRingFormat::objectName(name);
+
+    auto mapping = new CShmRingMapping;
+    mapping->size = static_cast<size_t>(totalSize);
+    void *base = nullptr;
+#if defined(_WIN32)
+    mapping->handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                         static_cast<DWORD>(totalSize >> 32), static_cast<DWORD>(totalSize),
+                                         objectName.c_str());
+    if (mapping->handle != nullptr && GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Windows 上映射随最后一个句柄消失，同名仍存在说明另一个发布端还在运行
+        CloseHandle(mapping->handle);
+        mapping->handle = nullptr;
+        SetLastError(ERROR_ALREADY_EXISTS);
+    }
+    if (mapping->handle != nullptr) {
+        base = MapViewOfFile(mapping->handle, FILE_MAP_ALL_ACCESS, 0, 0, mapping->size);
+    }
+#else
+    // 同名对象只可能是崩溃的发布端遗留的，直接替换；已连接的读取端仍持有旧映射，不受影响
+    shm_unlink(objectName.c_str());
+    const int fd = shm_open(objectName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd >= 0) {
+        if (ftruncate(fd, static_cast<off_t>(totalSize)) == 0) {
+            base = mmap(nullptr, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (base == MAP_FAILED) {
+                base = nullptr;
+            }
+        }
+        const int savedErrno = errno;
+        ::close(fd);
+        errno = savedErrno;
+        if (base == nullptr) {
+            shm_unlink(objectName.c_str());
+        }
+    }
+#endif
+    if (base == nullptr) {
+        if (error) {
+            *error = "Cannot create shared memory " + objectName + ": " + lastErrorMessage();
+        }
+        delete mapping;
+        return false;
+    }
+
+    // 新建的共享内存已清零，槽位、位置都从 0 开始
+    mapping->header = static_cast<RingHeader *>(base);
+    mapping->data = static_cast<char *>(base) + dataOffset;
+    mapping->mask = roundedCapacity - 1;
+    RingHeader *header = mapping->header;
+    header->version = ShmRingFormat::kVersion;
+    header->capacity = roundedCapacity;
+    header->maxReaders = ShmRingFormat::kMaxReaders;
+    header->dataOffset = dataOffset;
+    header->magic.store(ShmRingFormat::kMagic, std::memory_order_release);
+
+    m_p_Mapping = mapping;
+    m_Name = objectName;
+    m_WritePosition = 0;
+    m_Records.store(0);
+    m_Bytes.store(0);
+    return true;
+}
+
+void CShmRingPublisher::close()
+{
+    if (m_p_Mapping == nullptr) {
+        return;
+    }
+    m_p_Mapping->header->isClosed.store(1, std::memory_order_release);
+#if !defined(_WIN32)
+    shm_unlink(m_Name.c_str());
+#endif
+    delete m_p_Mapping;
+    m_p_Mapping = nullptr;
+}
+
+bool CShmRingPublisher::isOpen() const
+{
+    return m_p_Mapping != nullptr;
+}
+
+const std::string &CShmRingPublisher::name() const
+{
+    return m_Name;
+}
+
+uint64_t CShmRingPublisher::capacity() const
+{
+    return m_p_Mapping != nullptr ? m_p_Mapping->header->capacity : 0;
+}
+
+void CShmRingPublisher::publish(const char *data, size_t size, uint64_t timestampNs)
+{
+    if (m_p_Mapping == nullptr) {
+        return;
+    }
+    RingHeader *header = m_p_Mapping->header;
+    const uint64_t capacity = header->capacity;
+    const size_t maxPayload = static_cast<size_t>(capacity / 4 - ShmRingFormat::kRecordHeaderSize);
+    while (size > 0) {
+        const size_t chunk = size < maxPayload ? size : maxPayload;
+        const uint64_t length = alignRecord(ShmRingFormat::kRecordHeaderSize + chunk);
+        uint64_t position = m_WritePosition;
+        const uint64_t offset = position & m_p_Mapping->mask;
+        const uint64_t padding = offset + length > capacity ? capacity - offset : 0;
+
+        // 先公布将被覆盖的范围再写数据，读取端据此判断刚拷贝的记录是否被改写
+        header->reservePosition.store(position + padding + length, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        if (padding > 0) {
+            writeRecord(position, static_cast<uint32_t>(padding - ShmRingFormat::kRecordHeaderSize), kPaddingRecord, 0,
+                        nullptr);
+            position += padding;
+        }
+        writeRecord(position, static_cast<uint32_t>(chunk), 0, timestampNs, data);
+        m_WritePosition = position + length;
+        header->writePosition.store(m_WritePosition, std::memory_order_release);
+
+        // 单一写入者，读改写不必是原子操作
+        m_Records.store(m_Records.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_Bytes.store(m_Bytes.load(std::memory_order_relaxed) + chunk, std::memory_order_relaxed);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void CShmRingPublisher::writeRecord(uint64_t position, uint32_t length, uint32_t flags, uint64_t timestampNs,
+                                    const char *data)
+{
+    char *record = m_p_Mapping->data + (position & m_p_Mapping->mask);
+    std::memcpy(record, &length, sizeof(length));
+    std::memcpy(record + 4, &flags, sizeof(flags));
+    std::memcpy(record + 8, &timestampNs, sizeof(timestampNs));
+    if (data != nullptr) {
+        std::memcpy(record + ShmRingFormat::kRecordHeaderSize, data, length);
+    }
+}
+
+CShmRingPublisher::Stats CShmRingPublisher::stats()
+{
+    Stats stats;
+    if (m_p_Mapping == nullptr) {
+        return stats;
+    }
+    stats.records = m_Records.load(std::memory_order_relaxed);
+    stats.bytes = m_Bytes.load(std::memory_order_relaxed);
+    const uint64_t writePosition = m_p_Mapping->header->writePosition.load(std::memory_order_acquire);
+    for (ReaderSlot &slot : m_p_Mapping->header->readers) {
+        if (slot.state.load(std::memory_order_acquire) != SlotActive) {
+            continue;
+        }
+#if !defined(_WIN32)
+        // 读取端进程被杀掉时来不及释放槽位
+        const int64_t pid = slot.pid.load(std::memory_order_relaxed);
+        if (pid > 0 && kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) {
+            slot.pid.store(0, std::memory_order_relaxed);
+            slot.state.store(SlotFree, std::memory_order_release);
+            continue;
+        }
+#endif
+        ++stats.readers;
+        const uint64_t cursor = slot.cursor.load(std::memory_order_relaxed);
+        const uint64_t lag = writePosition > cursor ? writePosition - cursor : 0;
+        stats.maxLagBytes = lag > stats.maxLagBytes ? lag : stats.maxLagBytes;
+        stats.readerOverruns += slot.overruns.load(std::memory_order_relaxed);
+        stats.readerLostBytes += slot.lostBytes.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+CShmRingReader::~CShmRingReader()
+{
+    close();
+}
+
+bool CShmRingReader::open(const std::string &name, std::string *error)
+{
+    close();
+    const std::string objectName = ShmRingFormat::objectName(name);
+    auto mapping = new CShmRingMapping;
+    void *base = nullptr;
+    std::string failure;
+#if defined(_WIN32)
+    mapping->handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, objectName.c_str());
+    if (mapping->handle != nullptr) {
+        base = MapViewOfFile(mapping->handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        if (base != nullptr && VirtualQuery(base, &info, sizeof(info)) != 0) {
+            mapping->size = info.RegionSize;
+        }
+    }
+#else
+    const int fd = shm_open(objectName.c_str(), O_RDWR, 0);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0) {
+            if (static_cast<size_t>(info.st_size) >= sizeof(RingHeader)) {
+                mapping->size = static_cast<size_t>(info.st_size);
+                base = mmap(nullptr, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (base == MAP_FAILED) {
+                    base = nullptr;
+                }
+            } else {
+                errno = EINVAL;
+            }
+        }
+        const int savedErrno = errno;
+        ::close(fd);
+        errno = savedErrno;
+    }
+#endif
+    if (base == nullptr) {
+        failure = "Cannot open shared memory " + objectName + ": " + lastErrorMessage();
+    } else {
+        mapping->header = static_cast<RingHeader *>(base);
+        RingHeader *header = mapping->header;
+        if (header->magic.load(std::memory_order_acquire) != ShmRingFormat::kMagic
+            || header->version != ShmRingFormat::kVersion
+            || header->dataOffset + header->capacity > mapping->size) {
+            failure = "Shared memory " + objectName + " is not a serial ring or is still being created";
+        } else {
+            mapping->data = static_cast<char *>(base) + header->dataOffset;
+            mapping->mask = header->capacity - 1;
+            // 抢一个空闲槽位
+            m_Slot = ShmRingFormat::kMaxReaders;
+            for (uint32_t i = 0; i < ShmRingFormat::kMaxReaders; ++i) {
+                uint32_t expected = SlotFree;
+                if (header->readers[i].state.compare_exchange_strong(expected, SlotActive, std::memory_order_acq_rel)) {
+                    m_Slot = i;
+                    break;
+                }
+            }
+            if (m_Slot == ShmRingFormat::kMaxReaders) {
+                failure = "Shared memory " + objectName + " has no free reader slot";
+            }
+        }
+    }
+    if (!failure.empty()) {
+        if (error) {
+            *error = failure;
+        }
+        delete mapping;
+        return false;
+    }
+
+    ReaderSlot &slot = mapping->header->readers[m_Slot];
+    m_Cursor = mapping->header->writePosition.load(std::memory_order_acquire);
+    slot.pid.store(currentProcessId(), std::memory_order_relaxed);
+    slot.cursor.store(m_Cursor, std::memory_order_relaxed);
+    slot.overruns.store(0, std::memory_order_relaxed);
+    slot.lostBytes.store(0, std::memory_order_relaxed);
+    m_p_Mapping = mapping;
+    m_Record.resize(static_cast<size_t>(mapping->header->capacity / 4));
+    m_Stats = Stats();
+    return true;
+}
+
+void CShmRingReader::close()
+{
+    if (m_p_Mapping == nullptr) {
+        return;
+    }
+    // 先清进程号：新读取端抢到槽位、还没写入自己的进程号时，发布端不会按旧进程号误回收
+    ReaderSlot &slot = m_p_Mapping->header->readers[m_Slot];
+    slot.pid.store(0, std::memory_order_relaxed);
+    slot.state.store(SlotFree, std::memory_order_release);
+    delete m_p_Mapping;
+    m_p_Mapping = nullptr;
+}
+
+bool CShmRingReader::isOpen() const
+{
+    return m_p_Mapping != nullptr;
+}
+
+size_t CShmRingReader::poll(const Handler &handler, size_t maxRecords)
+{
+    if (m_p_Mapping == nullptr) {
+        return 0;
+    }
+    RingHeader *header = m_p_Mapping->header;
+    const uint64_t capacity = header->capacity;
+    const uint64_t maxPayload = capacity / 4 - ShmRingFormat::kRecordHeaderSize;
+    uint64_t writePosition = header->writePosition.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (m_Cursor != writePosition && count < maxRecords) {
+        if (writePosition - m_Cursor > capacity) {
+            skipToLatest();
+            writePosition = m_Cursor;
+            break;
+        }
+        const uint64_t offset = m_Cursor & m_p_Mapping->mask;
+        const char *record = m_p_Mapping->data + offset;
+        uint32_t length = 0;
+        uint32_t flags = 0;
+        uint64_t timestampNs = 0;
+        std::memcpy(&length, record, sizeof(length));
+        std::memcpy(&flags, record + 4, sizeof(flags));
+        std::memcpy(&timestampNs, record + 8, sizeof(timestampNs));
+        const uint64_t recordSize = alignRecord(ShmRingFormat::kRecordHeaderSize + length);
+        const bool isPadding = (flags & kPaddingRecord) != 0;
+        // 被覆盖到一半的记录头可能是任意值，越界时不拷贝，交给下面的覆盖检查处理
+        const bool isValid = offset + recordSize <= capacity && (isPadding || length <= maxPayload);
+        if (isValid && !isPadding) {
+            std::memcpy(m_Record.data(), record + ShmRingFormat::kRecordHeaderSize, length);
+        }
+        // 拷贝完成后再看发布端是否已经开始改写这段内存
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t reservePosition = header->reservePosition.load(std::memory_order_relaxed);
+        if (reservePosition - m_Cursor > capacity || !isValid) {
+            skipToLatest();
+            writePosition = m_Cursor;
+            break;
+        }
+        m_Cursor += recordSize;
+        if (!isPadding) {
+            ++m_Stats.records;
+            m_Stats.bytes += length;
+            ++count;
+            handler(m_Record.data(), length, timestampNs);
+        }
+    }
+    // 游标槽只有本读取端写，普通存储即可，发布端统计时读到稍旧的值无妨
+    header->readers[m_Slot].cursor.store(m_Cursor, std::memory_order_relaxed);
+    return count;
+}
+
+void CShmRingReader::skipToLatest()
+{
+    // 被覆盖：放弃积压的数据，从最新完整写入的位置（总是记录边界）重新开始
+    RingHeader *header = m_p_Mapping->header;
+    const uint64_t latest = header->writePosition.load(std::memory_order_acquire);
+    ++m_Stats.overruns;
+    m_Stats.lostBytes += latest - m_Cursor;
+    m_Cursor = latest;
+    ReaderSlot &slot = header->readers[m_Slot];
+    slot.overruns.store(m_Stats.overruns, std::memory_order_relaxed);
+    slot.lostBytes.store(m_Stats.lostBytes, std::memory_order_relaxed);
+}
+
+bool CShmRingReader::isFinished() const
+{
+    return m_p_Mapping == nullptr
+           || (m_p_Mapping->header->isClosed.load(std::memory_order_acquire) != 0
+               && m_Cursor == m_p_Mapping->header->writePosition.load(std::memory_order_acquire));
+}
+
+uint64_t CShmRingReader::backlog() const
+{
+    return m_p_Mapping != nullptr ? m_p_Mapping->header->writePosition.load(std::memory_order_acquire) - m_Cursor : 0;
+}
+
+CShmRingReader::Stats CShmRingReader::stats() const
+{
+    return m_Stats;
+}
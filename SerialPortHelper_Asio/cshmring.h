@@ -0,0 +1,119 @@
+#ifndef CSHMRING_H
+#define CSHMRING_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 共享内存单写多读环形缓冲：发布端把串口收到的数据块连同接收时间戳写入环，多个进程各自以独立游标读取。
+// 布局：固定头（魔数、容量、写入位置、每个读取端一个游标槽）后跟 2 的幂字节的数据区。
+// 每条记录 16 字节头（u32 负载长度 + u32 标志 + u64 时间戳）+ 负载，按 16 字节对齐，时间戳与录制文件相同（Unix 纪元纳秒）；
+// 放不下时在数据区末尾写一条填充记录再回绕。位置为单调递增的 64 位字节计数，取模得到偏移。
+// 发布端从不等待读取端：写入前先公布“预留位置”，读取端拷贝完一条记录后检查预留位置，
+// 若该记录已被覆盖（落后超过一圈）就丢弃并跳到最新写入位置，计入丢失字节；慢读取端只影响自己。
+// 读取热路径只有原子读和内存拷贝，没有系统调用。
+// 不依赖 Qt，引擎与命令行客户端共用；POSIX 上为 shm_open 对象，Windows 上为命名文件映射
+namespace ShmRingFormat
+{
+constexpr uint32_t kMagic = 0x52485053;   // "SPHR"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kMaxReaders = 16;
+constexpr uint32_t kRecordHeaderSize = 16;
+constexpr uint32_t kRecordAlignment = 16;
+constexpr uint64_t kDefaultCapacity = 4 * 1024 * 1024;
+
+// 名称规范化：POSIX 上补齐前导 '/'，Windows 上去掉
+std::string objectName(const std::string &name);
+}
+
+struct CShmRingMapping;
+
+// 发布端：单线程调用 publish()（引擎中为串口的 I/O 线程）
+class CShmRingPublisher
+{
+public:
+    struct Stats
+    {
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+        uint32_t readers = 0;         // 当前连接的读取端
+        uint64_t maxLagBytes = 0;     // 最慢读取端落后的字节数
+        uint64_t readerOverruns = 0;  // 各读取端被覆盖而跳过的次数之和
+        uint64_t readerLostBytes = 0; // 各读取端因此丢失的字节数之和
+    };
+
+    CShmRingPublisher() = default;
+    ~CShmRingPublisher();
+    CShmRingPublisher(const CShmRingPublisher &) = delete;
+    CShmRingPublisher &operator=(const CShmRingPublisher &) = delete;
+
+    // 创建（同名残留对象先删除）并初始化；capacity 向上取 2 的幂，至少 64 KiB
+    bool open(const std::string &name, uint64_t capacity = ShmRingFormat::kDefaultCapacity,
+              std::string *error = nullptr);
+    // 标记关闭并删除名称，已连接的读取端仍可读完剩余数据
+    void close();
+    bool isOpen() const;
+    const std::string &name() const;
+    uint64_t capacity() const;
+
+    // 超过 capacity / 4 的数据块拆成多条记录
+    void publish(const char *data, size_t size, uint64_t timestampNs);
+
+    // 可在其他线程调用；顺带回收已退出进程遗留的读取槽（POSIX），不在热路径上调用
+    Stats stats();
+
+private:
+    void writeRecord(uint64_t position, uint32_t length, uint32_t flags, uint64_t timestampNs, const char *data);
+
+    CShmRingMapping *m_p_Mapping = nullptr;
+    std::string m_Name;
+    uint64_t m_WritePosition = 0;   // 只有发布端写，本地副本免去原子读
+    std::atomic<uint64_t> m_Records{0};
+    std::atomic<uint64_t> m_Bytes{0};
+};
+
+// 读取端：连接时从当前写入位置开始，只能在一个线程上使用
+class CShmRingReader
+{
+public:
+    using Handler = std::function<void(const char *data, size_t size, uint64_t timestampNs)>;
+
+    struct Stats
+    {
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+        uint64_t overruns = 0;
+        uint64_t lostBytes = 0;
+    };
+
+    CShmRingReader() = default;
+    ~CShmRingReader();
+    CShmRingReader(const CShmRingReader &) = delete;
+    CShmRingReader &operator=(const CShmRingReader &) = delete;
+
+    // 读取槽已满或发布端尚未初始化完成时失败
+    bool open(const std::string &name, std::string *error = nullptr);
+    void close();
+    bool isOpen() const;
+
+    // 读出至多 maxRecords 条记录交给 handler，返回条数；没有新数据时立即返回 0。
+    // handler 收到的指针指向读取端自己的缓冲，只在回调期间有效
+    size_t poll(const Handler &handler, size_t maxRecords = static_cast<size_t>(-1));
+    // 发布端已关闭且剩余数据已读完
+    bool isFinished() const;
+    uint64_t backlog() const;
+    Stats stats() const;
+
+private:
+    void skipToLatest();
+
+    CShmRingMapping *m_p_Mapping = nullptr;
+    uint32_t m_Slot = 0;
+    uint64_t m_Cursor = 0;
+    std::vector<char> m_Record;
+    Stats m_Stats;
+};
+
+#endif // CSHMRING_H
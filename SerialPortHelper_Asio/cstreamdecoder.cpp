@@ -0,0 +1,368 @@
+#include "cstreamdecoder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <iconv.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STREAMDECODER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define STREAMDECODER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+constexpr char16_t kReplacement = 0xFFFD;
+constexpr unsigned int kGb18030CodePage = 54936;  // GBK 的超集
+
+enum class SequenceStatus
+{
+    Complete,
+    Invalid,
+    Incomplete
+};
+
+// 校验 p 处的一个非 ASCII UTF-8 序列（Unicode 第 3 章表 3-7）：
+// Complete 时 length 为序列长度；Invalid 时 length 为需要替换掉的最长合法前缀（至少 1 字节）；
+// Incomplete 表示数据在一个目前为止合法的序列中间结束
+SequenceStatus checkUtf8Sequence(const unsigned char *p, size_t n, size_t &length, char32_t &codePoint)
+{
+    const unsigned char lead = p[0];
+    size_t continuation = 0;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        continuation = 1;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        continuation = 2;
+        codePoint = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;    // 排除超长编码
+        high = lead == 0xED ? 0x9F : 0xBF;   // 排除代理项
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        continuation = 3;
+        codePoint = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;   // 不超过 U+10FFFF
+    } else {
+        length = 1;
+        return SequenceStatus::Invalid;
+    }
+    for (size_t i = 1; i <= continuation; ++i) {
+        if (i >= n) {
+            length = i;
+            return SequenceStatus::Incomplete;
+        }
+        if (p[i] < low || p[i] > high) {
+            length = i;
+            return SequenceStatus::Invalid;
+        }
+        low = 0x80;
+        high = 0xBF;
+        codePoint = (codePoint << 6) | (p[i] & 0x3F);
+    }
+    length = continuation + 1;
+    return SequenceStatus::Complete;
+}
+
+void appendCodePoint(char16_t *&out, char32_t codePoint)
+{
+    if (codePoint >= 0x10000) {
+        codePoint -= 0x10000;
+        *out++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+        *out++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+    } else {
+        *out++ = static_cast<char16_t>(codePoint);
+    }
+}
+
+// 把字节按 Latin-1 展开为 UTF-16；asciiOnly 时遇到含高位字节的 16 字节块即停止。
+// 返回已处理的字节数（整块处理，尾部不足 16 字节的部分留给调用方）
+size_t widenBlocks(const unsigned char *p, size_t n, char16_t *out, bool asciiOnly)
+{
+    size_t i = 0;
+#if defined(STREAMDECODER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        if (asciiOnly && _mm_movemask_epi8(bytes) != 0) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+    }
+#elif defined(STREAMDECODER_NEON)
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t bytes = vld1q_u8(p + i);
+        if (asciiOnly && vmaxvq_u8(bytes) >= 0x80) {
+            break;
+        }
+        vst1q_u16(reinterpret_cast<uint16_t *>(out + i), vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(reinterpret_cast<uint16_t *>(out + i + 8), vmovl_u8(vget_high_u8(bytes)));
+    }
+#else
+    (void)p;
+    (void)n;
+    (void)out;
+    (void)asciiOnly;
+#endif
+    return i;
+}
+
+// GB18030 序列长度：单字节 / 双字节 / 第二字节为数字的四字节；数据不足时返回 0
+size_t gbkSequenceLength(const unsigned char *p, size_t n)
+{
+    if (p[0] < 0x80 || p[0] == 0x80 || p[0] == 0xFF) {
+        return 1;  // ASCII，或交给转换器替换的非法单字节
+    }
+    if (n < 2) {
+        return 0;
+    }
+    if (p[1] >= 0x30 && p[1] <= 0x39) {
+        return n >= 4 ? 4 : 0;
+    }
+    return 2;
+}
+}
+
+CStreamDecoder::CStreamDecoder(Encoding encoding)
+    : m_Encoding(encoding)
+{
+}
+
+CStreamDecoder::~CStreamDecoder()
+{
+#if !defined(_WIN32)
+    if (m_GbkConverter) {
+        iconv_close(static_cast<iconv_t>(m_GbkConverter));
+    }
+#endif
+}
+
+void CStreamDecoder::setEncoding(Encoding encoding)
+{
+    if (encoding != m_Encoding) {
+        m_Encoding = encoding;
+        reset();
+    }
+}
+
+CStreamDecoder::Encoding CStreamDecoder::encoding() const
+{
+    return m_Encoding;
+}
+
+void CStreamDecoder::reset()
+{
+    m_PendingSize = 0;
+    m_Output.clear();
+}
+
+const std::u16string &CStreamDecoder::decode(const char *data, size_t size)
+{
+    const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+    switch (m_Encoding) {
+    case Utf8:
+        decodeUtf8(bytes, size);
+        break;
+    case Latin1:
+        decodeLatin1(bytes, size);
+        break;
+    case Gbk:
+        decodeGbk(bytes, size);
+        break;
+    }
+    return m_Output;
+}
+
+const std::u16string &CStreamDecoder::flush()
+{
+    m_Output.clear();
+    if (m_PendingSize > 0) {
+        m_Output.push_back(kReplacement);
+        ++m_InvalidCount;
+        m_PendingSize = 0;
+    }
+    return m_Output;
+}
+
+size_t CStreamDecoder::invalidCount() const
+{
+    return m_InvalidCount;
+}
+
+size_t CStreamDecoder::pendingSize() const
+{
+    return m_PendingSize;
+}
+
+void CStreamDecoder::decodeUtf8(const unsigned char *data, size_t size)
+{
+    // 每个输入字节至多产生一个 UTF-16 单元（四字节序列产生两个）
+    m_Output.resize(size + m_PendingSize);
+    char16_t *out = &m_Output[0];
+    size_t i = 0;
+
+    if (m_PendingSize > 0) {
+        // 用上一块残留的前缀加上本块开头的字节补全一个序列
+        unsigned char sequence[4];
+        std::memcpy(sequence, m_Pending, m_PendingSize);
+        const size_t taken = std::min(size, sizeof(sequence) - m_PendingSize);
+        std::memcpy(sequence + m_PendingSize, data, taken);
+        size_t length = 0;
+        char32_t codePoint = 0;
+        switch (checkUtf8Sequence(sequence, m_PendingSize + taken, length, codePoint)) {
+        case SequenceStatus::Incomplete:
+            std::memcpy(m_Pending, sequence, m_PendingSize + taken);
+            m_PendingSize += taken;
+            m_Output.clear();
+            return;
+        case SequenceStatus::Complete:
+            appendCodePoint(out, codePoint);
+            break;
+        case SequenceStatus::Invalid:
+            *out++ = kReplacement;
+            ++m_InvalidCount;
+            break;
+        }
+        i = length - m_PendingSize;
+        m_PendingSize = 0;
+    }
+
+    while (i < size) {
+        const size_t ascii = widenBlocks(data + i, size - i, out, true);
+        i += ascii;
+        out += ascii;
+        if (i >= size) {
+            break;
+        }
+        if (data[i] < 0x80) {
+            *out++ = data[i++];
+            continue;
+        }
+        size_t length = 0;
+        char32_t codePoint = 0;
+        switch (checkUtf8Sequence(data + i, size - i, length, codePoint)) {
+        case SequenceStatus::Complete:
+            appendCodePoint(out, codePoint);
+            i += length;
+            break;
+        case SequenceStatus::Invalid:
+            *out++ = kReplacement;
+            ++m_InvalidCount;
+            i += length;
+            break;
+        case SequenceStatus::Incomplete:
+            m_PendingSize = size - i;
+            std::memcpy(m_Pending, data + i, m_PendingSize);
+            i = size;
+            break;
+        }
+    }
+    m_Output.resize(static_cast<size_t>(out - m_Output.data()));
+}
+
+void CStreamDecoder::decodeLatin1(const unsigned char *data, size_t size)
+{
+    m_Output.resize(size);
+    char16_t *out = &m_Output[0];
+    for (size_t i = widenBlocks(data, size, out, false); i < size; ++i) {
+        out[i] = data[i];
+    }
+}
+
+void CStreamDecoder::decodeGbk(const unsigned char *data, size_t size)
+{
+    m_Output.clear();
+    size_t i = 0;
+    if (m_PendingSize > 0) {
+        unsigned char sequence[4];
+        std::memcpy(sequence, m_Pending, m_PendingSize);
+        const size_t taken = std::min(size, sizeof(sequence) - m_PendingSize);
+        std::memcpy(sequence + m_PendingSize, data, taken);
+        const size_t length = gbkSequenceLength(sequence, m_PendingSize + taken);
+        if (length == 0) {
+            std::memcpy(m_Pending, sequence, m_PendingSize + taken);
+            m_PendingSize += taken;
+            return;
+        }
+        convertGbk(sequence, length);
+        i = length - m_PendingSize;
+        m_PendingSize = 0;
+    }
+
+    // 只把完整序列交给转换器，末尾被切断的序列留到下一块
+    size_t complete = i;
+    while (complete < size) {
+        const size_t length = gbkSequenceLength(data + complete, size - complete);
+        if (length == 0) {
+            break;
+        }
+        complete += length;
+    }
+    convertGbk(data + i, complete - i);
+    m_PendingSize = size - complete;
+    std::memcpy(m_Pending, data + complete, m_PendingSize);
+}
+
+void CStreamDecoder::convertGbk(const unsigned char *data, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    const size_t oldSize = m_Output.size();
+#if defined(_WIN32)
+    const auto *source = reinterpret_cast<const char *>(data);
+    const int units = MultiByteToWideChar(kGb18030CodePage, 0, source, static_cast<int>(size), nullptr, 0);
+    m_Output.resize(oldSize + static_cast<size_t>(units));
+    MultiByteToWideChar(kGb18030CodePage, 0, source, static_cast<int>(size),
+                        reinterpret_cast<wchar_t *>(&m_Output[oldSize]), units);
+#else
+    (void)kGb18030CodePage;
+    if (!m_GbkConverter) {
+        const uint16_t probe = 1;
+        const bool littleEndian = *reinterpret_cast<const unsigned char *>(&probe) == 1;
+        iconv_t converter = iconv_open(littleEndian ? "UTF-16LE" : "UTF-16BE", "GB18030");
+        if (converter == reinterpret_cast<iconv_t>(-1)) {
+            converter = iconv_open(littleEndian ? "UTF-16LE" : "UTF-16BE", "GBK");
+        }
+        m_GbkConverter = converter == reinterpret_cast<iconv_t>(-1) ? nullptr : converter;
+    }
+
+    // GB18030 的每个序列至多产生与其字节数相同的 UTF-16 单元
+    m_Output.resize(oldSize + size);
+    char *in = reinterpret_cast<char *>(const_cast<unsigned char *>(data));
+    size_t inLeft = size;
+    char *out = reinterpret_cast<char *>(&m_Output[oldSize]);
+    size_t outLeft = size * sizeof(char16_t);
+    while (inLeft > 0) {
+        if (m_GbkConverter
+            && iconv(static_cast<iconv_t>(m_GbkConverter), &in, &inLeft, &out, &outLeft) != static_cast<size_t>(-1)) {
+            break;
+        }
+        // 非法字节（或没有可用的转换器时的非 ASCII 字节）替换为 U+FFFD 后继续
+        const char16_t unit = static_cast<unsigned char>(*in) < 0x80 ? static_cast<char16_t>(*in) : kReplacement;
+        if (unit == kReplacement) {
+            ++m_InvalidCount;
+        }
+        std::memcpy(out, &unit, sizeof(unit));
+        out += sizeof(unit);
+        outLeft -= sizeof(unit);
+        ++in;
+        --inLeft;
+    }
+    m_Output.resize(static_cast<size_t>(reinterpret_cast<char16_t *>(out) - m_Output.data()));
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef CSTREAMDECODER_H
+#define CSTREAMDECODER_H
+#include <cstddef>
+#include <string>
+
+// 有状态的增量解码器：被 async_read_some 切断的多字节字符保留到下一块数据再解码，
+// 输出写入内部复用的 UTF-16 缓冲，不再每块数据分配一个 QString。
+// UTF-8 以 16 字节为单位用 SIMD 判断并展开纯 ASCII 块，非 ASCII 部分按 Unicode 规范逐序列校验；
+// GBK 按 GB18030（GBK 的超集）切分完整序列后交给系统转换（Windows 代码页 / iconv）。
+class CStreamDecoder
+{
+public:
+    enum Encoding
+    {
+        Utf8,
+        Latin1,
+        Gbk
+    };
+
+    explicit CStreamDecoder(Encoding encoding = Utf8);
+    ~CStreamDecoder();
+    CStreamDecoder(const CStreamDecoder &) = delete;
+    CStreamDecoder &operator=(const CStreamDecoder &) = delete;
+
+    void setEncoding(Encoding encoding);
+    Encoding encoding() const;
+
+    // 丢弃残留的不完整序列
+    void reset();
+
+    // 解码一块数据，返回的引用在下一次 decode()/flush() 前有效
+    const std::u16string &decode(const char *data, size_t size);
+    // 输入结束：残留的不完整序列输出为 U+FFFD
+    const std::u16string &flush();
+
+    // 累计遇到的非法序列个数
+    size_t invalidCount() const;
+    // 末尾残留、等待后续字节补全的不完整序列长度
+    size_t pendingSize() const;
+
+private:
+    void decodeUtf8(const unsigned char *data, size_t size);
+    void decodeLatin1(const unsigned char *data, size_t size);
+    void decodeGbk(const unsigned char *data, size_t size);
+    void convertGbk(const unsigned char *data, size_t size);
+
+    Encoding m_Encoding;
+    std::u16string m_Output;
+    unsigned char m_Pending[4] = {};
+    size_t m_PendingSize = 0;
+    size_t m_InvalidCount = 0;
+    void *m_GbkConverter = nullptr;   // 非 Windows 平台上的 iconv_t
+};
+
+#endif // CSTREAMDECODER_H
@@ -0,0 +1,147 @@
+// SerialDecodeBench：测接收区解码器（CStreamDecoder）在各类数据上的吞吐，不需要硬件。
+// UTF-8 只有纯 ASCII 的 16 字节块走 SIMD，中文等非 ASCII 序列逐个按标量校验，GBK 交给系统转换；
+// 这里按串口读取常见的块大小（以及接收区每行 4096 字节）分块解码，与 12 Mbaud 的线路速率对比，
+// 确认标量路径在最坏的数据上也远高于线路速率，绘制每帧只解码几十行更不成问题。
+//   SerialDecodeBench [--megabytes <n>] [--chunk <bytes>]
+#include "cstreamdecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr double kFastestLineBytesPerSecond = 12e6 / 10;  // 12 Mbaud、8N1 每字节 10 位
+constexpr size_t kDefaultChunkSizes[] = {64, 4096, 65536};
+
+struct Options
+{
+    size_t megabytes = 64;
+    std::vector<size_t> chunkSizes;
+};
+
+struct Workload
+{
+    const char *name;
+    CStreamDecoder::Encoding encoding;
+    std::string data;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialDecodeBench [--megabytes <n>] [--chunk <bytes>]...\n"
+                 "  without --chunk, decodes in 64, 4096 and 65536 byte chunks\n";
+}
+
+// 常用汉字的 Unicode 范围内随机取字，夹杂 ASCII 标点与数字，接近中文标签设备的输出
+void appendUtf8Chinese(std::string &out, std::mt19937 &random, size_t size)
+{
+    std::uniform_int_distribution<int> hanzi(0x4E00, 0x9FA5);
+    std::uniform_int_distribution<int> choice(0, 9);
+    while (out.size() < size) {
+        if (choice(random) < 8) {
+            const int codePoint = hanzi(random);
+            out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            out += choice(random) < 5 ? ": 12.5, " : "\r\n";
+        }
+    }
+}
+
+// GB2312 区（GBK 的子集）中的双字节汉字，夹杂 ASCII
+void appendGbkChinese(std::string &out, std::mt19937 &random, size_t size)
+{
+    std::uniform_int_distribution<int> lead(0xB0, 0xF7);
+    std::uniform_int_distribution<int> trail(0xA1, 0xFE);
+    std::uniform_int_distribution<int> choice(0, 9);
+    while (out.size() < size) {
+        if (choice(random) < 8) {
+            out.push_back(static_cast<char>(lead(random)));
+            out.push_back(static_cast<char>(trail(random)));
+        } else {
+            out += choice(random) < 5 ? ": 12.5, " : "\r\n";
+        }
+    }
+}
+
+std::vector<Workload> makeWorkloads(size_t size)
+{
+    std::mt19937 random(1);
+    std::vector<Workload> workloads;
+
+    Workload ascii{"utf8-ascii", CStreamDecoder::Utf8, {}};
+    while (ascii.data.size() < size) {
+        ascii.data += "[12:00:00.123] sensor 3: temperature=25.4 humidity=61 status=OK\r\n";
+    }
+    workloads.push_back(std::move(ascii));
+
+    Workload chinese{"utf8-chinese", CStreamDecoder::Utf8, {}};
+    appendUtf8Chinese(chinese.data, random, size);
+    workloads.push_back(std::move(chinese));
+
+    // 随机字节几乎全是非法序列，每个字节都走标量校验与替换
+    Workload binary{"utf8-binary", CStreamDecoder::Utf8, std::string(size, '\0')};
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (char &c : binary.data) {
+        c = static_cast<char>(byte(random));
+    }
+    workloads.push_back({"latin1-binary", CStreamDecoder::Latin1, binary.data});
+    workloads.push_back(std::move(binary));
+
+    Workload gbk{"gbk-chinese", CStreamDecoder::Gbk, {}};
+    appendGbkChinese(gbk.data, random, size);
+    workloads.push_back(std::move(gbk));
+    return workloads;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--megabytes" && i + 1 < argc) {
+            options.megabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--chunk" && i + 1 < argc) {
+            options.chunkSizes.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[++i]))));
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.chunkSizes.empty()) {
+        options.chunkSizes.assign(std::begin(kDefaultChunkSizes), std::end(kDefaultChunkSizes));
+    }
+
+    const auto workloads = makeWorkloads(options.megabytes << 20);
+    std::printf("%-14s %8s %10s %12s %10s\n", "data", "chunk", "MB/s", "x 12 Mbaud", "invalid");
+    for (const Workload &workload : workloads) {
+        for (size_t chunkSize : options.chunkSizes) {
+            CStreamDecoder decoder(workload.encoding);
+            size_t units = 0;
+            const auto start = Clock::now();
+            for (size_t offset = 0; offset < workload.data.size(); offset += chunkSize) {
+                const size_t size = std::min(chunkSize, workload.data.size() - offset);
+                units += decoder.decode(workload.data.data() + offset, size).size();
+            }
+            units += decoder.flush().size();
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            const double bytesPerSecond = workload.data.size() / seconds;
+            std::printf("%-14s %8zu %10.1f %12.0f %10zu\n", workload.name, chunkSize, bytesPerSecond / 1e6,
+                        bytesPerSecond / kFastestLineBytesPerSecond, decoder.invalidCount());
+            if (units == 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
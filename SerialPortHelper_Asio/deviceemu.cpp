@@ -0,0 +1,289 @@
+// SerialDeviceEmulator：按规则表（格式见 cdevicerules.h）模拟一台串口设备。
+// 默认新建 pty 对并打印被测程序要打开的一端，--port 时打开现有串口（虚拟串口对或零调制解调器线的一端）；
+// 每隔 --interval 打印一行收发统计，Ctrl+C 退出时打印每条规则的命中次数。
+// --bench 在本进程内用 CSerialPortManager 打开 pty 的另一端，连续发送给定的请求帧并等待应答，
+// 同时保持 --window 个请求在途，测每秒往返次数与往返时延：既验证规则表，也是串口引擎收发路径的负载测试。
+//   SerialDeviceEmulator --rules modbus.rules
+//   SerialDeviceEmulator --rules modbus.rules --bench "01 03 00 00 00 02 {crc:modbus}" --count 20000 --window 4
+#include "cdeviceemulator.h"
+#include "cdevicerules.h"
+#include "cserialportmanager.h"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kBenchTimeout = std::chrono::seconds(5);
+
+std::atomic<bool> g_IsStopRequested{false};
+
+void requestStop(int)
+{
+    g_IsStopRequested.store(true);
+}
+
+struct Options
+{
+    std::string rulesPath;
+    CDeviceEmulator::Options emulator;
+    int intervalMs = 1000;
+    std::string benchRequest;
+    int count = 10000;
+    int window = 1;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialDeviceEmulator --rules <file> [--port <device>] [--baud <rate>] [--gap <us>] [--interval <ms>]\n"
+                 "       SerialDeviceEmulator --rules <file> --bench <request template> [--count <n>] [--window <n>]\n"
+                 "  without --port a pty pair is created and the path to open is printed\n";
+}
+
+void printRuleStats(const CDeviceRules &rules, const CDeviceEmulator::Stats &stats)
+{
+    for (size_t i = 0; i < rules.ruleCount() && i < stats.ruleMatches.size(); ++i) {
+        std::printf("%10llu  line %d: %s\n", static_cast<unsigned long long>(stats.ruleMatches[i]),
+                    rules.ruleLine(static_cast<int>(i)), rules.ruleText(static_cast<int>(i)).c_str());
+    }
+    std::printf("%10llu  unmatched bytes\n", static_cast<unsigned long long>(stats.unmatchedBytes));
+}
+
+// 闭环往返：在 I/O 线程上收到一条完整应答就再发一条请求
+struct Bench
+{
+    std::shared_ptr<std::vector<char>> request;
+    size_t replySize = 0;
+    int count = 0;
+    int window = 0;
+    CSerialPortManager *manager = nullptr;
+    int sent = 0;
+    int completed = 0;
+    uint64_t receivedBytes = 0;
+    std::deque<Clock::time_point> sendTimes;
+    std::vector<double> roundTripsUs;
+    std::promise<void> done;
+
+    void send()
+    {
+        sendTimes.push_back(Clock::now());
+        ++sent;
+        manager->writeShared(request, request->size(), []() {});
+    }
+
+    void handleRead(size_t size, Clock::time_point arrival)
+    {
+        if (completed == count) {
+            return;
+        }
+        receivedBytes += size;
+        while (completed < count && receivedBytes >= static_cast<uint64_t>(completed + 1) * replySize) {
+            roundTripsUs.push_back(std::chrono::duration<double, std::micro>(arrival - sendTimes.front()).count());
+            sendTimes.pop_front();
+            ++completed;
+            if (sent < count) {
+                send();
+            }
+            if (completed == count) {
+                done.set_value();
+            }
+        }
+    }
+};
+
+int runBench(const Options &options, const CDeviceRules &rules, CDeviceEmulator &emulator,
+             CDeviceRules &expected)
+{
+    std::vector<uint8_t> request;
+    std::string error;
+    if (!CDeviceRules::renderTemplate(options.benchRequest, &request, &error)) {
+        std::cerr << "invalid --bench request: " << error << "\n";
+        return 2;
+    }
+    // 按同一规则表算出应答长度，收满即算一次往返
+    CDeviceRules::Match match;
+    if (expected.match(request.data(), request.size(), &match) != CDeviceRules::Matched
+        || match.length != request.size()) {
+        std::cerr << "the --bench request is not exactly one frame of any rule\n";
+        return 2;
+    }
+    std::vector<uint8_t> reply;
+    expected.render(match, request.data(), &reply);
+    if (reply.empty()) {
+        std::cerr << "the rule matching the --bench request does not reply\n";
+        return 2;
+    }
+
+    boost::asio::io_context ioContext;
+    auto workGuard = boost::asio::make_work_guard(ioContext);
+    std::thread ioThread([&ioContext]() { ioContext.run(); });
+    int status = 0;
+    {
+        CSerialPortManager manager(ioContext);
+        if (!manager.openPort(QString::fromStdString(emulator.devicePath()), 115200, 8, 0, 1)) {
+            std::cerr << "failed to open " << emulator.devicePath() << "\n";
+            status = 1;
+        } else {
+            Bench bench;
+            bench.request = std::make_shared<std::vector<char>>(request.begin(), request.end());
+            bench.replySize = reply.size();
+            bench.count = options.count;
+            bench.window = std::min(options.window, options.count);
+            bench.manager = &manager;
+            auto finished = bench.done.get_future();
+            int tapId = 0;
+            const auto start = Clock::now();
+            boost::asio::post(ioContext, [&]() {
+                tapId = manager.addReadTap([&bench](const std::shared_ptr<std::vector<char>> &, size_t size,
+                                                    Clock::time_point arrival) { bench.handleRead(size, arrival); });
+                for (int i = 0; i < bench.window; ++i) {
+                    bench.send();
+                }
+            });
+            // 每次往返都远小于超时，超时说明应答丢失或规则不符
+            int lastCompleted = -1;
+            std::future_status waitStatus = std::future_status::timeout;
+            while (waitStatus == std::future_status::timeout) {
+                waitStatus = finished.wait_for(kBenchTimeout);
+                std::promise<int> progress;
+                boost::asio::post(ioContext, [&]() { progress.set_value(bench.completed); });
+                const int completed = progress.get_future().get();
+                if (waitStatus == std::future_status::timeout && completed == lastCompleted) {
+                    std::cerr << "no reply for " << kBenchTimeout.count() << " s after " << completed << " exchanges\n";
+                    status = 1;
+                    break;
+                }
+                lastCompleted = completed;
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            std::promise<void> removed;
+            boost::asio::post(ioContext, [&]() {
+                manager.removeReadTap(tapId);
+                removed.set_value();
+            });
+            removed.get_future().wait();
+            if (status == 0) {
+                std::vector<double> samples = bench.roundTripsUs;
+                std::sort(samples.begin(), samples.end());
+                std::printf("%d exchanges of %zu + %zu bytes, window %d: %.0f exchanges/s\n", bench.completed,
+                            request.size(), reply.size(), bench.window, bench.completed / seconds);
+                std::printf("round trip (us): median %.1f  p99 %.1f  max %.1f\n", samples[samples.size() / 2],
+                            samples[std::min(samples.size() - 1, samples.size() * 99 / 100)], samples.back());
+            }
+        }
+        manager.closePort();
+    }
+    workGuard.reset();
+    ioThread.join();
+
+    const auto stats = emulator.stats();
+    std::printf("emulator: %llu frames, %llu replies, %llu bytes in, %llu bytes out\n",
+                static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.replies),
+                static_cast<unsigned long long>(stats.bytesIn), static_cast<unsigned long long>(stats.bytesOut));
+    printRuleStats(rules, stats);
+    return status;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--rules" && i + 1 < argc) {
+            options.rulesPath = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.emulator.device = argv[++i];
+        } else if (arg == "--baud" && i + 1 < argc) {
+            options.emulator.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--gap" && i + 1 < argc) {
+            options.emulator.frameGap = std::chrono::microseconds(std::strtoll(argv[++i], nullptr, 10));
+        } else if (arg == "--interval" && i + 1 < argc) {
+            options.intervalMs = std::atoi(argv[++i]);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            options.benchRequest = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc) {
+            options.count = std::atoi(argv[++i]);
+        } else if (arg == "--window" && i + 1 < argc) {
+            options.window = std::atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    const bool isBench = !options.benchRequest.empty();
+    if (options.rulesPath.empty() || options.intervalMs <= 0 || options.emulator.frameGap.count() <= 0
+        || options.count <= 0 || options.window <= 0 || (isBench && !options.emulator.device.empty())) {
+        printUsage();
+        return 2;
+    }
+
+    // 统计输出用一份，模拟器与 --bench 各用一份（render() 会推进计数与随机数）
+    CDeviceRules rules;
+    CDeviceRules emulatorRules;
+    CDeviceRules benchRules;
+    std::string error;
+    if (!rules.load(options.rulesPath, &error) || !emulatorRules.load(options.rulesPath, &error)
+        || !benchRules.load(options.rulesPath, &error)) {
+        std::cerr << options.rulesPath << ": " << error << "\n";
+        return 2;
+    }
+
+    boost::asio::io_context ioContext;
+    auto workGuard = boost::asio::make_work_guard(ioContext);
+    std::thread ioThread([&ioContext]() { ioContext.run(); });
+    int status = 0;
+    {
+        CDeviceEmulator emulator(ioContext);
+        if (!emulator.start(std::move(emulatorRules), options.emulator, &error)) {
+            std::cerr << error << "\n";
+            status = 1;
+        } else if (isBench) {
+            status = runBench(options, rules, emulator, benchRules);
+        } else {
+            std::printf("device: %s\n", emulator.devicePath().c_str());
+            std::fflush(stdout);
+            std::signal(SIGINT, requestStop);
+            std::signal(SIGTERM, requestStop);
+            CDeviceEmulator::Stats last;
+            auto nextReport = Clock::now() + std::chrono::milliseconds(options.intervalMs);
+            while (!g_IsStopRequested.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                if (Clock::now() < nextReport) {
+                    continue;
+                }
+                nextReport += std::chrono::milliseconds(options.intervalMs);
+                const auto stats = emulator.stats();
+                const double seconds = options.intervalMs / 1000.0;
+                std::printf("%8.0f frames/s %8.0f replies/s  in %10llu B  out %10llu B  unmatched %llu  queued %llu\n",
+                            (stats.frames - last.frames) / seconds, (stats.replies - last.replies) / seconds,
+                            static_cast<unsigned long long>(stats.bytesIn), static_cast<unsigned long long>(stats.bytesOut),
+                            static_cast<unsigned long long>(stats.unmatchedBytes),
+                            static_cast<unsigned long long>(stats.queuedReplies));
+                std::fflush(stdout);
+                last = stats;
+            }
+            emulator.stop();
+            printRuleStats(rules, emulator.stats());
+        }
+        emulator.stop();
+    }
+    workGuard.reset();
+    ioThread.join();
+    return status;
+}
@@ -0,0 +1,277 @@
+// SerialLatencyBench：请求/应答往返时延测试，逐个时延模式打开串口、发送请求帧并等待完整回送。
+// 对端需要把收到的数据原样回送：回环插头（TX 短接 RX）、回显固件，
+// 或者用 --echo 指定第二个串口，由本工具在该口上回显（两口之间接零调制解调器线）。
+#include "cserialtuning.h"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int kWarmupRounds = 10;
+
+struct Options
+{
+    std::string port;
+    std::string echoPort;
+    unsigned baudRate = 115200;
+    size_t frameSize = 16;
+    int count = 1000;
+    int timeoutMs = 1000;
+    std::vector<SerialTuning::LatencyMode> modes;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialLatencyBench <port> [--echo <port>] [--baud <rate>] [--size <bytes>]\n"
+                 "                          [--count <n>] [--timeout <ms>] [--mode default|low|throughput|all]\n"
+                 "  <port>     port that sends requests and waits for the echoed response\n"
+                 "  --echo     echo on this port from inside the tool (null-modem pair)\n"
+                 "             instead of relying on a loopback plug or echo firmware\n"
+                 "  --mode     latency mode to measure, may be repeated (default: all)\n";
+}
+
+bool openPort(boost::asio::serial_port &port, const std::string &name, unsigned baudRate,
+              SerialTuning::LatencyMode mode, std::string &error)
+{
+    boost::system::error_code ec;
+    port.open(name, ec);
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::baud_rate(baudRate), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::character_size(8), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::parity(boost::asio::serial_port::parity::none), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::stop_bits(boost::asio::serial_port::stop_bits::one), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::flow_control(boost::asio::serial_port::flow_control::none), ec);
+    }
+    if (ec) {
+        error = name + ": " + ec.message();
+        return false;
+    }
+    if (!SerialTuning::applyLatencyMode(port.native_handle(), mode, &error)
+        || !SerialTuning::flushInput(port.native_handle(), &error)) {
+        error = name + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+// 在独立的 io_context 上原样回送收到的数据
+class EchoServer
+{
+public:
+    EchoServer(boost::asio::io_context &ioContext, boost::asio::serial_port &port)
+        : m_IoContext(ioContext)
+        , m_Port(port)
+        , m_Buffer(4096)
+    {
+    }
+
+    void start()
+    {
+        read();
+        m_Thread = std::thread([this]() { m_IoContext.run(); });
+    }
+
+    void stop()
+    {
+        m_IoContext.stop();
+        if (m_Thread.joinable()) {
+            m_Thread.join();
+        }
+    }
+
+private:
+    void read()
+    {
+        m_Port.async_read_some(boost::asio::buffer(m_Buffer), [this](const boost::system::error_code &error, size_t size) {
+            if (error) {
+                return;
+            }
+            boost::asio::async_write(m_Port, boost::asio::buffer(m_Buffer.data(), size),
+                                     [this](const boost::system::error_code &error, size_t) {
+                                         if (!error) {
+                                             read();
+                                         }
+                                     });
+        });
+    }
+
+    boost::asio::io_context &m_IoContext;
+    boost::asio::serial_port &m_Port;
+    std::vector<char> m_Buffer;
+    std::thread m_Thread;
+};
+
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool runMode(const Options &options, SerialTuning::LatencyMode mode)
+{
+    boost::asio::io_context ioContext;
+    boost::asio::serial_port port(ioContext);
+    std::string error;
+    if (!openPort(port, options.port, options.baudRate, mode, error)) {
+        std::cerr << error << "\n";
+        return false;
+    }
+
+    boost::asio::io_context echoContext;
+    boost::asio::serial_port echoPort(echoContext);
+    EchoServer echo(echoContext, echoPort);
+    if (!options.echoPort.empty()) {
+        if (!openPort(echoPort, options.echoPort, options.baudRate, mode, error)) {
+            std::cerr << error << "\n";
+            return false;
+        }
+        echo.start();
+    }
+
+    std::vector<char> request(options.frameSize);
+    std::vector<char> response(options.frameSize);
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(options.count));
+    int timeouts = 0;
+    int mismatches = 0;
+
+    for (int round = -kWarmupRounds; round < options.count; ++round) {
+        for (size_t i = 0; i < request.size(); ++i) {
+            request[i] = static_cast<char>(i + static_cast<size_t>(round));
+        }
+        bool done = false;
+        boost::system::error_code readError;
+        const auto start = std::chrono::steady_clock::now();
+        boost::system::error_code writeError;
+        boost::asio::write(port, boost::asio::buffer(request), writeError);
+        if (writeError) {
+            std::cerr << options.port << ": " << writeError.message() << "\n";
+            echo.stop();
+            return false;
+        }
+        boost::asio::async_read(port, boost::asio::buffer(response),
+                                [&](const boost::system::error_code &error, size_t) {
+                                    readError = error;
+                                    done = true;
+                                });
+        ioContext.restart();
+        ioContext.run_for(std::chrono::milliseconds(options.timeoutMs));
+        const auto end = std::chrono::steady_clock::now();
+        if (!done) {
+            // 超时：取消未完成的读取并丢弃迟到的回送，避免错位到下一轮
+            port.cancel();
+            ioContext.restart();
+            ioContext.run();
+            SerialTuning::flushInput(port.native_handle());
+            ++timeouts;
+            continue;
+        }
+        if (readError) {
+            std::cerr << options.port << ": " << readError.message() << "\n";
+            echo.stop();
+            return false;
+        }
+        if (round < 0) {
+            continue;
+        }
+        if (response != request) {
+            ++mismatches;
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    echo.stop();
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    bool lowLatencyFlag = false;
+    const char *driverFlag = SerialTuning::queryLowLatencyFlag(port.native_handle(), lowLatencyFlag)
+                                 ? (lowLatencyFlag ? "on" : "off")
+                                 : "n/a";
+    std::printf("%-11s %-8s %7zu %8d %8d %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+                SerialTuning::latencyModeName(mode), driverFlag, samples.size(), timeouts, mismatches,
+                samples.empty() ? 0.0 : samples.front(), percentile(samples, 0.5), percentile(samples, 0.9),
+                percentile(samples, 0.99), samples.empty() ? 0.0 : samples.back(),
+                samples.empty() ? 0.0 : sum / static_cast<double>(samples.size()));
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--echo" && i + 1 < argc) {
+            options.echoPort = argv[++i];
+        } else if (arg == "--baud" && i + 1 < argc) {
+            options.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--size" && i + 1 < argc) {
+            options.frameSize = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--count" && i + 1 < argc) {
+            options.count = std::atoi(argv[++i]);
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            options.timeoutMs = std::atoi(argv[++i]);
+        } else if (arg == "--mode" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            SerialTuning::LatencyMode mode;
+            if (name == "all") {
+                options.modes = {SerialTuning::DefaultLatency, SerialTuning::LowLatency, SerialTuning::HighThroughput};
+            } else if (SerialTuning::parseLatencyMode(name, mode)) {
+                options.modes.push_back(mode);
+            } else {
+                printUsage();
+                return 2;
+            }
+        } else if (options.port.empty() && arg[0] != '-') {
+            options.port = arg;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.port.empty() || options.frameSize == 0 || options.count <= 0 || options.baudRate == 0
+        || options.timeoutMs <= 0) {
+        printUsage();
+        return 2;
+    }
+    if (options.modes.empty()) {
+        options.modes = {SerialTuning::DefaultLatency, SerialTuning::LowLatency, SerialTuning::HighThroughput};
+    }
+
+    // 线路上往返的理论时间（10 位/字节），作为对照
+    const double wireUs = 2.0 * static_cast<double>(options.frameSize) * 10.0 * 1e6 / options.baudRate;
+    std::printf("%zu-byte frames at %u baud, wire time %.1f us round trip\n",
+                options.frameSize, options.baudRate, wireUs);
+    std::printf("%-11s %-8s %7s %8s %8s %9s %9s %9s %9s %9s %9s\n", "mode", "low-lat", "samples", "timeouts",
+                "mismatch", "min(us)", "p50", "p90", "p99", "max", "mean");
+    int status = 0;
+    for (SerialTuning::LatencyMode mode : options.modes) {
+        if (!runMode(options, mode)) {
+            status = 1;
+        }
+    }
+    return status;
+}
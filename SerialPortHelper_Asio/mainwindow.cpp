@@ -1,99 +1,174 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "cmultiportwindow.h"
+#include "cportpanel.h"
 #include <QSerialPort>
-#include <QSerialPortInfo>
 #include <QMessageBox>
 #include <QDebug>
 #include <QPushButton>
 #include <QComboBox>
+#include <QFileDialog>
+#include <QStringList>
+#include <algorithm>
 #include <thread>
+
+namespace
+{
+// 分隔符输入框中的 \r \n \t \\ \xHH 转义转成实际字节，其余字符按 UTF-8 原样
+QByteArray parseEscapes(const QString &text)
+{
+    const QByteArray raw=text.toUtf8();
+    QByteArray out;
+    for(int i=0;i<raw.size();++i)
+    {
+        if(raw[i]!='\\'||i+1>=raw.size())
+        {
+            out.append(raw[i]);
+            continue;
+        }
+        const char c=raw[++i];
+        if(c=='r')
+        {
+            out.append('\r');
+        }else if(c=='n'){
+            out.append('\n');
+        }else if(c=='t'){
+            out.append('\t');
+        }else if(c=='x'&&i+2<raw.size()){
+            bool ok=false;
+            const int value=raw.mid(i+1,2).toInt(&ok,16);
+            if(ok)
+            {
+                out.append(static_cast<char>(value));
+                i+=2;
+            }else{
+                out.append('\\').append(c);
+            }
+        }else{
+            out.append(c);
+        }
+    }
+    return out;
+}
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    ,m_p_SendSerialPortManager(std::make_unique<CSerialPortManager>())
-    ,m_p_RecSerialPortManager(std::make_unique<CSerialPortManager>())
+    ,m_p_Registry(std::make_unique<CSerialPortRegistry>())
+    ,m_p_SendSerialPortManager(m_p_Registry->port(m_p_Registry->addPort("发送")))
+    ,m_p_RecSerialPortManager(m_p_Registry->port(m_p_Registry->addPort("接收")))
+    ,m_p_PortWatcher(std::make_unique<CPortWatcher>())
+    ,m_p_PrbsTester(std::make_unique<CPrbsTester>(m_p_SendSerialPortManager->ioContext()))
 {
     ui->setupUi(this);
     init();
+    // 桥接监听时两个方向交错显示，行首标出数据是从哪个串口读到的（stream 0 为接收串口，1 为发送串口）
+    ui->receiveView_RecMessage->setStreamLabels({"接收口","发送口"});
 
 
-    connect(m_p_RecSerialPortManager.get(),&CSerialPortManager::signal_DataReceived,this,&MainWindow::handleDataReceived);
-    connect(m_p_SendSerialPortManager.get(),&CSerialPortManager::signal_ErrorOccurred,this,&MainWindow::handleSerialportError);
-    connect(m_p_RecSerialPortManager.get(),&CSerialPortManager::signal_ErrorOccurred,this,&MainWindow::handleSerialportError);
+    connect(m_p_RecSerialPortManager,&CSerialPortManager::signal_DataReceived,this,&MainWindow::handleDataReceived);
+    connect(m_p_SendSerialPortManager,&CSerialPortManager::signal_DataReceived,this,&MainWindow::handleSendPortDataReceived);
+    // 错误经注册表转发，重连期间每次尝试打开失败不逐条显示
+    connect(m_p_Registry.get(),&CSerialPortRegistry::signal_PortError,this,[this](int id,const QString &error){
+        CSerialPortManager *manager=m_p_Registry->port(id);
+        if(manager==m_p_SendSerialPortManager||manager==m_p_RecSerialPortManager)
+        {
+            handleSerialportError(error);
+        }
+    });
+    connect(m_p_SendSerialPortManager,&CSerialPortManager::signal_FileSendProgress,this,&MainWindow::handleFileSendProgress);
+    connect(m_p_SendSerialPortManager,&CSerialPortManager::signal_FileSendFinished,this,&MainWindow::handleFileSendFinished);
+    connect(m_p_SendSerialPortManager,&CSerialPortManager::signal_WriteQueueHighWatermark,this,&MainWindow::handleWriteQueueHighWatermark);
+    connect(m_p_SendSerialPortManager,&CSerialPortManager::signal_WriteQueueLowWatermark,this,&MainWindow::handleWriteQueueLowWatermark);
+    connect(m_p_RecSerialPortManager,&CSerialPortManager::signal_BaudDetectionFinished,this,&MainWindow::handleRecBaudDetectionFinished);
+
+    // 串口列表由后台线程枚举后推送，窗口不等枚举完成就显示；设备拔出时注册表关闭对应串口
+    connect(m_p_PortWatcher.get(),&CPortWatcher::signal_PortsChanged,this,&MainWindow::handlePortsChanged);
+    connect(m_p_PortWatcher.get(),&CPortWatcher::signal_PortsChanged,m_p_Registry.get(),&CSerialPortRegistry::handlePortsChanged);
+    connect(m_p_SendSerialPortManager,&CSerialPortManager::signal_PortClosed,this,[this](){
+        updateUIOnPortChange(ui->pushButton_OpenSendPort,false);
+        // 关闭时写队列直接清空，不会再发低水位信号
+        updateSendButton();
+        // 周期任务随端口关闭一起结束，失效关闭的在重连后恢复，手动关闭的由关闭按钮清除
+        if(m_PeriodicSendId>=0)
+        {
+            m_PeriodicSendId=-1;
+            m_IsPeriodicLost=true;
+            ui->pushButton_Periodic->setText("定时发送");
+        }
+        updateBridgeStats();
+    });
+    connect(m_p_RecSerialPortManager,&CSerialPortManager::signal_PortClosed,this,[this](){
+        updateUIOnPortChange(ui->pushButton_OpenRecPort,false);
+        updateBridgeStats();
+    });
+    // 串口失效后由注册表关闭并按退避重新打开，恢复后按钮随之更新
+    connect(m_p_Registry.get(),&CSerialPortRegistry::signal_PortReconnected,this,[this](int id){
+        CSerialPortManager *manager=m_p_Registry->port(id);
+        if(manager==m_p_SendSerialPortManager)
+        {
+            updateUIOnPortChange(ui->pushButton_OpenSendPort,manager->isOpen());
+        }else if(manager==m_p_RecSerialPortManager){
+            updateUIOnPortChange(ui->pushButton_OpenRecPort,manager->isOpen());
+        }else{
+            return;
+        }
+        ui->plainTextEdit_ErrorMessage->appendPlainText(QString("串口已重新连接: %1").arg(manager->portName()));
+        restoreAfterReconnect();
+    });
+
+    // 定时刷新发送通道的排队深度与等待时间
+    connect(&m_LaneStatsTimer,&QTimer::timeout,this,&MainWindow::updateWriteLaneStats);
+    connect(&m_LaneStatsTimer,&QTimer::timeout,this,&MainWindow::updatePeriodicStats);
+    connect(&m_LaneStatsTimer,&QTimer::timeout,this,&MainWindow::updateReadStats);
+    connect(&m_LaneStatsTimer,&QTimer::timeout,this,&MainWindow::updateBridgeStats);
+    connect(&m_LaneStatsTimer,&QTimer::timeout,this,&MainWindow::updatePrbsStats);
+    m_LaneStatsTimer.start(500);
+    m_p_PortWatcher->start();
 }
 
 MainWindow::~MainWindow()
 {
-    // 关闭发送串口
-    if (m_p_SendSerialPortManager->isOpen()) {
-        m_p_SendSerialPortManager->closePort();
-        m_p_SendSerialPortManager.reset();
-    }
+    // 先停监视线程，析构过程中不再有插拔通知
+    m_p_PortWatcher->stop();
 
-    // 关闭接收串口
-    if (m_p_RecSerialPortManager->isOpen()) {
-        m_p_RecSerialPortManager->closePort();
-        m_p_RecSerialPortManager.reset();
-    }
+    // 误码测试持有收发串口的读取旁路与写队列，先于串口关闭停止
+    m_p_PrbsTester->stop();
+
+    // 多串口窗口的面板引用注册表中的串口，先于注册表销毁
+    delete m_p_MultiPortWindow;
+
+    // 关闭发送、接收及多串口窗口中的所有串口，注册表析构时再停止 I/O 线程
+    m_p_Registry->closeAll();
     delete ui;
 }
 
 void MainWindow::init()
 {
-    //获取所有的可用的接口
-    auto portInfos=QSerialPortInfo::availablePorts();
-    for (auto & portInfo : portInfos) {
-        ui->comboBox_ChoseSendPort->addItem(portInfo.portName()+":"+portInfo.description(),portInfo.portName());
-        ui->comboBox_ChoseRecPort->addItem(portInfo.portName()+":"+portInfo.description(),portInfo.portName());
-    }
-
-    //获取标准的波特率
-    auto baudRates=QSerialPortInfo::standardBaudRates();
-    for(auto &baudRate:baudRates){
-        ui->comboBox_ChoseSendBaudRate->addItem(QString::number(baudRate),baudRate);
-        ui->comboBox_ChoseRecBaudRate->addItem(QString::number(baudRate),baudRate);
-    }
-    ui->comboBox_ChoseSendBaudRate->setCurrentText("9600");
-    ui->comboBox_ChoseRecBaudRate->setCurrentText("9600");
-
-    //设置停止位
-    ui->comboBox_ChoseSendStopBits->addItem("1",QSerialPort::OneStop);
-    ui->comboBox_ChoseSendStopBits->addItem("1.5",QSerialPort::OneAndHalfStop);
-    ui->comboBox_ChoseSendStopBits->addItem("2",QSerialPort::TwoStop);
-    ui->comboBox_ChoseSendStopBits->setCurrentText("1");
-
-    ui->comboBox_ChoseRecStopBits->addItem("1",QSerialPort::OneStop);
-    ui->comboBox_ChoseRecStopBits->addItem("1.5",QSerialPort::OneAndHalfStop);
-    ui->comboBox_ChoseRecStopBits->addItem("2",QSerialPort::TwoStop);
-    ui->comboBox_ChoseRecStopBits->setCurrentText("1");
-
-    //设置数据位
-    ui->comboBox_ChoseSendDataBits->addItem("5",QSerialPort::Data5);
-    ui->comboBox_ChoseSendDataBits->addItem("6",QSerialPort::Data6);
-    ui->comboBox_ChoseSendDataBits->addItem("7",QSerialPort::Data7);
-    ui->comboBox_ChoseSendDataBits->addItem("8",QSerialPort::Data8);
-    ui->comboBox_ChoseSendDataBits->setCurrentText("8");
-
-    ui->comboBox_ChoseRecDataBits->addItem("5",QSerialPort::Data5);
-    ui->comboBox_ChoseRecDataBits->addItem("6",QSerialPort::Data6);
-    ui->comboBox_ChoseRecDataBits->addItem("7",QSerialPort::Data7);
-    ui->comboBox_ChoseRecDataBits->addItem("8",QSerialPort::Data8);
-    ui->comboBox_ChoseRecDataBits->setCurrentText("8");
-
-    //设置校验位
-    ui->comboBox_ChoseSendParityBits->addItem("None",QSerialPort::NoParity);
-    ui->comboBox_ChoseSendParityBits->addItem("Even",QSerialPort::EvenParity);
-    ui->comboBox_ChoseSendParityBits->addItem("Odd",QSerialPort::OddParity);
-    ui->comboBox_ChoseSendParityBits->addItem("Space",QSerialPort::SpaceParity);
-    ui->comboBox_ChoseSendParityBits->addItem("Mark",QSerialPort::MarkParity);
-    ui->comboBox_ChoseSendParityBits->setCurrentText("None");
-
-    ui->comboBox_ChoseRecParityBits->addItem("None",QSerialPort::NoParity);
-    ui->comboBox_ChoseRecParityBits->addItem("Even",QSerialPort::EvenParity);
-    ui->comboBox_ChoseRecParityBits->addItem("Odd",QSerialPort::OddParity);
-    ui->comboBox_ChoseRecParityBits->addItem("Space",QSerialPort::SpaceParity);
-    ui->comboBox_ChoseRecParityBits->addItem("Mark",QSerialPort::MarkParity);
-    ui->comboBox_ChoseRecParityBits->setCurrentText("None");
+    //填充发送、接收两组串口设置
+    CPortPanel::populateSettings(ui->comboBox_ChoseSendBaudRate,ui->comboBox_ChoseSendDataBits,
+                                 ui->comboBox_ChoseSendParityBits,ui->comboBox_ChoseSendStopBits,
+                                 ui->comboBox_ChoseSendFlowControl,ui->comboBox_ChoseSendLatency);
+    CPortPanel::populateSettings(ui->comboBox_ChoseRecBaudRate,ui->comboBox_ChoseRecDataBits,
+                                 ui->comboBox_ChoseRecParityBits,ui->comboBox_ChoseRecStopBits,
+                                 ui->comboBox_ChoseRecFlowControl,ui->comboBox_ChoseRecLatency);
+
+    //设置接收区显示模式
+    ui->comboBox_RecDisplayMode->addItem("文本",CReceiveView::TextMode);
+    ui->comboBox_RecDisplayMode->addItem("HEX",CReceiveView::HexMode);
+
+    //设置接收区文本编码
+    ui->comboBox_RecEncoding->addItem("UTF-8",CStreamDecoder::Utf8);
+    ui->comboBox_RecEncoding->addItem("Latin-1",CStreamDecoder::Latin1);
+    ui->comboBox_RecEncoding->addItem("GBK",CStreamDecoder::Gbk);
+
+    //设置误码测试序列
+    ui->comboBox_PrbsPattern->addItem("PRBS-7",CPrbsGenerator::Prbs7);
+    ui->comboBox_PrbsPattern->addItem("PRBS-15",CPrbsGenerator::Prbs15);
+    ui->comboBox_PrbsPattern->addItem("PRBS-23",CPrbsGenerator::Prbs23);
+    ui->comboBox_PrbsPattern->addItem("PRBS-31",CPrbsGenerator::Prbs31);
+    ui->comboBox_PrbsPattern->setCurrentIndex(1);
 
 }
 
@@ -108,25 +183,44 @@ void MainWindow::updateUIOnPortChange(QPushButton *button, bool isPortOpen)
 
 }
 
+void MainWindow::reportAppliedBaudRate(QComboBox *comboBox, int requested, unsigned applied)
+{
+    // 驱动按分频系数取整，实际速率与请求值不同时提示偏差，偏差过大（约 2% 以上）时通信会出错
+    comboBox->setToolTip(QString("实际波特率: %1").arg(applied));
+    if(applied!=static_cast<unsigned>(requested))
+    {
+        const double deviation=(static_cast<double>(applied)-requested)*100.0/requested;
+        ui->plainTextEdit_ErrorMessage->appendPlainText(QString("Requested %1 baud, driver applied %2 (%3%)")
+                                                            .arg(requested).arg(applied).arg(deviation,0,'f',2));
+    }
+}
+
 void MainWindow::on_pushButton_OpenSendPort_clicked()
 {
     if(m_p_SendSerialPortManager->isOpen())
     {
         m_p_SendSerialPortManager->closePort();
         updateUIOnPortChange(ui->pushButton_OpenSendPort,false);
+        // 手动关闭后不再恢复周期任务与桥接
+        m_IsPeriodicLost=false;
+        m_IsBridgeRequested=false;
 
         // 等待关闭完成后再尝试重新打开串口
         std::this_thread::sleep_for(std::chrono::milliseconds(500)); // 等待500ms
     }else{
         QString portName=ui->comboBox_ChoseSendPort->currentData().toString();
-        int baudRate=ui->comboBox_ChoseSendBaudRate->currentData().toInt();
+        int baudRate=ui->comboBox_ChoseSendBaudRate->currentText().toInt();
         int dataBits=ui->comboBox_ChoseSendDataBits->currentData().toInt();
         int parity=ui->comboBox_ChoseSendParityBits->currentData().toInt();
         int stopBits=ui->comboBox_ChoseSendStopBits->currentData().toInt();
+        int flowControl=ui->comboBox_ChoseSendFlowControl->currentData().toInt();
+        auto latencyMode=static_cast<SerialTuning::LatencyMode>(ui->comboBox_ChoseSendLatency->currentData().toInt());
 
-        if(m_p_SendSerialPortManager->openPort(portName,baudRate,dataBits,parity,stopBits))
+        if(m_p_SendSerialPortManager->openPort(portName,baudRate,dataBits,parity,stopBits,flowControl,latencyMode))
         {
             updateUIOnPortChange(ui->pushButton_OpenSendPort,true);
+            updateSendButton();
+            reportAppliedBaudRate(ui->comboBox_ChoseSendBaudRate,baudRate,m_p_SendSerialPortManager->appliedBaudRate());
         }else
         {
             QMessageBox::warning(this,"警告","打开串口失败");
@@ -141,17 +235,21 @@ void MainWindow::on_pushButton_OpenRecPort_clicked()
     {
         m_p_RecSerialPortManager->closePort();
         updateUIOnPortChange(ui->pushButton_OpenRecPort,false);
+        m_IsBridgeRequested=false;
         std::this_thread::sleep_for(std::chrono::milliseconds(500)); // 等待500ms
     }else{
         QString portName=ui->comboBox_ChoseRecPort->currentData().toString();
-        int baudRate=ui->comboBox_ChoseRecBaudRate->currentData().toInt();
+        int baudRate=ui->comboBox_ChoseRecBaudRate->currentText().toInt();
         int dataBits=ui->comboBox_ChoseRecDataBits->currentData().toInt();
         int parity=ui->comboBox_ChoseRecParityBits->currentData().toInt();
         int stopBits=ui->comboBox_ChoseRecStopBits->currentData().toInt();
+        int flowControl=ui->comboBox_ChoseRecFlowControl->currentData().toInt();
+        auto latencyMode=static_cast<SerialTuning::LatencyMode>(ui->comboBox_ChoseRecLatency->currentData().toInt());
 
-        if(m_p_RecSerialPortManager->openPort(portName,baudRate,dataBits,parity,stopBits))
+        if(m_p_RecSerialPortManager->openPort(portName,baudRate,dataBits,parity,stopBits,flowControl,latencyMode))
         {
             updateUIOnPortChange(ui->pushButton_OpenRecPort,true);
+            reportAppliedBaudRate(ui->comboBox_ChoseRecBaudRate,baudRate,m_p_RecSerialPortManager->appliedBaudRate());
         }else{
             QMessageBox::warning(this,"警告","打开串口失败");
         }
@@ -167,18 +265,428 @@ void MainWindow::on_pushButton_Send_clicked()
         return;
     }
     QByteArray data=ui->plainTextEdit_SendMessage->toPlainText().toUtf8();
-    m_p_SendSerialPortManager->sendData(data);
+    auto priority=ui->checkBox_SendHighPriority->isChecked()?CSerialPortManager::HighPriority:CSerialPortManager::NormalPriority;
+    m_p_SendSerialPortManager->sendData(data,priority);
 }
 
 
+void MainWindow::on_pushButton_ApplyReadPolicy_clicked()
+{
+    // 接收端口未打开时也可设置，下次打开时生效
+    CSerialPortManager::ReadPolicy policy;
+    policy.delimiter=parseEscapes(ui->lineEdit_RecDelimiter->text());
+    policy.minBytes=static_cast<size_t>(ui->spinBox_RecMinBytes->value());
+    policy.idleGap=std::chrono::microseconds(static_cast<qint64>(ui->doubleSpinBox_RecIdleGapMs->value()*1000));
+    policy.idleGapChars=ui->doubleSpinBox_RecIdleGapChars->value();
+    policy.timeout=std::chrono::microseconds(static_cast<qint64>(ui->doubleSpinBox_RecReadTimeoutMs->value()*1000));
+    m_p_RecSerialPortManager->setReadPolicy(policy);
+}
+
+void MainWindow::on_pushButton_Bridge_clicked()
+{
+    if(m_p_RecSerialPortManager->isBridged())
+    {
+        m_p_RecSerialPortManager->stopBridge();
+        m_IsBridgeRequested=false;
+        updateBridgeStats();
+        return;
+    }
+    if(!m_p_SendSerialPortManager->isOpen()||!m_p_RecSerialPortManager->isOpen())
+    {
+        QMessageBox::warning(this,"警告","请先打开发送和接收串口");
+        return;
+    }
+    m_p_SendSerialPortManager->setBridgeTap(ui->checkBox_BridgeTap->isChecked());
+    m_p_RecSerialPortManager->setBridgeTap(ui->checkBox_BridgeTap->isChecked());
+    m_IsBridgeRequested=m_p_RecSerialPortManager->startBridge(m_p_SendSerialPortManager);
+    updateBridgeStats();
+}
+
+void MainWindow::on_checkBox_BridgeTap_toggled(bool checked)
+{
+    m_p_SendSerialPortManager->setBridgeTap(checked);
+    m_p_RecSerialPortManager->setBridgeTap(checked);
+}
+
+void MainWindow::on_pushButton_DetectRecBaud_clicked()
+{
+    if(m_p_RecSerialPortManager->isDetectingBaud())
+    {
+        m_p_RecSerialPortManager->cancelBaudDetection();
+        return;
+    }
+    // 未打开时按当前设置先打开，波特率取什么都可以，检测时会逐个重新配置
+    if(!m_p_RecSerialPortManager->isOpen())
+    {
+        on_pushButton_OpenRecPort_clicked();
+        if(!m_p_RecSerialPortManager->isOpen())
+        {
+            return;
+        }
+    }
+    if(m_p_RecSerialPortManager->startBaudDetection())
+    {
+        ui->pushButton_DetectRecBaud->setText("取消检测");
+        ui->plainTextEdit_ErrorMessage->appendPlainText("正在检测接收波特率...");
+    }
+}
+
+void MainWindow::on_pushButton_PrbsTest_clicked()
+{
+    if(m_p_PrbsTester->isRunning())
+    {
+        m_p_PrbsTester->stop();
+        updatePrbsStats();
+        return;
+    }
+    if(!m_p_SendSerialPortManager->isOpen())
+    {
+        QMessageBox::warning(this,"警告","请先打开发送串口");
+        return;
+    }
+    // 接收串口未打开时在发送串口上环回
+    CSerialPortManager *receiver=m_p_RecSerialPortManager->isOpen()?m_p_RecSerialPortManager:m_p_SendSerialPortManager;
+    CPrbsTester::Options options;
+    options.pattern=static_cast<CPrbsGenerator::Pattern>(ui->comboBox_PrbsPattern->currentData().toInt());
+    std::string error;
+    if(!m_p_PrbsTester->start(m_p_SendSerialPortManager,receiver,options,&error))
+    {
+        ui->plainTextEdit_ErrorMessage->appendPlainText(QString("Failed to start PRBS test: %1").arg(QString::fromStdString(error)));
+        return;
+    }
+    ui->plainTextEdit_ErrorMessage->appendPlainText(QString("误码测试: %1 → %2, %3")
+                                                        .arg(m_p_SendSerialPortManager->portName())
+                                                        .arg(receiver->portName())
+                                                        .arg(ui->comboBox_PrbsPattern->currentText()));
+    updatePrbsStats();
+}
+
+void MainWindow::on_pushButton_MultiPort_clicked()
+{
+    // 窗口在第一次打开时创建，关闭后只是隐藏，其中的串口继续运行
+    if(m_p_MultiPortWindow==nullptr)
+    {
+        m_p_MultiPortWindow=new CMultiPortWindow(m_p_Registry.get(),m_p_PortWatcher.get(),this);
+    }
+    m_p_MultiPortWindow->show();
+    m_p_MultiPortWindow->raise();
+    m_p_MultiPortWindow->activateWindow();
+}
+
+
+void MainWindow::on_pushButton_Periodic_clicked()
+{
+    if(m_PeriodicSendId>=0)
+    {
+        m_p_SendSerialPortManager->stopPeriodicSend(m_PeriodicSendId);
+        m_PeriodicSendId=-1;
+        ui->pushButton_Periodic->setText("定时发送");
+        return;
+    }
+    if(!m_p_SendSerialPortManager->isOpen())
+    {
+        QMessageBox::warning(this,"警告","请先打开发送串口");
+        return;
+    }
+    // 帧在启动时构造一次，之后由 I/O 线程按绝对截止时间发送，不再经过界面线程
+    m_IsPeriodicLost=false;
+    m_PeriodicFrame=ui->plainTextEdit_SendMessage->toPlainText().toUtf8();
+    m_PeriodicPeriod=std::chrono::microseconds(static_cast<qint64>(ui->doubleSpinBox_PeriodMs->value()*1000));
+    m_PeriodicPriority=ui->checkBox_SendHighPriority->isChecked()?CSerialPortManager::HighPriority:CSerialPortManager::NormalPriority;
+    m_PeriodicSendId=m_p_SendSerialPortManager->startPeriodicSend(m_PeriodicFrame,m_PeriodicPeriod,m_PeriodicPriority);
+    if(m_PeriodicSendId>=0)
+    {
+        ui->pushButton_Periodic->setText("停止定时");
+    }
+}
+
+void MainWindow::restoreAfterReconnect()
+{
+    // 与 SerialPortDaemon 一样，两端都恢复后重新桥接，发送串口恢复后重新开始定时发送
+    if(m_IsBridgeRequested&&m_p_SendSerialPortManager->isOpen()&&m_p_RecSerialPortManager->isOpen()
+        &&!m_p_RecSerialPortManager->isBridged())
+    {
+        m_p_RecSerialPortManager->startBridge(m_p_SendSerialPortManager);
+    }
+    updateBridgeStats();
+    if(m_IsPeriodicLost&&m_p_SendSerialPortManager->isOpen())
+    {
+        m_IsPeriodicLost=false;
+        m_PeriodicSendId=m_p_SendSerialPortManager->startPeriodicSend(m_PeriodicFrame,m_PeriodicPeriod,m_PeriodicPriority);
+        if(m_PeriodicSendId>=0)
+        {
+            ui->pushButton_Periodic->setText("停止定时");
+        }
+    }
+}
+
 void MainWindow::on_pushButton_Clean_clicked()
 {
     ui->plainTextEdit_SendMessage->clear();
 }
 
-void MainWindow::handleDataReceived(const QByteArray &data)
+void MainWindow::on_pushButton_Record_clicked()
 {
-    ui->plainTextEdit_RecMessage->appendPlainText(QString::fromUtf8(data));
+    if(m_p_RecSerialPortManager->isRecording())
+    {
+        m_p_RecSerialPortManager->stopRecording();
+        ui->pushButton_Record->setText("开始录制");
+        return;
+    }
+    QString filePath=QFileDialog::getSaveFileName(this,"保存捕获文件",QString(),"捕获文件 (*.sphcap)");
+    if(filePath.isEmpty())
+    {
+        return;
+    }
+    if(m_p_RecSerialPortManager->startRecording(filePath))
+    {
+        ui->pushButton_Record->setText("停止录制");
+    }
+}
+
+void MainWindow::on_comboBox_RecDisplayMode_currentIndexChanged(int index)
+{
+    auto mode=static_cast<CReceiveView::DisplayMode>(ui->comboBox_RecDisplayMode->itemData(index).toInt());
+    ui->receiveView_RecMessage->setDisplayMode(mode);
+}
+
+void MainWindow::on_comboBox_RecEncoding_currentIndexChanged(int index)
+{
+    auto encoding=static_cast<CStreamDecoder::Encoding>(ui->comboBox_RecEncoding->itemData(index).toInt());
+    ui->receiveView_RecMessage->setTextEncoding(encoding);
+}
+
+void MainWindow::on_checkBox_RecTimestamp_toggled(bool checked)
+{
+    ui->receiveView_RecMessage->setTimestampVisible(checked);
+}
+
+void MainWindow::on_pushButton_SendFile_clicked()
+{
+    if(m_p_SendSerialPortManager->isSendingFile())
+    {
+        m_p_SendSerialPortManager->cancelFileSend();
+        return;
+    }
+    if(!m_p_SendSerialPortManager->isOpen())
+    {
+        QMessageBox::warning(this,"警告","请先打开发送串口");
+        return;
+    }
+    QString filePath=QFileDialog::getOpenFileName(this,"选择要发送的文件");
+    if(filePath.isEmpty())
+    {
+        return;
+    }
+    if(m_p_SendSerialPortManager->sendFile(filePath))
+    {
+        ui->progressBar_SendFile->setValue(0);
+        ui->pushButton_SendFile->setText("取消发送");
+    }
+}
+
+void MainWindow::handleFileSendProgress(qint64 bytesSent, qint64 totalBytes, double bytesPerSecond)
+{
+    ui->progressBar_SendFile->setValue(totalBytes>0?static_cast<int>(bytesSent*100/totalBytes):100);
+    ui->label_SendFileRate->setText(QString("%1 / %2 KB  %3 KB/s")
+                                        .arg(bytesSent/1024).arg(totalBytes/1024)
+                                        .arg(bytesPerSecond/1024,0,'f',1));
+}
+
+void MainWindow::handleFileSendFinished(bool success, const QString &message)
+{
+    ui->pushButton_SendFile->setText("发送文件");
+    if(!success)
+    {
+        ui->plainTextEdit_ErrorMessage->appendPlainText(message);
+    }
+}
+
+void MainWindow::handleWriteQueueHighWatermark(qint64 queuedBytes)
+{
+    Q_UNUSED(queuedBytes);
+    // 对端流控或波特率跟不上时暂停普通手动发送，等写队列回落到低水位再恢复；限流状态显示在通道统计里
+    updateSendButton();
+    updateWriteLaneStats();
+}
+
+void MainWindow::handleRecBaudDetectionFinished(bool success, unsigned baudRate, const QString &message)
+{
+    ui->pushButton_DetectRecBaud->setText("自动检测接收波特率");
+    ui->plainTextEdit_ErrorMessage->appendPlainText(message);
+    if(success)
+    {
+        ui->comboBox_ChoseRecBaudRate->setCurrentText(QString::number(baudRate));
+        reportAppliedBaudRate(ui->comboBox_ChoseRecBaudRate,static_cast<int>(baudRate),m_p_RecSerialPortManager->appliedBaudRate());
+    }
+}
+
+void MainWindow::handleWriteQueueLowWatermark(qint64 queuedBytes)
+{
+    Q_UNUSED(queuedBytes);
+    updateSendButton();
+    updateWriteLaneStats();
+}
+
+void MainWindow::updateSendButton()
+{
+    // 文件发送期间写队列常驻高水位附近，高优先级帧走独立通道插队发出，不随普通发送一起暂停
+    ui->pushButton_Send->setEnabled(ui->checkBox_SendHighPriority->isChecked()
+                                    ||!m_p_SendSerialPortManager->isOpen()
+                                    ||!m_p_SendSerialPortManager->isWriteThrottled());
+}
+
+void MainWindow::on_checkBox_SendHighPriority_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+    updateSendButton();
+}
+
+void MainWindow::updateWriteLaneStats()
+{
+    if(!m_p_SendSerialPortManager->isOpen())
+    {
+        return;
+    }
+    QStringList lines;
+    const char *names[]={"高优先级","普通"};
+    for(int lane=0;lane<CSerialPortManager::WritePriorityCount;++lane)
+    {
+        auto stats=m_p_SendSerialPortManager->writeLaneStats(static_cast<CSerialPortManager::WritePriority>(lane));
+        lines<<QString("%1: %2 帧 / %3 KB 排队, 等待 %4 ms (平均 %5, 最大 %6)")
+                     .arg(names[lane])
+                     .arg(stats.queuedFrames)
+                     .arg(stats.queuedBytes/1024)
+                     .arg(stats.lastWaitMs,0,'f',1)
+                     .arg(stats.averageWaitMs,0,'f',1)
+                     .arg(stats.maxWaitMs,0,'f',1);
+    }
+    if(m_p_SendSerialPortManager->isWriteThrottled())
+    {
+        lines<<"写队列限流中: 普通发送暂停，高优先级仍可发送";
+    }
+    ui->label_WriteLaneStats->setText(lines.join('\n'));
+}
+
+void MainWindow::updatePeriodicStats()
+{
+    if(m_PeriodicSendId<0)
+    {
+        return;
+    }
+    auto stats=m_p_SendSerialPortManager->periodicStats(m_PeriodicSendId);
+    QStringList lines;
+    lines<<QString("定时发送: %1 帧, 跳过 %2, 限流 %3").arg(stats.sent).arg(stats.missed).arg(stats.throttled);
+    lines<<QString("迟到: 平均 %1 us, 最大 %2 us").arg(stats.meanLatenessUs,0,'f',1).arg(stats.maxLatenessUs,0,'f',1);
+    qint64 lower=0;
+    for(int bin=0;bin<CSerialPortManager::kJitterBinCount;++bin)
+    {
+        QString range=bin<CSerialPortManager::kJitterBinCount-1
+                            ?QString("%1-%2 us").arg(lower).arg(CSerialPortManager::kJitterBinBoundsUs[bin])
+                            :QString(">= %1 us").arg(lower);
+        lines<<QString("%1: %2").arg(range,-14).arg(stats.histogram[bin]);
+        if(bin<CSerialPortManager::kJitterBinCount-1)
+        {
+            lower=CSerialPortManager::kJitterBinBoundsUs[bin];
+        }
+    }
+    ui->label_PeriodicJitter->setText(lines.join('\n'));
+}
+
+void MainWindow::updateReadStats()
+{
+    if(!m_p_RecSerialPortManager->isOpen())
+    {
+        return;
+    }
+    auto stats=m_p_RecSerialPortManager->readStats();
+    if(stats.completions<m_LastReadStats.completions)
+    {
+        // 重新打开串口后计数清零
+        m_LastReadStats=CSerialPortManager::ReadStats();
+    }
+    const double seconds=m_LaneStatsTimer.interval()/1000.0;
+    const quint64 deliveries=stats.deliveries-m_LastReadStats.deliveries;
+    const quint64 bytes=stats.bytes-m_LastReadStats.bytes;
+    const double characterUs=m_p_RecSerialPortManager->characterTime().count()/1000.0;
+    ui->label_RecReadStats->setText(QString("读取完成 %1 次/s, 交付 %2 次/s, 平均每次交付 %3 字节, 字符时间 %4 us")
+                                        .arg((stats.completions-m_LastReadStats.completions)/seconds,0,'f',0)
+                                        .arg(deliveries/seconds,0,'f',0)
+                                        .arg(deliveries>0?static_cast<double>(bytes)/deliveries:0.0,0,'f',1)
+                                        .arg(characterUs,0,'f',1));
+    m_LastReadStats=stats;
+}
+
+void MainWindow::handleDataReceived(const QByteArray &data, qint64 timestampNs)
+{
+    // 误码测试期间收到的是测试序列，不显示；录制不受影响
+    if(m_p_PrbsTester->isRunning())
+    {
+        return;
+    }
+    ui->receiveView_RecMessage->appendData(data,timestampNs);
+}
+
+void MainWindow::updateBridgeStats()
+{
+    // 任一端关闭时桥接自动解除，按钮文字随之恢复
+    const bool isBridged=m_p_RecSerialPortManager->isBridged();
+    ui->pushButton_Bridge->setText(isBridged?"解除桥接":"桥接收发串口");
+    if(!isBridged)
+    {
+        return;
+    }
+    QStringList lines;
+    for(CSerialPortManager *source:{m_p_RecSerialPortManager,m_p_SendSerialPortManager})
+    {
+        const auto stats=source->bridgeStats();
+        lines<<QString("%1: %2 KB, 转发时延 平均 %3 us / 最大 %4 us, 暂停读取 %5 次")
+                     .arg(source==m_p_RecSerialPortManager?"接收→发送":"发送→接收")
+                     .arg(stats.forwardedBytes/1024)
+                     .arg(stats.meanLatencyUs,0,'f',0)
+                     .arg(stats.maxLatencyUs,0,'f',0)
+                     .arg(stats.stalls);
+    }
+    ui->label_BridgeStats->setText(lines.join('\n'));
+}
+
+void MainWindow::updatePrbsStats()
+{
+    const bool isRunning=m_p_PrbsTester->isRunning();
+    ui->pushButton_PrbsTest->setText(isRunning?"停止误码测试":"误码测试");
+    const auto stats=m_p_PrbsTester->stats();
+    if(stats.sentBytes==0)
+    {
+        return;
+    }
+    QStringList lines;
+    lines<<QString("%1 %2, 发送 %3 KB, 接收 %4 KB, 误码率 %5 (%6 bit)")
+               .arg(isRunning?"运行中":"已停止")
+               .arg(stats.checker.isLocked?"已同步":"未同步")
+               .arg(stats.sentBytes/1024)
+               .arg(stats.checker.bytes/1024)
+               .arg(stats.bitErrorRate,0,'e',2)
+               .arg(stats.checker.bitErrors);
+    lines<<QString("丢失 %1 字节, 多出 %2 字节, 失步 %3 次")
+               .arg(stats.checker.lostBytes)
+               .arg(stats.checker.insertedBytes)
+               .arg(stats.checker.syncLosses);
+    lines<<QString("吞吐 %1 KB/s (线路 %2%), 单向时延 最小 %3 us / 平均 %4 us / 最大 %5 us")
+               .arg(stats.bytesPerSecond/1024,0,'f',1)
+               .arg(stats.lineUtilization*100,0,'f',0)
+               .arg(stats.minLatencyUs,0,'f',0)
+               .arg(stats.meanLatencyUs,0,'f',0)
+               .arg(stats.maxLatencyUs,0,'f',0);
+    ui->label_PrbsStats->setText(lines.join('\n'));
+}
+
+void MainWindow::handleSendPortDataReceived(const QByteArray &data, qint64 timestampNs)
+{
+    // 发送串口收到的数据只在桥接监听时显示，与接收串口的数据按时间交错在同一接收区，按来源分行着色
+    if(m_p_SendSerialPortManager->isBridged())
+    {
+        ui->receiveView_RecMessage->appendData(data,timestampNs,1);
+    }
 }
 
 void MainWindow::handleSerialportError(const QString &error)
@@ -186,3 +694,24 @@ void MainWindow::handleSerialportError(const QString &error)
     ui->plainTextEdit_ErrorMessage->appendPlainText(error);
 }
 
+void MainWindow::handlePortsChanged(const QStringList &added, const QStringList &removed)
+{
+    const auto ports=m_p_PortWatcher->ports();
+    CPortPanel::updatePortList(ui->comboBox_ChoseSendPort,ports);
+    CPortPanel::updatePortList(ui->comboBox_ChoseRecPort,ports);
+    // 第一次枚举的结果不算插入
+    if(!m_IsPortListReady)
+    {
+        m_IsPortListReady=true;
+        return;
+    }
+    for(const QString &name:added)
+    {
+        ui->plainTextEdit_ErrorMessage->appendPlainText(QString("串口已插入: %1").arg(name));
+    }
+    for(const QString &name:removed)
+    {
+        ui->plainTextEdit_ErrorMessage->appendPlainText(QString("串口已拔出: %1").arg(name));
+    }
+}
+
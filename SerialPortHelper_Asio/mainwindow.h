@@ -1,10 +1,16 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "cportwatcher.h"
+#include "cprbstester.h"
 #include "cserialportmanager.h"
+#include "cserialportregistry.h"
 
 #include <QMainWindow>
+#include <QTimer>
 class QPushButton;
+class QComboBox;
+class CMultiPortWindow;
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -20,19 +26,65 @@ public:
     ~MainWindow();
     void init();
     void updateUIOnPortChange(QPushButton *button, bool isPortOpen);
+    void reportAppliedBaudRate(QComboBox *comboBox, int requested, unsigned applied);
+    void updateSendButton();
+    void restoreAfterReconnect();
 
 private slots:
     void on_pushButton_OpenSendPort_clicked();
     void on_pushButton_OpenRecPort_clicked();
     void on_pushButton_Send_clicked();
     void on_pushButton_Clean_clicked();
+    void on_pushButton_Record_clicked();
+    void on_comboBox_RecDisplayMode_currentIndexChanged(int index);
+    void on_comboBox_RecEncoding_currentIndexChanged(int index);
+    void on_checkBox_RecTimestamp_toggled(bool checked);
+    void on_checkBox_SendHighPriority_toggled(bool checked);
+    void on_pushButton_SendFile_clicked();
+    void on_pushButton_Periodic_clicked();
+    void on_pushButton_ApplyReadPolicy_clicked();
+    void on_pushButton_Bridge_clicked();
+    void on_checkBox_BridgeTap_toggled(bool checked);
+    void on_pushButton_MultiPort_clicked();
+    void on_pushButton_DetectRecBaud_clicked();
+    void on_pushButton_PrbsTest_clicked();
 
-    void handleDataReceived(const QByteArray &data);
+    void updateWriteLaneStats();
+    void updatePeriodicStats();
+    void updateReadStats();
+    void updateBridgeStats();
+    void updatePrbsStats();
+
+    void handleDataReceived(const QByteArray &data, qint64 timestampNs);
+    void handleSendPortDataReceived(const QByteArray &data, qint64 timestampNs);
     void handleSerialportError(const QString &error);
+    void handlePortsChanged(const QStringList &added, const QStringList &removed);
+    void handleFileSendProgress(qint64 bytesSent, qint64 totalBytes, double bytesPerSecond);
+    void handleFileSendFinished(bool success, const QString &message);
+    void handleWriteQueueHighWatermark(qint64 queuedBytes);
+    void handleWriteQueueLowWatermark(qint64 queuedBytes);
+    void handleRecBaudDetectionFinished(bool success, unsigned baudRate, const QString &message);
 
 private:
     Ui::MainWindow *ui;
-    std::unique_ptr<CSerialPortManager> m_p_SendSerialPortManager;
-    std::unique_ptr<CSerialPortManager> m_p_RecSerialPortManager;
+    // 发送、接收串口与多串口窗口中的串口都登记在注册表里，共用一个 I/O 线程
+    std::unique_ptr<CSerialPortRegistry> m_p_Registry;
+    CSerialPortManager *m_p_SendSerialPortManager;
+    CSerialPortManager *m_p_RecSerialPortManager;
+    // 后台枚举串口并推送插拔，声明在注册表之后，先于注册表停止
+    std::unique_ptr<CPortWatcher> m_p_PortWatcher;
+    // 运行在注册表的 I/O 线程上，析构前先停止
+    std::unique_ptr<CPrbsTester> m_p_PrbsTester;
+    CMultiPortWindow *m_p_MultiPortWindow = nullptr;
+    QTimer m_LaneStatsTimer;
+    int m_PeriodicSendId = -1;
+    // 注册表重连只重新打开端口，桥接与定时发送按断开前的设置由窗口重新建立
+    QByteArray m_PeriodicFrame;
+    std::chrono::microseconds m_PeriodicPeriod{0};
+    CSerialPortManager::WritePriority m_PeriodicPriority = CSerialPortManager::NormalPriority;
+    bool m_IsPeriodicLost = false;
+    bool m_IsBridgeRequested = false;
+    bool m_IsPortListReady = false;
+    CSerialPortManager::ReadStats m_LastReadStats;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,248 @@
+// SerialPrbsBench：PRBS 误码测试的命令行版本。
+// --selftest 不需要硬件：测 CPrbsGenerator / CPrbsChecker 的单核吞吐（折算为 8N1 波特率），
+// 并在生成的序列中注入已知的丢字节、多字节与比特翻转，核对校验端找回的数量，不一致时返回 1。
+// 硬件模式由引擎打开 <port> 连续发送，--peer 给出时在另一口接收（两口之间接线），
+// 否则同一口接收（插环回头）；每秒打印一行，结束时打印汇总。
+#include "cprbs.h"
+#include "cprbstester.h"
+#include "cserialportmanager.h"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSelfTestBytes = 32 << 20;
+constexpr size_t kImpairmentSpacing = 256 * 1024;   // 相邻两次注入的间隔，保证每次都能重新锁定
+constexpr size_t kMaxDrop = 4096;
+constexpr size_t kMaxInsert = 64;
+
+struct Options
+{
+    std::string port;
+    std::string peerPort;
+    unsigned baudRate = 115200;
+    CPrbsGenerator::Pattern pattern = CPrbsGenerator::Prbs15;
+    int seconds = 10;
+    bool selfTest = false;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialPrbsBench <port> [--peer <port>] [--baud <rate>] [--pattern 7|15|23|31] [--seconds <n>]\n"
+                 "       SerialPrbsBench --selftest\n"
+                 "  without --peer the pattern is looped back on <port> (loopback plug)\n";
+}
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 8N1 每字节 10 个比特时间
+double toMegabaud(double bytesPerSecond)
+{
+    return bytesPerSecond * 10.0 / 1e6;
+}
+
+bool selfTestPattern(CPrbsGenerator::Pattern pattern, std::mt19937 &random)
+{
+    CPrbsGenerator generator(pattern);
+    std::vector<uint8_t> sent(kSelfTestBytes);
+    auto start = Clock::now();
+    generator.generate(sent.data(), sent.size());
+    const double generateSeconds = secondsSince(start);
+
+    // 每隔 kImpairmentSpacing 依次注入：丢若干字节、插入若干随机字节、翻转几个比特
+    std::vector<uint8_t> received;
+    received.reserve(sent.size() + sent.size() / kImpairmentSpacing * kMaxInsert);
+    uint64_t droppedBytes = 0;
+    uint64_t insertedBytes = 0;
+    uint64_t flippedBits = 0;
+    size_t offset = 0;
+    for (int event = 0; offset < sent.size(); ++event) {
+        const size_t end = std::min(offset + kImpairmentSpacing, sent.size());
+        received.insert(received.end(), sent.begin() + static_cast<std::ptrdiff_t>(offset),
+                        sent.begin() + static_cast<std::ptrdiff_t>(end));
+        offset = end;
+        if (offset == sent.size()) {
+            break;
+        }
+        if (event % 3 == 0) {
+            const size_t drop = std::min<size_t>(1 + random() % kMaxDrop, sent.size() - offset);
+            offset += drop;
+            droppedBytes += drop;
+        } else if (event % 3 == 1) {
+            const size_t insert = 1 + random() % kMaxInsert;
+            for (size_t i = 0; i < insert; ++i) {
+                received.push_back(static_cast<uint8_t>(random()));
+            }
+            insertedBytes += insert;
+        } else {
+            const int bits = 1 + static_cast<int>(random() % 3);
+            for (int i = 0; i < bits; ++i) {
+                received[received.size() - 1 - static_cast<size_t>(i) * 7] ^= static_cast<uint8_t>(1u << (random() % 8));
+            }
+            flippedBits += static_cast<uint64_t>(bits);
+        }
+    }
+
+    // 按串口读取的典型粒度分块送入
+    CPrbsChecker checker(pattern);
+    start = Clock::now();
+    for (size_t position = 0; position < received.size();) {
+        const size_t size = std::min<size_t>(1 + random() % 4096, received.size() - position);
+        checker.check(received.data() + position, size);
+        position += size;
+    }
+    const double checkSeconds = secondsSince(start);
+
+    const CPrbsChecker::Stats &stats = checker.stats();
+    // PRBS-7 的周期只有 127 字节，错位只能确定到 127 的整数倍以内，多出 k 字节与丢失 127-k 字节无法区分，只核对净错位
+    bool slipMatches = stats.lostBytes == droppedBytes && stats.insertedBytes == insertedBytes;
+    if (pattern == CPrbsGenerator::Prbs7) {
+        const int64_t period = 127;
+        auto netSlip = [period](uint64_t lost, uint64_t inserted) {
+            return ((static_cast<int64_t>(lost) - static_cast<int64_t>(inserted)) % period + period) % period;
+        };
+        slipMatches = netSlip(stats.lostBytes, stats.insertedBytes) == netSlip(droppedBytes, insertedBytes);
+    }
+    const bool isCorrect = stats.bitErrors == flippedBits && slipMatches && stats.unresolvedSlips == 0 && stats.isLocked;
+    const double generateRate = static_cast<double>(sent.size()) / generateSeconds;
+    const double checkRate = static_cast<double>(received.size()) / checkSeconds;
+    std::printf("PRBS-%-2d %10.0f %10.0f %10.0f %10llu/%-8llu %8llu/%-8llu %6llu/%-6llu %s\n",
+                static_cast<int>(pattern), generateRate / 1e6, checkRate / 1e6, toMegabaud(checkRate),
+                static_cast<unsigned long long>(stats.lostBytes), static_cast<unsigned long long>(droppedBytes),
+                static_cast<unsigned long long>(stats.insertedBytes), static_cast<unsigned long long>(insertedBytes),
+                static_cast<unsigned long long>(stats.bitErrors), static_cast<unsigned long long>(flippedBits),
+                isCorrect ? "ok" : "MISMATCH");
+    return isCorrect;
+}
+
+int runSelfTest()
+{
+    std::printf("%-8s %10s %10s %10s %19s %17s %13s\n", "pattern", "gen MB/s", "chk MB/s", "chk Mbaud",
+                "lost (found/inj)", "inserted", "bit errors");
+    std::mt19937 random(1);
+    bool isCorrect = true;
+    for (auto pattern : {CPrbsGenerator::Prbs7, CPrbsGenerator::Prbs15, CPrbsGenerator::Prbs23, CPrbsGenerator::Prbs31}) {
+        isCorrect = selfTestPattern(pattern, random) && isCorrect;
+    }
+    return isCorrect ? 0 : 1;
+}
+
+void printStats(const char *label, const CPrbsTester::Stats &stats)
+{
+    std::printf("%-6s sent %12llu  recv %12llu  %s  BER %.2e (%llu bits)  lost %llu  inserted %llu  slips %llu/%llu"
+                "  %.1f KB/s (%.0f%% line)  latency us %.0f/%.0f/%.0f\n",
+                label, static_cast<unsigned long long>(stats.sentBytes),
+                static_cast<unsigned long long>(stats.checker.bytes), stats.checker.isLocked ? "locked  " : "unlocked",
+                stats.bitErrorRate, static_cast<unsigned long long>(stats.checker.bitErrors),
+                static_cast<unsigned long long>(stats.checker.lostBytes),
+                static_cast<unsigned long long>(stats.checker.insertedBytes),
+                static_cast<unsigned long long>(stats.checker.syncLosses),
+                static_cast<unsigned long long>(stats.checker.unresolvedSlips), stats.bytesPerSecond / 1e3,
+                stats.lineUtilization * 100.0, stats.minLatencyUs, stats.meanLatencyUs, stats.maxLatencyUs);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--selftest") {
+            options.selfTest = true;
+        } else if (arg == "--peer" && i + 1 < argc) {
+            options.peerPort = argv[++i];
+        } else if (arg == "--baud" && i + 1 < argc) {
+            options.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--pattern" && i + 1 < argc) {
+            const int order = std::atoi(argv[++i]);
+            if (!CPrbsGenerator::isValidPattern(order)) {
+                printUsage();
+                return 2;
+            }
+            options.pattern = static_cast<CPrbsGenerator::Pattern>(order);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::atoi(argv[++i]);
+        } else if (options.port.empty() && arg[0] != '-') {
+            options.port = arg;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.selfTest) {
+        return runSelfTest();
+    }
+    if (options.port.empty() || options.baudRate == 0 || options.seconds <= 0) {
+        printUsage();
+        return 2;
+    }
+
+    boost::asio::io_context ioContext;
+    auto workGuard = boost::asio::make_work_guard(ioContext);
+    std::thread ioThread([&ioContext]() { ioContext.run(); });
+    int status = 0;
+    {
+        CSerialPortManager sender(ioContext);
+        CSerialPortManager peer(ioContext);
+        CSerialPortManager *receiver = &sender;
+        CPrbsTester tester(ioContext);
+        std::string error;
+        if (!sender.openPort(QString::fromStdString(options.port), static_cast<int>(options.baudRate), 8, 0, 1)) {
+            std::cerr << "failed to open " << options.port << "\n";
+            status = 1;
+        } else if (!options.peerPort.empty()) {
+            receiver = &peer;
+            if (!peer.openPort(QString::fromStdString(options.peerPort), static_cast<int>(options.baudRate), 8, 0, 1)) {
+                std::cerr << "failed to open " << options.peerPort << "\n";
+                status = 1;
+            }
+        }
+        CPrbsTester::Options testOptions;
+        testOptions.pattern = options.pattern;
+        if (status == 0 && !tester.start(&sender, receiver, testOptions, &error)) {
+            std::cerr << error << "\n";
+            status = 1;
+        }
+        if (status == 0) {
+            std::printf("PRBS-%d at %u baud on %s -> %s for %d s\n", static_cast<int>(options.pattern),
+                        options.baudRate, options.port.c_str(),
+                        options.peerPort.empty() ? options.port.c_str() : options.peerPort.c_str(), options.seconds);
+            for (int second = 1; second <= options.seconds; ++second) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                printStats(std::to_string(second).c_str(), tester.stats());
+            }
+            tester.stop();
+            const CPrbsTester::Stats stats = tester.stats();
+            printStats("total", stats);
+            std::printf("unchecked %llu bytes while acquiring, %llu bytes in flight at stop, %llu latency samples\n",
+                        static_cast<unsigned long long>(stats.checker.uncheckedBytes),
+                        static_cast<unsigned long long>(stats.pendingBytes),
+                        static_cast<unsigned long long>(stats.latencySamples));
+            if (stats.checker.bytes == 0 || stats.checker.checkedBits == 0) {
+                std::cerr << "no PRBS data received\n";
+                status = 1;
+            }
+        }
+        tester.stop();
+        sender.closePort();
+        peer.closePort();
+    }
+    workGuard.reset();
+    ioThread.join();
+    return status;
+}
@@ -0,0 +1,221 @@
+// SerialReadBench：比较固定大小与自适应大小的 async_read_some 在持续数据流下每 MB 的完成次数。
+// 数据由本工具从 --writer 指定的串口（零调制解调器线连到读取口）写出；
+// 省略 --writer 时在同一设备上再打开一次写出，需要回环插头（Windows 上串口独占，必须指定 --writer）。
+#include "creadsizer.h"
+#include "cserialtuning.h"
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr auto kIdleTimeout = std::chrono::seconds(2);
+constexpr size_t kWriteBlockSize = 4096;
+
+struct Options
+{
+    std::string readerPort;
+    std::string writerPort;
+    unsigned baudRate = 115200;
+    size_t megabytes = 4;
+    size_t fixedSize = 1024;
+    size_t maxReadSize = CReadSizer::kDefaultMaxSize;
+    bool runFixed = true;
+    bool runAdaptive = true;
+};
+
+struct Result
+{
+    unsigned long long completions = 0;
+    unsigned long long bytes = 0;
+    double seconds = 0.0;
+    size_t finalReadSize = 0;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialReadBench <reader-port> [--writer <port>] [--baud <rate>] [--megabytes <n>]\n"
+                 "                       [--fixed-size <bytes>] [--max-read <bytes>] [--sizing fixed|adaptive|both]\n"
+                 "  --writer      port that streams the test data (defaults to <reader-port> again,\n"
+                 "                which needs a loopback plug)\n"
+                 "  --fixed-size  request size of the fixed strategy (default 1024, the old behaviour)\n"
+                 "  --max-read    upper bound of the adaptive strategy (default 65536)\n";
+}
+
+bool openPort(boost::asio::serial_port &port, const std::string &name, unsigned baudRate, std::string &error)
+{
+    boost::system::error_code ec;
+    port.open(name, ec);
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::character_size(8), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::parity(boost::asio::serial_port::parity::none), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::stop_bits(boost::asio::serial_port::stop_bits::one), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::flow_control(boost::asio::serial_port::flow_control::none), ec);
+    }
+    if (ec) {
+        error = name + ": " + ec.message();
+        return false;
+    }
+    if (!SerialTuning::setBaudRate(port.native_handle(), baudRate, &error)
+        || !SerialTuning::flushInput(port.native_handle(), &error)) {
+        error = name + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+bool runStrategy(const Options &options, bool adaptive, Result &result)
+{
+    boost::asio::io_context ioContext;
+    boost::asio::serial_port reader(ioContext);
+    boost::asio::io_context writerContext;
+    boost::asio::serial_port writer(writerContext);
+    std::string error;
+    if (!openPort(reader, options.readerPort, options.baudRate, error)
+        || !openPort(writer, options.writerPort.empty() ? options.readerPort : options.writerPort, options.baudRate, error)) {
+        std::cerr << error << "\n";
+        return false;
+    }
+
+    CReadSizer sizer(options.maxReadSize);
+    sizer.setBaudRate(options.baudRate);
+    std::vector<char> buffer(adaptive ? sizer.maxSize() : options.fixedSize);
+    const unsigned long long total = static_cast<unsigned long long>(options.megabytes) << 20;
+
+    auto lastProgress = std::chrono::steady_clock::now();
+    std::function<void()> arm = [&]() {
+        const size_t request = adaptive ? sizer.size() : options.fixedSize;
+        reader.async_read_some(boost::asio::buffer(buffer.data(), request),
+                               [&](const boost::system::error_code &error, size_t bytesTransferred) {
+                                   if (error) {
+                                       return;
+                                   }
+                                   ++result.completions;
+                                   result.bytes += bytesTransferred;
+                                   lastProgress = std::chrono::steady_clock::now();
+                                   if (adaptive) {
+                                       sizer.record(bytesTransferred);
+                                   }
+                                   if (result.bytes < total) {
+                                       arm();
+                                   }
+                               });
+    };
+
+    bool writeFailed = false;
+    std::thread writerThread([&]() {
+        std::vector<char> block(kWriteBlockSize);
+        for (size_t i = 0; i < block.size(); ++i) {
+            block[i] = static_cast<char>(i);
+        }
+        boost::system::error_code ec;
+        for (unsigned long long written = 0; written < total && !ec; written += block.size()) {
+            boost::asio::write(writer, boost::asio::buffer(block.data(),
+                                                           static_cast<size_t>(std::min<unsigned long long>(block.size(), total - written))),
+                               ec);
+        }
+        writeFailed = static_cast<bool>(ec);
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    arm();
+    while (result.bytes < total && std::chrono::steady_clock::now() - lastProgress < kIdleTimeout) {
+        ioContext.run_for(std::chrono::milliseconds(100));
+    }
+    result.seconds = std::chrono::duration<double>(lastProgress - start).count();
+    result.finalReadSize = adaptive ? sizer.size() : options.fixedSize;
+    reader.cancel();
+    ioContext.restart();
+    ioContext.run();
+    writerThread.join();
+    if (writeFailed) {
+        std::cerr << "write failed\n";
+        return false;
+    }
+    if (result.bytes < total) {
+        std::cerr << "stream stalled after " << result.bytes << " bytes\n";
+    }
+    return true;
+}
+
+void printResult(const char *name, const Result &result)
+{
+    const double megabytes = static_cast<double>(result.bytes) / (1 << 20);
+    std::printf("%-9s %12llu %10.1f %12.1f %10.2f %10zu\n", name, result.completions,
+                megabytes > 0 ? result.completions / megabytes : 0.0,
+                result.completions > 0 ? static_cast<double>(result.bytes) / result.completions : 0.0,
+                result.seconds > 0 ? megabytes / result.seconds : 0.0, result.finalReadSize);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--writer" && i + 1 < argc) {
+            options.writerPort = argv[++i];
+        } else if (arg == "--baud" && i + 1 < argc) {
+            options.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--megabytes" && i + 1 < argc) {
+            options.megabytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--fixed-size" && i + 1 < argc) {
+            options.fixedSize = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-read" && i + 1 < argc) {
+            options.maxReadSize = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--sizing" && i + 1 < argc) {
+            const std::string sizing = argv[++i];
+            options.runFixed = sizing == "fixed" || sizing == "both";
+            options.runAdaptive = sizing == "adaptive" || sizing == "both";
+            if (!options.runFixed && !options.runAdaptive) {
+                printUsage();
+                return 2;
+            }
+        } else if (options.readerPort.empty() && arg[0] != '-') {
+            options.readerPort = arg;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.readerPort.empty() || options.baudRate == 0 || options.megabytes == 0 || options.fixedSize == 0) {
+        printUsage();
+        return 2;
+    }
+
+    std::printf("%zu MiB at %u baud\n", options.megabytes, options.baudRate);
+    std::printf("%-9s %12s %10s %12s %10s %10s\n", "sizing", "completions", "per MiB", "bytes/read", "MiB/s",
+                "read size");
+    int status = 0;
+    Result result;
+    if (options.runFixed) {
+        if (runStrategy(options, false, result)) {
+            printResult("fixed", result);
+        } else {
+            status = 1;
+        }
+    }
+    if (options.runAdaptive) {
+        result = Result();
+        if (runStrategy(options, true, result)) {
+            printResult("adaptive", result);
+        } else {
+            status = 1;
+        }
+    }
+    return status;
+}
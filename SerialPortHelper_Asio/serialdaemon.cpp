@@ -0,0 +1,571 @@
+// SerialPortDaemon：无界面运行串口引擎，用于没有显示器的测试机架，图形界面只是可选的前端。
+// 只依赖 Qt Core（QCoreApplication 事件循环、QSettings 读配置），不加载窗口系统，启动只需几毫秒。
+// 串口来自 INI 配置文件（--config）或命令行（--port，可重复），每个口可以录制、与另一个口桥接转发、
+// 以 TCP / 共享内存共享、开机发送一帧并周期发送若干帧。指标按固定间隔以 JSON 行写到标准输出，错误写到标准错误。
+// 串口的插入、拔出也以 JSON 行写到标准输出。读写出错或拔出的串口随即关闭，按退避重新打开（reconnect=0 关闭），
+// 重新打开后恢复桥接与周期发送。
+//
+// 命令行：--port <device>[,key=value...]，例如
+//   SerialPortDaemon --port /dev/ttyUSB0,name=rx,baud=115200,record=rx.spcap,shm=sph-rx
+//                    --port /dev/ttyUSB1,name=tx,baud=115200,periodic=01030000000AC5CD@100ms
+// 配置文件：每个分组是一个串口，分组名即名称，键与命令行相同；多个周期帧用逗号分隔：
+//   interval=1000
+//   [rx]
+//   device=/dev/ttyUSB0
+//   baud=115200
+//   bridge=tx
+//   periodic=AA55@10ms, 0102@1s
+#include "cportwatcher.h"
+#include "cserialportregistry.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr int kDefaultMetricsIntervalMs = 1000;
+constexpr int kStopPollIntervalMs = 100;
+
+std::atomic<bool> g_IsStopRequested{false};
+
+void requestStop(int)
+{
+    g_IsStopRequested.store(true);
+}
+
+struct PeriodicFrame
+{
+    QByteArray frame;
+    std::chrono::microseconds period{0};
+    int taskId = -1;
+};
+
+struct PortConfig
+{
+    QString name;
+    QString device;
+    int baudRate = 115200;
+    int dataBits = 8;
+    int parity = 0;        // 取值同 QSerialPort::Parity
+    int stopBits = 1;      // 取值同 QSerialPort::StopBits（1.5 为 3）
+    int flowControl = 0;   // 取值同 QSerialPort::FlowControl
+    SerialTuning::LatencyMode latency = SerialTuning::DefaultLatency;
+    QString recordPath;
+    QString bridgePeer;
+    int tcpPort = -1;      // -1 不共享，0 由系统分配
+    QString tcpAddress = "127.0.0.1";
+    QString shmName;
+    QByteArray initialFrame;
+    std::vector<PeriodicFrame> periodic;
+    bool reconnect = true;
+};
+
+struct PortState
+{
+    PortConfig config;
+    int id = 0;
+    quint64 lastCompletions = 0;
+    quint64 lastDeliveries = 0;
+    quint64 lastBytes = 0;
+};
+
+void printError(const QString &message)
+{
+    std::fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+}
+
+bool parseHex(const QString &value, QByteArray &frame)
+{
+    QString digits = value;
+    digits.remove(' ');
+    frame = QByteArray::fromHex(digits.toLatin1());
+    return !frame.isEmpty() && frame.size() * 2 == digits.size();
+}
+
+// 接受 500us / 100ms / 2s，不带单位按毫秒
+bool parsePeriod(const QString &value, std::chrono::microseconds &period)
+{
+    QString number = value.trimmed();
+    qint64 scale = 1000;
+    if (number.endsWith("us")) {
+        scale = 1;
+        number.chop(2);
+    } else if (number.endsWith("ms")) {
+        number.chop(2);
+    } else if (number.endsWith("s")) {
+        scale = 1000000;
+        number.chop(1);
+    }
+    bool ok = false;
+    const double amount = number.toDouble(&ok);
+    if (!ok || amount <= 0.0) {
+        return false;
+    }
+    period = std::chrono::microseconds(static_cast<qint64>(amount * static_cast<double>(scale)));
+    return period.count() > 0;
+}
+
+bool applyPortSetting(PortConfig &config, const QString &key, const QString &rawValue, QString *error)
+{
+    const QString value = rawValue.trimmed();
+    bool ok = true;
+    if (key == "device") {
+        config.device = value;
+    } else if (key == "name") {
+        config.name = value;
+    } else if (key == "baud") {
+        config.baudRate = value.toInt(&ok);
+        ok = ok && config.baudRate > 0;
+    } else if (key == "dataBits") {
+        config.dataBits = value.toInt(&ok);
+        ok = ok && config.dataBits >= 5 && config.dataBits <= 8;
+    } else if (key == "parity") {
+        // boost::asio 的串口不支持 space / mark 校验，按非法值拒绝
+        static const std::map<QString, int> parities = {{"none", 0}, {"even", 2}, {"odd", 3}};
+        auto it = parities.find(value.toLower());
+        ok = it != parities.end();
+        config.parity = ok ? it->second : 0;
+    } else if (key == "stopBits") {
+        ok = value == "1" || value == "1.5" || value == "2";
+        config.stopBits = value == "1.5" ? 3 : value.toInt();
+    } else if (key == "flow") {
+        static const std::map<QString, int> flows = {{"none", 0}, {"rtscts", 1}, {"xonxoff", 2}};
+        auto it = flows.find(value.toLower());
+        ok = it != flows.end();
+        config.flowControl = ok ? it->second : 0;
+    } else if (key == "latency") {
+        ok = SerialTuning::parseLatencyMode(value.toStdString(), config.latency);
+    } else if (key == "record") {
+        config.recordPath = value;
+    } else if (key == "bridge") {
+        config.bridgePeer = value;
+    } else if (key == "tcp") {
+        config.tcpPort = value.toInt(&ok);
+        ok = ok && config.tcpPort >= 0 && config.tcpPort <= 65535;
+    } else if (key == "tcpAddress") {
+        config.tcpAddress = value;
+    } else if (key == "shm") {
+        config.shmName = value;
+    } else if (key == "reconnect") {
+        const QString flag = value.toLower();
+        ok = flag == "1" || flag == "true" || flag == "on" || flag == "0" || flag == "false" || flag == "off";
+        config.reconnect = flag == "1" || flag == "true" || flag == "on";
+    } else if (key == "send") {
+        ok = parseHex(value, config.initialFrame);
+    } else if (key == "periodic") {
+        // <hex>@<period>
+        const int at = value.lastIndexOf('@');
+        PeriodicFrame periodic;
+        ok = at > 0 && parseHex(value.left(at), periodic.frame) && parsePeriod(value.mid(at + 1), periodic.period);
+        if (ok) {
+            config.periodic.push_back(periodic);
+        }
+    } else {
+        if (error) {
+            *error = QString("Unknown port setting: %1").arg(key);
+        }
+        return false;
+    }
+    if (!ok && error) {
+        *error = QString("Invalid value for %1: %2").arg(key, value);
+    }
+    return ok;
+}
+
+bool parsePortSpec(const QString &spec, PortConfig &config, QString *error)
+{
+    const QStringList items = spec.split(',', Qt::SkipEmptyParts);
+    for (int i = 0; i < items.size(); ++i) {
+        const int equals = items[i].indexOf('=');
+        if (equals < 0) {
+            if (i != 0) {
+                if (error) {
+                    *error = QString("Expected key=value in port spec: %1").arg(items[i]);
+                }
+                return false;
+            }
+            config.device = items[i].trimmed();
+            continue;
+        }
+        if (!applyPortSetting(config, items[i].left(equals).trimmed(), items[i].mid(equals + 1), error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadConfig(const QString &path, std::vector<PortConfig> &ports, int &metricsIntervalMs, QString *error)
+{
+    if (!QFileInfo::exists(path)) {
+        if (error) {
+            *error = QString("Config file not found: %1").arg(path);
+        }
+        return false;
+    }
+    QSettings settings(path, QSettings::IniFormat);
+    if (settings.status() != QSettings::NoError) {
+        if (error) {
+            *error = QString("Cannot parse config file: %1").arg(path);
+        }
+        return false;
+    }
+    metricsIntervalMs = settings.value("interval", metricsIntervalMs).toInt();
+    for (const QString &group : settings.childGroups()) {
+        PortConfig config;
+        config.name = group;
+        settings.beginGroup(group);
+        for (const QString &key : settings.childKeys()) {
+            // 含逗号的值被 QSettings 解析为列表，逐项应用（多个周期帧）
+            const QVariant value = settings.value(key);
+            const QStringList values =
+                value.userType() == QMetaType::QStringList ? value.toStringList() : QStringList{value.toString()};
+            for (const QString &item : values) {
+                if (!applyPortSetting(config, key, item, error)) {
+                    settings.endGroup();
+                    if (error) {
+                        *error = QString("[%1] %2").arg(group, *error);
+                    }
+                    return false;
+                }
+            }
+        }
+        settings.endGroup();
+        ports.push_back(config);
+    }
+    return true;
+}
+
+QJsonObject portMetrics(CSerialPortRegistry &registry, PortState &state, const CSerialPortRegistry::PortMetrics &metrics,
+                        double seconds)
+{
+    CSerialPortManager *manager = registry.port(state.id);
+    auto delta = [](quint64 current, quint64 &last) {
+        const quint64 value = current >= last ? current - last : current;
+        last = current;
+        return value;
+    };
+    QJsonObject object{
+        {"port", state.config.name},
+        {"device", metrics.portName},
+        {"open", metrics.isOpen},
+        {"baud", static_cast<qint64>(metrics.baudRate)},
+        {"rxBytes", static_cast<qint64>(metrics.read.bytes)},
+        {"rxKBps", static_cast<double>(delta(metrics.read.bytes, state.lastBytes)) / 1024.0 / seconds},
+        {"readsPerS", static_cast<double>(delta(metrics.read.completions, state.lastCompletions)) / seconds},
+        {"deliveriesPerS", static_cast<double>(delta(metrics.read.deliveries, state.lastDeliveries)) / seconds},
+        {"writeQueueBytes", static_cast<qint64>(metrics.writeQueueBytes)},
+        {"throttled", metrics.isWriteThrottled},
+        {"errors", static_cast<qint64>(metrics.errorCount)},
+    };
+    if (manager->isRecording()) {
+        object.insert("record", state.config.recordPath);
+    }
+    if (manager->isBridged()) {
+        const auto bridge = manager->bridgeStats();
+        object.insert("bridge", QJsonObject{
+                                    {"peer", state.config.bridgePeer},
+                                    {"forwardedBytes", static_cast<qint64>(bridge.forwardedBytes)},
+                                    {"droppedBytes", static_cast<qint64>(bridge.droppedBytes)},
+                                    {"stalls", static_cast<qint64>(bridge.stalls)},
+                                    {"meanLatencyUs", bridge.meanLatencyUs},
+                                    {"maxLatencyUs", bridge.maxLatencyUs},
+                                });
+    }
+    if (!state.config.periodic.empty()) {
+        QJsonArray periodic;
+        for (const PeriodicFrame &frame : state.config.periodic) {
+            const auto stats = manager->periodicStats(frame.taskId);
+            periodic.append(QJsonObject{
+                {"periodUs", static_cast<qint64>(frame.period.count())},
+                {"sent", static_cast<qint64>(stats.sent)},
+                {"missed", static_cast<qint64>(stats.missed)},
+                {"throttled", static_cast<qint64>(stats.throttled)},
+                {"meanLateUs", stats.meanLatenessUs},
+                {"maxLateUs", stats.maxLatenessUs},
+            });
+        }
+        object.insert("periodic", periodic);
+    }
+    if (metrics.tcpPort != 0) {
+        object.insert("tcp", QJsonObject{{"port", metrics.tcpPort}, {"clients", static_cast<qint64>(metrics.tcpClients)}});
+    }
+    if (metrics.reconnect.outages > 0) {
+        object.insert("reconnect", QJsonObject{
+                                       {"reconnecting", metrics.reconnect.isReconnecting},
+                                       {"outages", static_cast<qint64>(metrics.reconnect.outages)},
+                                       {"reconnects", static_cast<qint64>(metrics.reconnect.reconnects)},
+                                       {"attempts", static_cast<qint64>(metrics.reconnect.attempts)},
+                                       {"lastOutageMs", metrics.reconnect.lastOutageMs},
+                                       {"maxOutageMs", metrics.reconnect.maxOutageMs},
+                                       {"totalOutageMs", metrics.reconnect.totalOutageMs},
+                                       {"currentOutageMs", metrics.reconnect.currentOutageMs},
+                                       {"lastError", metrics.reconnect.lastError},
+                                   });
+    }
+    if (!metrics.shmName.isEmpty()) {
+        object.insert("shm", QJsonObject{
+                                 {"name", metrics.shmName},
+                                 {"readers", static_cast<qint64>(metrics.shm.readers)},
+                                 {"maxLagBytes", static_cast<qint64>(metrics.shm.maxLagBytes)},
+                                 {"overruns", static_cast<qint64>(metrics.shm.readerOverruns)},
+                                 {"lostBytes", static_cast<qint64>(metrics.shm.readerLostBytes)},
+                             });
+    }
+    return object;
+}
+
+void printDeviceEvents(const char *event, const QStringList &devices)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const QString &device : devices) {
+        const QJsonObject object{{"t", now}, {"event", event}, {"device", device}};
+        std::printf("%s\n", QJsonDocument(object).toJson(QJsonDocument::Compact).constData());
+    }
+    std::fflush(stdout);
+}
+
+void printMetrics(CSerialPortRegistry &registry, std::vector<PortState> &ports, double seconds)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const auto metrics = registry.metrics();
+    for (PortState &state : ports) {
+        for (const auto &port : metrics) {
+            if (port.id != state.id) {
+                continue;
+            }
+            QJsonObject object = portMetrics(registry, state, port, seconds);
+            object.insert("t", now);
+            std::printf("%s\n", QJsonDocument(object).toJson(QJsonDocument::Compact).constData());
+        }
+    }
+    std::fflush(stdout);
+}
+
+// 按配置打开串口并接好录制、桥接、共享与周期发送；任何一步失败都返回 false，测试机架上宁可启动失败也不带病运行
+bool startPorts(CSerialPortRegistry &registry, std::vector<PortState> &ports)
+{
+    std::map<QString, int> ids;
+    for (PortState &state : ports) {
+        const PortConfig &config = state.config;
+        state.id = registry.addPort(config.name);
+        registry.setAutoReconnect(state.id, config.reconnect);
+        ids[config.name] = state.id;
+        if (!registry.port(state.id)->openPort(config.device, config.baudRate, config.dataBits, config.parity,
+                                               config.stopBits, config.flowControl, config.latency)) {
+            printError(QString("%1: failed to open %2").arg(config.name, config.device));
+            return false;
+        }
+        if (!config.recordPath.isEmpty() && !registry.port(state.id)->startRecording(config.recordPath)) {
+            return false;
+        }
+    }
+    for (PortState &state : ports) {
+        PortConfig &config = state.config;
+        CSerialPortManager *manager = registry.port(state.id);
+        if (!config.bridgePeer.isEmpty() && !manager->isBridged()) {
+            auto peer = ids.find(config.bridgePeer);
+            if (peer == ids.end()) {
+                printError(QString("%1: unknown bridge peer %2").arg(config.name, config.bridgePeer));
+                return false;
+            }
+            if (!manager->startBridge(registry.port(peer->second))) {
+                return false;
+            }
+        }
+        if (config.tcpPort >= 0) {
+            const unsigned short port = registry.startTcpServer(state.id, config.tcpAddress,
+                                                                static_cast<unsigned short>(config.tcpPort));
+            if (port == 0) {
+                return false;
+            }
+            std::fprintf(stderr, "%s: sharing on tcp %s:%u\n", config.name.toLocal8Bit().constData(),
+                         config.tcpAddress.toLocal8Bit().constData(), port);
+        }
+        if (!config.shmName.isEmpty() && !registry.startSharedMemory(state.id, config.shmName)) {
+            return false;
+        }
+        if (!config.initialFrame.isEmpty() && !manager->sendData(config.initialFrame)) {
+            printError(QString("%1: failed to send the initial frame").arg(config.name));
+            return false;
+        }
+        for (PeriodicFrame &frame : config.periodic) {
+            frame.taskId = manager->startPeriodicSend(frame.frame, frame.period);
+            if (frame.taskId < 0) {
+                printError(QString("%1: failed to start a periodic frame").arg(config.name));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 重新打开的串口恢复桥接（无论它是发起方还是被桥接的一方）和周期发送；对端尚未恢复时等对端重连后再接上
+void restorePort(CSerialPortRegistry &registry, std::vector<PortState> &ports, int id)
+{
+    auto findPort = [&ports](const QString &name) -> PortState * {
+        for (PortState &state : ports) {
+            if (state.config.name == name) {
+                return &state;
+            }
+        }
+        return nullptr;
+    };
+    for (PortState &state : ports) {
+        const PortState *peer = findPort(state.config.bridgePeer);
+        if (peer == nullptr || (state.id != id && peer->id != id)) {
+            continue;
+        }
+        CSerialPortManager *manager = registry.port(state.id);
+        CSerialPortManager *peerManager = registry.port(peer->id);
+        if (manager->isOpen() && peerManager->isOpen() && !manager->isBridged()) {
+            manager->startBridge(peerManager);
+        }
+    }
+    auto state = std::find_if(ports.begin(), ports.end(), [id](const PortState &port) { return port.id == id; });
+    if (state == ports.end()) {
+        return;
+    }
+    CSerialPortManager *manager = registry.port(id);
+    for (PeriodicFrame &frame : state->config.periodic) {
+        frame.taskId = manager->startPeriodicSend(frame.frame, frame.period);
+        if (frame.taskId < 0) {
+            printError(QString("%1: failed to restart a periodic frame").arg(state->config.name));
+        }
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("SerialPortDaemon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs serial ports without a GUI and prints metrics as JSON lines.");
+    parser.addHelpOption();
+    const QCommandLineOption configOption({"c", "config"}, "INI file, one group per port.", "file");
+    const QCommandLineOption portOption({"p", "port"},
+                                        "Port spec <device>[,key=value...]; keys: name, baud, dataBits, parity, "
+                                        "stopBits, flow, latency, record, bridge, tcp, tcpAddress, shm, send, periodic, reconnect.",
+                                        "spec");
+    const QCommandLineOption intervalOption({"i", "interval"}, "Metrics interval in ms, 0 disables (default 1000).",
+                                            "ms");
+    const QCommandLineOption durationOption({"d", "duration"}, "Exit after this many seconds.", "s");
+    parser.addOptions({configOption, portOption, intervalOption, durationOption});
+    parser.process(app);
+
+    std::vector<PortConfig> configs;
+    int metricsIntervalMs = kDefaultMetricsIntervalMs;
+    QString error;
+    if (parser.isSet(configOption) && !loadConfig(parser.value(configOption), configs, metricsIntervalMs, &error)) {
+        printError(error);
+        return 2;
+    }
+    for (const QString &spec : parser.values(portOption)) {
+        PortConfig config;
+        if (!parsePortSpec(spec, config, &error)) {
+            printError(error);
+            return 2;
+        }
+        configs.push_back(config);
+    }
+    if (parser.isSet(intervalOption)) {
+        metricsIntervalMs = parser.value(intervalOption).toInt();
+    }
+    std::vector<PortState> ports;
+    for (PortConfig &config : configs) {
+        if (config.device.isEmpty()) {
+            printError(QString("Port %1 has no device").arg(config.name));
+            return 2;
+        }
+        if (config.name.isEmpty()) {
+            config.name = QFileInfo(config.device).fileName();
+        }
+        PortState state;
+        state.config = config;
+        ports.push_back(state);
+    }
+    if (ports.empty()) {
+        parser.showHelp(2);
+    }
+
+    CSerialPortRegistry registry;
+    QObject::connect(&registry, &CSerialPortRegistry::signal_PortError, [&registry](int id, const QString &message) {
+        printError(QString("%1: %2").arg(registry.label(id), message));
+    });
+    QObject::connect(&registry, &CSerialPortRegistry::signal_PortReconnected, [&registry, &ports](int id) {
+        const auto metrics = registry.metrics();
+        for (const auto &port : metrics) {
+            if (port.id != id) {
+                continue;
+            }
+            const QJsonObject object{{"t", QDateTime::currentMSecsSinceEpoch()},
+                                     {"event", "reconnected"},
+                                     {"port", port.label},
+                                     {"outageMs", port.reconnect.lastOutageMs},
+                                     {"attempts", static_cast<qint64>(port.reconnect.attempts)}};
+            std::printf("%s\n", QJsonDocument(object).toJson(QJsonDocument::Compact).constData());
+            std::fflush(stdout);
+        }
+        restorePort(registry, ports, id);
+    });
+    if (!startPorts(registry, ports)) {
+        // 让排队中的错误信号先打印出来
+        QCoreApplication::processEvents();
+        return 1;
+    }
+
+    // 第一次枚举报告的是启动时已有的串口，不算插入
+    CPortWatcher watcher;
+    bool isFirstScan = true;
+    QObject::connect(&watcher, &CPortWatcher::signal_PortsChanged, &registry,
+                     [&isFirstScan](const QStringList &added, const QStringList &removed) {
+                         if (!std::exchange(isFirstScan, false)) {
+                             printDeviceEvents("added", added);
+                         }
+                         printDeviceEvents("removed", removed);
+                     });
+    QObject::connect(&watcher, &CPortWatcher::signal_PortsChanged, &registry, &CSerialPortRegistry::handlePortsChanged);
+    watcher.start();
+
+    QTimer metricsTimer;
+    if (metricsIntervalMs > 0) {
+        QObject::connect(&metricsTimer, &QTimer::timeout, [&]() {
+            printMetrics(registry, ports, metricsIntervalMs / 1000.0);
+        });
+        metricsTimer.start(metricsIntervalMs);
+    }
+    // 信号处理函数里只能置标志，由事件循环轮询后正常退出，录制文件得以完整关闭
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    QTimer stopTimer;
+    QObject::connect(&stopTimer, &QTimer::timeout, [&app]() {
+        if (g_IsStopRequested.load()) {
+            app.quit();
+        }
+    });
+    stopTimer.start(kStopPollIntervalMs);
+    if (parser.isSet(durationOption)) {
+        QTimer::singleShot(static_cast<int>(parser.value(durationOption).toDouble() * 1000), &app,
+                           &QCoreApplication::quit);
+    }
+
+    const int status = app.exec();
+    watcher.stop();
+    registry.closeAll();
+    return status;
+}
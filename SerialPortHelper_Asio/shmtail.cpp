@@ -0,0 +1,246 @@
+// SerialShmTail：共享内存环的读取客户端，也是其他分析程序接入的示例。
+// 默认把每条记录按“时间戳 长度: HEX”打印；--raw 把负载原样写到标准输出，便于接管道；--stats 每秒打印吞吐与丢失。
+// --bench 在进程内起一个发布线程和若干读取线程（各自按名称打开映射，与跨进程相同），测读取端吞吐，
+// 并可加一个故意很慢的读取端，验证它被跳过而不拖慢发布端和其他读取端。
+#include "cshmring.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// 没有新数据时先忙等这么多次再睡眠，数据连续到达时读取端不进内核
+constexpr int kSpinPolls = 2000;
+constexpr auto kIdleSleep = std::chrono::microseconds(50);
+
+struct Options
+{
+    std::string name;
+    bool raw = false;
+    bool stats = false;
+    bool bench = false;
+    size_t readers = 2;
+    size_t megabytes = 256;
+    size_t chunkSize = 4096;
+    uint64_t capacity = ShmRingFormat::kDefaultCapacity;
+    bool slowReader = false;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialShmTail <name> [--raw] [--stats]\n"
+                 "       SerialShmTail <name> --bench [--readers <n>] [--megabytes <n>] [--chunk <bytes>]\n"
+                 "                            [--capacity <bytes>] [--slow-reader]\n"
+                 "  <name>         shared memory name shown in the multi-port window\n"
+                 "  --raw          write payloads to stdout unmodified\n"
+                 "  --stats        print throughput and lost bytes once per second instead of data\n"
+                 "  --bench        publish from this process and measure reader throughput\n"
+                 "  --slow-reader  add a reader that sleeps 1 ms per record and gets skipped\n";
+}
+
+void idle(int &idlePolls)
+{
+    if (++idlePolls > kSpinPolls) {
+        std::this_thread::sleep_for(kIdleSleep);
+    }
+}
+
+int runTail(const Options &options)
+{
+    CShmRingReader reader;
+    std::string error;
+    if (!reader.open(options.name, &error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    auto lastReport = std::chrono::steady_clock::now();
+    CShmRingReader::Stats lastStats;
+    int idlePolls = 0;
+    const CShmRingReader::Handler print = [&](const char *data, size_t size, uint64_t timestampNs) {
+        if (options.stats) {
+            return;
+        }
+        if (options.raw) {
+            std::fwrite(data, 1, size, stdout);
+            return;
+        }
+        std::printf("%llu.%09llu %zu:", static_cast<unsigned long long>(timestampNs / 1000000000ULL),
+                    static_cast<unsigned long long>(timestampNs % 1000000000ULL), size);
+        for (size_t i = 0; i < size; ++i) {
+            std::printf(" %02X", static_cast<unsigned char>(data[i]));
+        }
+        std::printf("\n");
+    };
+    while (!reader.isFinished()) {
+        if (reader.poll(print) > 0) {
+            idlePolls = 0;
+        } else {
+            std::fflush(stdout);
+            idle(idlePolls);
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (options.stats && now - lastReport >= std::chrono::seconds(1)) {
+            const CShmRingReader::Stats stats = reader.stats();
+            const double seconds = std::chrono::duration<double>(now - lastReport).count();
+            std::printf("%10.2f KiB/s %10.0f records/s  backlog %8llu  overruns %llu  lost %llu bytes\n",
+                        static_cast<double>(stats.bytes - lastStats.bytes) / 1024.0 / seconds,
+                        static_cast<double>(stats.records - lastStats.records) / seconds,
+                        static_cast<unsigned long long>(reader.backlog()),
+                        static_cast<unsigned long long>(stats.overruns),
+                        static_cast<unsigned long long>(stats.lostBytes));
+            std::fflush(stdout);
+            lastStats = stats;
+            lastReport = now;
+        }
+    }
+    return 0;
+}
+
+struct ReaderResult
+{
+    CShmRingReader::Stats stats;
+    uint64_t badRecords = 0;
+    double seconds = 0.0;
+};
+
+int runBench(const Options &options)
+{
+    CShmRingPublisher publisher;
+    std::string error;
+    if (!publisher.open(options.name, options.capacity, &error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    const uint64_t capacity = publisher.capacity();
+    if (options.chunkSize > capacity / 4 - ShmRingFormat::kRecordHeaderSize) {
+        // 更大的块会被拆成多条记录，校验图案对不上
+        std::cerr << "--chunk must not exceed a quarter of the ring\n";
+        return 2;
+    }
+    const size_t readerCount = options.readers + (options.slowReader ? 1 : 0);
+    std::vector<CShmRingReader> readers(readerCount);
+    for (auto &reader : readers) {
+        if (!reader.open(options.name, &error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    // 每条记录的首字节是序号的低 8 位，其余字节由首字节推出，读取端据此校验没有读到撕裂的记录
+    std::vector<ReaderResult> results(readerCount);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < readerCount; ++i) {
+        threads.emplace_back([&, i]() {
+            const bool isSlow = options.slowReader && i == readerCount - 1;
+            CShmRingReader &reader = readers[i];
+            ReaderResult &result = results[i];
+            int idlePolls = 0;
+            const auto start = std::chrono::steady_clock::now();
+            const CShmRingReader::Handler check = [&](const char *data, size_t size, uint64_t) {
+                for (size_t j = 1; j < size; ++j) {
+                    if (data[j] != static_cast<char>(data[0] + j)) {
+                        ++result.badRecords;
+                        break;
+                    }
+                }
+                if (isSlow) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            };
+            while (!reader.isFinished()) {
+                if (reader.poll(check) > 0) {
+                    idlePolls = 0;
+                } else {
+                    idle(idlePolls);
+                }
+            }
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.stats = reader.stats();
+        });
+    }
+
+    const uint64_t total = static_cast<uint64_t>(options.megabytes) << 20;
+    std::vector<char> chunk(options.chunkSize);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t sequence = 0;
+    for (uint64_t published = 0; published < total; published += chunk.size(), ++sequence) {
+        for (size_t j = 0; j < chunk.size(); ++j) {
+            chunk[j] = static_cast<char>(sequence + j);
+        }
+        const auto now = std::chrono::steady_clock::now();
+        publisher.publish(chunk.data(), chunk.size(),
+                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    now.time_since_epoch()).count()));
+    }
+    const double publishSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const CShmRingPublisher::Stats publisherStats = publisher.stats();
+    publisher.close();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::printf("%zu MiB in %zu-byte chunks, ring %llu KiB\n", options.megabytes, options.chunkSize,
+                static_cast<unsigned long long>(capacity / 1024));
+    std::printf("publisher  %10.1f MiB/s  (includes filling the test pattern)\n",
+                static_cast<double>(total) / (1 << 20) / publishSeconds);
+    std::printf("%-10s %12s %10s %10s %12s %8s\n", "reader", "records", "MiB/s", "overruns", "lost bytes", "bad");
+    int status = 0;
+    for (size_t i = 0; i < readerCount; ++i) {
+        const ReaderResult &result = results[i];
+        const bool isSlow = options.slowReader && i == readerCount - 1;
+        std::printf("%-10s %12llu %10.1f %10llu %12llu %8llu\n", isSlow ? "slow" : std::to_string(i).c_str(),
+                    static_cast<unsigned long long>(result.stats.records),
+                    result.seconds > 0 ? static_cast<double>(result.stats.bytes) / (1 << 20) / result.seconds : 0.0,
+                    static_cast<unsigned long long>(result.stats.overruns),
+                    static_cast<unsigned long long>(result.stats.lostBytes),
+                    static_cast<unsigned long long>(result.badRecords));
+        if (result.badRecords > 0) {
+            status = 1;
+        }
+    }
+    std::printf("publisher saw %u readers, %llu overruns\n", publisherStats.readers,
+                static_cast<unsigned long long>(publisherStats.readerOverruns));
+    return status;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--bench") {
+            options.bench = true;
+        } else if (arg == "--slow-reader") {
+            options.slowReader = true;
+        } else if (arg == "--readers" && i + 1 < argc) {
+            options.readers = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--megabytes" && i + 1 < argc) {
+            options.megabytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--chunk" && i + 1 < argc) {
+            options.chunkSize = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--capacity" && i + 1 < argc) {
+            options.capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (options.name.empty() && arg[0] != '-') {
+            options.name = arg;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.name.empty() || (options.bench && (options.megabytes == 0 || options.chunkSize == 0))) {
+        printUsage();
+        return 2;
+    }
+    return options.bench ? runBench(options) : runTail(options);
+}
@@ -0,0 +1,336 @@
+// SerialTcpBench：比较直接读写串口与经 CSerialTcpServer 走本机回环 TCP 的吞吐和往返时延。
+// <port> 由引擎打开并以 TCP 共享，--peer 是与它相连的另一端（零调制解调器线或 pty 对），
+// 本工具在对端上灌入/读出测试数据，并在往返测试中回显。
+#include "cserialportmanager.h"
+#include "cserialtcpserver.h"
+#include "cserialtuning.h"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t kWriteBlockSize = 4096;
+constexpr auto kIdleTimeout = std::chrono::seconds(5);
+
+using boost::asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string port;
+    std::string peerPort;
+    unsigned baudRate = 3000000;
+    size_t megabytes = 8;
+    int observers = 2;
+    int frames = 1000;
+    size_t frameSize = 16;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: SerialTcpBench <port> --peer <port> [--baud <rate>] [--megabytes <n>]\n"
+                 "                      [--observers <n>] [--frames <n>] [--size <bytes>]\n"
+                 "  <port>       port opened by the engine and shared over TCP on 127.0.0.1\n"
+                 "  --peer       the other end of a null-modem cable or pty pair, driven by this tool\n"
+                 "  --observers  read-only TCP clients in addition to the writer (default 2)\n"
+                 "  --frames     round trips measured per path (default 1000)\n";
+}
+
+char patternByte(unsigned long long offset)
+{
+    return static_cast<char>((offset * 7) & 0xff);
+}
+
+bool openRawPort(boost::asio::serial_port &port, const std::string &name, unsigned baudRate, std::string &error)
+{
+    boost::system::error_code ec;
+    port.open(name, ec);
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::character_size(8), ec);
+    }
+    if (!ec) {
+        port.set_option(boost::asio::serial_port::flow_control(boost::asio::serial_port::flow_control::none), ec);
+    }
+    if (ec) {
+        error = name + ": " + ec.message();
+        return false;
+    }
+    if (!SerialTuning::setBaudRate(port.native_handle(), baudRate, &error)
+        || !SerialTuning::flushInput(port.native_handle(), &error)) {
+        error = name + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+// 在 writer 上写出 total 字节的测试图样
+template <typename Stream>
+std::thread startPatternWriter(Stream &writer, unsigned long long total, std::atomic<bool> &failed)
+{
+    return std::thread([&writer, total, &failed]() {
+        std::vector<char> block(kWriteBlockSize);
+        boost::system::error_code ec;
+        for (unsigned long long written = 0; written < total && !ec;) {
+            const size_t size = static_cast<size_t>(std::min<unsigned long long>(block.size(), total - written));
+            for (size_t i = 0; i < size; ++i) {
+                block[i] = patternByte(written + i);
+            }
+            boost::asio::write(writer, boost::asio::buffer(block.data(), size), ec);
+            written += size;
+        }
+        if (ec) {
+            failed = true;
+        }
+    });
+}
+
+// 从 reader 读满 total 字节并校验图样，返回从 start 到读完的秒数，出错或超时返回负数
+template <typename Stream>
+double readPattern(Stream &reader, unsigned long long total, Clock::time_point start, unsigned long long &badBytes)
+{
+    std::vector<char> buffer(64 * 1024);
+    unsigned long long received = 0;
+    boost::system::error_code ec;
+    while (received < total) {
+        const size_t size = reader.read_some(boost::asio::buffer(buffer), ec);
+        if (ec) {
+            return -1.0;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            badBytes += buffer[i] != patternByte(received + i);
+        }
+        received += size;
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 在 requester 上逐帧发送、在 responder 上收到后回显，返回各次往返的微秒数
+template <typename Requester, typename ReplySource, typename Responder>
+std::vector<double> measureRoundTrips(Requester &requester, ReplySource &replySource, Responder &responder,
+                                      const Options &options)
+{
+    std::vector<double> samples;
+    std::atomic<bool> stop{false};
+    std::thread echo([&]() {
+        std::vector<char> buffer(options.frameSize);
+        boost::system::error_code ec;
+        for (int i = 0; i < options.frames && !stop; ++i) {
+            boost::asio::read(responder, boost::asio::buffer(buffer), ec);
+            if (ec) {
+                return;
+            }
+            boost::asio::write(responder, boost::asio::buffer(buffer), ec);
+        }
+    });
+    std::vector<char> request(options.frameSize, 0x5a);
+    std::vector<char> reply(options.frameSize);
+    boost::system::error_code ec;
+    for (int i = 0; i < options.frames; ++i) {
+        const auto start = Clock::now();
+        boost::asio::write(requester, boost::asio::buffer(request), ec);
+        if (!ec) {
+            boost::asio::read(replySource, boost::asio::buffer(reply), ec);
+        }
+        if (ec) {
+            break;
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    stop = true;
+    echo.join();
+    return samples;
+}
+
+void printRoundTrips(const char *name, std::vector<double> samples)
+{
+    if (samples.empty()) {
+        std::printf("%-24s %10s\n", name, "failed");
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    std::printf("%-24s %10.1f %10.1f %10.1f\n", name, samples[samples.size() / 2],
+                samples[std::min(samples.size() - 1, samples.size() * 99 / 100)], samples.back());
+}
+
+void printThroughput(const char *name, unsigned long long bytes, double seconds, unsigned long long badBytes)
+{
+    if (seconds <= 0.0) {
+        std::printf("%-24s %10s\n", name, "failed");
+        return;
+    }
+    std::printf("%-24s %10.2f %12llu\n", name, static_cast<double>(bytes) / (1 << 20) / seconds, badBytes);
+}
+
+bool connectClient(tcp::socket &socket, unsigned short port)
+{
+    boost::system::error_code ec;
+    socket.connect(tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), port), ec);
+    if (!ec) {
+        socket.set_option(tcp::no_delay(true), ec);
+    }
+    return !ec;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--peer" && i + 1 < argc) {
+            options.peerPort = argv[++i];
+        } else if (arg == "--baud" && i + 1 < argc) {
+            options.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--megabytes" && i + 1 < argc) {
+            options.megabytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--observers" && i + 1 < argc) {
+            options.observers = std::atoi(argv[++i]);
+        } else if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (arg == "--size" && i + 1 < argc) {
+            options.frameSize = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (options.port.empty() && arg[0] != '-') {
+            options.port = arg;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.port.empty() || options.peerPort.empty() || options.baudRate == 0 || options.megabytes == 0
+        || options.observers < 0 || options.frames <= 0 || options.frameSize == 0) {
+        printUsage();
+        return 2;
+    }
+    const unsigned long long total = static_cast<unsigned long long>(options.megabytes) << 20;
+
+    boost::asio::io_context rawContext;
+    boost::asio::serial_port peer(rawContext);
+    std::string error;
+    if (!openRawPort(peer, options.peerPort, options.baudRate, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    std::printf("%zu MiB at %u baud, %d observer(s), %d round trips of %zu bytes\n", options.megabytes,
+                options.baudRate, options.observers, options.frames, options.frameSize);
+    std::printf("%-24s %10s %12s\n", "throughput", "MiB/s", "bad bytes");
+
+    // 基准：不经引擎，直接读写串口
+    std::vector<double> directRoundTrips;
+    {
+        boost::asio::serial_port port(rawContext);
+        if (!openRawPort(port, options.port, options.baudRate, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::atomic<bool> failed{false};
+        unsigned long long badBytes = 0;
+        const auto start = Clock::now();
+        std::thread writer = startPatternWriter(peer, total, failed);
+        const double seconds = readPattern(port, total, start, badBytes);
+        writer.join();
+        printThroughput("direct serial", total, failed ? -1.0 : seconds, badBytes);
+        directRoundTrips = measureRoundTrips(port, port, peer, options);
+    }
+
+    // 引擎打开串口，在同一个 io_context 上以 TCP 共享
+    boost::asio::io_context ioContext;
+    auto workGuard = boost::asio::make_work_guard(ioContext);
+    std::thread ioThread([&ioContext]() { ioContext.run(); });
+    int status = 0;
+    {
+        CSerialPortManager manager(ioContext);
+        CSerialTcpServer server(ioContext);
+        if (!manager.openPort(QString::fromStdString(options.port), static_cast<int>(options.baudRate), 8, 0, 1)) {
+            std::cerr << "failed to open " << options.port << "\n";
+            status = 1;
+        } else if (!server.start(&manager, "127.0.0.1", 0, &error)) {
+            std::cerr << error << "\n";
+            status = 1;
+        }
+        boost::asio::io_context clientContext;
+        tcp::socket writerClient(clientContext);
+        std::vector<std::unique_ptr<tcp::socket>> observers;
+        if (status == 0 && !connectClient(writerClient, server.port())) {
+            std::cerr << "failed to connect to 127.0.0.1:" << server.port() << "\n";
+            status = 1;
+        }
+        for (int i = 0; status == 0 && i < options.observers; ++i) {
+            observers.push_back(std::make_unique<tcp::socket>(clientContext));
+            if (!connectClient(*observers.back(), server.port())) {
+                status = 1;
+            }
+        }
+        // 第一个连接是写入者，等所有连接都登记后再开始
+        const auto connectDeadline = Clock::now() + kIdleTimeout;
+        while (status == 0 && server.stats().clients < observers.size() + 1 && Clock::now() < connectDeadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (status == 0) {
+            // 串口 -> 所有 TCP 客户端
+            std::atomic<bool> failed{false};
+            std::vector<double> seconds(observers.size() + 1, -1.0);
+            std::vector<unsigned long long> badBytes(observers.size() + 1, 0);
+            const auto start = Clock::now();
+            std::vector<std::thread> readers;
+            readers.emplace_back([&]() { seconds[0] = readPattern(writerClient, total, start, badBytes[0]); });
+            for (size_t i = 0; i < observers.size(); ++i) {
+                readers.emplace_back([&, i]() { seconds[i + 1] = readPattern(*observers[i], total, start, badBytes[i + 1]); });
+            }
+            std::thread writer = startPatternWriter(peer, total, failed);
+            writer.join();
+            for (auto &reader : readers) {
+                reader.join();
+            }
+            const double slowest = *std::max_element(seconds.begin(), seconds.end());
+            const bool anyFailed = failed || *std::min_element(seconds.begin(), seconds.end()) < 0.0;
+            unsigned long long bad = 0;
+            for (auto value : badBytes) {
+                bad += value;
+            }
+            printThroughput("serial -> tcp (all)", total, anyFailed ? -1.0 : slowest, bad);
+
+            // 写入者 TCP 客户端 -> 串口
+            failed = false;
+            unsigned long long bad2 = 0;
+            const auto start2 = Clock::now();
+            std::thread tcpWriter = startPatternWriter(writerClient, total, failed);
+            const double seconds2 = readPattern(peer, total, start2, bad2);
+            tcpWriter.join();
+            printThroughput("tcp -> serial", total, failed ? -1.0 : seconds2, bad2);
+            // 写入的数据没有回环，观察者不会收到；往返测试中回显的数据会广播给所有客户端，丢给观察者即可
+            for (auto &observer : observers) {
+                observer->close();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            std::printf("%-24s %10s %10s %10s\n", "round trip (us)", "median", "p99", "max");
+            printRoundTrips("direct serial", directRoundTrips);
+            printRoundTrips("via tcp", measureRoundTrips(writerClient, writerClient, peer, options));
+
+            const auto stats = server.stats();
+            std::printf("server: %llu bytes to clients, %llu from writer, %llu dropped, %llu ignored\n",
+                        static_cast<unsigned long long>(stats.bytesToClients),
+                        static_cast<unsigned long long>(stats.bytesFromWriter),
+                        static_cast<unsigned long long>(stats.droppedBytes),
+                        static_cast<unsigned long long>(stats.ignoredBytes));
+        }
+        server.stop();
+        manager.closePort();
+    }
+    workGuard.reset();
+    ioThread.join();
+    return status;
+}